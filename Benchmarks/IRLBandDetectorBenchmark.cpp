@@ -0,0 +1,62 @@
+//
+//  IRLBandDetectorBenchmark.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Steady state cost of re-detecting a page around its previous quad, against a full frame
+//  detection, and the fraction of a hand-held sequence served by the bands.
+//
+
+#include "IRLBandDetector.hpp"
+#include "IRLBenchmark.hpp"
+#include "IRLFrameSequence.hpp"
+#include "IRLQuadDetector.hpp"
+
+using namespace irl;
+using namespace irl::test;
+
+static void run(const char* name, int width, int height, int count) {
+    FrameSequence sequence;
+    sequence.width      = width;
+    sequence.height     = height;
+    sequence.amplitudeX = height * 0.05f;
+    sequence.amplitudeY = height * 0.035f;
+
+    std::vector<Frame> frames;
+    for (int i = 0; i <= 30; i++) frames.push_back(sequence.frame(i));
+
+    BandDetector detector;
+    Quad quad;
+    bench::Timing band = bench::measure(count, [&] { detector.detect(frames[1].view(), sequence.corners(0), quad); });
+    bench::report(std::string(name) + " band re-detection", width, height, band);
+
+    QuadDetectorOptions options;
+    options.pyramidLevels = 2;
+    QuadDetector full(options);
+    bench::Timing pyramid = bench::measure(count, [&] { full.detect(frames[1].view()); });
+    bench::report(std::string(name) + " full detection pyramid 1/4", width, height, pyramid);
+    std::printf("  band speedup x%.1f\n", pyramid.median / band.median);
+
+    // Hand-held sequence, falling back to the full detector when the bands fail
+    detector.resetCounters();
+    Quad previous = sequence.corners(0);
+    float worst = 0.0f;
+    for (size_t i = 1; i < frames.size(); i++) {
+        if (!detector.detect(frames[i].view(), previous, quad)) {
+            std::vector<DetectedQuad> detected = full.detect(frames[i].view());
+            if (detected.empty()) continue;
+            quad = detected[0].quad;
+        }
+        worst = std::max(worst, cornerError(quad, sequence.corners(static_cast<int>(i))));
+        previous = quad;
+    }
+    std::printf("  %.0f%% of %llu frames served by the bands, worst corner error %.2f px\n",
+                100.0f * detector.counters().servedFraction(), static_cast<unsigned long long>(detector.counters().attempts), worst);
+}
+
+int main() {
+    run("preview", 1440, 1080, bench::iterations(100));
+    run("still 12MP", 4032, 3024, bench::iterations(10));
+    return 0;
+}
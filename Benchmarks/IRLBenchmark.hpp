@@ -0,0 +1,71 @@
+//
+//  IRLBenchmark.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Minimal timing helpers for the Linux benchmark targets. Kept dependency free so the
+//  same sources can be dropped in a device test harness.
+//
+
+#ifndef IRL_BENCHMARK_HPP
+#define IRL_BENCHMARK_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace irl {
+namespace bench {
+
+/** @brief Timing of repeated runs, in milliseconds */
+struct Timing {
+    double  median  = 0.0;
+    double  best    = 0.0;
+    double  mean    = 0.0;
+};
+
+/** @return Iteration count, overridable with IRL_BENCH_ITERATIONS */
+inline int iterations(int fallback) {
+    const char* value = std::getenv("IRL_BENCH_ITERATIONS");
+    int parsed = value ? std::atoi(value) : 0;
+    return parsed > 0 ? parsed : fallback;
+}
+
+/** @brief Run `body` once to warm up, then `count` times */
+template <typename Body>
+Timing measure(int count, Body&& body) {
+    using Clock = std::chrono::steady_clock;
+    body();
+
+    std::vector<double> samples;
+    samples.reserve(static_cast<size_t>(count));
+    for (int i = 0; i < count; i++) {
+        Clock::time_point start = Clock::now();
+        body();
+        samples.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+
+    std::sort(samples.begin(), samples.end());
+    Timing timing;
+    timing.best   = samples.front();
+    timing.median = samples[samples.size() / 2];
+    for (double sample : samples) timing.mean += sample;
+    timing.mean /= samples.size();
+    return timing;
+}
+
+/** @brief Print one result line: name, frame size, timings and throughput */
+inline void report(const std::string& name, int width, int height, const Timing& timing) {
+    double megapixels = width * static_cast<double>(height) / 1e6;
+    std::printf("%-40s %5dx%-5d  median %8.3f ms  best %8.3f ms  %8.1f MP/s\n",
+                name.c_str(), width, height, timing.median, timing.best, megapixels / (timing.median / 1000.0));
+}
+
+} // namespace bench
+} // namespace irl
+
+#endif /* IRL_BENCHMARK_HPP */
@@ -0,0 +1,53 @@
+//
+//  IRLBinarizerBenchmark.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Binarization of a rectified still: the cost must not depend on the window size, and should
+//  scale with the threads.
+//
+
+#include "IRLBenchmark.hpp"
+#include "IRLBinarizer.hpp"
+#include "IRLSyntheticPage.hpp"
+
+#include <thread>
+
+using namespace irl;
+using namespace irl::test;
+
+static void run(const char* name, int width, int height, int count) {
+    SyntheticPage page;
+    page.width   = width;
+    page.height  = height;
+    page.corners = pageCorners(width, height, 0.02f, 0.0f);
+    Frame luma   = renderPage(page, PixelFormat::Gray8);
+    BitPlane bits;
+
+    const int cores = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    std::vector<int> threadCounts = { 1 };
+    if (cores > 1) threadCounts.push_back(cores);
+
+    for (ThresholdMethod method : { ThresholdMethod::Sauvola, ThresholdMethod::Bradley }) {
+        for (int radius : { 8, 32, 128 }) {
+            for (int threads : threadCounts) {
+                BinarizerOptions options;
+                options.method       = method;
+                options.windowRadius = radius;
+                options.threads      = threads;
+                Binarizer binarizer(options);
+
+                char label[96];
+                std::snprintf(label, sizeof(label), "%s %s r%d %dT", name, method == ThresholdMethod::Sauvola ? "sauvola" : "bradley", radius, threads);
+                bench::report(label, width, height, bench::measure(count, [&] { binarizer.binarize(luma.view(), bits); }));
+            }
+        }
+    }
+}
+
+int main() {
+    run("preview", 1920, 1080, bench::iterations(20));
+    run("still 12MP", 4032, 3024, bench::iterations(5));
+    return 0;
+}
@@ -0,0 +1,51 @@
+//
+//  IRLColorControlsBenchmark.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Cost per megapixel of the Enhance and Contrast filters, per kernel variant and source format.
+//
+
+#include "IRLBenchmark.hpp"
+#include "IRLColorControls.hpp"
+#include "IRLColorKernels.hpp"
+#include "IRLSyntheticPage.hpp"
+
+using namespace irl;
+using namespace irl::test;
+
+static void run(const char* name, int width, int height, int count) {
+    SyntheticPage page;
+    page.width   = width;
+    page.height  = height;
+    page.corners = pageCorners(width, height, 0.12f, height * 0.03f);
+    Frame           bgra = renderPage(page);
+    BiPlanarFrame   nv12 = encodeBiPlanar(bgra);
+    std::vector<uint8_t> filtered(bgra.pixels.size());
+    const double megapixels = width * static_cast<double>(height) / 1e6;
+
+    struct Preset { const char* name; ColorControlsOptions options; };
+    const Preset presets[] = { { "enhance", enhanceColorControls() }, { "contrast", contrastColorControls() } };
+
+    for (const Preset& preset : presets) {
+        for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::NEON }) {
+            if (!detail::colorKernels(level)) continue;
+            ColorControls controls(preset.options, level);
+
+            bench::Timing fromBGRA = bench::measure(count, [&] { controls.apply(bgra.view(), filtered.data(), bgra.stride); });
+            bench::report(std::string(name) + " " + preset.name + " BGRA " + simdLevelName(level), width, height, fromBGRA);
+
+            bench::Timing fromNV12 = bench::measure(count, [&] { controls.apply(nv12.view(), filtered.data(), bgra.stride); });
+            bench::report(std::string(name) + " " + preset.name + " NV12 " + simdLevelName(level), width, height, fromNV12);
+
+            std::printf("  %.3f ms/MP from BGRA, %.3f ms/MP from NV12\n", fromBGRA.median / megapixels, fromNV12.median / megapixels);
+        }
+    }
+}
+
+int main() {
+    run("preview", 1920, 1080, bench::iterations(30));
+    run("still 12MP", 4032, 3024, bench::iterations(5));
+    return 0;
+}
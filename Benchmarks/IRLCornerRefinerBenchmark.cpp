@@ -0,0 +1,43 @@
+//
+//  IRLCornerRefinerBenchmark.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Cost and accuracy of the sub-pixel corner refinement on a 12MP still, starting from
+//  corners a few pixels off (typical of CIDetector or of a pyramid level).
+//
+
+#include "IRLBenchmark.hpp"
+#include "IRLCornerRefiner.hpp"
+#include "IRLSyntheticPage.hpp"
+
+using namespace irl;
+using namespace irl::test;
+
+static void run(const char* name, int width, int height, PixelFormat format, int count) {
+    SyntheticPage page;
+    page.width   = width;
+    page.height  = height;
+    page.corners = pageCorners(width, height, 0.12f, width * 0.03f);
+    Frame frame  = renderPage(page, format);
+
+    Quad start = page.corners;
+    const float offsets[4][2] = { { 3.5f, -2.0f }, { -4.0f, 2.5f }, { 2.0f, 4.0f }, { -3.0f, -3.5f } };
+    for (int k = 0; k < 4; k++) start[k] = start[k] + Point(offsets[k][0], offsets[k][1]);
+
+    Quad refined;
+    bench::Timing timing = bench::measure(count, [&] {
+        refined = start;
+        refineQuad(frame.view(), refined);
+    });
+    bench::report(name, width, height, timing);
+    std::printf("  corner error %.2f px -> %.3f px\n", cornerError(start, page.corners), cornerError(refined, page.corners));
+}
+
+int main() {
+    run("still 12MP BGRA", 4032, 3024, PixelFormat::BGRA8, bench::iterations(200));
+    run("still 12MP luma", 4032, 3024, PixelFormat::Gray8, bench::iterations(200));
+    run("preview BGRA", 1440, 1080, PixelFormat::BGRA8, bench::iterations(200));
+    return 0;
+}
@@ -0,0 +1,67 @@
+//
+//  IRLCornerTrackerBenchmark.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Per-frame cost of following a page with the corner tracker, against a full detection
+//  of the same preview frame, and the tracking error over a replayed hand-held sequence.
+//
+
+#include "IRLBenchmark.hpp"
+#include "IRLCornerTracker.hpp"
+#include "IRLFrameSequence.hpp"
+#include "IRLLineQuadFinder.hpp"
+#include "IRLQuadDetector.hpp"
+
+using namespace irl;
+using namespace irl::test;
+
+static void run(const char* name, int width, int height, int count) {
+    FrameSequence sequence;
+    sequence.width      = width;
+    sequence.height     = height;
+    sequence.amplitudeX = height * 0.05f;
+    sequence.amplitudeY = height * 0.035f;
+
+    std::vector<Frame> frames;
+    for (int i = 0; i <= 30; i++) frames.push_back(sequence.frame(i));
+
+    // Cost of one tracked frame, always tracking frame 0 -> 1 from the same start
+    CornerTracker tracker;
+    bench::Timing tracking = bench::measure(count, [&] {
+        tracker.start(frames[0].view(), sequence.corners(0));
+        tracker.track(frames[1].view());
+    });
+    bench::report(std::string(name) + " tracker start + track", width, height, tracking);
+
+    QuadDetectorOptions detectorOptions;
+    detectorOptions.pyramidLevels = 2;
+    QuadDetector detector(detectorOptions);
+    bench::report(std::string(name) + " QuadDetector pyramid 1/4", width, height,
+                  bench::measure(count, [&] { detector.detect(frames[1].view()); }));
+
+    LineQuadFinder finder;
+    bench::report(std::string(name) + " LineQuadFinder", width, height,
+                  bench::measure(count, [&] { finder.find(frames[1].view()); }));
+
+    // Error over the sequence, with a simulated exact detection whenever the tracker asks for one
+    tracker.start(frames[0].view(), sequence.corners(0));
+    float sum = 0.0f, worst = 0.0f;
+    int   lost = 0;
+    for (size_t i = 1; i < frames.size(); i++) {
+        const Quad truth = sequence.corners(static_cast<int>(i));
+        if (!tracker.track(frames[i].view())) lost++;
+        sum  += cornerError(tracker.quad(), truth);
+        worst = std::max(worst, cornerError(tracker.quad(), truth));
+        if (tracker.needsDetection()) tracker.start(frames[i].view(), truth, tracker.isTracking());
+    }
+    std::printf("  tracking over %zu frames: mean worst-corner error %.2f px, worst %.2f px, %d lost\n",
+                frames.size() - 1, sum / (frames.size() - 1), worst, lost);
+}
+
+int main() {
+    run("preview", 1440, 1080, bench::iterations(200));
+    run("preview 1080p", 1920, 1080, bench::iterations(200));
+    return 0;
+}
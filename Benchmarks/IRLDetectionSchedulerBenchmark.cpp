@@ -0,0 +1,104 @@
+//
+//  IRLDetectionSchedulerBenchmark.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Replays a preview where the phone first rests over a page, then moves, with the corner
+//  tracker between detections and the scheduler picking the detection frames. Prints the
+//  logged decisions where the reason changes, then the detections and the average cost per
+//  frame of each phase against the budget.
+//
+
+#include "IRLBenchmark.hpp"
+#include "IRLCornerTracker.hpp"
+#include "IRLDetectionScheduler.hpp"
+#include "IRLFrameSequence.hpp"
+#include "IRLQuadDetector.hpp"
+
+#include <chrono>
+
+using namespace irl;
+using namespace irl::test;
+
+static double elapsed(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct Phase {
+    const char*     name;
+    FrameSequence   sequence;
+    int             frames;
+};
+
+static void run(float budget, bool verbose) {
+    FrameSequence resting;
+    resting.width       = 1440;
+    resting.height      = 1080;
+    resting.amplitudeX  = resting.amplitudeY = resting.rotation = resting.zoom = 0.0f;
+    resting.wobble      = 0.3f;
+
+    FrameSequence moving = resting;
+    moving.amplitudeX   = 50.0f;
+    moving.amplitudeY   = 35.0f;
+    moving.rotation     = 3.0f;
+    moving.zoom         = 0.05f;
+    moving.wobble       = 1.5f;
+
+    const Phase phases[] = { { "resting", resting, 200 }, { "moving", moving, 90 } };
+
+    QuadDetectorOptions detectorOptions;
+    detectorOptions.pyramidLevels = 2;
+    QuadDetector detector(detectorOptions);
+    CornerTracker tracker;
+
+    DetectionSchedulerOptions options;
+    options.frameBudget = budget;
+    DetectionScheduler scheduler(options);
+    scheduler.setLogging(true);
+
+    std::printf("budget %.1f ms per frame\n", budget);
+    int confidence = 0;
+    for (const Phase& phase : phases) {
+        const float diagonal = std::hypot(static_cast<float>(phase.sequence.width), static_cast<float>(phase.sequence.height));
+        const size_t first = scheduler.log().size();
+        int    detections = 0;
+        double cost = 0.0;
+
+        for (int i = 0; i < phase.frames; i++) {
+            Frame frame = phase.sequence.frame(i);
+
+            auto start = std::chrono::steady_clock::now();
+            bool tracking = tracker.isTracking() && tracker.track(frame.view());
+            if (tracking) scheduler.recordTracking(static_cast<float>(elapsed(start)));
+            confidence = tracking ? confidence + 1 : 0;
+
+            ScheduleDecision decision = scheduler.next(tracking, tracker.motion() / diagonal, confidence > 66);
+            if (decision.detect) {
+                auto detectStart = std::chrono::steady_clock::now();
+                std::vector<DetectedQuad> quads = detector.detect(frame.view());
+                scheduler.recordDetection(static_cast<float>(elapsed(detectStart)));
+                if (!quads.empty()) tracker.start(frame.view(), quads[0].quad, tracking);
+                detections++;
+            }
+            cost += elapsed(start);
+        }
+
+        if (verbose) {
+            for (size_t d = first; d < scheduler.log().size(); d++) {
+                const ScheduleDecision& decision = scheduler.log()[d];
+                if (d != first && decision.reason == scheduler.log()[d - 1].reason) continue;
+                std::printf("  frame %3u %-6s  interval %3d  %-7s  detection %5.2f ms  tracking %5.3f ms  motion %.4f\n",
+                            decision.frame, decision.detect ? "detect" : "track", decision.interval, scheduleReasonName(decision.reason),
+                            decision.detectionLatency, decision.trackingLatency, decision.motion);
+            }
+        }
+        std::printf("  %-8s %3d frames  %3d detections  %6.3f ms per frame\n", phase.name, phase.frames, detections, cost / phase.frames);
+    }
+}
+
+int main() {
+    run(8.0f, true);
+    run(0.3f, true);
+    return 0;
+}
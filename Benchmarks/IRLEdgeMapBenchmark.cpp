@@ -0,0 +1,71 @@
+//
+//  IRLEdgeMapBenchmark.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Throughput of the edge kernels per instruction set on a 1080p preview frame and a
+//  12MP still: gradient alone, gradient + suppression, and the complete edge map.
+//
+
+#include "IRLBenchmark.hpp"
+#include "IRLEdgeKernels.hpp"
+#include "IRLEdgeMap.hpp"
+#include "IRLSyntheticPage.hpp"
+
+using namespace irl;
+using namespace irl::test;
+
+static void run(const char* name, int width, int height, int count) {
+    SyntheticPage page;
+    page.width   = width;
+    page.height  = height;
+    page.corners = pageCorners(width, height, 0.12f, width * 0.03f);
+    Frame frame  = renderPage(page, PixelFormat::Gray8);
+
+    Plane8 luma, smoothed;
+    convertToLuma(frame.view(), luma);
+    smoothBinomial3(luma, smoothed);
+
+    const size_t w = static_cast<size_t>(width);
+    std::vector<int16_t> rows(9 * w);
+    std::vector<uint8_t> classes(w);
+    EdgeMapOptions options;
+
+    for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::NEON }) {
+        const detail::EdgeKernels* kernels = detail::edgeKernels(level);
+        if (!kernels) continue;
+        const std::string label = std::string(name) + " " + simdLevelName(level);
+
+        bench::Timing sobel = bench::measure(count, [&] {
+            for (int y = 1; y < height - 1; y++) {
+                const size_t slot = static_cast<size_t>(y % 3) * w;
+                kernels->sobelRow(smoothed.row(y - 1), smoothed.row(y), smoothed.row(y + 1), width,
+                                  &rows[slot], &rows[3 * w + slot], &rows[6 * w + slot]);
+            }
+        });
+        bench::report(label + " sobel", width, height, sobel);
+
+        bench::Timing suppression = bench::measure(count, [&] {
+            for (int y = 1; y < height - 1; y++) {
+                const size_t slot = static_cast<size_t>(y % 3) * w;
+                kernels->sobelRow(smoothed.row(y - 1), smoothed.row(y), smoothed.row(y + 1), width,
+                                  &rows[slot], &rows[3 * w + slot], &rows[6 * w + slot]);
+                kernels->suppressRow(&rows[6 * w], &rows[7 * w], &rows[8 * w], &rows[slot], &rows[3 * w + slot],
+                                     width, options.lowThreshold, options.highThreshold, classes.data());
+            }
+        });
+        bench::report(label + " sobel+nms", width, height, suppression);
+
+        EdgeDetector detector(level);
+        Plane8 edges;
+        bench::Timing canny = bench::measure(count, [&] { detector.detect(smoothed.view(), options, edges); });
+        bench::report(label + " edge map", width, height, canny);
+    }
+}
+
+int main() {
+    run("1080p", 1920, 1080, bench::iterations(30));
+    run("12MP", 4032, 3024, bench::iterations(8));
+    return 0;
+}
@@ -0,0 +1,134 @@
+//
+//  IRLGuidedFilterBenchmark.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Cost of the guided filter on a noisy 12MP capture per radius, which should stay flat, and
+//  an estimate of what it saves on the JPEG. The core has no encoder, so no file is written:
+//  the size is the entropy of the baseline JPEG symbols of the luma, 8x8 DCT quantized at
+//  quality 75, a bound an optimized Huffman encoder gets close to. It is not the size of the
+//  files of ImageIO, which also have the chroma and the headers.
+//
+
+#include "IRLBenchmark.hpp"
+#include "IRLGuidedFilter.hpp"
+#include "IRLSyntheticPage.hpp"
+
+#include <cmath>
+
+using namespace irl;
+using namespace irl::test;
+
+/** Annex K luminance table */
+static const int kLumaQuantization[64] = {
+    16, 11, 10, 16,  24,  40,  51,  61,   12, 12, 14, 19,  26,  58,  60,  55,
+    14, 13, 16, 24,  40,  57,  69,  56,   14, 17, 22, 29,  51,  87,  80,  62,
+    18, 22, 37, 56,  68, 109, 103,  77,   24, 35, 55, 64,  81, 104, 113,  92,
+    49, 64, 78, 87, 103, 121, 120, 101,   72, 92, 95, 98, 112, 100, 103,  99,
+};
+
+static const int kZigzag[64] = {
+     0,  1,  8, 16,  9,  2,  3, 10,  17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34,  27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36,  29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46,  53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+static int magnitudeBits(int value) {
+    int bits = 0;
+    for (value = std::abs(value); value; value >>= 1) bits++;
+    return bits;
+}
+
+static double entropyBits(const std::vector<double>& counts) {
+    double total = 0.0, bits = 0.0;
+    for (double count : counts) total += count;
+    for (double count : counts) if (count > 0.0) bits -= count * std::log2(count / total);
+    return bits;
+}
+
+/** Estimated JPEG bytes of the luma of `frame`, quality 75 */
+static double jpegLumaBytes(const Frame& frame) {
+    Plane8 luma;
+    convertToLuma(frame.view(), luma);
+
+    int quantization[64];
+    for (int i = 0; i < 64; i++) quantization[i] = std::min(std::max((kLumaQuantization[i] * 50 + 50) / 100, 1), 255);
+    double basis[8][8];
+    for (int u = 0; u < 8; u++) {
+        for (int x = 0; x < 8; x++) basis[u][x] = (u ? 0.5 : std::sqrt(0.125)) * std::cos((2 * x + 1) * u * M_PI / 16.0);
+    }
+
+    std::vector<double> dcSymbols(16, 0.0), acSymbols(256, 0.0);
+    double magnitude = 0.0;
+    int previousDC = 0;
+    for (int by = 0; by + 8 <= luma.height(); by += 8) {
+        for (int bx = 0; bx + 8 <= luma.width(); bx += 8) {
+            double rows[8][8], block[64];
+            for (int y = 0; y < 8; y++) {
+                for (int u = 0; u < 8; u++) {
+                    double sum = 0.0;
+                    for (int x = 0; x < 8; x++) sum += basis[u][x] * (luma.row(by + y)[bx + x] - 128.0);
+                    rows[y][u] = sum;
+                }
+            }
+            for (int v = 0; v < 8; v++) {
+                for (int u = 0; u < 8; u++) {
+                    double sum = 0.0;
+                    for (int y = 0; y < 8; y++) sum += basis[v][y] * rows[y][u];
+                    block[v * 8 + u] = sum;
+                }
+            }
+
+            int coefficients[64];
+            for (int i = 0; i < 64; i++) coefficients[i] = static_cast<int>(std::lround(block[kZigzag[i]] / quantization[kZigzag[i]]));
+
+            const int dcBits = magnitudeBits(coefficients[0] - previousDC);
+            dcSymbols[static_cast<size_t>(dcBits)]++;
+            magnitude += dcBits;
+            previousDC = coefficients[0];
+
+            int run = 0;
+            for (int i = 1; i < 64; i++) {
+                if (!coefficients[i]) { run++; continue; }
+                for (; run > 15; run -= 16) acSymbols[0xF0]++;
+                const int bits = magnitudeBits(coefficients[i]);
+                acSymbols[static_cast<size_t>(run << 4 | bits)]++;
+                magnitude += bits;
+                run = 0;
+            }
+            if (run) acSymbols[0x00]++;
+        }
+    }
+    return (entropyBits(dcSymbols) + entropyBits(acSymbols) + magnitude) / 8.0;
+}
+
+int main() {
+    SyntheticPage page;
+    page.width   = 4032;
+    page.height  = 3024;
+    page.noise   = 12;
+    page.corners = pageCorners(page.width, page.height, 0.05f, 40.0f);
+    const Frame frame = renderPage(page);
+
+    Frame filtered = frame;
+    for (int radius : { 2, 4, 8, 16 }) {
+        GuidedFilterOptions options;
+        options.radius = radius;
+        GuidedFilter filter(options);
+        const bench::Timing timing = bench::measure(bench::iterations(10), [&] {
+            filter.apply(frame.view(), filtered.pixels.data(), filtered.stride);
+        });
+
+        char label[96];
+        std::snprintf(label, sizeof(label), "guided filter radius %d", radius);
+        bench::report(label, page.width, page.height, timing);
+    }
+
+    GuidedFilter().apply(frame.view(), filtered.pixels.data(), filtered.stride);
+    const double before = jpegLumaBytes(frame), after = jpegLumaBytes(filtered);
+    std::printf("estimated JPEG luma q75: %.2f MB noisy, %.2f MB filtered (%.0f%% smaller)\n",
+                before / 1e6, after / 1e6, 100.0 * (1.0 - after / before));
+    return 0;
+}
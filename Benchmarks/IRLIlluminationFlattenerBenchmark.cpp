@@ -0,0 +1,42 @@
+//
+//  IRLIlluminationFlattenerBenchmark.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Shadow removal at several estimation levels: past level 2 the background costs little
+//  next to the full resolution pass.
+//
+
+#include "IRLBenchmark.hpp"
+#include "IRLIlluminationFlattener.hpp"
+#include "IRLSyntheticPage.hpp"
+
+using namespace irl;
+using namespace irl::test;
+
+static void run(const char* name, int width, int height, PixelFormat format, int count) {
+    SyntheticPage page;
+    page.width   = width;
+    page.height  = height;
+    page.corners = pageCorners(width, height, 0.02f, 0.0f);
+    Frame frame  = renderPage(page, format);
+    std::vector<uint8_t> output(frame.pixels.size());
+
+    for (int level : { 2, 3, 4, 5 }) {
+        IlluminationOptions options;
+        options.level = level;
+        IlluminationFlattener flattener(options);
+
+        char label[96];
+        std::snprintf(label, sizeof(label), "%s %s level %d", name, format == PixelFormat::Gray8 ? "gray" : "bgra", level);
+        bench::report(label, width, height, bench::measure(count, [&] { flattener.apply(frame.view(), output.data(), frame.stride); }));
+    }
+}
+
+int main() {
+    run("preview", 1920, 1080, PixelFormat::BGRA8, bench::iterations(20));
+    run("still 12MP", 4032, 3024, PixelFormat::BGRA8, bench::iterations(5));
+    run("still 12MP", 4032, 3024, PixelFormat::Gray8, bench::iterations(5));
+    return 0;
+}
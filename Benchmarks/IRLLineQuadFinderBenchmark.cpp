@@ -0,0 +1,54 @@
+//
+//  IRLLineQuadFinderBenchmark.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Latency of the line based candidate generator against the number of lines kept, with
+//  the arena footprint and the heap allocations per frame once warmed up.
+//
+
+#include "IRLAllocationCounter.hpp"
+#include "IRLBenchmark.hpp"
+#include "IRLLineQuadFinder.hpp"
+#include "IRLSyntheticPage.hpp"
+
+using namespace irl;
+using namespace irl::test;
+
+static void run(const char* name, int width, int height, int count) {
+    SyntheticPage page;
+    page.width   = width;
+    page.height  = height;
+    page.corners = pageCorners(width, height, 0.12f, width * 0.03f);
+    Frame frame  = renderPage(page);
+
+    for (int searchSize : { 512, 1024 }) {
+        for (int lines : { 8, 16, 24 }) {
+            LineQuadFinderOptions options;
+            options.maximumSearchSize = searchSize;
+            options.maximumLines      = lines;
+            LineQuadFinder finder(options);
+
+            Span<const QuadCandidate> candidates;
+            bench::Timing timing = bench::measure(count, [&] { candidates = finder.find(frame.view()); });
+
+            const long before = allocationCount();
+            for (int i = 0; i < count; i++) finder.find(frame.view());
+            const long allocations = allocationCount() - before;
+
+            std::string label = std::string(name) + " search " + std::to_string(searchSize) + ", " + std::to_string(lines) + " lines";
+            bench::report(label, width, height, timing);
+            std::printf("  level 1/%d, %d angle bins, %d candidates, arena %zu KB, %ld heap allocations over %d more frames",
+                        1 << finder.searchedLevel(), finder.angleBins(), candidates.count, finder.arena().used() / 1024, allocations, count);
+            if (!candidates.isEmpty()) std::printf(", corner error %.2f px", cornerError(candidates[0].quad, page.corners));
+            std::printf("\n");
+        }
+    }
+}
+
+int main() {
+    run("preview", 1440, 1080, bench::iterations(30));
+    run("still 12MP", 4032, 3024, bench::iterations(5));
+    return 0;
+}
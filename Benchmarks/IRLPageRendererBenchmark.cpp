@@ -0,0 +1,91 @@
+//
+//  IRLPageRendererBenchmark.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Final still of a 12MP photo: the chain of full size steps of the CoreImage path (filter,
+//  rectify, crop) against the fused renderer. Besides the time, reports the memory each one
+//  needs on top of the decoded photo, measured in a forked child.
+//
+
+#include "IRLBenchmark.hpp"
+#include "IRLPageRenderer.hpp"
+#include "IRLPeakMemory.hpp"
+#include "IRLSyntheticPage.hpp"
+
+#include <cstring>
+
+using namespace irl;
+using namespace irl::test;
+
+static const double kMegabyte = 1024.0 * 1024.0;
+
+int main() {
+    SyntheticPage page;
+    page.width   = 4032;
+    page.height  = 3024;
+    page.corners = pageCorners(page.width, page.height, 0.08f, 60.0f);
+    const Frame frame = renderPage(page);
+    const int count = bench::iterations(5);
+
+    for (PageFilter filter : { PageFilter::Contrast, PageFilter::UltraContrast }) {
+        const char* name = filter == PageFilter::Contrast ? "contrast" : "ultra contrast";
+
+        // Staged: every step writes a full size image, like the CoreImage chain rendered step by step
+        auto staged = [&] {
+            ColorControls colors(contrastColorControls());
+            ToneMapper    toneMapper;
+            std::vector<uint8_t> filtered(frame.pixels.size());
+            if (filter == PageFilter::Contrast) {
+                colors.apply(frame.view(), filtered.data(), frame.stride);
+            } else {
+                Plane8 luma;
+                convertToLuma(frame.view(), luma);
+                toneMapper.apply(luma.view(), kUltraContrastCurve, luma);
+                for (int y = 0; y < frame.height; y++) {
+                    uint8_t* row = filtered.data() + frame.stride * y;
+                    for (int x = 0; x < frame.width; x++) std::memset(row + 4 * x, luma.row(y)[x], 4);
+                }
+            }
+
+            PageRenderOptions plain;
+            plain.filter = PageFilter::None;
+            plain.margin = 0;
+            PageRenderer rectifier(plain);
+            int width, height;
+            rectifier.outputSize(page.corners, width, height);
+            std::vector<uint8_t> rectified(4 * static_cast<size_t>(width) * height);
+            rectifier.render(ImageView(filtered.data(), frame.width, frame.height, frame.stride, PixelFormat::BGRA8),
+                             page.corners, rectified.data(), 4 * static_cast<size_t>(width));
+
+            std::vector<uint8_t> cropped(4 * static_cast<size_t>(width - 80) * (height - 80));
+            for (int y = 0; y < height - 80; y++) {
+                std::memcpy(cropped.data() + 4 * static_cast<size_t>(width - 80) * y, rectified.data() + 4 * (static_cast<size_t>(width) * (y + 40) + 40), 4 * static_cast<size_t>(width - 80));
+            }
+        };
+
+        PageRenderOptions options;
+        options.filter = filter;
+        PageRenderer renderer(options);
+        int width, height;
+        renderer.outputSize(page.corners, width, height);
+        const size_t outputBytes = bytesPerPixel(renderer.outputFormat()) * static_cast<size_t>(width) * height;
+
+        auto fused = [&] {
+            std::vector<uint8_t> output(outputBytes);
+            renderer.render(frame.view(), page.corners, output.data(), bytesPerPixel(renderer.outputFormat()) * width);
+        };
+
+        char label[96];
+        std::snprintf(label, sizeof(label), "%s staged", name);
+        bench::report(label, frame.width, frame.height, bench::measure(count, staged));
+        std::snprintf(label, sizeof(label), "%s fused", name);
+        bench::report(label, frame.width, frame.height, bench::measure(count, fused));
+
+        std::printf("%-40s source %.1f MB  output %.1f MB  working memory: staged %.1f MB  fused %.1f MB\n", name,
+                    frame.pixels.size() / kMegabyte, outputBytes / kMegabyte,
+                    peakWorkingBytes(staged) / kMegabyte, peakWorkingBytes(fused) / kMegabyte);
+    }
+    return 0;
+}
@@ -0,0 +1,156 @@
+//
+//  IRLPerspectiveWarpBenchmark.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Rectification of a 12MP photo per instruction set, bilinear and bicubic, on one thread and
+//  on all of them. The baseline is the sampler the page renderer had before it moved to the
+//  row kernels of the warp: it divides per pixel like the Core Image perspective correction.
+//
+//  Then a page wanted at 200 dpi: rectified at full size and downscaled afterwards, against the
+//  area filter sampling it at its final size in one pass, with the memory each one needs.
+//
+//  Last a 48MP photo: the whole page rectified then read by the encoder, against bands of the
+//  page warped into one buffer and read as they come.
+//
+
+#include "IRLBenchmark.hpp"
+#include "IRLPageAspect.hpp"
+#include "IRLPeakMemory.hpp"
+#include "IRLPerspectiveWarp.hpp"
+#include "IRLSyntheticPage.hpp"
+#include "IRLWarpKernels.hpp"
+
+#include <algorithm>
+
+using namespace irl;
+using namespace irl::test;
+
+static const double kMegabyte = 1024.0 * 1024.0;
+
+/** Bilinear samples of one output row, the projective division done at every pixel, weights in Q8 */
+static void divisionRow(const ImageView& source, const Homography& H, double y, int count, uint8_t* destination) {
+    const double rowX = H.m[1] * y + H.m[2];
+    const double rowY = H.m[4] * y + H.m[5];
+    const double rowW = H.m[7] * y + H.m[8];
+    const int    maxX = source.width - 1, maxY = source.height - 1;
+
+    for (int i = 0; i < count; i++, destination += 4) {
+        const double x = i + 0.5;
+        const double w = 1.0 / (H.m[6] * x + rowW);
+        const float sx = std::min(std::max(static_cast<float>((H.m[0] * x + rowX) * w) + 0.5f, 0.0f), static_cast<float>(maxX + 1));
+        const float sy = std::min(std::max(static_cast<float>((H.m[3] * x + rowY) * w) + 0.5f, 0.0f), static_cast<float>(maxY + 1));
+        const int   ax = static_cast<int>(sx), ay = static_cast<int>(sy);
+        const int   wx = static_cast<int>((sx - ax) * 256.0f + 0.5f);
+        const int   wy = static_cast<int>((sy - ay) * 256.0f + 0.5f);
+
+        const int   left   = std::max(ax - 1, 0), right  = std::min(ax, maxX);
+        const int   top    = std::max(ay - 1, 0), bottom = std::min(ay, maxY);
+        const uint8_t* t = source.row(top);
+        const uint8_t* b = source.row(bottom);
+        for (int c = 0; c < 4; c++) {
+            const int upper = t[4 * left + c] * (256 - wx) + t[4 * right + c] * wx;
+            const int lower = b[4 * left + c] * (256 - wx) + b[4 * right + c] * wx;
+            destination[c] = static_cast<uint8_t>((upper * (256 - wy) + lower * wy + 32768) >> 16);
+        }
+    }
+}
+
+int main() {
+    SyntheticPage page;
+    page.width   = 4032;
+    page.height  = 3024;
+    page.corners = pageCorners(page.width, page.height, 0.05f, 40.0f);
+    const Frame frame = renderPage(page);
+
+    int width, height;
+    rectifiedSize(page.corners, width, height);
+    const size_t rowBytes = 4 * static_cast<size_t>(width);
+    std::vector<uint8_t> output(rowBytes * height);
+
+    const Homography H = Homography::rectangleToQuad(width, height, page.corners);
+    const bench::Timing baseline = bench::measure(bench::iterations(10), [&] {
+        for (int y = 0; y < height; y++) divisionRow(frame.view(), H, y + 0.5, width, output.data() + rowBytes * y);
+    });
+    bench::report("division per pixel, 1 thread", width, height, baseline);
+
+    for (Interpolation interpolation : { Interpolation::Bilinear, Interpolation::Bicubic }) {
+        const char* name = interpolation == Interpolation::Bilinear ? "bilinear" : "bicubic";
+        for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::NEON }) {
+            if (!detail::warpKernels(level)) continue;
+            for (int threads : { 1, 0 }) {
+                WarpOptions options;
+                options.interpolation = interpolation;
+                options.threads       = threads;
+                PerspectiveWarp warp(options, level);
+                const bench::Timing timing = bench::measure(bench::iterations(10), [&] {
+                    warp.rectify(frame.view(), page.corners, output.data(), rowBytes);
+                });
+                bench::report(std::string("warp ") + name + " " + simdLevelName(level) + (threads == 1 ? ", 1 thread" : ", shared"),
+                              width, height, timing);
+            }
+        }
+    }
+
+    // 200 dpi on the A4 sheet the page is taken for
+    PageAspectOptions resolution;
+    resolution.dpi = 200.0;
+    int pageWidth = width, pageHeight = height;
+    limitPageResolution(pageWidth, pageHeight, resolution);
+    const size_t pageBytes = 4 * static_cast<size_t>(pageWidth);
+
+    WarpOptions bilinear, area;
+    bilinear.threads      = 1;
+    area.threads          = 1;
+    area.interpolation    = Interpolation::Area;
+    PerspectiveWarp fullWarp(bilinear), areaWarp(area);
+    Homography shrink;
+    shrink.m[0] = static_cast<double>(width) / pageWidth;
+    shrink.m[4] = static_cast<double>(height) / pageHeight;
+
+    auto downscaled = [&] {
+        std::vector<uint8_t> rectified(rowBytes * height), result(pageBytes * pageHeight);
+        fullWarp.rectify(frame.view(), page.corners, rectified.data(), rowBytes);
+        areaWarp.warp(ImageView(rectified.data(), width, height, rowBytes, PixelFormat::BGRA8), shrink, result.data(), pageBytes, pageWidth, pageHeight);
+    };
+    auto direct = [&] {
+        std::vector<uint8_t> result(pageBytes * pageHeight);
+        areaWarp.rectify(frame.view(), page.corners, pageWidth, pageHeight, result.data(), pageBytes);
+    };
+    bench::report("200 dpi: full size warp then downscale", pageWidth, pageHeight, bench::measure(bench::iterations(10), downscaled));
+    bench::report("200 dpi: area warp", pageWidth, pageHeight, bench::measure(bench::iterations(10), direct));
+    std::printf("%-40s %dx%d from %dx%d  working memory: downscaled %.1f MB  direct %.1f MB\n", "200 dpi", pageWidth, pageHeight, width, height,
+                peakWorkingBytes(downscaled) / kMegabyte, peakWorkingBytes(direct) / kMegabyte);
+
+    // The bytes are summed where an encoder would compress them
+    SyntheticPage large;
+    large.width   = 8000;
+    large.height  = 6000;
+    large.corners = pageCorners(large.width, large.height, 0.05f, 40.0f);
+    const Frame largeFrame = renderPage(large);
+    int largeWidth, largeHeight;
+    rectifiedSize(large.corners, largeWidth, largeHeight);
+    const size_t largeBytes = 4 * static_cast<size_t>(largeWidth);
+
+    uint64_t checksum = 0;
+    auto encode = [&](const ImageView& band) {
+        for (int y = 0; y < band.height; y++) {
+            for (size_t x = 0; x < largeBytes; x += 64) checksum += band.data[band.stride * y + x];
+        }
+        return true;
+    };
+    auto whole = [&] {
+        std::vector<uint8_t> result(largeBytes * largeHeight);
+        fullWarp.rectify(largeFrame.view(), large.corners, largeWidth, largeHeight, result.data(), largeBytes);
+        encode(ImageView(result.data(), largeWidth, largeHeight, largeBytes, PixelFormat::BGRA8));
+    };
+    auto banded = [&] {
+        fullWarp.rectifyBands(largeFrame.view(), large.corners, largeWidth, largeHeight, [&](const ImageView& band, int) { return encode(band); });
+    };
+    bench::report("48MP: whole page", largeWidth, largeHeight, bench::measure(bench::iterations(5), whole));
+    bench::report("48MP: bands", largeWidth, largeHeight, bench::measure(bench::iterations(5), banded));
+    std::printf("%-40s %dx%d  working memory: whole %.1f MB  bands %.1f MB  (checksum %llu)\n", "48MP", largeWidth, largeHeight,
+                peakWorkingBytes(whole) / kMegabyte, peakWorkingBytes(banded) / kMegabyte, static_cast<unsigned long long>(checksum));
+    return 0;
+}
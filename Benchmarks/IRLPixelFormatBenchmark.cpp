@@ -0,0 +1,62 @@
+//
+//  IRLPixelFormatBenchmark.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Per frame latency and memory traffic of detection on a 32BGRA camera frame against the
+//  Y plane of a 420 bi-planar one, with and without a BGRA conversion for the preview.
+//
+
+#include "IRLBenchmark.hpp"
+#include "IRLImage.hpp"
+#include "IRLQuadDetector.hpp"
+#include "IRLSyntheticPage.hpp"
+
+using namespace irl;
+using namespace irl::test;
+
+static void traffic(const char* name, double read, double written, int width, int height) {
+    const double pixels = width * static_cast<double>(height);
+    std::printf("  %-38s read %5.2f B/px  written %5.2f B/px  %6.1f MB/frame\n",
+                name, read, written, (read + written) * pixels / 1e6);
+}
+
+static void run(const char* name, int width, int height, int count) {
+    SyntheticPage page;
+    page.width   = width;
+    page.height  = height;
+    page.corners = pageCorners(width, height, 0.12f, height * 0.03f);
+    Frame               bgra = renderPage(page);
+    BiPlanarFrame       nv12 = encodeBiPlanar(bgra);
+    std::vector<uint8_t> converted(bgra.pixels.size());
+
+    QuadDetectorOptions options;
+    options.pyramidLevels = 2;
+    QuadDetector detector(options);
+
+    bench::Timing fromBGRA = bench::measure(count, [&] { detector.detect(bgra.view()); });
+    bench::report(std::string(name) + " detection 32BGRA", width, height, fromBGRA);
+
+    bench::Timing fromLuma = bench::measure(count, [&] { detector.detect(nv12.view().luma); });
+    bench::report(std::string(name) + " detection NV12 Y plane", width, height, fromLuma);
+
+    bench::Timing conversion = bench::measure(count, [&] { convertToBGRA(nv12.view(), converted.data(), bgra.stride); });
+    bench::report(std::string(name) + " NV12 to BGRA (CPU preview)", width, height, conversion);
+
+    std::printf("  Y plane speedup x%.2f, x%.2f with a CPU BGRA conversion\n",
+                fromBGRA.median / fromLuma.median, fromBGRA.median / (fromLuma.median + conversion.median));
+
+    // Bytes touched by the first pass over the camera frame, every later pass works on the downsampled pyramid
+    traffic("camera frame 32BGRA", 4.0, 0.0, width, height);
+    traffic("camera frame NV12", 1.5, 0.0, width, height);
+    traffic("detection from 32BGRA", 4.0, 0.0, width, height);
+    traffic("detection from NV12 Y plane", 1.0, 0.0, width, height);
+    traffic("NV12 to BGRA conversion", 1.5, 4.0, width, height);
+}
+
+int main() {
+    run("preview", 1920, 1080, bench::iterations(50));
+    run("still 12MP", 4032, 3024, bench::iterations(5));
+    return 0;
+}
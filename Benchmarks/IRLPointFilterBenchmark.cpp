@@ -0,0 +1,80 @@
+//
+//  IRLPointFilterBenchmark.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Throughput of the fixed point filter per kernel variant, against the same chain on floats
+//  compiled for the same core: the color chain, and the luma and curve of the Ultra Contrast
+//  page of `PageRenderer`.
+//
+
+#include "IRLBenchmark.hpp"
+#include "IRLPointFilter.hpp"
+#include "IRLPointFilterKernels.hpp"
+#include "IRLSyntheticPage.hpp"
+
+using namespace irl;
+using namespace irl::test;
+
+static void run(const char* name, PixelFormat format, int width, int height, int count) {
+    SyntheticPage page;
+    page.width   = width;
+    page.height  = height;
+    page.corners = pageCorners(width, height, 0.12f, height * 0.03f);
+    Frame frame  = renderPage(page, format);
+    std::vector<uint8_t> filtered(frame.pixels.size());
+    const int channels = static_cast<int>(bytesPerPixel(format));
+
+    PointFilterOptions options;
+    options.saturation = 0.35f;
+    options.contrast   = 1.14f;
+
+    const bench::Timing floating = bench::measure(count, [&] {
+        for (int y = 0; y < height; y++) {
+            detail::pointFilterRowFloat(frame.view().row(y), filtered.data() + y * frame.stride, width, channels, options);
+        }
+    });
+    bench::report(std::string(name) + " float", width, height, floating);
+
+    for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::NEON }) {
+        if (!detail::pointFilterKernels(level)) continue;
+        PointFilter filter(options, level);
+        const bench::Timing fixed = bench::measure(count, [&] { filter.apply(frame.view(), filtered.data(), frame.stride); });
+        bench::report(std::string(name) + " fixed " + simdLevelName(level), width, height, fixed);
+        std::printf("  x%.2f against float\n", floating.median / fixed.median);
+    }
+}
+
+static void runLuma(const char* name, int width, int height, int count) {
+    SyntheticPage page;
+    page.width   = width;
+    page.height  = height;
+    page.corners = pageCorners(width, height, 0.12f, height * 0.03f);
+    Frame frame  = renderPage(page, PixelFormat::BGRA8);
+    std::vector<uint8_t> gray(static_cast<size_t>(width) * height);
+
+    PointFilterOptions options;
+    options.curve = &kUltraContrastCurve;
+
+    const bench::Timing floating = bench::measure(count, [&] {
+        for (int y = 0; y < height; y++) detail::pointFilterLumaRowFloat(frame.view().row(y), gray.data() + static_cast<size_t>(y) * width, width, options);
+    });
+    bench::report(std::string(name) + " float", width, height, floating);
+
+    for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::NEON }) {
+        if (!detail::pointFilterKernels(level)) continue;
+        PointFilter filter(options, level);
+        const bench::Timing fixed = bench::measure(count, [&] { filter.applyLuma(frame.view(), gray.data(), static_cast<size_t>(width)); });
+        bench::report(std::string(name) + " fixed " + simdLevelName(level), width, height, fixed);
+        std::printf("  x%.2f against float\n", floating.median / fixed.median);
+    }
+}
+
+int main() {
+    const int count = bench::iterations(5);
+    run("still 12MP BGRA", PixelFormat::BGRA8, 4032, 3024, count);
+    run("still 12MP gray", PixelFormat::Gray8, 4032, 3024, count);
+    runLuma("still 12MP ultra contrast", 4032, 3024, count);
+    return 0;
+}
@@ -0,0 +1,89 @@
+//
+//  IRLQuadBenchmark.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Cost and heap allocations of naming the 4 corners of a quad, done on every preview frame.
+//  The baseline mirrors the Objective-C code it replaced: the corners copied to a heap array,
+//  sorted with a comparator boxing the atan2 of both sides, the sorted copy allocated again.
+//
+
+#include "IRLAllocationCounter.hpp"
+#include "IRLBenchmark.hpp"
+#include "IRLQuad.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+using namespace irl;
+using namespace irl::test;
+
+static const int kQuads  = 64;
+static const int kRounds = 2000;
+
+/** The NSArray of NSValue, the NSNumber of every angle and the sorted NSArray, with their C++ counterparts */
+static Quad boxedSort(const Point corners[4]) {
+    std::vector<std::unique_ptr<Point>> points;
+    for (int k = 0; k < 4; k++) points.emplace_back(new Point(corners[k]));
+
+    float minX = points[0]->x, minY = points[0]->y, maxX = minX, maxY = minY;
+    for (const auto& point : points) {
+        minX = std::fmin(point->x, minX); maxX = std::fmax(point->x, maxX);
+        minY = std::fmin(point->y, minY); maxY = std::fmax(point->y, maxY);
+    }
+    const Point center(0.5f * (minX + maxX), 0.5f * (minY + maxY));
+    auto angle = [&](const Point& p) { return std::unique_ptr<float>(new float(std::atan2(p.y - center.y, p.x - center.x))); };
+
+    std::vector<const Point*> sorted;
+    for (const auto& point : points) sorted.push_back(point.get());
+    std::sort(sorted.begin(), sorted.end(), [&](const Point* a, const Point* b) { return *angle(*a) < *angle(*b); });
+
+    int first = 0;
+    for (int k = 1; k < 4; k++) if (sorted[k]->x + sorted[k]->y < sorted[first]->x + sorted[first]->y) first = k;
+    Quad quad;
+    for (int k = 0; k < 4; k++) quad[k] = *sorted[(first + k) & 3];
+    return quad;
+}
+
+template <typename Order>
+static void run(const char* name, const std::vector<Point>& corners, Order&& order) {
+    float checksum = 0.0f;
+    const bench::Timing timing = bench::measure(bench::iterations(10), [&] {
+        for (int round = 0; round < kRounds; round++) {
+            for (int q = 0; q < kQuads; q++) checksum += order(&corners[4 * q]).topLeft.x;
+        }
+    });
+
+    const long before = allocationCount();
+    for (int q = 0; q < kQuads; q++) checksum += order(&corners[4 * q]).topLeft.x;
+    const double allocations = static_cast<double>(allocationCount() - before) / kQuads;
+
+    const double nanoseconds = timing.median * 1e6 / (static_cast<double>(kRounds) * kQuads);
+    std::printf("%-40s %8.1f ns per quad  %5.1f heap allocations per quad  (checksum %.0f)\n", name, nanoseconds, allocations, checksum);
+}
+
+int main() {
+    // Detected documents turned every which way, their corners in a random order
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> jitter(-60.0f, 60.0f), turn(-3.14159f, 3.14159f);
+    std::vector<Point> corners;
+    for (int q = 0; q < kQuads; q++) {
+        const float a = turn(random);
+        const Point center(720.0f + jitter(random), 540.0f + jitter(random));
+        Point quad[4];
+        for (int k = 0; k < 4; k++) {
+            const float angle = a + k * 1.5708f;
+            quad[k] = Point(center.x + 400.0f * std::cos(angle) + jitter(random), center.y + 300.0f * std::sin(angle) + jitter(random));
+        }
+        std::shuffle(quad, quad + 4, random);
+        corners.insert(corners.end(), quad, quad + 4);
+    }
+
+    run("boxed atan2 sort", corners, boxedSort);
+    run("canonicalQuad", corners, canonicalQuad);
+    return 0;
+}
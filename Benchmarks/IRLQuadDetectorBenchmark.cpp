@@ -0,0 +1,45 @@
+//
+//  IRLQuadDetectorBenchmark.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Per-frame latency and corner error of the native detector on a preview frame
+//  (AVCaptureSessionPresetPhoto video output) and on a 12MP still, single scale and pyramid.
+//
+
+#include "IRLBenchmark.hpp"
+#include "IRLQuadDetector.hpp"
+#include "IRLSyntheticPage.hpp"
+
+using namespace irl;
+using namespace irl::test;
+
+static void run(const char* name, int width, int height, int count) {
+    SyntheticPage page;
+    page.width   = width;
+    page.height  = height;
+    page.corners = pageCorners(width, height, 0.12f, width * 0.03f);
+    Frame frame  = renderPage(page);
+
+    // Single scale first, then detection on the 1/4 and 1/8 levels with per level refinement
+    for (int levels : { 0, 2, 3 }) {
+        QuadDetectorOptions options;
+        options.pyramidLevels = levels;
+        QuadDetector detector(options);
+
+        std::vector<DetectedQuad> quads;
+        bench::Timing timing = bench::measure(count, [&] { quads = detector.detect(frame.view()); });
+
+        std::string label = std::string(name) + (levels ? " pyramid 1/" + std::to_string(1 << levels) : " single scale");
+        bench::report(label, width, height, timing);
+        if (quads.size() == 1) std::printf("  corner error %.2f px\n", cornerError(quads[0].quad, page.corners));
+        else std::printf("  warning: %zu quads detected\n", quads.size());
+    }
+}
+
+int main() {
+    run("preview", 1440, 1080, bench::iterations(30));
+    run("still 12MP", 4032, 3024, bench::iterations(5));
+    return 0;
+}
@@ -0,0 +1,51 @@
+//
+//  IRLQuadScorerBenchmark.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Cost of scoring a batch of candidate quads on a preview frame, with every criterion enabled.
+//
+
+#include "IRLBenchmark.hpp"
+#include "IRLQuadScorer.hpp"
+#include "IRLSyntheticPage.hpp"
+
+using namespace irl;
+using namespace irl::test;
+
+static void run(int candidates, int count) {
+    SyntheticPage page;
+    page.corners = pageCorners(page.width, page.height, 0.15f, 30.0f);
+    Frame frame  = renderPage(page);
+
+    XorShift random(3);
+    std::vector<Quad> quads;
+    for (int i = 0; i < candidates; i++) {
+        Quad quad = page.corners;
+        for (int k = 0; k < 4; k++) {
+            quad[k].x += 60.0f * (static_cast<float>(random.next() % 2001) / 1000.0f - 1.0f);
+            quad[k].y += 60.0f * (static_cast<float>(random.next() % 2001) / 1000.0f - 1.0f);
+        }
+        quads.push_back(quad);
+    }
+
+    QuadScorer scorer;
+    const Quad previous = page.corners;
+    int best = -1;
+    bench::Timing timing = bench::measure(count, [&] {
+        scorer.clear();
+        for (const Quad& quad : quads) scorer.add(quad);
+        best = scorer.score(frame.view(), 0, 0, &previous);
+    });
+
+    bench::report(std::to_string(candidates) + " candidates", page.width, page.height, timing);
+    std::printf("  %.2f us per candidate, best %d (score %.3f)\n", 1000.0 * timing.median / candidates, best, scorer.scoreOf(best).total);
+}
+
+int main() {
+    run(4, bench::iterations(1000));
+    run(100, bench::iterations(200));
+    run(500, bench::iterations(50));
+    return 0;
+}
@@ -0,0 +1,83 @@
+//
+//  IRLTileExecutorBenchmark.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Scaling of the still stages from 1 to N threads on a 12MP page, with the speedup over one
+//  thread. N is the core count, or IRL_BENCH_THREADS.
+//
+
+#include "IRLBenchmark.hpp"
+#include "IRLBinarizer.hpp"
+#include "IRLIlluminationFlattener.hpp"
+#include "IRLPageRenderer.hpp"
+#include "IRLSyntheticPage.hpp"
+#include "IRLTileExecutor.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+
+using namespace irl;
+using namespace irl::test;
+
+static int maximumThreads() {
+    const char* value = std::getenv("IRL_BENCH_THREADS");
+    const int parsed = value ? std::atoi(value) : 0;
+    return parsed > 0 ? parsed : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+/** Run `stage(threads)` for every thread count and print the speedup over one thread */
+template <typename Stage>
+static void scale(const char* name, int width, int height, int count, Stage&& stage) {
+    double single = 0.0;
+    for (int threads = 1; threads <= maximumThreads(); threads++) {
+        const bench::Timing timing = bench::measure(count, [&] { stage(threads); });
+        if (threads == 1) single = timing.median;
+
+        char label[96];
+        std::snprintf(label, sizeof(label), "%s %dT (x%.2f)", name, threads, single / timing.median);
+        bench::report(label, width, height, timing);
+    }
+}
+
+int main() {
+    SyntheticPage page;
+    page.width   = 4032;
+    page.height  = 3024;
+    page.corners = pageCorners(page.width, page.height, 0.05f, 40.0f);
+    const Frame frame = renderPage(page);
+    const Frame luma  = renderPage(page, PixelFormat::Gray8);
+    const int   count = bench::iterations(5);
+
+    std::vector<uint8_t> output(frame.pixels.size());
+
+    scale("page renderer", page.width, page.height, count, [&](int threads) {
+        PageRenderOptions options;
+        options.threads = threads;
+        PageRenderer renderer(options);
+        renderer.render(frame.view(), page.corners, output.data(), frame.stride);
+    });
+
+    scale("illumination flattener", page.width, page.height, count, [&](int threads) {
+        IlluminationOptions options;
+        options.threads = threads;
+        IlluminationFlattener flattener(options);
+        flattener.apply(frame.view(), output.data(), frame.stride);
+    });
+
+    BitPlane bits;
+    scale("binarizer", page.width, page.height, count, [&](int threads) {
+        BinarizerOptions options;
+        options.threads = threads;
+        Binarizer binarizer(options);
+        binarizer.binarize(luma.view(), bits);
+    });
+
+    // Dispatch cost alone: 192 tiles of 256x256 doing nothing
+    TileExecutor executor;
+    bench::report("dispatch of 192 empty tiles", page.width, page.height,
+                  bench::measure(bench::iterations(1000), [&] { executor.run(page.width, page.height, 256, 256, [](const Tile&, int) {}); }));
+    return 0;
+}
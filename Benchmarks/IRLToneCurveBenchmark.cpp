@@ -0,0 +1,38 @@
+//
+//  IRLToneCurveBenchmark.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Ultra Contrast on the Y plane of a camera frame, per kernel variant.
+//
+
+#include "IRLBenchmark.hpp"
+#include "IRLSyntheticPage.hpp"
+#include "IRLToneCurve.hpp"
+#include "IRLToneCurveKernels.hpp"
+
+using namespace irl;
+using namespace irl::test;
+
+static void run(const char* name, int width, int height, int count) {
+    SyntheticPage page;
+    page.width   = width;
+    page.height  = height;
+    page.corners = pageCorners(width, height, 0.12f, height * 0.03f);
+    Frame luma   = renderPage(page, PixelFormat::Gray8);
+    Plane8 mapped;
+
+    for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::NEON }) {
+        if (!detail::toneCurveKernels(level)) continue;
+        ToneMapper mapper(level);
+        bench::Timing timing = bench::measure(count, [&] { mapper.apply(luma.view(), kUltraContrastCurve, mapped); });
+        bench::report(std::string(name) + " ultra contrast " + simdLevelName(level), width, height, timing);
+    }
+}
+
+int main() {
+    run("preview", 1920, 1080, bench::iterations(100));
+    run("still 12MP", 4032, 3024, bench::iterations(10));
+    return 0;
+}
@@ -0,0 +1,62 @@
+//
+//  IRLUnsharpMaskBenchmark.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Cost of the unsharp mask per radius on a 12MP page, which should stay flat, and of the
+//  sharpening fused in the page render compared to a second pass over the rendered page.
+//
+
+#include "IRLBenchmark.hpp"
+#include "IRLPageRenderer.hpp"
+#include "IRLSyntheticPage.hpp"
+#include "IRLUnsharpMask.hpp"
+
+using namespace irl;
+using namespace irl::test;
+
+int main() {
+    SyntheticPage page;
+    page.width   = 4032;
+    page.height  = 3024;
+    page.corners = pageCorners(page.width, page.height, 0.05f, 40.0f);
+    const Frame frame = renderPage(page);
+
+    std::vector<uint8_t> sharpened(frame.pixels.size());
+    for (int radius : { 1, 2, 4, 8, 16 }) {
+        UnsharpMaskOptions options;
+        options.radius = radius;
+        UnsharpMask sharpener(options);
+        const bench::Timing timing = bench::measure(bench::iterations(10), [&] {
+            sharpener.apply(frame.view(), sharpened.data(), frame.stride);
+        });
+
+        char label[96];
+        std::snprintf(label, sizeof(label), "unsharp mask radius %d", radius);
+        bench::report(label, page.width, page.height, timing);
+    }
+
+    PageRenderOptions options;
+    PageRenderer renderer(options);
+    int width, height;
+    renderer.outputSize(page.corners, width, height);
+    const size_t rowBytes = 4 * static_cast<size_t>(width);
+    std::vector<uint8_t> rendered(rowBytes * height), output(rendered.size());
+
+    UnsharpMask sharpener;
+    const bench::Timing separate = bench::measure(bench::iterations(10), [&] {
+        renderer.render(frame.view(), page.corners, rendered.data(), rowBytes);
+        sharpener.apply(ImageView(rendered.data(), width, height, rowBytes, PixelFormat::BGRA8), output.data(), rowBytes);
+    });
+    bench::report("render, then sharpen", width, height, separate);
+
+    options.sharpen = true;
+    renderer.setOptions(options);
+    const bench::Timing fused = bench::measure(bench::iterations(10), [&] {
+        renderer.render(frame.view(), page.corners, output.data(), rowBytes);
+    });
+    bench::report("render and sharpen fused", width, height, fused);
+    std::printf("%-40s intermediate page of the second pass: %.1f MB\n", "render, then sharpen", rendered.size() / 1e6);
+    return 0;
+}
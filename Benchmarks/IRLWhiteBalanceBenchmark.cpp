@@ -0,0 +1,35 @@
+//
+//  IRLWhiteBalanceBenchmark.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Cost of the paper white estimate per grid size. It reads a fixed number of samples, so the
+//  photo size does not matter.
+//
+
+#include "IRLBenchmark.hpp"
+#include "IRLSyntheticPage.hpp"
+#include "IRLWhiteBalance.hpp"
+
+using namespace irl;
+using namespace irl::test;
+
+int main() {
+    SyntheticPage page;
+    page.width   = 4032;
+    page.height  = 3024;
+    page.corners = pageCorners(page.width, page.height, 0.05f, 40.0f);
+    const Frame frame = renderPage(page);
+
+    for (int grid : { 64, 128, 256, 512 }) {
+        WhiteBalanceOptions options;
+        options.grid = grid;
+        const bench::Timing timing = bench::measure(bench::iterations(200), [&] { estimatePaperWhite(frame.view(), page.corners, options); });
+
+        char label[96];
+        std::snprintf(label, sizeof(label), "paper white grid %d", grid);
+        bench::report(label, page.width, page.height, timing);
+    }
+    return 0;
+}
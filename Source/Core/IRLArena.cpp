@@ -0,0 +1,57 @@
+//
+//  IRLArena.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLArena.hpp"
+
+namespace irl {
+
+static size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+Arena::Arena(size_t capacity) {
+    if (capacity > 0) {
+        _capacity = alignUp(capacity, kAlignment);
+        _base     = allocateBlock(_capacity, _block);
+    }
+    // Keep room for a few overflow blocks so a frame that overflows does not also grow this vector
+    _overflow.reserve(16);
+}
+
+uint8_t* Arena::allocateBlock(size_t size, std::unique_ptr<uint8_t[]>& owner) {
+    owner.reset(new uint8_t[size + kAlignment]);
+    _heapAllocations++;
+    const uintptr_t address = reinterpret_cast<uintptr_t>(owner.get());
+    return reinterpret_cast<uint8_t*>(alignUp(address, kAlignment));
+}
+
+void* Arena::allocateBytes(size_t size) {
+    size = alignUp(size == 0 ? 1 : size, kAlignment);
+    _used += size;
+
+    if (_offset + size <= _capacity) {
+        void* result = _base + _offset;
+        _offset += size;
+        return result;
+    }
+
+    _overflow.emplace_back();
+    return allocateBlock(size, _overflow.back());
+}
+
+void Arena::reset() {
+    if (!_overflow.empty()) {
+        // One block for the whole last frame, plus some slack for frames slightly busier than this one
+        _overflow.clear();
+        _capacity = alignUp(_used + _used / 4, kAlignment);
+        _base     = allocateBlock(_capacity, _block);
+    }
+    _offset = 0;
+    _used   = 0;
+}
+
+} // namespace irl
@@ -0,0 +1,93 @@
+//
+//  IRLArena.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Per-frame bump allocator. Everything a frame needs is carved out of one block and
+//  released at once by `reset()` at the start of the next frame.
+//
+//  When a frame needs more than the block, the extra requests are served by separate
+//  overflow blocks and the next `reset()` replaces the block by one big enough for that
+//  frame. After the first frames of a session the arena therefore stops allocating.
+//
+
+#ifndef IRL_ARENA_HPP
+#define IRL_ARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace irl {
+
+/** @brief Non owning array, typically living in an `Arena` */
+template <typename T>
+struct Span {
+    T*  data    = nullptr;
+    int count   = 0;
+
+    Span() = default;
+    Span(T* data, int count) : data(data), count(count) {}
+
+    /** Span<T> converts to Span<const T> */
+    template <typename U>
+    Span(const Span<U>& other) : data(other.data), count(other.count) {}
+
+    T*          begin() const               { return data; }
+    T*          end()   const               { return data + count; }
+    T&          operator[](int index) const { return data[index]; }
+    bool        isEmpty() const             { return count == 0; }
+};
+
+class Arena {
+public:
+    /** @param capacity Initial block size in bytes */
+    explicit Arena(size_t capacity = 0);
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /** @brief Release everything allocated since the last reset. Grows the block if the last frame overflowed. */
+    void reset();
+
+    /**
+     @brief Uninitialized storage for `count` objects of `T`, aligned on a cache line.
+     @discussion Only trivial types can live in the arena: nothing is ever destroyed.
+     */
+    template <typename T>
+    T* allocate(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "Arena objects are never destroyed");
+        static_assert(alignof(T) <= kAlignment, "Arena alignment is a cache line");
+        return static_cast<T*>(allocateBytes(count * sizeof(T)));
+    }
+
+    /** @return Bytes allocated since the last reset */
+    size_t used() const { return _used; }
+
+    /** @return Size of the main block in bytes */
+    size_t capacity() const { return _capacity; }
+
+    /** @return Number of heap allocations done by the arena since it was created */
+    int heapAllocations() const { return _heapAllocations; }
+
+private:
+    static const size_t kAlignment = 64;
+
+    void* allocateBytes(size_t size);
+    uint8_t* allocateBlock(size_t size, std::unique_ptr<uint8_t[]>& owner);
+
+    std::unique_ptr<uint8_t[]>              _block;
+    uint8_t*                                _base       = nullptr;
+    size_t                                  _capacity   = 0;
+    size_t                                  _offset     = 0;
+    size_t                                  _used       = 0;
+    std::vector<std::unique_ptr<uint8_t[]>> _overflow;
+    int                                     _heapAllocations = 0;
+};
+
+} // namespace irl
+
+#endif /* IRL_ARENA_HPP */
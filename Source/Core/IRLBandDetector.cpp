@@ -0,0 +1,71 @@
+//
+//  IRLBandDetector.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLBandDetector.hpp"
+#include "IRLCornerRefiner.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace irl {
+
+BandDetector::BandDetector(const BandDetectorOptions& options)
+: _options(options) {}
+
+bool BandDetector::detect(const ImageView& frame, const Quad& previous, Quad& quad) {
+    _counters.attempts++;
+    if (!detectInBands(frame, previous, quad)) return false;
+    _counters.served++;
+    return true;
+}
+
+bool BandDetector::detectInBands(const ImageView& frame, const Quad& previous, Quad& quad) {
+    if (frame.isEmpty()) return false;
+
+    const int   minimum = std::min(frame.width, frame.height);
+    const int   samples = std::min(std::max(_options.profileSamples, 4), 32);
+    const float band    = std::max(_options.bandWidth * minimum, 4.0f);
+
+    // Coarse search: the profiles span the band with `samples` steps on each side of the previous edge
+    CornerRefinerOptions search;
+    search.searchRadius     = samples;
+    search.profileStep      = std::max(band / samples, 1.0f);
+    search.sampleSpacing    = std::max(search.profileStep, 4.0f);
+    search.maximumSamples   = 48;
+    search.outlierDistance  = search.profileStep;
+    search.minimumContrast  = 8.0f;
+
+    EdgeLine lines[4];
+    for (int k = 0; k < 4; k++) {
+        if (!fitEdgeLine(frame, previous[k], previous[(k + 1) & 3], search, lines[k])) return false;
+        if (lines[k].inliers < _options.minimumInlierRatio * lines[k].samples) return false;
+    }
+
+    // Corner k joins side k - 1 and side k
+    Quad found;
+    for (int k = 0; k < 4; k++) {
+        if (!intersectEdgeLines(lines[(k + 3) & 3], lines[k], found[k])) return false;
+        if (distance(found[k], previous[k]) > 2.0f * band) return false;
+    }
+
+    // The coarse profiles leave up to a step of error, the full resolution refinement removes it
+    CornerRefinerOptions refinement;
+    refinement.searchRadius = std::max(refinement.searchRadius, static_cast<int>(std::ceil(2.0f * search.profileStep)));
+    refineQuad(frame, found, refinement);
+
+    const float minimumSide = _options.minimumFeatureSize * minimum;
+    for (int k = 0; k < 4; k++) {
+        const Point a = found[k], b = found[(k + 1) & 3], c = found[(k + 2) & 3];
+        if (cross(b - a, c - b) <= 0.0f || distance(a, b) < minimumSide) return false;
+        if (a.x < -1.0f || a.y < -1.0f || a.x > frame.width + 1.0f || a.y > frame.height + 1.0f) return false;
+    }
+
+    quad = found;
+    return true;
+}
+
+} // namespace irl
@@ -0,0 +1,83 @@
+//
+//  IRLBandDetector.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Incremental re-detection of a document around its last known quad.
+//
+//  While the phone is held over a page, the page edges move by a few pixels per frame. Instead
+//  of segmenting the whole frame again, only a band around each previous side is searched, with
+//  strided luma profiles across the side: `fitEdgeLine` finds the side in its band, adjacent sides
+//  are intersected and the corners refined at full resolution. A few thousand pixels are read,
+//  whatever the frame size. When a side cannot be found in its band (page moved too far,
+//  occluded, gone) the caller falls back to a full frame detection.
+//
+
+#ifndef IRL_BAND_DETECTOR_HPP
+#define IRL_BAND_DETECTOR_HPP
+
+#include "IRLImage.hpp"
+#include "IRLQuad.hpp"
+
+#include <cstdint>
+
+namespace irl {
+
+/** @brief Tuning of `BandDetector` */
+struct BandDetectorOptions {
+    /** Half width of the band searched around each previous side, as a fraction of the smaller frame dimension. */
+    float   bandWidth           = 0.03f;
+
+    /** Samples read on each half of a profile across the band. Fewer samples are cheaper and coarser. */
+    int     profileSamples      = 12;
+
+    /** Smallest fraction of the profiles of a side that must agree on the new edge. */
+    float   minimumInlierRatio  = 0.5f;
+
+    /** Smallest accepted quad side, as a fraction of the smaller frame dimension (same as `QuadDetectorOptions`). */
+    float   minimumFeatureSize  = 0.5f;
+};
+
+/** @brief How many re-detections the band served, the others fell back to a full detection */
+struct BandDetectorCounters {
+    uint64_t    attempts    = 0;
+    uint64_t    served      = 0;
+
+    /** @return Fraction of the attempts served by the band, 0 before the first attempt */
+    float servedFraction() const { return attempts ? static_cast<float>(served) / attempts : 0.0f; }
+};
+
+/**
+ @brief Re-detection of a quad near its previous position in a BGRA (kCVPixelFormatType_32BGRA) or Gray8 frame.
+ @discussion Buffers are allocated by the first calls and reused afterwards. Not thread safe, use one instance per queue.
+ */
+class BandDetector {
+public:
+    explicit BandDetector(const BandDetectorOptions& options = BandDetectorOptions());
+
+    const BandDetectorOptions&  options() const                                 { return _options; }
+    void                        setOptions(const BandDetectorOptions& options)  { _options = options; }
+
+    /**
+     @brief Find the document of `previous` again in `frame`, reading bands around its sides only.
+     @param previous The last known quad, in buffer coordinates
+     @param quad     The new quad on success, untouched otherwise
+     @return false when the bands do not hold a valid quad: detect on the full frame instead
+     */
+    bool detect(const ImageView& frame, const Quad& previous, Quad& quad);
+
+    /** @return Attempts and successes since creation or the last `resetCounters` */
+    const BandDetectorCounters& counters() const { return _counters; }
+    void                        resetCounters()  { _counters = BandDetectorCounters(); }
+
+private:
+    bool detectInBands(const ImageView& frame, const Quad& previous, Quad& quad);
+
+    BandDetectorOptions     _options;
+    BandDetectorCounters    _counters;
+};
+
+} // namespace irl
+
+#endif /* IRL_BAND_DETECTOR_HPP */
@@ -0,0 +1,202 @@
+//
+//  IRLBinarizer.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLBinarizer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace irl {
+
+Binarizer::Binarizer(const BinarizerOptions& options)
+: _options(options) {}
+
+int Binarizer::windowRadius(int width, int height) const {
+    const int radius = _options.windowRadius > 0 ? _options.windowRadius
+                                                 : static_cast<int>(std::lround(_options.windowFraction * std::min(width, height)));
+    return std::min(std::max(radius, 1), kMaximumWindowRadius);
+}
+
+// MARK: - Bands
+
+void Binarizer::integrate(const ImageView& luma, int first, int last, Band& band) const {
+    // (rows + 1) x (width + 1) sums, the first row and column being 0. Totals wrap around 2^32, but the sums of
+    // a window never exceed it (255² x 255² < 2^32), so differences of wrapped totals are exact.
+    const size_t columns = static_cast<size_t>(luma.width) + 1;
+    const size_t rows    = static_cast<size_t>(last - first) + 1;
+    band.sums.resize(columns * rows);
+    band.squares.resize(columns * rows);
+    std::fill(band.sums.begin(), band.sums.begin() + columns, 0u);
+    std::fill(band.squares.begin(), band.squares.begin() + columns, 0u);
+
+    for (int y = first; y < last; y++) {
+        const uint8_t*  src             = luma.row(y);
+        const size_t    offset          = (static_cast<size_t>(y - first) + 1) * columns;
+        uint32_t*       sums            = band.sums.data() + offset;
+        uint32_t*       squares         = band.squares.data() + offset;
+        const uint32_t* sumsAbove       = sums - columns;
+        const uint32_t* squaresAbove    = squares - columns;
+
+        // Running sums along the row first (serial), then the row above is added (vectorized by the compiler)
+        uint32_t sum = 0, square = 0;
+        sums[0] = 0;
+        squares[0] = 0;
+        for (int x = 0; x < luma.width; x++) {
+            sum    += src[x];
+            square += static_cast<uint32_t>(src[x]) * src[x];
+            sums[x + 1]    = sum;
+            squares[x + 1] = square;
+        }
+        for (size_t x = 1; x < columns; x++) {
+            sums[x]    += sumsAbove[x];
+            squares[x] += squaresAbove[x];
+        }
+    }
+}
+
+/** Black (1) when `value` is below the local threshold of a `count` pixels window of luma `sum` and squared luma `square` */
+template <bool Sauvola>
+static inline uint8_t classify(uint8_t value, uint32_t sum, uint32_t square, float inverse, float k, float range, float bradley) {
+    const float mean = static_cast<float>(sum) * inverse;
+    float limit;
+    if (Sauvola) {
+        const float variance = std::max(static_cast<float>(square) * inverse - mean * mean, 0.0f);
+        limit = mean * (1.0f + k * (std::sqrt(variance) * range - 1.0f));
+    } else {
+        limit = mean * bradley;
+    }
+    return static_cast<float>(value) <= limit ? 1 : 0;
+}
+
+template <bool Sauvola>
+static void thresholdRow(const uint8_t* src, int width, int radius, int rows,
+                         const uint32_t* sumsTop, const uint32_t* sumsBottom, const uint32_t* squaresTop, const uint32_t* squaresBottom,
+                         const BinarizerOptions& options, uint8_t* black) {
+    const float k       = options.k;
+    const float range   = 1.0f / std::max(options.dynamicRange, 1.0f);
+    const float bradley = 1.0f - options.bradleyRatio;
+
+    // Sums of a window: 4 reads in each integral, wrapping arithmetic gives the exact value
+    auto pixel = [&](int x, int left, int right, float inverse) {
+        const uint32_t sum    = sumsBottom[right] - sumsBottom[left] - sumsTop[right] + sumsTop[left];
+        const uint32_t square = squaresBottom[right] - squaresBottom[left] - squaresTop[right] + squaresTop[left];
+        black[x] = classify<Sauvola>(src[x], sum, square, inverse, k, range, bradley);
+    };
+    auto clipped = [&](int x) {
+        const int left  = std::max(x - radius, 0);
+        const int right = std::min(x + radius + 1, width);
+        pixel(x, left, right, 1.0f / static_cast<float>(rows * (right - left)));
+    };
+
+    // Full windows in the middle of the row share one area
+    const int begin = std::min(radius, width);
+    const int end   = std::max(width - radius - 1, begin);
+    for (int x = 0; x < begin; x++) clipped(x);
+    const float inverse = 1.0f / static_cast<float>(rows * (2 * radius + 1));
+    for (int x = begin; x < end; x++) pixel(x, x - radius, x + radius + 1, inverse);
+    for (int x = end; x < width; x++) clipped(x);
+}
+
+void Binarizer::threshold(const ImageView& luma, int y, int first, int last, int radius, Band& band) const {
+    const size_t    columns = static_cast<size_t>(luma.width) + 1;
+    const int       top     = std::max(y - radius, first) - first;
+    const int       bottom  = std::min(y + radius + 1, last) - first;
+
+    band.black.resize(static_cast<size_t>(luma.width));
+    const uint32_t* sumsTop         = band.sums.data()    + static_cast<size_t>(top)    * columns;
+    const uint32_t* sumsBottom      = band.sums.data()    + static_cast<size_t>(bottom) * columns;
+    const uint32_t* squaresTop      = band.squares.data() + static_cast<size_t>(top)    * columns;
+    const uint32_t* squaresBottom   = band.squares.data() + static_cast<size_t>(bottom) * columns;
+
+    if (_options.method == ThresholdMethod::Sauvola) {
+        thresholdRow<true>(luma.row(y), luma.width, radius, bottom - top, sumsTop, sumsBottom, squaresTop, squaresBottom, _options, band.black.data());
+    } else {
+        thresholdRow<false>(luma.row(y), luma.width, radius, bottom - top, sumsTop, sumsBottom, squaresTop, squaresBottom, _options, band.black.data());
+    }
+}
+
+int Binarizer::bandHeight(int radius) const {
+    // Each band integrates one radius above and below it as well, tall enough bands keep that overhead bounded
+    return std::max(_options.bandHeight, 4 * radius);
+}
+
+template <typename Output>
+void Binarizer::run(const ImageView& window, int top, int height, int first, int last, int radius, Output&& output) {
+    TileExecutor& executor = executorForThreads(_options.threads, _executor);
+    if (static_cast<int>(_bands.size()) < executor.threadCount()) _bands.resize(static_cast<size_t>(executor.threadCount()));
+
+    executor.runBands(window.width, last - first, bandHeight(radius), [&](const Tile& tile, int worker) {
+        Band& band = _bands[static_cast<size_t>(worker)];
+        const int begin = first + tile.y;
+        const int end   = begin + tile.height;
+        // Rows of `window`
+        const int above = std::max(begin - radius, 0) - top;
+        const int below = std::min(end + radius, height) - top;
+        integrate(window, above, below, band);
+        for (int y = begin; y < end; y++) {
+            threshold(window, y - top, above, below, radius, band);
+            output(y, band.black.data());
+        }
+    });
+}
+
+// MARK: - Outputs
+
+static void packRow(const uint8_t* black, int width, BitPlane& bits, int y) {
+    uint8_t* dst = bits.row(y);
+    std::memset(dst, 0, bits.stride());
+    for (int x = 0; x < width; x++) dst[x >> 3] |= static_cast<uint8_t>(black[x] << (7 - (x & 7)));
+}
+
+void Binarizer::binarize(const ImageView& luma, BitPlane& bits) {
+    assert(luma.format == PixelFormat::Gray8);
+    bits.resize(luma.width, luma.height);
+    if (luma.isEmpty()) return;
+
+    const int width = luma.width;
+    run(luma, 0, luma.height, 0, luma.height, windowRadius(luma.width, luma.height), [&](int y, const uint8_t* black) {
+        packRow(black, width, bits, y);
+    });
+}
+
+void Binarizer::binarize(const ImageView& luma, Plane8& gray) {
+    assert(luma.format == PixelFormat::Gray8);
+    gray.resize(luma.width, luma.height);
+    if (luma.isEmpty()) return;
+
+    const int width = luma.width;
+    run(luma, 0, luma.height, 0, luma.height, windowRadius(luma.width, luma.height), [&](int y, const uint8_t* black) {
+        uint8_t* dst = gray.row(y);
+        for (int x = 0; x < width; x++) dst[x] = black[x] ? 0 : 255;
+    });
+}
+
+void Binarizer::binarizeRows(int width, int height, RowSource rows, void* context, BitPlane& bits) {
+    bits.resize(std::max(width, 0), std::max(height, 0));
+    if (width <= 0 || height <= 0) return;
+
+    // One band per worker at a time, with the rows their windows reach above and below
+    const int radius  = windowRadius(width, height);
+    const int workers = executorForThreads(_options.threads, _executor).threadCount();
+    const int step    = bandHeight(radius) * workers;
+    for (int first = 0; first < height; first += step) {
+        const int last  = std::min(first + step, height);
+        const int top   = std::max(first - radius, 0);
+        const int count = std::min(last + radius, height) - top;
+        _window.resize(static_cast<size_t>(width) * static_cast<size_t>(count));
+        rows(context, top, count, _window.data(), static_cast<size_t>(width));
+
+        const ImageView window(_window.data(), width, count, static_cast<size_t>(width), PixelFormat::Gray8);
+        run(window, top, height, first, last, radius, [&](int y, const uint8_t* black) {
+            packRow(black, width, bits, y);
+        });
+    }
+}
+
+} // namespace irl
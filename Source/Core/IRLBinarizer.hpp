@@ -0,0 +1,136 @@
+//
+//  IRLBinarizer.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Adaptive black and white conversion of a document: every pixel is compared with a threshold
+//  computed from the mean (Bradley) or the mean and standard deviation (Sauvola) of the luma in a
+//  window around it, so shadows and uneven lighting do not turn text gray or paper black.
+//
+//  Window sums come from integral images of the luma and of its square, four reads per pixel
+//  whatever the window size. Integral images are built per band of rows, with a halo of one
+//  window radius, so the memory stays small and the bands can run on several threads. A page
+//  rendered in bands can be binarized as it comes: only the rows of a few bands are held.
+//
+
+#ifndef IRL_BINARIZER_HPP
+#define IRL_BINARIZER_HPP
+
+#include "IRLImage.hpp"
+#include "IRLTileExecutor.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace irl {
+
+/** Largest window radius: the sums of squares of a 255 x 255 window still fit in 32 bits */
+static const int kMaximumWindowRadius = 127;
+
+/** @brief Local threshold formula */
+enum class ThresholdMethod : uint8_t {
+    Sauvola,    ///< mean * (1 + k * (deviation / dynamicRange - 1))
+    Bradley     ///< mean * (1 - bradleyRatio)
+};
+
+/** @brief Tuning of `Binarizer` */
+struct BinarizerOptions {
+    ThresholdMethod method      = ThresholdMethod::Sauvola;
+
+    /** Half size of the window, in pixels, up to `kMaximumWindowRadius`. 0 to use `windowFraction` instead. */
+    int     windowRadius        = 0;
+
+    /** Half size of the window as a fraction of the smaller image dimension, when `windowRadius` is 0. */
+    float   windowFraction      = 0.01f;
+
+    /** Sauvola sensitivity: higher values make more pixels white. */
+    float   k                   = 0.2f;
+
+    /** Sauvola dynamic range of the standard deviation. */
+    float   dynamicRange        = 128.0f;
+
+    /** Bradley: a pixel darker than the window mean by more than this fraction is black. */
+    float   bradleyRatio        = 0.15f;
+
+    /** Rows per band, the unit of work of a thread. Raised to 4 window radii at least. */
+    int     bandHeight          = 128;
+
+    /** Threads used for one image, 0 to share `TileExecutor::shared()` with the other stages. */
+    int     threads             = 0;
+};
+
+/**
+ @brief Local mean / variance binarization of luma planes.
+ @discussion Every band gives the same result whatever the band height and thread count.
+ Band buffers are kept between calls. Not thread safe, use one instance per queue.
+ */
+class Binarizer {
+public:
+    explicit Binarizer(const BinarizerOptions& options = BinarizerOptions());
+
+    const BinarizerOptions& options() const                         { return _options; }
+    void                    setOptions(const BinarizerOptions& options) { _options = options; }
+
+    /** @return The window radius used for a `width` x `height` image */
+    int windowRadius(int width, int height) const;
+
+    /**
+     @brief Binarize `luma` into packed bits, a set bit being black.
+     @param luma A Gray8 view, e.g. the Y plane of a bi-planar frame or a rectified still
+     */
+    void binarize(const ImageView& luma, BitPlane& bits);
+
+    /** @brief Same as above, black 0 and white 255, for display */
+    void binarize(const ImageView& luma, Plane8& gray);
+
+    /**
+     @brief Binarize a `width` x `height` luma image handed over in bands of rows, never whole in memory. The bits are the same as
+     for the whole image.
+     @discussion `rows(int top, int count, uint8_t* destination, size_t stride)` writes Gray8 rows `top` to `top + count - 1`, e.g.
+     from `PageRenderer::renderRows`. It is called in turn from the calling thread, for one band per worker and the window radius
+     around them, so it may run its own stages on an executor. The rows around two calls are asked for twice.
+     */
+    template <typename Rows>
+    void binarize(int width, int height, Rows&& rows, BitPlane& bits) {
+        binarizeRows(width, height, &invokeRows<typename std::remove_reference<Rows>::type>, &rows, bits);
+    }
+
+private:
+    typedef void (*RowSource)(void* rows, int top, int count, uint8_t* destination, size_t stride);
+
+    template <typename Rows>
+    static void invokeRows(void* rows, int top, int count, uint8_t* destination, size_t stride) {
+        (*static_cast<Rows*>(rows))(top, count, destination, stride);
+    }
+
+
+    struct Band {
+        std::vector<uint32_t>   sums;
+        std::vector<uint32_t>   squares;
+        std::vector<uint8_t>    black;
+    };
+
+    void binarizeRows(int width, int height, RowSource rows, void* context, BitPlane& bits);
+
+    /** @return Rows of a band for a window of `radius` */
+    int bandHeight(int radius) const;
+
+    /** Rows `first` to `last - 1` of a `height` rows image, from `window` holding its rows from `top`, the radius around them included */
+    template <typename Output>
+    void run(const ImageView& window, int top, int height, int first, int last, int radius, Output&& output);
+
+    void integrate(const ImageView& luma, int first, int last, Band& band) const;
+    void threshold(const ImageView& luma, int y, int first, int last, int radius, Band& band) const;
+
+    BinarizerOptions                _options;
+    std::vector<Band>               _bands;     // one per worker
+    std::vector<uint8_t>            _window;    // rows handed over by `binarizeRows`
+    std::unique_ptr<TileExecutor>   _executor;  // when `threads` is set
+};
+
+} // namespace irl
+
+#endif /* IRL_BINARIZER_HPP */
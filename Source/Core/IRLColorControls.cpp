@@ -0,0 +1,178 @@
+//
+//  IRLColorControls.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLColorControls.hpp"
+#include "IRLColorKernels.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace irl {
+namespace detail {
+
+// MARK: - Scalar kernels
+
+static void mixRowScalar(const uint8_t* source, uint8_t* destination, int width, const ColorTables& tables) {
+    for (int x = 0; x < width; x++) mixPixel(source + 4 * x, destination + 4 * x, tables);
+}
+
+static void grayRowScalar(const uint8_t* source, uint8_t* destination, int width, const ColorTables& tables) {
+    for (int x = 0; x < width; x++) grayPixel(source + 4 * x, destination + 4 * x, tables);
+}
+
+static void directRowScalar(const uint8_t* source, uint8_t* destination, int width, const ColorTables& tables) {
+    for (int x = 0; x < width; x++) directPixel(source + 4 * x, destination + 4 * x, tables);
+}
+
+const ColorKernels* colorKernelsScalar() {
+    static const ColorKernels kernels = { mixRowScalar, grayRowScalar, directRowScalar };
+    return &kernels;
+}
+
+const ColorKernels* colorKernels(SimdLevel level) {
+    if (!isSimdLevelSupported(level)) return nullptr;
+    switch (level) {
+        case SimdLevel::Scalar: return colorKernelsScalar();
+        case SimdLevel::SSE41:  return colorKernelsSSE41();
+        case SimdLevel::AVX2:   return colorKernelsAVX2();
+        case SimdLevel::NEON:   return colorKernelsNEON();
+    }
+    return nullptr;
+}
+
+// MARK: - Tables
+
+static double decodeSRGB(double v) {
+    return v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4);
+}
+
+static double encodeSRGB(double v) {
+    return v <= 0.0031308 ? v * 12.92 : 1.055 * std::pow(v, 1.0 / 2.4) - 0.055;
+}
+
+static int32_t toFixed(double v) {
+    return static_cast<int32_t>(std::lround(v * kColorOne));
+}
+
+static void buildTables(const ColorControlsOptions& options, ColorTables& tables) {
+    const bool linear = options.linear;
+    for (int v = 0; v < 256; v++) {
+        const double value = linear ? decodeSRGB(v / 255.0) : v / 255.0;
+        double gained[3];
+        for (int c = 0; c < 3; c++) {
+            gained[c] = std::min(value * std::max(static_cast<double>(options.gains[c]), 0.0), 1.0);
+            tables.decode[c][v] = toFixed(gained[c]);
+        }
+        tables.lumaR[v]  = toFixed(0.2125 * gained[2]);
+        tables.lumaG[v]  = toFixed(0.7154 * gained[1]);
+        tables.lumaB[v]  = toFixed(0.0721 * gained[0]);
+    }
+
+    for (int i = 0; i <= kColorOne; i++) {
+        double value = (static_cast<double>(i) / kColorOne + options.brightness - 0.5) * options.contrast + 0.5;
+        value = std::min(std::max(value, 0.0), 1.0);
+        if (linear) value = encodeSRGB(value);
+        tables.encode[i] = static_cast<uint8_t>(std::lround(value * 255.0));
+    }
+    for (int i = kColorOne + 1; i < kColorOne + 4; i++) tables.encode[i] = 0;
+
+    for (int c = 0; c < 3; c++) {
+        for (int v = 0; v < 256; v++) tables.direct[c][v] = tables.encode[tables.decode[c][v]];
+    }
+    tables.saturation = toFixed(std::min(std::max(static_cast<double>(options.saturation), 0.0), 1.0));
+
+    // Byte tables of the shuffle kernels
+    const int32_t* luma[3] = { tables.lumaB, tables.lumaG, tables.lumaR };
+    for (int c = 0; c < 3; c++) {
+        for (int v = 0; v < 256; v++) {
+            tables.directBytes[c][v] = static_cast<uint8_t>(tables.direct[c][v]);
+            tables.lumaLow[c][v]     = static_cast<uint8_t>(luma[c][v]);
+            tables.lumaHigh[c][v]    = static_cast<uint8_t>(luma[c][v] >> 8);
+        }
+    }
+
+    // First value of each encoded byte, then the levels of the search
+    tables.searchable = std::is_sorted(tables.encode, tables.encode + kColorOne + 1);
+    int thresholds[256];
+    std::fill(thresholds, thresholds + 256, kColorOne + 1);
+    for (int i = 0, next = 0; i <= kColorOne && next < 256; i++) {
+        while (next < 256 && next <= tables.encode[i]) thresholds[next++] = i;
+    }
+    tables.searchLow[0] = tables.searchHigh[0] = 0;
+    for (int level = 0; level < 8; level++) {
+        const int step = 128 >> level;
+        for (int j = 0; j < (1 << level); j++) {
+            const int threshold = thresholds[(2 * j + 1) * step];
+            tables.searchLow[(1 << level) + j]  = static_cast<uint8_t>(threshold);
+            tables.searchHigh[(1 << level) + j] = static_cast<uint8_t>(threshold >> 8);
+        }
+    }
+}
+
+} // namespace detail
+
+// MARK: - ColorControls
+
+ColorControls::ColorControls(const ColorControlsOptions& options, SimdLevel level)
+: _level(level)
+, _kernels(detail::colorKernels(level))
+, _tables(new detail::ColorTables()) {
+    if (!_kernels) {
+        _level   = SimdLevel::Scalar;
+        _kernels = detail::colorKernelsScalar();
+    }
+    setOptions(options);
+}
+
+ColorControls::~ColorControls() = default;
+
+void ColorControls::setOptions(const ColorControlsOptions& options) {
+    _options = options;
+    detail::buildTables(options, *_tables);
+}
+
+void ColorControls::filterRow(const uint8_t* source, uint8_t* destination, int width) const {
+    if (_tables->saturation == detail::kColorOne)   _kernels->directRow(source, destination, width, *_tables);
+    else if (_tables->saturation == 0)              _kernels->grayRow(source, destination, width, *_tables);
+    else                                            _kernels->mixRow(source, destination, width, *_tables);
+}
+
+void ColorControls::apply(const ImageView& source, uint8_t* destination, size_t stride) {
+    if (source.isEmpty()) return;
+
+    if (source.format == PixelFormat::BGRA8) {
+        for (int y = 0; y < source.height; y++) {
+            filterRow(source.row(y), destination + static_cast<size_t>(y) * stride, source.width);
+        }
+        return;
+    }
+
+    // Gray rows are expanded in the destination row, then filtered in place
+    for (int y = 0; y < source.height; y++) {
+        const uint8_t*  src = source.row(y);
+        uint8_t*        dst = destination + static_cast<size_t>(y) * stride;
+        for (int x = 0; x < source.width; x++) {
+            dst[4 * x + 0] = dst[4 * x + 1] = dst[4 * x + 2] = src[x];
+            dst[4 * x + 3] = 255;
+        }
+        filterRow(dst, dst, source.width);
+    }
+}
+
+void ColorControls::apply(const BiPlanarView& source, uint8_t* destination, size_t stride) {
+    if (source.isEmpty()) return;
+
+    for (int y = 0; y < source.luma.height; y++) {
+        uint8_t* dst = destination + static_cast<size_t>(y) * stride;
+        const BiPlanarView row(source.luma.row(y), source.luma.width, 1, source.luma.stride, source.chromaRow(y >> 1), source.chromaStride);
+        convertToBGRA(row, dst, stride);
+        filterRow(dst, dst, source.luma.width);
+    }
+}
+
+} // namespace irl
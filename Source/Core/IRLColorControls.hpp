@@ -0,0 +1,108 @@
+//
+//  IRLColorControls.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Saturation, brightness and contrast in one pass over the pixels, the CPU counterpart of the
+//  `CIColorControls` filter behind the Enhance (black and white) and Contrast scanner views.
+//
+//  CoreImage runs the filter in a linear working space: pixels are decoded from sRGB, mixed
+//  with their luminance (Rec. 709 weights 0.2125, 0.7154, 0.0721), offset by the brightness,
+//  stretched around 0.5 by the contrast, clamped and encoded back. The same chain is folded
+//  here into a few lookup tables with Q14 linear values: every output byte is within 1 of the
+//  formula evaluated in double precision, and within 1 of the float16 working values of a GPU
+//  CIContext on the gray ramps of both presets (Tests/IRLColorControlsTests.cpp).
+//
+
+#ifndef IRL_COLOR_CONTROLS_HPP
+#define IRL_COLOR_CONTROLS_HPP
+
+#include "IRLImage.hpp"
+#include "IRLSimd.hpp"
+
+#include <memory>
+
+namespace irl {
+
+namespace detail { struct ColorKernels; struct ColorTables; }
+
+/** @brief Parameters of `ColorControls`, same meaning as the inputs of `CIColorControls` */
+struct ColorControlsOptions {
+    /** 0 gives the luminance, 1 keeps the colors. Clamped to [0, 1]. */
+    float   saturation  = 1.0f;
+
+    /** Added to every channel, in linear light. */
+    float   brightness  = 0.0f;
+
+    /** Slope around mid gray, in linear light. */
+    float   contrast    = 1.0f;
+
+    /** Apply the chain on linear values like the default CoreImage working space, on the encoded values otherwise. */
+    bool    linear      = true;
+
+    /** Blue, green and red multipliers of the (linear) values, applied first: the white balance of `estimatePaperWhite`. Clamped to 1. */
+    float   gains[3]    = { 1.0f, 1.0f, 1.0f };
+};
+
+/** @return The options of the Enhance filter (IRLScannerViewTypeBlackAndWhite): contrast 1.14, saturation 0 */
+inline ColorControlsOptions enhanceColorControls() {
+    ColorControlsOptions options;
+    options.contrast    = 1.14f;
+    options.saturation  = 0.0f;
+    return options;
+}
+
+/** @return The options of the Contrast filter (IRLScannerViewTypeNormal): contrast 1.1 */
+inline ColorControlsOptions contrastColorControls() {
+    ColorControlsOptions options;
+    options.contrast    = 1.1f;
+    return options;
+}
+
+/**
+ @brief Fused CIColorControls on BGRA8, Gray8 and bi-planar frames.
+ @discussion Each row is converted and filtered while it is in cache, the output is always BGRA8.
+ Every variant gives the same bytes as the scalar reference. AVX2 gathers from the tables 8 pixels at a time. NEON and
+ SSE4.1 have no gathers: they read byte tables 16 pixels at a time, and encode the luminance of the Enhance filter
+ with a binary search of the first value of each output byte. On x86 the 16 entries shuffles of SSE4.1 cost more than
+ the scalar loads (see IRLColorControlsBenchmark); NEON reads 64 entries per lookup. Saturations other than 0 and 1
+ keep the scalar kernel on both.
+ Not thread safe, use one instance per queue.
+ */
+class ColorControls {
+public:
+    /** @param level Kernel variant. An unsupported level falls back to the scalar reference. */
+    explicit ColorControls(const ColorControlsOptions& options = ColorControlsOptions(), SimdLevel level = bestSimdLevel());
+    ~ColorControls();
+
+    const ColorControlsOptions& options() const { return _options; }
+
+    /** @brief Change the parameters, the tables are rebuilt (about 20 µs) */
+    void setOptions(const ColorControlsOptions& options);
+
+    /** @return The kernel variant actually used */
+    SimdLevel simdLevel() const { return _level; }
+
+    /**
+     @brief Filter `source` into `destination`.
+     @param destination At least `source.height` rows of `stride` bytes. May be `source.data` itself for a BGRA8 source.
+     */
+    void apply(const ImageView& source, uint8_t* destination, size_t stride);
+
+    /** @brief Filter a bi-planar frame, converted to BGRA row by row on the way */
+    void apply(const BiPlanarView& source, uint8_t* destination, size_t stride);
+
+private:
+    void filterRow(const uint8_t* source, uint8_t* destination, int width) const;
+
+    ColorControlsOptions                    _options;
+    SimdLevel                               _level;
+    const detail::ColorKernels*             _kernels;
+    std::unique_ptr<detail::ColorTables>    _tables;
+    std::vector<uint8_t>                    _row;
+};
+
+} // namespace irl
+
+#endif /* IRL_COLOR_CONTROLS_HPP */
@@ -0,0 +1,103 @@
+//
+//  IRLColorControlsAVX2.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  AVX2 color kernels, 8 pixels per iteration in 32 bit lanes, table lookups with gathers.
+//
+
+#include "IRLColorKernels.hpp"
+
+#if IRL_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace irl {
+namespace detail {
+
+#if IRL_SIMD_X86
+
+IRL_TARGET_AVX2 static inline __m256i channel(__m256i pixels, int shift) {
+    return _mm256_and_si256(_mm256_srli_epi32(pixels, shift), _mm256_set1_epi32(0xFF));
+}
+
+IRL_TARGET_AVX2 static inline __m256i gather(const int32_t* table, __m256i index) {
+    return _mm256_i32gather_epi32(reinterpret_cast<const int*>(table), index, 4);
+}
+
+/** encode[index] in the low byte of each lane, the table being read 4 bytes at a time */
+IRL_TARGET_AVX2 static inline __m256i encode(const ColorTables& tables, __m256i index) {
+    const __m256i bytes = _mm256_i32gather_epi32(reinterpret_cast<const int*>(tables.encode), index, 1);
+    return _mm256_and_si256(bytes, _mm256_set1_epi32(0xFF));
+}
+
+IRL_TARGET_AVX2 static inline __m256i luma(const ColorTables& tables, __m256i b, __m256i g, __m256i r) {
+    const __m256i sum = _mm256_add_epi32(_mm256_add_epi32(gather(tables.lumaR, r), gather(tables.lumaG, g)), gather(tables.lumaB, b));
+    return _mm256_min_epi32(sum, _mm256_set1_epi32(kColorOne));
+}
+
+IRL_TARGET_AVX2 static inline __m256i pack(__m256i pixels, __m256i b, __m256i g, __m256i r) {
+    const __m256i alpha = _mm256_and_si256(pixels, _mm256_set1_epi32(static_cast<int>(0xFF000000u)));
+    return _mm256_or_si256(_mm256_or_si256(alpha, b), _mm256_or_si256(_mm256_slli_epi32(g, 8), _mm256_slli_epi32(r, 16)));
+}
+
+/** (saturation * decode[value] + weightedLuma) >> 14, encoded. `weightedLuma` already holds the complement weight and the rounding. */
+IRL_TARGET_AVX2 static inline __m256i mix(const ColorTables& tables, const int32_t* decode, __m256i saturation, __m256i value, __m256i weightedLuma) {
+    const __m256i mixed = _mm256_add_epi32(_mm256_mullo_epi32(saturation, gather(decode, value)), weightedLuma);
+    return encode(tables, _mm256_srai_epi32(mixed, kColorShift));
+}
+
+IRL_TARGET_AVX2 static void mixRowAVX2(const uint8_t* source, uint8_t* destination, int width, const ColorTables& tables) {
+    const __m256i saturation = _mm256_set1_epi32(tables.saturation);
+    const __m256i complement = _mm256_set1_epi32(kColorOne - tables.saturation);
+    const __m256i half       = _mm256_set1_epi32(kColorOne >> 1);
+
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + 4 * x));
+        const __m256i b = channel(pixels, 0), g = channel(pixels, 8), r = channel(pixels, 16);
+        const __m256i weightedLuma = _mm256_add_epi32(_mm256_mullo_epi32(complement, luma(tables, b, g, r)), half);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + 4 * x),
+                            pack(pixels, mix(tables, tables.decode[0], saturation, b, weightedLuma),
+                                 mix(tables, tables.decode[1], saturation, g, weightedLuma),
+                                 mix(tables, tables.decode[2], saturation, r, weightedLuma)));
+    }
+    for (; x < width; x++) mixPixel(source + 4 * x, destination + 4 * x, tables);
+}
+
+IRL_TARGET_AVX2 static void grayRowAVX2(const uint8_t* source, uint8_t* destination, int width, const ColorTables& tables) {
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + 4 * x));
+        const __m256i v = encode(tables, luma(tables, channel(pixels, 0), channel(pixels, 8), channel(pixels, 16)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + 4 * x), pack(pixels, v, v, v));
+    }
+    for (; x < width; x++) grayPixel(source + 4 * x, destination + 4 * x, tables);
+}
+
+IRL_TARGET_AVX2 static void directRowAVX2(const uint8_t* source, uint8_t* destination, int width, const ColorTables& tables) {
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + 4 * x));
+        const __m256i b = gather(tables.direct[0], channel(pixels, 0));
+        const __m256i g = gather(tables.direct[1], channel(pixels, 8));
+        const __m256i r = gather(tables.direct[2], channel(pixels, 16));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + 4 * x), pack(pixels, b, g, r));
+    }
+    for (; x < width; x++) directPixel(source + 4 * x, destination + 4 * x, tables);
+}
+
+const ColorKernels* colorKernelsAVX2() {
+    static const ColorKernels kernels = { mixRowAVX2, grayRowAVX2, directRowAVX2 };
+    return &kernels;
+}
+
+#else
+
+const ColorKernels* colorKernelsAVX2() { return nullptr; }
+
+#endif
+
+} // namespace detail
+} // namespace irl
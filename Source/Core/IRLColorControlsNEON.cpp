@@ -0,0 +1,105 @@
+//
+//  IRLColorControlsNEON.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  NEON color kernels, 16 pixels per iteration in byte lanes. The tables are read with 64 entries
+//  table lookups: the Q14 luminance is summed from its low and high bytes, and encoded by a
+//  binary search of the thresholds of the output bytes.
+//
+
+#include "IRLColorKernels.hpp"
+
+#if IRL_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace irl {
+namespace detail {
+
+#if IRL_SIMD_NEON
+
+/** table[index] for tables of `size` bytes, 16, 32 or a multiple of 64. tbl writes 0 past the table, tbx keeps the previous value. */
+static inline uint8x16_t lookup(const uint8_t* table, int size, uint8x16_t index) {
+    if (size <= 16) return vqtbl1q_u8(vld1q_u8(table), index);
+    if (size <= 32) return vqtbl2q_u8(vld1q_u8_x2(table), index);
+    uint8x16_t result = vqtbl4q_u8(vld1q_u8_x4(table), index);
+    for (int offset = 64; offset < size; offset += 64) {
+        index  = vsubq_u8(index, vdupq_n_u8(64));
+        result = vqtbx4q_u8(result, vld1q_u8_x4(table + offset), index);
+    }
+    return result;
+}
+
+/** Q14 luminance of the 16 pixels, pixels 0 ... 7 in `low` and 8 ... 15 in `high` */
+static inline void luma(const ColorTables& tables, const uint8x16x4_t& pixels, uint16x8_t& low, uint16x8_t& high) {
+    low = high = vdupq_n_u16(0);
+    for (int c = 0; c < 3; c++) {
+        const uint8x16_t lowBytes  = lookup(tables.lumaLow[c],  256, pixels.val[c]);
+        const uint8x16_t highBytes = lookup(tables.lumaHigh[c], 256, pixels.val[c]);
+        low  = vaddq_u16(low,  vreinterpretq_u16_u8(vzip1q_u8(lowBytes, highBytes)));
+        high = vaddq_u16(high, vreinterpretq_u16_u8(vzip2q_u8(lowBytes, highBytes)));
+    }
+    low  = vminq_u16(low,  vdupq_n_u16(kColorOne));
+    high = vminq_u16(high, vdupq_n_u16(kColorOne));
+}
+
+/** encode[value] by `searchEncode`: each level doubles the index and adds 1 where its threshold is reached */
+static inline uint8x16_t encode(const ColorTables& tables, uint16x8_t low, uint16x8_t high) {
+    uint8x16_t index = vdupq_n_u8(0);
+    for (int level = 0; level < 8; level++) {
+        const int size = 1 << level;
+        const uint8x16_t thresholdLow  = lookup(tables.searchLow  + size, size, index);
+        const uint8x16_t thresholdHigh = lookup(tables.searchHigh + size, size, index);
+        const uint16x8_t reachedLow    = vcleq_u16(vreinterpretq_u16_u8(vzip1q_u8(thresholdLow, thresholdHigh)), low);
+        const uint16x8_t reachedHigh   = vcleq_u16(vreinterpretq_u16_u8(vzip2q_u8(thresholdLow, thresholdHigh)), high);
+        const uint8x16_t reached       = vcombine_u8(vmovn_u16(reachedLow), vmovn_u16(reachedHigh));
+        index = vsubq_u8(vaddq_u8(index, index), reached);
+    }
+    return index;
+}
+
+static void grayRowNEON(const uint8_t* source, uint8_t* destination, int width, const ColorTables& tables) {
+    int x = 0;
+    if (tables.searchable) {
+        for (; x + 16 <= width; x += 16) {
+            uint8x16x4_t pixels = vld4q_u8(source + 4 * x);
+            uint16x8_t low, high;
+            luma(tables, pixels, low, high);
+            const uint8x16_t v = encode(tables, low, high);
+            pixels.val[0] = pixels.val[1] = pixels.val[2] = v;
+            vst4q_u8(destination + 4 * x, pixels);
+        }
+    }
+    for (; x < width; x++) grayPixel(source + 4 * x, destination + 4 * x, tables);
+}
+
+static void directRowNEON(const uint8_t* source, uint8_t* destination, int width, const ColorTables& tables) {
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        uint8x16x4_t pixels = vld4q_u8(source + 4 * x);
+        for (int c = 0; c < 3; c++) pixels.val[c] = lookup(tables.directBytes[c], 256, pixels.val[c]);
+        vst4q_u8(destination + 4 * x, pixels);
+    }
+    for (; x < width; x++) directPixel(source + 4 * x, destination + 4 * x, tables);
+}
+
+static void mixRowNEON(const uint8_t* source, uint8_t* destination, int width, const ColorTables& tables) {
+    // No scanner view mixes a share of the luminance in, this one keeps the scalar kernel
+    for (int x = 0; x < width; x++) mixPixel(source + 4 * x, destination + 4 * x, tables);
+}
+
+const ColorKernels* colorKernelsNEON() {
+    static const ColorKernels kernels = { mixRowNEON, grayRowNEON, directRowNEON };
+    return &kernels;
+}
+
+#else
+
+const ColorKernels* colorKernelsNEON() { return nullptr; }
+
+#endif
+
+} // namespace detail
+} // namespace irl
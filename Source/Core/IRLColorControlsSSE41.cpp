@@ -0,0 +1,129 @@
+//
+//  IRLColorControlsSSE41.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  SSE4.1 color kernels, 16 pixels per iteration in byte lanes. Without gathers the tables are
+//  read with shuffles of 16 entries: the Q14 luminance is summed from its low and high bytes,
+//  and encoded by a binary search of the thresholds of the output bytes.
+//
+
+#include "IRLColorKernels.hpp"
+
+#if IRL_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace irl {
+namespace detail {
+
+#if IRL_SIMD_X86
+
+/** table[index] for tables of `size` bytes, a multiple of 16. Shuffle g only sees the bytes of 16g ... 16g + 15 (see IRLToneCurveSSE41.cpp). */
+IRL_TARGET_SSE41 static inline __m128i lookup(const uint8_t* table, int size, __m128i index) {
+    const __m128i outside = _mm_set1_epi8(0x70);
+    __m128i result = _mm_setzero_si128();
+    for (int g = 0; g < size / 16; g++) {
+        const __m128i part  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(table + 16 * g));
+        const __m128i local = _mm_adds_epu8(_mm_xor_si128(index, _mm_set1_epi8(static_cast<char>(16 * g))), outside);
+        result = _mm_or_si128(result, _mm_shuffle_epi8(part, local));
+    }
+    return result;
+}
+
+/** 16 BGRA pixels split into their channels */
+IRL_TARGET_SSE41 static inline void loadPixels(const uint8_t* source, __m128i& b, __m128i& g, __m128i& r, __m128i& a) {
+    const __m128i order = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+    const __m128i q0 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source)),      order);
+    const __m128i q1 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 16)), order);
+    const __m128i q2 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 32)), order);
+    const __m128i q3 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 48)), order);
+    const __m128i bg01 = _mm_unpacklo_epi32(q0, q1), bg23 = _mm_unpacklo_epi32(q2, q3);
+    const __m128i ra01 = _mm_unpackhi_epi32(q0, q1), ra23 = _mm_unpackhi_epi32(q2, q3);
+    b = _mm_unpacklo_epi64(bg01, bg23);
+    g = _mm_unpackhi_epi64(bg01, bg23);
+    r = _mm_unpacklo_epi64(ra01, ra23);
+    a = _mm_unpackhi_epi64(ra01, ra23);
+}
+
+IRL_TARGET_SSE41 static inline void storePixels(uint8_t* destination, __m128i b, __m128i g, __m128i r, __m128i a) {
+    const __m128i bgLow = _mm_unpacklo_epi8(b, g), bgHigh = _mm_unpackhi_epi8(b, g);
+    const __m128i raLow = _mm_unpacklo_epi8(r, a), raHigh = _mm_unpackhi_epi8(r, a);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(destination),      _mm_unpacklo_epi16(bgLow, raLow));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + 16), _mm_unpackhi_epi16(bgLow, raLow));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + 32), _mm_unpacklo_epi16(bgHigh, raHigh));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + 48), _mm_unpackhi_epi16(bgHigh, raHigh));
+}
+
+/** Q14 luminance of the 16 pixels, pixels 0 ... 7 in `low` and 8 ... 15 in `high` */
+IRL_TARGET_SSE41 static inline void luma(const ColorTables& tables, const __m128i channels[3], __m128i& low, __m128i& high) {
+    low = high = _mm_setzero_si128();
+    for (int c = 0; c < 3; c++) {
+        const __m128i lowBytes  = lookup(tables.lumaLow[c],  256, channels[c]);
+        const __m128i highBytes = lookup(tables.lumaHigh[c], 256, channels[c]);
+        low  = _mm_add_epi16(low,  _mm_unpacklo_epi8(lowBytes, highBytes));
+        high = _mm_add_epi16(high, _mm_unpackhi_epi8(lowBytes, highBytes));
+    }
+    low  = _mm_min_epu16(low,  _mm_set1_epi16(kColorOne));
+    high = _mm_min_epu16(high, _mm_set1_epi16(kColorOne));
+}
+
+/** encode[value] by `searchEncode`: each level doubles the index and adds 1 where its threshold is reached */
+IRL_TARGET_SSE41 static inline __m128i encode(const ColorTables& tables, __m128i low, __m128i high) {
+    __m128i index = _mm_setzero_si128();
+    for (int level = 0; level < 8; level++) {
+        const int size = 1 << level;
+        const __m128i thresholdLow  = lookup(tables.searchLow  + size, size < 16 ? 16 : size, index);
+        const __m128i thresholdHigh = lookup(tables.searchHigh + size, size < 16 ? 16 : size, index);
+        // Values and thresholds are below 2^15, the signed compare is fine
+        const __m128i above = _mm_packs_epi16(_mm_cmpgt_epi16(_mm_unpacklo_epi8(thresholdLow, thresholdHigh), low),
+                                              _mm_cmpgt_epi16(_mm_unpackhi_epi8(thresholdLow, thresholdHigh), high));
+        index = _mm_add_epi8(_mm_add_epi8(index, index), _mm_andnot_si128(above, _mm_set1_epi8(1)));
+    }
+    return index;
+}
+
+IRL_TARGET_SSE41 static void grayRowSSE41(const uint8_t* source, uint8_t* destination, int width, const ColorTables& tables) {
+    int x = 0;
+    if (tables.searchable) {
+        for (; x + 16 <= width; x += 16) {
+            __m128i channels[3], a, low, high;
+            loadPixels(source + 4 * x, channels[0], channels[1], channels[2], a);
+            luma(tables, channels, low, high);
+            const __m128i v = encode(tables, low, high);
+            storePixels(destination + 4 * x, v, v, v, a);
+        }
+    }
+    for (; x < width; x++) grayPixel(source + 4 * x, destination + 4 * x, tables);
+}
+
+IRL_TARGET_SSE41 static void directRowSSE41(const uint8_t* source, uint8_t* destination, int width, const ColorTables& tables) {
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i b, g, r, a;
+        loadPixels(source + 4 * x, b, g, r, a);
+        storePixels(destination + 4 * x, lookup(tables.directBytes[0], 256, b), lookup(tables.directBytes[1], 256, g),
+                    lookup(tables.directBytes[2], 256, r), a);
+    }
+    for (; x < width; x++) directPixel(source + 4 * x, destination + 4 * x, tables);
+}
+
+static void mixRowSSE41(const uint8_t* source, uint8_t* destination, int width, const ColorTables& tables) {
+    // No scanner view mixes a share of the luminance in, this one keeps the scalar kernel
+    for (int x = 0; x < width; x++) mixPixel(source + 4 * x, destination + 4 * x, tables);
+}
+
+const ColorKernels* colorKernelsSSE41() {
+    static const ColorKernels kernels = { mixRowSSE41, grayRowSSE41, directRowSSE41 };
+    return &kernels;
+}
+
+#else
+
+const ColorKernels* colorKernelsSSE41() { return nullptr; }
+
+#endif
+
+} // namespace detail
+} // namespace irl
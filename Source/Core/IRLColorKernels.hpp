@@ -0,0 +1,133 @@
+//
+//  IRLColorKernels.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Row kernels behind `ColorControls`, one table per instruction set. Not part of the public
+//  API: exposed for the bit-exactness tests and the benchmarks only.
+//
+
+#ifndef IRL_COLOR_KERNELS_HPP
+#define IRL_COLOR_KERNELS_HPP
+
+#include "IRLSimd.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace irl {
+namespace detail {
+
+/** Linear values are in Q14, 1.0 is kColorOne */
+static const int kColorShift    = 14;
+static const int kColorOne      = 1 << kColorShift;
+
+/**
+ @brief Lookup tables of one `ColorControlsOptions`, shared by every kernel variant.
+ @discussion 32 bit entries and a few padding bytes after `encode` so the vector variants can gather
+ them without reading past the end.
+ */
+struct ColorTables {
+    /** Linear value of each encoded byte times the gain of the channel, clamped to kColorOne, Q14. Blue, green, red. */
+    int32_t     decode[3][256];
+
+    /** Decoded value times the luminance weight of the channel, Q14. The three sum to at most kColorOne + 1. */
+    int32_t     lumaR[256];
+    int32_t     lumaG[256];
+    int32_t     lumaB[256];
+
+    /** encode[decode[c][v]], the whole chain of one channel when saturation is 1 */
+    int32_t     direct[3][256];
+
+    /** Brightness, contrast, clamping and encoding of a linear Q14 value */
+    uint8_t     encode[kColorOne + 1 + 3];
+
+    /** Weight of the channel against the luminance, Q14 */
+    int32_t     saturation;
+
+    /** `direct` as bytes, for the byte shuffles of the SSE4.1 and NEON kernels. Blue, green, red. */
+    uint8_t     directBytes[3][256];
+
+    /** lumaB, lumaG and lumaR split into their low and high bytes, for the same */
+    uint8_t     lumaLow[3][256];
+    uint8_t     lumaHigh[3][256];
+
+    /**
+     Smallest Q14 value encoded to each byte or more, split like `lumaLow`, laid out for a binary search: level L
+     (0 ... 7) holds from offset 2^L the thresholds of the bytes 128 >> L, 3 * (128 >> L), ... Past kColorOne when
+     the byte is never reached. Only valid when `searchable`.
+     */
+    uint8_t     searchLow[256];
+    uint8_t     searchHigh[256];
+
+    /** `encode` never decreases, as with any positive contrast: the encoded byte is the last threshold reached */
+    bool        searchable;
+};
+
+/** @brief Row kernels of one instruction set. Every kernel reads and writes `width` BGRA pixels, alpha is kept. */
+struct ColorKernels {
+    /** Any saturation: each channel is mixed with the luminance in linear light before encoding */
+    void (*mixRow)(const uint8_t* source, uint8_t* destination, int width, const ColorTables& tables);
+
+    /** Saturation 0: the encoded luminance on the three channels */
+    void (*grayRow)(const uint8_t* source, uint8_t* destination, int width, const ColorTables& tables);
+
+    /** Saturation 1: one 256 entries lookup per channel */
+    void (*directRow)(const uint8_t* source, uint8_t* destination, int width, const ColorTables& tables);
+};
+
+/** @return The kernels of `level`, nullptr when the level is not compiled in or not supported by the CPU */
+const ColorKernels* colorKernels(SimdLevel level);
+
+const ColorKernels* colorKernelsScalar();
+const ColorKernels* colorKernelsSSE41();
+const ColorKernels* colorKernelsAVX2();
+const ColorKernels* colorKernelsNEON();
+
+// MARK: - Scalar reference, also used by the vector variants on row ends
+
+inline int lumaOf(const uint8_t* p, const ColorTables& tables) {
+    return std::min(tables.lumaR[p[2]] + tables.lumaG[p[1]] + tables.lumaB[p[0]], kColorOne);
+}
+
+inline uint8_t mixChannel(int channel, int value, int luma, const ColorTables& tables) {
+    const int mixed = (tables.saturation * tables.decode[channel][value] + (kColorOne - tables.saturation) * luma + (kColorOne >> 1)) >> kColorShift;
+    return tables.encode[mixed];
+}
+
+inline void mixPixel(const uint8_t* source, uint8_t* destination, const ColorTables& tables) {
+    const int luma = lumaOf(source, tables);
+    const uint8_t b = mixChannel(0, source[0], luma, tables);
+    const uint8_t g = mixChannel(1, source[1], luma, tables);
+    const uint8_t r = mixChannel(2, source[2], luma, tables);
+    destination[0] = b; destination[1] = g; destination[2] = r; destination[3] = source[3];
+}
+
+inline void grayPixel(const uint8_t* source, uint8_t* destination, const ColorTables& tables) {
+    const uint8_t v = tables.encode[lumaOf(source, tables)];
+    destination[0] = v; destination[1] = v; destination[2] = v; destination[3] = source[3];
+}
+
+/** The binary search of the shuffle kernels, one value at a time: `encode[value]` when the tables are `searchable` */
+inline uint8_t searchEncode(int value, const ColorTables& tables) {
+    int index = 0;
+    for (int level = 0; level < 8; level++) {
+        const int slot      = (1 << level) + index;
+        const int threshold = tables.searchLow[slot] | tables.searchHigh[slot] << 8;
+        index = 2 * index + (threshold <= value ? 1 : 0);
+    }
+    return static_cast<uint8_t>(index);
+}
+
+inline void directPixel(const uint8_t* source, uint8_t* destination, const ColorTables& tables) {
+    const uint8_t b = static_cast<uint8_t>(tables.direct[0][source[0]]);
+    const uint8_t g = static_cast<uint8_t>(tables.direct[1][source[1]]);
+    const uint8_t r = static_cast<uint8_t>(tables.direct[2][source[2]]);
+    destination[0] = b; destination[1] = g; destination[2] = r; destination[3] = source[3];
+}
+
+} // namespace detail
+} // namespace irl
+
+#endif /* IRL_COLOR_KERNELS_HPP */
@@ -0,0 +1,168 @@
+//
+//  IRLCornerRefiner.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLCornerRefiner.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace irl {
+
+static const int kMaximumRadius = 32;
+
+static inline int lumaAt(const ImageView& image, int x, int y) {
+    x = std::min(std::max(x, 0), image.width - 1);
+    y = std::min(std::max(y, 0), image.height - 1);
+    const uint8_t* row = image.row(y);
+    if (image.format == PixelFormat::Gray8) return row[x];
+    const uint8_t* p = row + 4 * x;
+    return (29 * p[0] + 150 * p[1] + 77 * p[2] + 128) >> 8;
+}
+
+float sampleLuma(const ImageView& image, float x, float y) {
+    // Pixel (i, j) has its center at (i + 0.5, j + 0.5)
+    const float fx = x - 0.5f, fy = y - 0.5f;
+    const float x0 = std::floor(fx), y0 = std::floor(fy);
+    const float ax = fx - x0, ay = fy - y0;
+    const int   ix = static_cast<int>(x0), iy = static_cast<int>(y0);
+
+    const float top    = lumaAt(image, ix, iy)     + ax * (lumaAt(image, ix + 1, iy)     - lumaAt(image, ix, iy));
+    const float bottom = lumaAt(image, ix, iy + 1) + ax * (lumaAt(image, ix + 1, iy + 1) - lumaAt(image, ix, iy + 1));
+    return top + ay * (bottom - top);
+}
+
+/** Total least squares fit of `points[0 ... count)`, only the closed form of the 2x2 covariance eigenvector */
+static bool fitLine(const Point* points, int count, EdgeLine& line) {
+    if (count < 2) return false;
+
+    Point mean;
+    for (int i = 0; i < count; i++) mean = mean + points[i];
+    mean = mean * (1.0f / count);
+
+    float sxx = 0.0f, sxy = 0.0f, syy = 0.0f;
+    for (int i = 0; i < count; i++) {
+        const Point d = points[i] - mean;
+        sxx += d.x * d.x;
+        sxy += d.x * d.y;
+        syy += d.y * d.y;
+    }
+
+    // Largest eigenvalue, then the better conditioned of the two eigenvector expressions
+    const float half    = 0.5f * (sxx - syy);
+    const float lambda  = 0.5f * (sxx + syy) + std::sqrt(half * half + sxy * sxy);
+    Point direction     = Point(sxy, lambda - sxx);
+    const Point other   = Point(lambda - syy, sxy);
+    if (dot(other, other) > dot(direction, direction)) direction = other;
+
+    const float norm = std::sqrt(dot(direction, direction));
+    if (norm <= 0.0f) return false;
+
+    line.point      = mean;
+    line.direction  = direction * (1.0f / norm);
+    line.inliers    = count;
+    return true;
+}
+
+bool fitEdgeLine(const ImageView& image, Point from, Point to, const CornerRefinerOptions& options, EdgeLine& line) {
+    const float length = distance(from, to);
+    if (image.isEmpty() || length < 1.0f) return false;
+
+    const Point along   = (to - from) * (1.0f / length);
+    const Point normal  = Point(-along.y, along.x);
+    const int   radius  = std::min(std::max(options.searchRadius, 2), kMaximumRadius);
+    const int   limit   = std::min(std::max(options.maximumSamples, 2), kMaximumEdgeSamples);
+    const float step    = std::max(options.profileStep, 1.0f);
+
+    const float margin  = std::min(std::max(options.cornerMargin, 0.0f), 0.45f);
+    const float usable  = length * (1.0f - 2.0f * margin);
+    const int   samples = std::min(limit, std::max(2, static_cast<int>(usable / std::max(options.sampleSpacing, 1.0f)) + 1));
+
+    Point   points[kMaximumEdgeSamples];
+    float   profile[2 * kMaximumRadius + 1];
+    int     count = 0;
+
+    for (int s = 0; s < samples; s++) {
+        const float t       = length * margin + usable * s / (samples - 1);
+        const Point center  = from + along * t;
+
+        for (int o = -radius; o <= radius; o++) {
+            const Point p = center + normal * (step * o);
+            profile[o + radius] = sampleLuma(image, p.x, p.y);
+        }
+
+        // Strongest central difference, either polarity, then parabolic interpolation of its magnitude
+        int   best = 0;
+        float bestGradient = 0.0f;
+        for (int i = 1; i < 2 * radius; i++) {
+            const float gradient = std::fabs(profile[i + 1] - profile[i - 1]) * 0.5f;
+            if (gradient > bestGradient) { bestGradient = gradient; best = i; }
+        }
+        if (best < 2 || best > 2 * radius - 2 || bestGradient < options.minimumContrast) continue;
+
+        const float before  = std::fabs(profile[best] - profile[best - 2]) * 0.5f;
+        const float after   = std::fabs(profile[best + 2] - profile[best]) * 0.5f;
+        const float curve   = before - 2.0f * bestGradient + after;
+        const float shift   = curve < 0.0f ? 0.5f * (before - after) / curve : 0.0f;
+
+        points[count++] = center + normal * (step * (static_cast<float>(best - radius) + shift));
+    }
+
+    const int minimum = std::max(4, samples / 3);
+    if (count < minimum || !fitLine(points, count, line)) return false;
+
+    // Drop the points far from the first fit (text, shadows, the other side of a fold) and fit again
+    const Point lineNormal = Point(-line.direction.y, line.direction.x);
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        if (std::fabs(dot(points[i] - line.point, lineNormal)) <= options.outlierDistance) points[kept++] = points[i];
+    }
+    if (kept < minimum || !fitLine(points, kept, line)) return false;
+
+    const Point refitNormal = Point(-line.direction.y, line.direction.x);
+    float squares = 0.0f;
+    for (int i = 0; i < kept; i++) {
+        const float d = dot(points[i] - line.point, refitNormal);
+        squares += d * d;
+    }
+    line.residual = std::sqrt(squares / kept);
+    line.samples  = samples;
+    return true;
+}
+
+bool intersectEdgeLines(const EdgeLine& a, const EdgeLine& b, Point& intersection) {
+    const float det = cross(a.direction, b.direction);
+    if (std::fabs(det) < 1e-4f) return false;
+    const float t = cross(b.point - a.point, b.direction) / det;
+    intersection = a.point + a.direction * t;
+    return true;
+}
+
+int applyEdgeLines(const EdgeLine (&lines)[4], const bool (&fitted)[4], const CornerRefinerOptions& options, Quad& quad) {
+    // Corner k joins side k - 1 (ending at it) and side k (starting at it)
+    const float maximumShift = 2.0f * std::min(std::max(options.searchRadius, 2), kMaximumRadius) * std::max(options.profileStep, 1.0f);
+    Quad refined = quad;
+    int  moved   = 0;
+    for (int k = 0; k < 4; k++) {
+        const int previous = (k + 3) & 3;
+        Point corner;
+        if (!fitted[previous] || !fitted[k] || !intersectEdgeLines(lines[previous], lines[k], corner)) continue;
+        if (distance(corner, quad[k]) > maximumShift) continue;
+        refined[k] = corner;
+        moved++;
+    }
+    quad = refined;
+    return moved;
+}
+
+int refineQuad(const ImageView& image, Quad& quad, const CornerRefinerOptions& options) {
+    EdgeLine    lines[4];
+    bool        fitted[4];
+    for (int k = 0; k < 4; k++) fitted[k] = fitEdgeLine(image, quad[k], quad[(k + 1) & 3], options, lines[k]);
+    return applyEdgeLines(lines, fitted, options, quad);
+}
+
+} // namespace irl
@@ -0,0 +1,100 @@
+//
+//  IRLCornerRefiner.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Sub-pixel refinement of a selected document quad.
+//
+//  Each side is sampled at regular intervals. At every sample the luma is read along the
+//  side normal, over a short profile, and the strongest gradient is located with a
+//  parabolic fit. A line is fitted to these edge points by total least squares, outliers
+//  (text, shadows) are dropped and the line refitted. Corners are the intersections of
+//  adjacent lines.
+//
+//  Only thin strips along the sides are read: a few thousand bilinear samples for the
+//  whole quad, whatever the image size. Nothing is allocated.
+//
+
+#ifndef IRL_CORNER_REFINER_HPP
+#define IRL_CORNER_REFINER_HPP
+
+#include "IRLImage.hpp"
+#include "IRLQuad.hpp"
+
+namespace irl {
+
+/** @brief Tuning of the corner refinement */
+struct CornerRefinerOptions {
+    /** Half length, in samples, of the luma profiles read across each side. Bounds the correction. */
+    int     searchRadius        = 8;
+
+    /** Distance, in pixels, between two luma samples of a profile. Larger steps search further for the same cost, less accurately. */
+    float   profileStep         = 1.0f;
+
+    /** Distance, in pixels, between two profiles along a side. */
+    float   sampleSpacing       = 4.0f;
+
+    /** Maximum number of profiles per side, at most `kMaximumEdgeSamples`. */
+    int     maximumSamples      = 96;
+
+    /** Fraction of each side left out near the corners, where the neighbour side interferes. */
+    float   cornerMargin        = 0.08f;
+
+    /** Smallest luma step, per profile sample, accepted as an edge. */
+    float   minimumContrast     = 6.0f;
+
+    /** Edge points further than this from the first fit are dropped before the second one, in pixels. */
+    float   outlierDistance     = 1.0f;
+};
+
+/** Capacity of the per-side sample buffers */
+static const int kMaximumEdgeSamples = 256;
+
+/** @brief A straight edge fitted along one side */
+struct EdgeLine {
+    /** Centroid of the inliers */
+    Point   point;
+
+    /** Unit direction */
+    Point   direction;
+
+    /** Number of profiles read along the side */
+    int     samples     = 0;
+
+    /** Number of edge points used by the final fit */
+    int     inliers     = 0;
+
+    /** Root mean square distance of the inliers to the line, in pixels */
+    float   residual    = 0.0f;
+};
+
+/**
+ @brief Fit the edge running from `from` to `to`.
+ @param image BGRA or Gray8 image, in the same coordinates as `from` and `to`
+ @return false when too few profiles found an edge
+ */
+bool fitEdgeLine(const ImageView& image, Point from, Point to, const CornerRefinerOptions& options, EdgeLine& line);
+
+/** @return false when the lines are parallel */
+bool intersectEdgeLines(const EdgeLine& a, const EdgeLine& b, Point& intersection);
+
+/**
+ @brief Move the corners of `quad` to the intersections of adjacent fitted sides, side k running from corner k to corner k + 1.
+ @discussion A corner moves only when both its sides were fitted and it stays within twice the search radius.
+ @return The number of corners moved
+ */
+int applyEdgeLines(const EdgeLine (&lines)[4], const bool (&fitted)[4], const CornerRefinerOptions& options, Quad& quad);
+
+/**
+ @brief Refine the corners of `quad` in `image`: `fitEdgeLine` on every side, then `applyEdgeLines`.
+ @return The number of corners moved
+ */
+int refineQuad(const ImageView& image, Quad& quad, const CornerRefinerOptions& options = CornerRefinerOptions());
+
+/** @return The luma of `image` at continuous coordinates (x, y), bilinear, borders replicated */
+float sampleLuma(const ImageView& image, float x, float y);
+
+} // namespace irl
+
+#endif /* IRL_CORNER_REFINER_HPP */
@@ -0,0 +1,137 @@
+//
+//  IRLCornerTracker.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLCornerTracker.hpp"
+#include "IRLPyramid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace irl {
+
+static const int kMaximumSearchRadius = 32;
+
+/** Sub-pixel position of the minimum of three samples, in [-0.5, 0.5] */
+static inline float parabolicMinimum(float before, float center, float after) {
+    const float curve = before - 2.0f * center + after;
+    if (curve <= 0.0f) return 0.0f;
+    return std::min(std::max(0.5f * (before - after) / curve, -0.5f), 0.5f);
+}
+
+CornerTracker::CornerTracker(const CornerTrackerOptions& options)
+: _options(options) {}
+
+void CornerTracker::start(const ImageView& frame, const Quad& quad, bool keepVelocity) {
+    _quad               = quad;
+    _tracking           = !frame.isEmpty();
+    _framesSinceStart   = 0;
+    _lastError          = 0.0f;
+    _motion             = 0.0f;
+    if (!_tracking) return;
+
+    const int   level   = std::max(_options.level, 0);
+    const float scale   = 1.0f / (1 << level);
+    const int   radius  = std::max(_options.patchRadius, 1);
+
+    for (int k = 0; k < 4; k++) {
+        Corner& corner = _corners[k];
+        const Point p = quad[k] * scale;
+        const int   x = static_cast<int>(std::floor(p.x));
+        const int   y = static_cast<int>(std::floor(p.y));
+        corner.offset = Point(p.x - x, p.y - y);
+        if (!keepVelocity) corner.velocity = Point();
+        extractLumaDownsampled(frame, level, x - radius, y - radius, 2 * radius + 1, 2 * radius + 1, corner.patch);
+    }
+}
+
+bool CornerTracker::track(const ImageView& frame) {
+    if (!_tracking || frame.isEmpty()) return false;
+
+    const int   level   = std::max(_options.level, 0);
+    const float size    = static_cast<float>(1 << level);
+    const int   radius  = std::max(_options.patchRadius, 1);
+    const int   search  = std::min(std::max(_options.searchRadius, 1), kMaximumSearchRadius);
+    const int   span    = 2 * radius + 1;
+    const int   side    = span + 2 * search;
+
+    Quad    measured;
+    Point   predicted[4];
+    float   worst = 0.0f;
+
+    for (int k = 0; k < 4; k++) {
+        Corner& corner = _corners[k];
+        predicted[k] = _quad[k] + corner.velocity;
+
+        // Anchor pixel such that anchor + offset is the prediction, in level pixels
+        const Point p  = predicted[k] * (1.0f / size) - corner.offset;
+        const int   ax = static_cast<int>(std::floor(p.x + 0.5f));
+        const int   ay = static_cast<int>(std::floor(p.y + 0.5f));
+        extractLumaDownsampled(frame, level, ax - radius - search, ay - radius - search, side, side, _window);
+
+        // Exhaustive SAD over the search window
+        uint32_t sads[2 * kMaximumSearchRadius + 1][2 * kMaximumSearchRadius + 1];
+        uint32_t best = std::numeric_limits<uint32_t>::max();
+        int      bx = 0, by = 0;
+        for (int dy = 0; dy <= 2 * search; dy++) {
+            for (int dx = 0; dx <= 2 * search; dx++) {
+                uint32_t sad = 0;
+                for (int j = 0; j < span && sad < best; j++) {
+                    const uint8_t* a = corner.patch.row(j);
+                    const uint8_t* b = _window.row(dy + j) + dx;
+                    for (int i = 0; i < span; i++) sad += static_cast<uint32_t>(std::abs(a[i] - b[i]));
+                }
+                sads[dy][dx] = sad;
+                if (sad < best) { best = sad; bx = dx; by = dy; }
+            }
+        }
+
+        // Rows cut short by the early exit hold a partial sum above `best`, good enough for the fit around the minimum
+        float sx = 0.0f, sy = 0.0f;
+        if (bx > 0 && bx < 2 * search) sx = parabolicMinimum(sads[by][bx - 1], sads[by][bx], sads[by][bx + 1]);
+        if (by > 0 && by < 2 * search) sy = parabolicMinimum(sads[by - 1][bx], sads[by][bx], sads[by + 1][bx]);
+
+        const Point found(ax + (bx - search) + sx + corner.offset.x, ay + (by - search) + sy + corner.offset.y);
+        measured[k] = found * size;
+        worst = std::max(worst, static_cast<float>(best) / (span * span));
+    }
+
+    _lastError = worst;
+    if (worst > _options.maximumError) {
+        _tracking = false;
+        return false;
+    }
+
+    // Alpha-beta filter, then sanity checks of the whole quad
+    Quad filtered;
+    for (int k = 0; k < 4; k++) {
+        const Point residual = measured[k] - predicted[k];
+        filtered[k] = predicted[k] + residual * _options.positionGain;
+        _corners[k].velocity = _corners[k].velocity + residual * _options.velocityGain;
+    }
+
+    bool valid = filtered.signedArea() > 0.0f;
+    for (int k = 0; k < 4 && valid; k++) {
+        valid = cross(filtered[(k + 1) & 3] - filtered[k], filtered[(k + 2) & 3] - filtered[(k + 1) & 3]) > 0.0f
+             && filtered[k].x >= 0.0f && filtered[k].y >= 0.0f && filtered[k].x <= frame.width && filtered[k].y <= frame.height;
+    }
+    if (!valid) {
+        _tracking = false;
+        return false;
+    }
+
+    float moved = 0.0f;
+    for (int k = 0; k < 4; k++) moved += distance(filtered[k], _quad[k]);
+    _motion = 0.25f * moved;
+
+    _quad = filtered;
+    _framesSinceStart++;
+    return true;
+}
+
+} // namespace irl
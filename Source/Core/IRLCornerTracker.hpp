@@ -0,0 +1,111 @@
+//
+//  IRLCornerTracker.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Frame to frame tracking of the four corners of a detected document.
+//
+//  When the detector finds a quad, a small luma patch is captured around each corner.
+//  On the next frames every corner is predicted by a constant velocity (alpha-beta)
+//  filter, then matched by sum of absolute differences in a small window around the
+//  prediction, with a parabolic fit of the best match for sub-pixel positions. Only the
+//  luma around the corners is read from the frame, box downsampled for large previews.
+//
+//  The full detector is only needed to acquire the quad, when tracking is lost, and
+//  every `redetectInterval` frames to correct drift (see `needsDetection`).
+//
+
+#ifndef IRL_CORNER_TRACKER_HPP
+#define IRL_CORNER_TRACKER_HPP
+
+#include "IRLImage.hpp"
+#include "IRLQuad.hpp"
+
+namespace irl {
+
+/** @brief Tuning of `CornerTracker` */
+struct CornerTrackerOptions {
+    /** Pyramid level the patches are matched on: 0 full resolution, 1 half resolution (4K previews)... */
+    int     level               = 0;
+
+    /** Patches are (2 * patchRadius + 1)^2 level pixels, centered on the corners. */
+    int     patchRadius         = 6;
+
+    /** Largest displacement from the prediction searched, in level pixels. */
+    int     searchRadius        = 12;
+
+    /** Mean absolute luma difference of the best match beyond which a corner, and the quad, are lost. */
+    float   maximumError        = 16.0f;
+
+    /** Number of tracked frames after which `needsDetection` asks for a full detection to correct drift. */
+    int     redetectInterval    = 15;
+
+    /** Gain of the constant velocity filter on the position residual. 1 trusts the measurement only. */
+    float   positionGain        = 0.85f;
+
+    /** Gain of the constant velocity filter on the velocity. 0 disables the prediction. */
+    float   velocityGain        = 0.5f;
+};
+
+/**
+ @brief Tracker of one document quad in a BGRA (kCVPixelFormatType_32BGRA) or Gray8 video.
+ @discussion Buffers are allocated by the first `start` and reused afterwards. Not thread safe, use one instance per queue.
+ */
+class CornerTracker {
+public:
+    explicit CornerTracker(const CornerTrackerOptions& options = CornerTrackerOptions());
+
+    const CornerTrackerOptions& options() const                                 { return _options; }
+    void                        setOptions(const CornerTrackerOptions& options) { _options = options; }
+
+    /** @brief Start tracking `quad`, found in `frame` by a detector. Velocities are reset unless `keepVelocity`. */
+    void start(const ImageView& frame, const Quad& quad, bool keepVelocity = false);
+
+    /** @brief Stop tracking. */
+    void stop() { _tracking = false; }
+
+    /**
+     @brief Follow the quad in the next frame.
+     @return false when the quad is lost (no good match, or degenerate quad). `quad()` is then the last good one.
+     */
+    bool track(const ImageView& frame);
+
+    /** @return true while a quad is tracked */
+    bool isTracking() const { return _tracking; }
+
+    /** @return true when the full detector should run on this frame: nothing tracked, or drift correction due */
+    bool needsDetection() const { return !_tracking || _framesSinceStart >= _options.redetectInterval; }
+
+    /** @return The tracked quad, in buffer coordinates */
+    const Quad& quad() const { return _quad; }
+
+    /** @return The worst corner match error of the last `track`, in mean absolute luma difference */
+    float lastError() const { return _lastError; }
+
+    /** @return Mean displacement of the corners on the last tracked frame, in pixels */
+    float motion() const { return _motion; }
+
+    /** @return Number of frames tracked since the last `start` */
+    int framesSinceStart() const { return _framesSinceStart; }
+
+private:
+    struct Corner {
+        Plane8  patch;
+        Point   offset;         // corner position inside its anchor pixel, in level pixels
+        Point   velocity;       // full resolution pixels per frame
+    };
+
+    CornerTrackerOptions    _options;
+    Corner                  _corners[4];
+    Quad                    _quad;
+    Plane8                  _window;
+    bool                    _tracking           = false;
+    int                     _framesSinceStart   = 0;
+    float                   _lastError          = 0.0f;
+    float                   _motion             = 0.0f;
+};
+
+} // namespace irl
+
+#endif /* IRL_CORNER_TRACKER_HPP */
@@ -0,0 +1,102 @@
+//
+//  IRLDetectionScheduler.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLDetectionScheduler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace irl {
+
+static inline float smooth(float average, float value, float weight, bool first) {
+    return first ? value : average + weight * (value - average);
+}
+
+DetectionScheduler::DetectionScheduler(const DetectionSchedulerOptions& options)
+: _options(options) {}
+
+void DetectionScheduler::reset() {
+    _sinceDetection     = kNeverDetected;
+    _backoff            = 0;
+    _detectionLatency   = 0.0f;
+    _trackingLatency    = 0.0f;
+    _motion             = 0.0f;
+}
+
+void DetectionScheduler::recordDetection(float milliseconds) {
+    _detectionLatency = smooth(_detectionLatency, milliseconds, _options.smoothing, _detectionLatency == 0.0f);
+}
+
+void DetectionScheduler::recordTracking(float milliseconds) {
+    _trackingLatency = smooth(_trackingLatency, milliseconds, _options.smoothing, _trackingLatency == 0.0f);
+}
+
+ScheduleDecision DetectionScheduler::next(bool tracking, float motion, bool confident) {
+    const int minimum = std::max(_options.minimumInterval, 1);
+    const int maximum = std::max(_options.maximumInterval, minimum);
+
+    // Fewest frames between detections keeping detection + tracking within the budget on average
+    const float spare   = std::max(_options.frameBudget - _trackingLatency, 0.05f * _options.frameBudget);
+    const int   budget  = std::min(std::max(static_cast<int>(std::ceil(_detectionLatency / std::max(spare, 1e-3f))), minimum), maximum);
+
+    ScheduleReason  reason;
+    int             interval;
+    if (!tracking) {
+        _motion  = 0.0f;
+        _backoff = 0;
+        reason   = ScheduleReason::Acquire;
+        interval = minimum;
+    } else {
+        _motion = smooth(_motion, motion, _options.smoothing, false);
+        if (_motion >= _options.fastMotion) {
+            _backoff = 0;
+            reason   = ScheduleReason::Motion;
+            interval = minimum;
+        } else if (_motion <= _options.staticMotion && confident) {
+            reason   = ScheduleReason::Static;
+            interval = std::min(std::max(_options.baseInterval, minimum) << std::min(_backoff, 16), maximum);
+        } else {
+            _backoff = 0;
+            reason   = ScheduleReason::Steady;
+            interval = std::min(std::max(_options.baseInterval, minimum), maximum);
+        }
+    }
+    if (budget > interval) {
+        interval = budget;
+        reason   = ScheduleReason::Budget;
+    }
+
+    _sinceDetection = std::min(_sinceDetection + 1, kNeverDetected);
+    ScheduleDecision decision;
+    decision.frame              = _frame++;
+    decision.detect             = _sinceDetection >= interval;
+    decision.interval           = interval;
+    decision.detectionLatency   = _detectionLatency;
+    decision.trackingLatency    = _trackingLatency;
+    decision.motion             = _motion;
+    decision.reason             = reason;
+
+    if (decision.detect) {
+        _sinceDetection = 0;
+        if (reason == ScheduleReason::Static) _backoff++;
+    }
+    if (_logging) _log.push_back(decision);
+    return decision;
+}
+
+const char* scheduleReasonName(ScheduleReason reason) {
+    switch (reason) {
+        case ScheduleReason::Acquire:   return "acquire";
+        case ScheduleReason::Motion:    return "motion";
+        case ScheduleReason::Steady:    return "steady";
+        case ScheduleReason::Static:    return "static";
+        case ScheduleReason::Budget:    return "budget";
+    }
+    return "unknown";
+}
+
+} // namespace irl
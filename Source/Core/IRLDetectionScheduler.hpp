@@ -0,0 +1,121 @@
+//
+//  IRLDetectionScheduler.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Cadence of the full detections of the preview.
+//
+//  Between detections the quad is followed by the corner tracker. The scheduler measures how
+//  long detections and tracking take, and how fast the tracked corners move, then picks the
+//  number of frames between two detections:
+//  - never less than what keeps the average detection plus tracking cost per frame within the budget,
+//  - every frame the budget allows while the phone moves fast or nothing is tracked,
+//  - a fixed interval otherwise, doubled after each detection while the scene is static and confident.
+//
+//  Decisions can be logged, one per frame, to replay and compare policies in benchmarks.
+//
+
+#ifndef IRL_DETECTION_SCHEDULER_HPP
+#define IRL_DETECTION_SCHEDULER_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace irl {
+
+/** @brief Tuning of `DetectionScheduler` */
+struct DetectionSchedulerOptions {
+    /** Average time, in milliseconds, that detection plus tracking may take per frame. */
+    float   frameBudget         = 8.0f;
+
+    /** Frames between two detections in normal conditions. */
+    int     baseInterval        = 15;
+
+    /** Bounds of the interval. */
+    int     minimumInterval     = 1;
+    int     maximumInterval     = 120;
+
+    /** Corner motion per frame, as a fraction of the frame diagonal, below which the scene is static. */
+    float   staticMotion        = 0.001f;
+
+    /** Corner motion per frame above which the phone moves fast and detections run as often as the budget allows. */
+    float   fastMotion          = 0.004f;
+
+    /** Weight of the newest measurement in the running averages of latencies and motion. */
+    float   smoothing           = 0.2f;
+};
+
+/** @brief Why a frame was, or was not, detected */
+enum class ScheduleReason : uint8_t {
+    Acquire,    ///< Nothing tracked
+    Motion,     ///< Fast motion
+    Steady,     ///< Base interval
+    Static,     ///< Static and confident scene, backing off
+    Budget,     ///< Interval stretched to stay within the budget
+};
+
+/** @brief One scheduling decision */
+struct ScheduleDecision {
+    uint32_t        frame               = 0;
+    bool            detect              = false;
+    int             interval            = 0;
+    float           detectionLatency    = 0.0f;     // running average, milliseconds
+    float           trackingLatency     = 0.0f;     // running average, milliseconds
+    float           motion              = 0.0f;     // running average, fraction of the diagonal per frame
+    ScheduleReason  reason              = ScheduleReason::Acquire;
+};
+
+/** @brief Detection cadence of one preview. Not thread safe, use one instance per queue. */
+class DetectionScheduler {
+public:
+    explicit DetectionScheduler(const DetectionSchedulerOptions& options = DetectionSchedulerOptions());
+
+    const DetectionSchedulerOptions&    options() const                                     { return _options; }
+    void                                setOptions(const DetectionSchedulerOptions& options) { _options = options; }
+
+    /**
+     @brief Decide whether the current frame runs a full detection.
+     @param tracking  true when the tracker followed the quad on this frame
+     @param motion    Mean corner displacement of this frame, as a fraction of the frame diagonal
+     @param confident true when the detection confidence is high enough to back off
+     */
+    ScheduleDecision next(bool tracking, float motion, bool confident);
+
+    /** @brief Report the duration, in milliseconds, of a detection */
+    void recordDetection(float milliseconds);
+
+    /** @brief Report the duration, in milliseconds, of tracking one frame */
+    void recordTracking(float milliseconds);
+
+    /** @brief Forget the measurements and restart from a detection on the next frame. The log is kept. */
+    void reset();
+
+    /** @return Running average of the detection latency, in milliseconds */
+    float detectionLatency() const { return _detectionLatency; }
+
+    /** @brief Record every decision in `log()`. Off by default. */
+    void                                    setLogging(bool logging)    { _logging = logging; }
+    const std::vector<ScheduleDecision>&    log() const                 { return _log; }
+    void                                    clearLog()                  { _log.clear(); }
+
+private:
+    static const int kNeverDetected = 1 << 20;
+
+    DetectionSchedulerOptions       _options;
+    uint32_t                        _frame              = 0;
+    int                             _sinceDetection     = kNeverDetected;
+    int                             _backoff            = 0;
+    float                           _detectionLatency   = 0.0f;
+    float                           _trackingLatency    = 0.0f;
+    float                           _motion             = 0.0f;
+    bool                            _logging            = false;
+    std::vector<ScheduleDecision>   _log;
+};
+
+/** @return A short name of `reason`, for logs */
+const char* scheduleReasonName(ScheduleReason reason);
+
+} // namespace irl
+
+#endif /* IRL_DETECTION_SCHEDULER_HPP */
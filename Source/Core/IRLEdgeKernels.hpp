@@ -0,0 +1,103 @@
+//
+//  IRLEdgeKernels.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Row kernels behind `EdgeDetector`, one table per instruction set. Not part of the public
+//  API: exposed for the bit-exactness tests and the benchmarks only.
+//
+
+#ifndef IRL_EDGE_KERNELS_HPP
+#define IRL_EDGE_KERNELS_HPP
+
+#include "IRLSimd.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+
+namespace irl {
+namespace detail {
+
+/** @brief Values of the intermediate edge class map */
+enum EdgeClass : uint8_t {
+    EdgeNone        = 0,
+    EdgeWeak        = 1,
+    EdgeStrong      = 2,
+    EdgeConfirmed   = 3
+};
+
+/** tan(22.5°) in Q16. tan(67.5°) = 2 + tan(22.5°). */
+static const int kTan22Q16 = 27146;
+
+/** @brief Row kernels of one instruction set */
+struct EdgeKernels {
+    /**
+     Sobel gradient of the `center` row, `above` and `below` being its neighbours. Columns are replicated at the
+     borders. Writes `width` values of dx, dy and |dx| + |dy|.
+     */
+    void (*sobelRow)(const uint8_t* above, const uint8_t* center, const uint8_t* below, int width,
+                     int16_t* dx, int16_t* dy, int16_t* magnitude);
+
+    /**
+     Non-maximum suppression and double threshold of the `center` magnitude row. Writes one `EdgeClass` per pixel,
+     `EdgeNone` on the first and last column.
+     */
+    void (*suppressRow)(const int16_t* above, const int16_t* center, const int16_t* below,
+                        const int16_t* dx, const int16_t* dy, int width, int low, int high, uint8_t* classes);
+
+    /** Columns of the `EdgeStrong` pixels of a class row, in increasing order. @return Their count */
+    int (*collectStrong)(const uint8_t* classes, int width, int32_t* positions);
+
+    /** `EdgeConfirmed` becomes 255, every other class 0. */
+    void (*finalizeRow)(uint8_t* classes, int width);
+};
+
+/** @return The kernels of `level`, nullptr when the level is not compiled in or not supported by the CPU */
+const EdgeKernels* edgeKernels(SimdLevel level);
+
+const EdgeKernels* edgeKernelsScalar();
+const EdgeKernels* edgeKernelsSSE41();
+const EdgeKernels* edgeKernelsAVX2();
+const EdgeKernels* edgeKernelsNEON();
+
+// MARK: - Scalar reference, also used by the vector variants on row ends
+
+inline void sobelPixel(const uint8_t* above, const uint8_t* center, const uint8_t* below, int left, int x, int right,
+                       int16_t& dx, int16_t& dy, int16_t& magnitude) {
+    const int gx = (above[right] - above[left]) + 2 * (center[right] - center[left]) + (below[right] - below[left]);
+    const int gy = (below[left] + 2 * below[x] + below[right]) - (above[left] + 2 * above[x] + above[right]);
+    dx          = static_cast<int16_t>(gx);
+    dy          = static_cast<int16_t>(gy);
+    magnitude   = static_cast<int16_t>(std::abs(gx) + std::abs(gy));
+}
+
+inline uint8_t suppressPixel(const int16_t* above, const int16_t* center, const int16_t* below, int x,
+                             int dx, int dy, int low, int high) {
+    const int m = center[x];
+    if (m <= low) return EdgeNone;
+
+    const int ax    = std::abs(dx);
+    const int ay    = std::abs(dy);
+    const int t22   = (ax * kTan22Q16) >> 16;
+
+    int n1, n2;
+    if (ay < t22) {
+        n1 = center[x - 1]; n2 = center[x + 1];     // horizontal gradient
+    } else if (ay > 2 * ax + t22) {
+        n1 = above[x];      n2 = below[x];          // vertical gradient
+    } else if ((dx ^ dy) < 0) {
+        n1 = above[x + 1];  n2 = below[x - 1];      // anti-diagonal, y is down
+    } else {
+        n1 = above[x - 1];  n2 = below[x + 1];      // diagonal
+    }
+
+    // Strict on one side only so plateaus of two equal pixels keep one of them
+    if (!(m > n1 && m >= n2)) return EdgeNone;
+    return m > high ? EdgeStrong : EdgeWeak;
+}
+
+} // namespace detail
+} // namespace irl
+
+#endif /* IRL_EDGE_KERNELS_HPP */
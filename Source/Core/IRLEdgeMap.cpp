@@ -0,0 +1,158 @@
+//
+//  IRLEdgeMap.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLEdgeMap.hpp"
+#include "IRLEdgeKernels.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace irl {
+namespace detail {
+
+// MARK: - Scalar kernels
+
+static void sobelRowScalar(const uint8_t* above, const uint8_t* center, const uint8_t* below, int width,
+                           int16_t* dx, int16_t* dy, int16_t* magnitude) {
+    for (int x = 0; x < width; x++) {
+        sobelPixel(above, center, below, std::max(x - 1, 0), x, std::min(x + 1, width - 1), dx[x], dy[x], magnitude[x]);
+    }
+}
+
+static void suppressRowScalar(const int16_t* above, const int16_t* center, const int16_t* below,
+                              const int16_t* dx, const int16_t* dy, int width, int low, int high, uint8_t* classes) {
+    classes[0] = EdgeNone;
+    for (int x = 1; x < width - 1; x++) {
+        classes[x] = suppressPixel(above, center, below, x, dx[x], dy[x], low, high);
+    }
+    classes[width - 1] = EdgeNone;
+}
+
+static int collectStrongScalar(const uint8_t* classes, int width, int32_t* positions) {
+    int count = 0;
+    for (int x = 0; x < width; x++) {
+        if (classes[x] == EdgeStrong) positions[count++] = x;
+    }
+    return count;
+}
+
+static void finalizeRowScalar(uint8_t* classes, int width) {
+    for (int x = 0; x < width; x++) {
+        classes[x] = classes[x] == EdgeConfirmed ? 255 : 0;
+    }
+}
+
+const EdgeKernels* edgeKernelsScalar() {
+    static const EdgeKernels kernels = { sobelRowScalar, suppressRowScalar, collectStrongScalar, finalizeRowScalar };
+    return &kernels;
+}
+
+const EdgeKernels* edgeKernels(SimdLevel level) {
+    if (!isSimdLevelSupported(level)) return nullptr;
+    switch (level) {
+        case SimdLevel::Scalar: return edgeKernelsScalar();
+        case SimdLevel::SSE41:  return edgeKernelsSSE41();
+        case SimdLevel::AVX2:   return edgeKernelsAVX2();
+        case SimdLevel::NEON:   return edgeKernelsNEON();
+    }
+    return nullptr;
+}
+
+} // namespace detail
+
+// MARK: - EdgeDetector
+
+EdgeDetector::EdgeDetector(SimdLevel level)
+: _level(level)
+, _kernels(detail::edgeKernels(level)) {
+    if (!_kernels) {
+        _level   = SimdLevel::Scalar;
+        _kernels = detail::edgeKernelsScalar();
+    }
+}
+
+void EdgeDetector::detect(const ImageView& luma, const EdgeMapOptions& options, Plane8& edges) {
+    assert(luma.format == PixelFormat::Gray8);
+    const int width  = luma.width;
+    const int height = luma.height;
+    edges.resize(width, height);
+    if (width < 3 || height < 3) {
+        std::memset(edges.data(), 0, edges.stride() * static_cast<size_t>(std::max(height, 0)));
+        return;
+    }
+
+    // Three rolling rows of dx, dy and magnitude: suppressing row y needs the magnitude of rows y - 1 ... y + 1
+    const size_t w = static_cast<size_t>(width);
+    _rows.resize(9 * w);
+    int16_t* dx         = _rows.data();
+    int16_t* dy         = dx + 3 * w;
+    int16_t* magnitude  = dy + 3 * w;
+
+    const int low   = std::min(std::max(options.lowThreshold, 0), 4096);
+    const int high  = std::min(std::max(options.highThreshold, 0), 4096);
+
+    auto gradient = [&](int y) {
+        const size_t slot = static_cast<size_t>(y % 3) * w;
+        _kernels->sobelRow(luma.row(std::max(y - 1, 0)), luma.row(y), luma.row(std::min(y + 1, height - 1)), width,
+                           dx + slot, dy + slot, magnitude + slot);
+    };
+
+    gradient(0);
+    gradient(1);
+    std::memset(edges.row(0), detail::EdgeNone, w);
+    for (int y = 1; y < height - 1; y++) {
+        gradient(y + 1);
+        const size_t above  = static_cast<size_t>((y - 1) % 3) * w;
+        const size_t center = static_cast<size_t>(y % 3) * w;
+        const size_t below  = static_cast<size_t>((y + 1) % 3) * w;
+        _kernels->suppressRow(magnitude + above, magnitude + center, magnitude + below, dx + center, dy + center,
+                              width, low, high, edges.row(y));
+    }
+    std::memset(edges.row(height - 1), detail::EdgeNone, w);
+
+    hysteresis(edges);
+}
+
+void EdgeDetector::hysteresis(Plane8& edges) {
+    const int       width   = edges.width();
+    const int       height  = edges.height();
+    const int32_t   stride  = static_cast<int32_t>(edges.stride());
+    const int32_t   neighbours[8] = { -stride - 1, -stride, -stride + 1, -1, 1, stride - 1, stride, stride + 1 };
+    uint8_t*        base    = edges.data();
+
+    // Borders are EdgeNone, so the neighbours of a queued pixel are always inside the plane
+    _positions.resize(static_cast<size_t>(width));
+    for (int y = 1; y < height - 1; y++) {
+        uint8_t* row = edges.row(y);
+        const int count = _kernels->collectStrong(row, width, _positions.data());
+        for (int i = 0; i < count; i++) {
+            const int32_t x = _positions[static_cast<size_t>(i)];
+            if (row[x] != detail::EdgeStrong) continue;    // reached from an earlier seed
+
+            row[x] = detail::EdgeConfirmed;
+            _stack.push_back(y * stride + x);
+            while (!_stack.empty()) {
+                const int32_t offset = _stack.back();
+                _stack.pop_back();
+                for (int32_t neighbour : neighbours) {
+                    uint8_t& value = base[offset + neighbour];
+                    if (value == detail::EdgeWeak || value == detail::EdgeStrong) {
+                        value = detail::EdgeConfirmed;
+                        _stack.push_back(offset + neighbour);
+                    }
+                }
+            }
+        }
+    }
+
+    for (int y = 0; y < height; y++) {
+        _kernels->finalizeRow(edges.row(y), width);
+    }
+}
+
+} // namespace irl
@@ -0,0 +1,70 @@
+//
+//  IRLEdgeMap.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Canny edge map of a luma plane: 3x3 Sobel gradient, non-maximum suppression along the
+//  gradient direction and hysteresis between two thresholds.
+//
+//  The row kernels have a scalar reference and SSE4.1, AVX2 and NEON variants that give
+//  bit-identical maps. Direction quantization only uses 16 bit integer arithmetic so the
+//  vector variants do not need to widen to 32 bits.
+//
+
+#ifndef IRL_EDGE_MAP_HPP
+#define IRL_EDGE_MAP_HPP
+
+#include "IRLImage.hpp"
+#include "IRLSimd.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace irl {
+
+namespace detail { struct EdgeKernels; }
+
+/** @brief Thresholds of `EdgeDetector`, on the L1 gradient magnitude |dx| + |dy| (0 ... 2040) */
+struct EdgeMapOptions {
+    /** Local maxima above this value are kept when connected to a strong edge. */
+    int lowThreshold    = 64;
+
+    /** Local maxima above this value always are edges. */
+    int highThreshold   = 160;
+};
+
+/**
+ @brief Canny edge detector working on Gray8 planes.
+ @discussion The luma is used as is, blur it first (e.g. `smoothBinomial3`) on noisy frames.
+ An instance keeps its row buffers between calls. It is not thread safe, use one instance per queue.
+ */
+class EdgeDetector {
+public:
+    /** @param level Kernel variant. An unsupported level falls back to the scalar reference. */
+    explicit EdgeDetector(SimdLevel level = bestSimdLevel());
+
+    /** @return The kernel variant actually used */
+    SimdLevel simdLevel() const { return _level; }
+
+    /**
+     @brief Edge map of `luma`.
+     @param luma A Gray8 view
+     @param edges Resized to the size of `luma`. 255 on edge pixels, 0 elsewhere. The one pixel border is always 0.
+     */
+    void detect(const ImageView& luma, const EdgeMapOptions& options, Plane8& edges);
+
+private:
+    void hysteresis(Plane8& edges);
+
+    SimdLevel                   _level;
+    const detail::EdgeKernels*  _kernels;
+
+    std::vector<int16_t>        _rows;
+    std::vector<int32_t>        _positions;
+    std::vector<int32_t>        _stack;
+};
+
+} // namespace irl
+
+#endif /* IRL_EDGE_MAP_HPP */
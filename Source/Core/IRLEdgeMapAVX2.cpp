@@ -0,0 +1,142 @@
+//
+//  IRLEdgeMapAVX2.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  AVX2 edge kernels, 16 pixels per iteration in 16 bit lanes.
+//
+
+#include "IRLEdgeKernels.hpp"
+
+#if IRL_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace irl {
+namespace detail {
+
+#if IRL_SIMD_X86
+
+IRL_TARGET_AVX2 static inline __m256i loadWidened(const uint8_t* p) {
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+}
+
+IRL_TARGET_AVX2 static inline __m256i load16(const int16_t* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+IRL_TARGET_AVX2 static void sobelRowAVX2(const uint8_t* above, const uint8_t* center, const uint8_t* below, int width,
+                                         int16_t* dx, int16_t* dy, int16_t* magnitude) {
+    sobelPixel(above, center, below, 0, 0, width > 1 ? 1 : 0, dx[0], dy[0], magnitude[0]);
+
+    int x = 1;
+    for (; x + 17 <= width; x += 16) {
+        const __m256i aL = loadWidened(above + x - 1), aM = loadWidened(above + x), aR = loadWidened(above + x + 1);
+        const __m256i cL = loadWidened(center + x - 1),                             cR = loadWidened(center + x + 1);
+        const __m256i bL = loadWidened(below + x - 1), bM = loadWidened(below + x), bR = loadWidened(below + x + 1);
+
+        const __m256i gx = _mm256_add_epi16(_mm256_add_epi16(_mm256_sub_epi16(aR, aL), _mm256_sub_epi16(bR, bL)),
+                                            _mm256_slli_epi16(_mm256_sub_epi16(cR, cL), 1));
+        const __m256i gy = _mm256_sub_epi16(_mm256_add_epi16(_mm256_add_epi16(bL, bR), _mm256_slli_epi16(bM, 1)),
+                                            _mm256_add_epi16(_mm256_add_epi16(aL, aR), _mm256_slli_epi16(aM, 1)));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dx + x), gx);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dy + x), gy);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(magnitude + x),
+                            _mm256_add_epi16(_mm256_abs_epi16(gx), _mm256_abs_epi16(gy)));
+    }
+
+    for (; x < width; x++) {
+        sobelPixel(above, center, below, x - 1, x, x + 1 < width ? x + 1 : x, dx[x], dy[x], magnitude[x]);
+    }
+}
+
+IRL_TARGET_AVX2 static void suppressRowAVX2(const int16_t* above, const int16_t* center, const int16_t* below,
+                                            const int16_t* dx, const int16_t* dy, int width, int low, int high,
+                                            uint8_t* classes) {
+    const __m256i tan22 = _mm256_set1_epi16(static_cast<int16_t>(kTan22Q16));
+    const __m256i lowV  = _mm256_set1_epi16(static_cast<int16_t>(low));
+    const __m256i highV = _mm256_set1_epi16(static_cast<int16_t>(high));
+    const __m256i one   = _mm256_set1_epi16(1);
+    const __m256i zero  = _mm256_setzero_si256();
+
+    classes[0] = EdgeNone;
+    int x = 1;
+    for (; x + 17 <= width; x += 16) {
+        const __m256i m  = load16(center + x);
+        const __m256i gx = load16(dx + x);
+        const __m256i gy = load16(dy + x);
+        const __m256i ax = _mm256_abs_epi16(gx);
+        const __m256i ay = _mm256_abs_epi16(gy);
+
+        const __m256i t22           = _mm256_mulhi_epu16(ax, tan22);
+        const __m256i t67           = _mm256_add_epi16(_mm256_slli_epi16(ax, 1), t22);
+        const __m256i horizontal    = _mm256_cmpgt_epi16(t22, ay);
+        const __m256i vertical      = _mm256_cmpgt_epi16(ay, t67);
+        const __m256i opposite      = _mm256_cmpgt_epi16(zero, _mm256_xor_si256(gx, gy));
+
+        const __m256i d1 = _mm256_blendv_epi8(load16(above + x - 1), load16(above + x + 1), opposite);
+        const __m256i d2 = _mm256_blendv_epi8(load16(below + x + 1), load16(below + x - 1), opposite);
+        const __m256i n1 = _mm256_blendv_epi8(_mm256_blendv_epi8(d1, load16(above + x), vertical), load16(center + x - 1), horizontal);
+        const __m256i n2 = _mm256_blendv_epi8(_mm256_blendv_epi8(d2, load16(below + x), vertical), load16(center + x + 1), horizontal);
+
+        const __m256i isMaximum = _mm256_andnot_si256(_mm256_cmpgt_epi16(n2, m), _mm256_cmpgt_epi16(m, n1));
+        __m256i cls = _mm256_add_epi16(_mm256_and_si256(_mm256_cmpgt_epi16(m, lowV), one),
+                                       _mm256_and_si256(_mm256_cmpgt_epi16(m, highV), one));
+        cls = _mm256_and_si256(cls, isMaximum);
+
+        // packus works per 128 bit lane, pack the two halves explicitly to keep pixel order
+        const __m128i packed = _mm_packus_epi16(_mm256_castsi256_si128(cls), _mm256_extracti128_si256(cls, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(classes + x), packed);
+    }
+
+    for (; x < width - 1; x++) {
+        classes[x] = suppressPixel(above, center, below, x, dx[x], dy[x], low, high);
+    }
+    classes[width - 1] = EdgeNone;
+}
+
+IRL_TARGET_AVX2 static int collectStrongAVX2(const uint8_t* classes, int width, int32_t* positions) {
+    const __m256i strong = _mm256_set1_epi8(EdgeStrong);
+    int count = 0;
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(classes + x)), strong)));
+        while (mask) {
+            positions[count++] = x + __builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+    }
+    for (; x < width; x++) {
+        if (classes[x] == EdgeStrong) positions[count++] = x;
+    }
+    return count;
+}
+
+IRL_TARGET_AVX2 static void finalizeRowAVX2(uint8_t* classes, int width) {
+    const __m256i confirmed = _mm256_set1_epi8(EdgeConfirmed);
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        __m256i* p = reinterpret_cast<__m256i*>(classes + x);
+        _mm256_storeu_si256(p, _mm256_cmpeq_epi8(_mm256_loadu_si256(p), confirmed));
+    }
+    for (; x < width; x++) {
+        classes[x] = classes[x] == EdgeConfirmed ? 255 : 0;
+    }
+}
+
+const EdgeKernels* edgeKernelsAVX2() {
+    static const EdgeKernels kernels = { sobelRowAVX2, suppressRowAVX2, collectStrongAVX2, finalizeRowAVX2 };
+    return &kernels;
+}
+
+#else
+
+const EdgeKernels* edgeKernelsAVX2() { return nullptr; }
+
+#endif
+
+} // namespace detail
+} // namespace irl
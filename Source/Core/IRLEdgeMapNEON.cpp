@@ -0,0 +1,133 @@
+//
+//  IRLEdgeMapNEON.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  NEON edge kernels, 8 pixels per iteration in 16 bit lanes.
+//
+
+#include "IRLEdgeKernels.hpp"
+
+#if IRL_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace irl {
+namespace detail {
+
+#if IRL_SIMD_NEON
+
+static inline int16x8_t loadWidened(const uint8_t* p) {
+    return vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p)));
+}
+
+static void sobelRowNEON(const uint8_t* above, const uint8_t* center, const uint8_t* below, int width,
+                         int16_t* dx, int16_t* dy, int16_t* magnitude) {
+    sobelPixel(above, center, below, 0, 0, width > 1 ? 1 : 0, dx[0], dy[0], magnitude[0]);
+
+    int x = 1;
+    for (; x + 9 <= width; x += 8) {
+        const int16x8_t aL = loadWidened(above + x - 1), aM = loadWidened(above + x), aR = loadWidened(above + x + 1);
+        const int16x8_t cL = loadWidened(center + x - 1),                             cR = loadWidened(center + x + 1);
+        const int16x8_t bL = loadWidened(below + x - 1), bM = loadWidened(below + x), bR = loadWidened(below + x + 1);
+
+        const int16x8_t gx = vaddq_s16(vaddq_s16(vsubq_s16(aR, aL), vsubq_s16(bR, bL)), vshlq_n_s16(vsubq_s16(cR, cL), 1));
+        const int16x8_t gy = vsubq_s16(vaddq_s16(vaddq_s16(bL, bR), vshlq_n_s16(bM, 1)),
+                                       vaddq_s16(vaddq_s16(aL, aR), vshlq_n_s16(aM, 1)));
+
+        vst1q_s16(dx + x, gx);
+        vst1q_s16(dy + x, gy);
+        vst1q_s16(magnitude + x, vaddq_s16(vabsq_s16(gx), vabsq_s16(gy)));
+    }
+
+    for (; x < width; x++) {
+        sobelPixel(above, center, below, x - 1, x, x + 1 < width ? x + 1 : x, dx[x], dy[x], magnitude[x]);
+    }
+}
+
+static void suppressRowNEON(const int16_t* above, const int16_t* center, const int16_t* below,
+                            const int16_t* dx, const int16_t* dy, int width, int low, int high, uint8_t* classes) {
+    const uint16x4_t tan22 = vdup_n_u16(static_cast<uint16_t>(kTan22Q16));
+    const int16x8_t  lowV  = vdupq_n_s16(static_cast<int16_t>(low));
+    const int16x8_t  highV = vdupq_n_s16(static_cast<int16_t>(high));
+    const uint16x8_t one   = vdupq_n_u16(1);
+    const int16x8_t  zero  = vdupq_n_s16(0);
+
+    classes[0] = EdgeNone;
+    int x = 1;
+    for (; x + 9 <= width; x += 8) {
+        const int16x8_t m  = vld1q_s16(center + x);
+        const int16x8_t gx = vld1q_s16(dx + x);
+        const int16x8_t gy = vld1q_s16(dy + x);
+        const int16x8_t ax = vabsq_s16(gx);
+        const int16x8_t ay = vabsq_s16(gy);
+
+        const uint16x8_t axu = vreinterpretq_u16_s16(ax);
+        const int16x8_t  t22 = vreinterpretq_s16_u16(vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(axu), tan22), 16),
+                                                                  vshrn_n_u32(vmull_u16(vget_high_u16(axu), tan22), 16)));
+        const int16x8_t  t67        = vaddq_s16(vshlq_n_s16(ax, 1), t22);
+        const uint16x8_t horizontal = vcltq_s16(ay, t22);
+        const uint16x8_t vertical   = vcgtq_s16(ay, t67);
+        const uint16x8_t opposite   = vcltq_s16(veorq_s16(gx, gy), zero);
+
+        const int16x8_t d1 = vbslq_s16(opposite, vld1q_s16(above + x + 1), vld1q_s16(above + x - 1));
+        const int16x8_t d2 = vbslq_s16(opposite, vld1q_s16(below + x - 1), vld1q_s16(below + x + 1));
+        const int16x8_t n1 = vbslq_s16(horizontal, vld1q_s16(center + x - 1), vbslq_s16(vertical, vld1q_s16(above + x), d1));
+        const int16x8_t n2 = vbslq_s16(horizontal, vld1q_s16(center + x + 1), vbslq_s16(vertical, vld1q_s16(below + x), d2));
+
+        const uint16x8_t isMaximum = vandq_u16(vcgtq_s16(m, n1), vcgeq_s16(m, n2));
+        uint16x8_t cls = vaddq_u16(vandq_u16(vcgtq_s16(m, lowV), one), vandq_u16(vcgtq_s16(m, highV), one));
+        cls = vandq_u16(cls, isMaximum);
+        vst1_u8(classes + x, vmovn_u16(cls));
+    }
+
+    for (; x < width - 1; x++) {
+        classes[x] = suppressPixel(above, center, below, x, dx[x], dy[x], low, high);
+    }
+    classes[width - 1] = EdgeNone;
+}
+
+static int collectStrongNEON(const uint8_t* classes, int width, int32_t* positions) {
+    const uint8x16_t strong = vdupq_n_u8(EdgeStrong);
+    int count = 0;
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        // No movemask on NEON: skip empty blocks, which are the vast majority, then scan the others
+        const uint8x16_t equal = vceqq_u8(vld1q_u8(classes + x), strong);
+        const uint8x8_t  any   = vorr_u8(vget_low_u8(equal), vget_high_u8(equal));
+        if (vget_lane_u64(vreinterpret_u64_u8(any), 0) == 0) continue;
+        for (int i = x; i < x + 16; i++) {
+            if (classes[i] == EdgeStrong) positions[count++] = i;
+        }
+    }
+    for (; x < width; x++) {
+        if (classes[x] == EdgeStrong) positions[count++] = x;
+    }
+    return count;
+}
+
+static void finalizeRowNEON(uint8_t* classes, int width) {
+    const uint8x16_t confirmed = vdupq_n_u8(EdgeConfirmed);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        vst1q_u8(classes + x, vceqq_u8(vld1q_u8(classes + x), confirmed));
+    }
+    for (; x < width; x++) {
+        classes[x] = classes[x] == EdgeConfirmed ? 255 : 0;
+    }
+}
+
+const EdgeKernels* edgeKernelsNEON() {
+    static const EdgeKernels kernels = { sobelRowNEON, suppressRowNEON, collectStrongNEON, finalizeRowNEON };
+    return &kernels;
+}
+
+#else
+
+const EdgeKernels* edgeKernelsNEON() { return nullptr; }
+
+#endif
+
+} // namespace detail
+} // namespace irl
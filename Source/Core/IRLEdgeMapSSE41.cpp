@@ -0,0 +1,137 @@
+//
+//  IRLEdgeMapSSE41.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  SSE4.1 edge kernels, 8 pixels per iteration in 16 bit lanes.
+//
+
+#include "IRLEdgeKernels.hpp"
+
+#if IRL_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace irl {
+namespace detail {
+
+#if IRL_SIMD_X86
+
+IRL_TARGET_SSE41 static inline __m128i loadWidened(const uint8_t* p) {
+    return _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+}
+
+IRL_TARGET_SSE41 static inline __m128i load16(const int16_t* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+IRL_TARGET_SSE41 static void sobelRowSSE41(const uint8_t* above, const uint8_t* center, const uint8_t* below, int width,
+                                           int16_t* dx, int16_t* dy, int16_t* magnitude) {
+    sobelPixel(above, center, below, 0, 0, width > 1 ? 1 : 0, dx[0], dy[0], magnitude[0]);
+
+    int x = 1;
+    for (; x + 9 <= width; x += 8) {
+        const __m128i aL = loadWidened(above + x - 1), aM = loadWidened(above + x), aR = loadWidened(above + x + 1);
+        const __m128i cL = loadWidened(center + x - 1),                             cR = loadWidened(center + x + 1);
+        const __m128i bL = loadWidened(below + x - 1), bM = loadWidened(below + x), bR = loadWidened(below + x + 1);
+
+        const __m128i gx = _mm_add_epi16(_mm_add_epi16(_mm_sub_epi16(aR, aL), _mm_sub_epi16(bR, bL)),
+                                         _mm_slli_epi16(_mm_sub_epi16(cR, cL), 1));
+        const __m128i gy = _mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(bL, bR), _mm_slli_epi16(bM, 1)),
+                                         _mm_add_epi16(_mm_add_epi16(aL, aR), _mm_slli_epi16(aM, 1)));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dx + x), gx);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dy + x), gy);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(magnitude + x), _mm_add_epi16(_mm_abs_epi16(gx), _mm_abs_epi16(gy)));
+    }
+
+    for (; x < width; x++) {
+        sobelPixel(above, center, below, x - 1, x, x + 1 < width ? x + 1 : x, dx[x], dy[x], magnitude[x]);
+    }
+}
+
+IRL_TARGET_SSE41 static void suppressRowSSE41(const int16_t* above, const int16_t* center, const int16_t* below,
+                                              const int16_t* dx, const int16_t* dy, int width, int low, int high,
+                                              uint8_t* classes) {
+    const __m128i tan22 = _mm_set1_epi16(static_cast<int16_t>(kTan22Q16));
+    const __m128i lowV  = _mm_set1_epi16(static_cast<int16_t>(low));
+    const __m128i highV = _mm_set1_epi16(static_cast<int16_t>(high));
+    const __m128i one   = _mm_set1_epi16(1);
+    const __m128i zero  = _mm_setzero_si128();
+
+    classes[0] = EdgeNone;
+    int x = 1;
+    for (; x + 9 <= width; x += 8) {
+        const __m128i m  = load16(center + x);
+        const __m128i gx = load16(dx + x);
+        const __m128i gy = load16(dy + x);
+        const __m128i ax = _mm_abs_epi16(gx);
+        const __m128i ay = _mm_abs_epi16(gy);
+
+        const __m128i t22           = _mm_mulhi_epu16(ax, tan22);
+        const __m128i t67           = _mm_add_epi16(_mm_slli_epi16(ax, 1), t22);
+        const __m128i horizontal    = _mm_cmplt_epi16(ay, t22);
+        const __m128i vertical      = _mm_cmpgt_epi16(ay, t67);
+        const __m128i opposite      = _mm_cmplt_epi16(_mm_xor_si128(gx, gy), zero);
+
+        const __m128i d1 = _mm_blendv_epi8(load16(above + x - 1), load16(above + x + 1), opposite);
+        const __m128i d2 = _mm_blendv_epi8(load16(below + x + 1), load16(below + x - 1), opposite);
+        const __m128i n1 = _mm_blendv_epi8(_mm_blendv_epi8(d1, load16(above + x), vertical), load16(center + x - 1), horizontal);
+        const __m128i n2 = _mm_blendv_epi8(_mm_blendv_epi8(d2, load16(below + x), vertical), load16(center + x + 1), horizontal);
+
+        const __m128i isMaximum = _mm_andnot_si128(_mm_cmpgt_epi16(n2, m), _mm_cmpgt_epi16(m, n1));
+        __m128i cls = _mm_add_epi16(_mm_and_si128(_mm_cmpgt_epi16(m, lowV), one), _mm_and_si128(_mm_cmpgt_epi16(m, highV), one));
+        cls = _mm_and_si128(cls, isMaximum);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(classes + x), _mm_packus_epi16(cls, zero));
+    }
+
+    for (; x < width - 1; x++) {
+        classes[x] = suppressPixel(above, center, below, x, dx[x], dy[x], low, high);
+    }
+    classes[width - 1] = EdgeNone;
+}
+
+IRL_TARGET_SSE41 static int collectStrongSSE41(const uint8_t* classes, int width, int32_t* positions) {
+    const __m128i strong = _mm_set1_epi8(EdgeStrong);
+    int count = 0;
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(classes + x)), strong)));
+        while (mask) {
+            positions[count++] = x + __builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+    }
+    for (; x < width; x++) {
+        if (classes[x] == EdgeStrong) positions[count++] = x;
+    }
+    return count;
+}
+
+IRL_TARGET_SSE41 static void finalizeRowSSE41(uint8_t* classes, int width) {
+    const __m128i confirmed = _mm_set1_epi8(EdgeConfirmed);
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i* p = reinterpret_cast<__m128i*>(classes + x);
+        _mm_storeu_si128(p, _mm_cmpeq_epi8(_mm_loadu_si128(p), confirmed));
+    }
+    for (; x < width; x++) {
+        classes[x] = classes[x] == EdgeConfirmed ? 255 : 0;
+    }
+}
+
+const EdgeKernels* edgeKernelsSSE41() {
+    static const EdgeKernels kernels = { sobelRowSSE41, suppressRowSSE41, collectStrongSSE41, finalizeRowSSE41 };
+    return &kernels;
+}
+
+#else
+
+const EdgeKernels* edgeKernelsSSE41() { return nullptr; }
+
+#endif
+
+} // namespace detail
+} // namespace irl
@@ -0,0 +1,226 @@
+//
+//  IRLGuidedFilter.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLGuidedFilter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace irl {
+
+static const int kBandHeight    = 128;
+static const int kMaximumRadius = 64;
+static const float kOne         = 65536.0f;   // 1 in the Q16 coefficients
+
+GuidedFilter::GuidedFilter(const GuidedFilterOptions& options) {
+    setOptions(options);
+}
+
+void GuidedFilter::setOptions(const GuidedFilterOptions& options) {
+    _options = options;
+    _radius  = std::min(std::max(options.radius, 1), kMaximumRadius);
+    _epsilon = std::max(options.epsilon, 1e-6f) * 255.0f * 255.0f;
+}
+
+void GuidedFilter::prepare(int width) {
+    _inverseColumns.resize(static_cast<size_t>(std::max(width, 0)));
+    for (int x = 0; x < width; x++) {
+        _inverseColumns[static_cast<size_t>(x)] = 1.0f / static_cast<float>(std::min(x + _radius, width - 1) - std::max(x - _radius, 0) + 1);
+    }
+}
+
+// MARK: - Box sums
+
+/** Sums of `values` over [x - radius, x + radius], clipped to the row, with one add and one subtract per pixel */
+template <typename T>
+static void boxRow(const T* values, int width, int radius, T* sums) {
+    T sum = 0;
+    for (int x = 0; x <= std::min(radius, width - 1); x++) sum += values[x];
+    for (int x = 0; x < width; x++) {
+        sums[x] = sum;
+        if (x + radius + 1 < width) sum += values[x + radius + 1];
+        if (x - radius >= 0)        sum -= values[x - radius];
+    }
+}
+
+template <typename T, typename V>
+static void addRow(T* sums, const V* row, int width, int sign) {
+    for (int x = 0; x < width; x++) sums[x] += sign * static_cast<T>(row[x]);
+}
+
+static void addSquaredRow(int32_t* sums, const uint8_t* row, int width, int sign) {
+    for (int x = 0; x < width; x++) sums[x] += sign * row[x] * row[x];
+}
+
+/** Coefficients a and b of row `y`, in Q16. The luma column sums cover the rows of its window. */
+static void coefficientRow(const int32_t* sumI, const int32_t* sumII, int width, int radius, int rows, const float* inverseColumns,
+                           float epsilon, int32_t* boxI, int32_t* boxII, int32_t* a, int32_t* b) {
+    boxRow(sumI, width, radius, boxI);
+    boxRow(sumII, width, radius, boxII);
+
+    const float inverseRows = 1.0f / static_cast<float>(rows);
+    for (int x = 0; x < width; x++) {
+        const float inverse  = inverseRows * inverseColumns[x];
+        const float mean     = static_cast<float>(boxI[x]) * inverse;
+        const float variance = std::max(static_cast<float>(boxII[x]) * inverse - mean * mean, 0.0f);
+        const float slope    = variance / (variance + epsilon);
+        a[x] = static_cast<int32_t>(std::lrint(slope * kOne));
+        b[x] = static_cast<int32_t>(std::lrint((mean - slope * mean) * kOne));
+    }
+}
+
+// MARK: - Streaming
+
+void GuidedFilter::beginBand(Band& band, int width, int height, PixelFormat format, int first) const {
+    const size_t count = static_cast<size_t>(width);
+    band.width    = width;
+    band.height   = height;
+    band.channels = static_cast<int>(bytesPerPixel(format));
+    band.pixels.resize(count * band.channels * ringSize());
+    band.luma.resize(count * ringSize());
+    band.sumI.assign(count, 0);
+    band.sumII.assign(count, 0);
+    band.boxI.resize(count);
+    band.boxII.resize(count);
+    band.sumA.assign(count, 0);
+    band.sumB.assign(count, 0);
+    band.meanA.resize(count);
+    band.meanB.resize(count);
+    band.ringA.resize(count * (2 * _radius + 1));
+    band.ringB.resize(count * (2 * _radius + 1));
+
+    // Output row `first` averages the coefficients from `first - radius`, each fitted on the luma from `radius` rows above
+    band.coefficientLow  = std::max(first - _radius, 0);
+    band.coefficientHigh = band.coefficientLow - 1;
+    band.lumaLow         = std::max(band.coefficientLow - _radius, 0);
+    band.lumaHigh        = band.lumaLow - 1;
+    band.next            = band.lumaLow;
+}
+
+int GuidedFilter::pendingRow(const Band& band, int y) const {
+    return band.next <= std::min(y + 2 * _radius, band.height - 1) ? band.next : -1;
+}
+
+uint8_t* GuidedFilter::rowBuffer(Band& band) const {
+    return band.pixels.data() + static_cast<size_t>(band.next % ringSize()) * band.width * band.channels;
+}
+
+void GuidedFilter::pushRow(Band& band) const {
+    const size_t    slot   = static_cast<size_t>(band.next % ringSize());
+    const uint8_t*  pixels = band.pixels.data() + slot * band.width * band.channels;
+    uint8_t*        luma   = band.luma.data() + slot * band.width;
+
+    if (band.channels == 1) {
+        std::memcpy(luma, pixels, static_cast<size_t>(band.width));
+    } else {
+        // BT.601 in Q8, as `convertToLuma`
+        for (int x = 0; x < band.width; x++, pixels += 4) {
+            luma[x] = static_cast<uint8_t>((29 * pixels[0] + 150 * pixels[1] + 77 * pixels[2] + 128) >> 8);
+        }
+    }
+    band.next++;
+}
+
+void GuidedFilter::filterRow(Band& band, int y, uint8_t* destination) const {
+    const int    width  = band.width, height = band.height, radius = _radius;
+    const int    ring   = 2 * radius + 1;
+    const size_t count  = static_cast<size_t>(width);
+    const int    low    = std::max(y - radius, 0), high = std::min(y + radius, height - 1);
+    auto lumaRow = [&](int row) { return band.luma.data() + static_cast<size_t>(row % ringSize()) * count; };
+
+    for (; band.coefficientLow < low; band.coefficientLow++) {
+        const size_t slot = static_cast<size_t>(band.coefficientLow % ring) * count;
+        addRow(band.sumA.data(), band.ringA.data() + slot, width, -1);
+        addRow(band.sumB.data(), band.ringB.data() + slot, width, -1);
+    }
+    while (band.coefficientHigh < high) {
+        band.coefficientHigh++;
+        // The luma rows that left the window are still in the ring, which holds the windows of the first row of the band
+        const int top = std::max(band.coefficientHigh - radius, 0), bottom = std::min(band.coefficientHigh + radius, height - 1);
+        for (; band.lumaHigh < bottom; band.lumaHigh++) {
+            addRow(band.sumI.data(), lumaRow(band.lumaHigh + 1), width, 1);
+            addSquaredRow(band.sumII.data(), lumaRow(band.lumaHigh + 1), width, 1);
+        }
+        for (; band.lumaLow < top; band.lumaLow++) {
+            addRow(band.sumI.data(), lumaRow(band.lumaLow), width, -1);
+            addSquaredRow(band.sumII.data(), lumaRow(band.lumaLow), width, -1);
+        }
+
+        const size_t slot = static_cast<size_t>(band.coefficientHigh % ring) * count;
+        int32_t* a = band.ringA.data() + slot;
+        int32_t* b = band.ringB.data() + slot;
+        coefficientRow(band.sumI.data(), band.sumII.data(), width, radius, bottom - top + 1, _inverseColumns.data(), _epsilon,
+                       band.boxI.data(), band.boxII.data(), a, b);
+        addRow(band.sumA.data(), a, width, 1);
+        addRow(band.sumB.data(), b, width, 1);
+    }
+
+    // q = mean(a) I + mean(b), the luma change is added to every channel
+    boxRow(band.sumA.data(), width, radius, band.meanA.data());
+    boxRow(band.sumB.data(), width, radius, band.meanB.data());
+    const float    inverseRows = 1.0f / (static_cast<float>(high - low + 1) * kOne);
+    const uint8_t* guide  = lumaRow(y);
+    const uint8_t* pixels = band.pixels.data() + static_cast<size_t>(y % ringSize()) * count * band.channels;
+    for (int x = 0; x < width; x++) {
+        const float inverse = inverseRows * _inverseColumns[static_cast<size_t>(x)];
+        const float value   = static_cast<float>(band.meanA[static_cast<size_t>(x)] * guide[x] + band.meanB[static_cast<size_t>(x)]) * inverse;
+        const int   change  = static_cast<int>(std::lrint(value - guide[x]));
+        if (band.channels == 1) {
+            destination[x] = static_cast<uint8_t>(std::min(std::max(pixels[x] + change, 0), 255));
+        } else {
+            for (int c = 0; c < 3; c++) destination[4 * x + c] = static_cast<uint8_t>(std::min(std::max(pixels[4 * x + c] + change, 0), 255));
+            destination[4 * x + 3] = pixels[4 * x + 3];
+        }
+    }
+}
+
+// MARK: - Apply
+
+void GuidedFilter::apply(const ImageView& source, uint8_t* destination, size_t stride) {
+    if (source.isEmpty()) return;
+
+    const int       width    = source.width, height = source.height;
+    const size_t    rowBytes = static_cast<size_t>(width) * bytesPerPixel(source.format);
+    const int       reach    = 2 * _radius;     // rows read past the edges of a band
+
+    // In place, a band reads rows its neighbours write: the `reach` rows on both sides of every band edge are kept aside
+    const bool inPlace = destination < source.data + source.stride * static_cast<size_t>(height) &&
+                         source.data < destination + stride * static_cast<size_t>(height);
+    const int  edges   = (height - 1) / kBandHeight;
+    if (inPlace) {
+        _halo.resize(rowBytes * 2 * reach * static_cast<size_t>(edges));
+        for (int edge = 1; edge <= edges; edge++) {
+            for (int row = std::max(edge * kBandHeight - reach, 0); row < std::min(edge * kBandHeight + reach, height); row++) {
+                const size_t slot = static_cast<size_t>(edge - 1) * 2 * reach + (row - edge * kBandHeight + reach);
+                std::memcpy(_halo.data() + slot * rowBytes, source.row(row), rowBytes);
+            }
+        }
+    }
+
+    TileExecutor& executor = executorForThreads(_options.threads, _executor);
+    prepare(width);
+    if (static_cast<int>(_bands.size()) < executor.threadCount()) _bands.resize(static_cast<size_t>(executor.threadCount()));
+
+    executor.runBands(width, height, kBandHeight, [&](const Tile& tile, int worker) {
+        Band& band = _bands[static_cast<size_t>(worker)];
+        const int top = tile.y, bottom = tile.y + tile.height;
+        auto rowOf = [&](int row) {
+            if (!inPlace || (row >= top && row < bottom)) return source.row(row);
+            const int edge = row < top ? top / kBandHeight : bottom / kBandHeight;
+            return static_cast<const uint8_t*>(_halo.data() + (static_cast<size_t>(edge - 1) * 2 * reach + (row - edge * kBandHeight + reach)) * rowBytes);
+        };
+
+        beginBand(band, width, height, source.format, top);
+        for (int y = top; y < bottom; y++) {
+            for (int row; (row = pendingRow(band, y)) >= 0; pushRow(band)) std::memcpy(rowBuffer(band), rowOf(row), rowBytes);
+            filterRow(band, y, destination + stride * static_cast<size_t>(y));
+        }
+    });
+}
+
+} // namespace irl
@@ -0,0 +1,117 @@
+//
+//  IRLGuidedFilter.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Edge preserving denoise for torch and low light captures: the guided filter of He, Sun and
+//  Tang, guided by the image itself. In every window the luma is fitted as `a * I + b`: flat
+//  areas, whose variance is below epsilon, get a ~ 0 and come out as their mean, edges and
+//  text strokes get a ~ 1 and are kept. Every mean is a box filter made of running sums, so
+//  the cost per pixel does not depend on the radius. The coefficients are summed in Q16 integers:
+//  the sums are exact, so a row comes out the same wherever its band starts.
+//
+//  Colors are not filtered separately: the change of the luma is added to the three channels.
+//  That removes the luma noise, which is most of what the JPEG encoder spends its bytes on,
+//  for the price of one row of luma per row of pixels.
+//
+//  Rows are streamed through a `Band` the way `UnsharpMask` does it: a row of output reads the
+//  2 radius rows on both sides of it, the band keeps 4 radius + 1 rows and never a whole plane,
+//  so `PageRenderer` can denoise the warped rows of a page as they are sampled.
+//
+
+#ifndef IRL_GUIDED_FILTER_HPP
+#define IRL_GUIDED_FILTER_HPP
+
+#include "IRLImage.hpp"
+#include "IRLTileExecutor.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace irl {
+
+/** @brief Tuning of `GuidedFilter` */
+struct GuidedFilterOptions {
+    /** Half size of the windows: 4 averages 9x9 pixels. At most 64. */
+    int     radius      = 4;
+
+    /** Variance, in (1/255)² units, under which a window is taken as flat. 0.01 smooths up to a noise sigma of ~25 levels. */
+    float   epsilon     = 0.01f;
+
+    /** Threads used for one image, 0 to share `TileExecutor::shared()` with the other stages. */
+    int     threads     = 0;
+};
+
+/**
+ @brief Self guided filter on BGRA8 or Gray8 images.
+ @discussion The options and tables are read only during a pass, so the workers of one image share the instance and keep
+ their rows in a `Band` each. Bands of rows are filtered on all the cores, the result does not depend on the thread count.
+ Buffers are kept between calls. Not thread safe otherwise, use one instance per queue.
+ */
+class GuidedFilter {
+public:
+    /** @brief Streaming state of one band of rows. Buffers are kept between bands. */
+    struct Band {
+        std::vector<uint8_t>    pixels;             // ring of source rows, row `y` in slot y % (4 radius + 1)
+        std::vector<uint8_t>    luma;               // and their luma, the guide
+        std::vector<int32_t>    sumI, sumII;        // luma column sums over the rows of the current window
+        std::vector<int32_t>    boxI, boxII;        // and over the window of each pixel
+        std::vector<int64_t>    sumA, sumB;         // same for the coefficients, in Q16
+        std::vector<int32_t>    ringA, ringB;       // coefficient rows still in the window, 2 radius + 1 of them
+        std::vector<int64_t>    meanA, meanB;       // box sums of one output row
+        int                     width       = 0;
+        int                     height      = 0;
+        int                     channels    = 0;
+        int                     next        = 0;    // next source row to push
+        int                     lumaLow     = 0;    // luma rows in `sumI` and `sumII`
+        int                     lumaHigh    = 0;
+        int                     coefficientLow  = 0;    // coefficient rows in `sumA` and `sumB`
+        int                     coefficientHigh = 0;
+    };
+
+    explicit GuidedFilter(const GuidedFilterOptions& options = GuidedFilterOptions());
+
+    const GuidedFilterOptions&  options() const { return _options; }
+    void                        setOptions(const GuidedFilterOptions& options);
+
+    /** @brief Prepare a pass over images `width` wide. Call before the bands start, they only read the tables. */
+    void prepare(int width);
+
+    /** @brief Start `band` at output row `first` of an image `height` rows high, in `format` */
+    void beginBand(Band& band, int width, int height, PixelFormat format, int first) const;
+
+    /** @return The next source row `band` needs before output row `y` can be filtered, or -1 when it has them all */
+    int pendingRow(const Band& band, int y) const;
+
+    /** @return Where to write the pixels of source row `pendingRow`, then call `pushRow` */
+    uint8_t* rowBuffer(Band& band) const;
+
+    /** @brief Take the row written in `rowBuffer` */
+    void pushRow(Band& band) const;
+
+    /** @brief Write output row `y`, once `pendingRow(band, y)` is -1. Rows are filtered in order. */
+    void filterRow(Band& band, int y, uint8_t* destination) const;
+
+    /**
+     @brief Filter `source` into `destination`, same format and size. Alpha is kept.
+     @param destination At least `source.height` rows of `stride` bytes. May be `source.data` itself: the rows around the
+     bands are then copied first, 4 radius per band.
+     */
+    void apply(const ImageView& source, uint8_t* destination, size_t stride);
+
+private:
+    int ringSize() const { return 4 * _radius + 1; }
+
+    GuidedFilterOptions             _options;
+    int                             _radius     = 4;
+    float                           _epsilon    = 0.0f;     // in levels²
+    std::vector<float>              _inverseColumns;        // 1 / columns in the window of each x
+    std::vector<Band>               _bands;                 // of `apply`, one per worker
+    std::vector<uint8_t>            _halo;                  // rows around the bands of an in place `apply`
+    std::unique_ptr<TileExecutor>   _executor;              // when `threads` is set
+};
+
+} // namespace irl
+
+#endif /* IRL_GUIDED_FILTER_HPP */
@@ -0,0 +1,88 @@
+//
+//  IRLHomography.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLHomography.hpp"
+
+#include <utility>
+
+namespace irl {
+
+Homography Homography::inverse() const {
+    // Adjugate over the determinant
+    const double* a = m;
+    Homography H;
+    H.m[0] = a[4] * a[8] - a[5] * a[7];  H.m[1] = a[2] * a[7] - a[1] * a[8];  H.m[2] = a[1] * a[5] - a[2] * a[4];
+    H.m[3] = a[5] * a[6] - a[3] * a[8];  H.m[4] = a[0] * a[8] - a[2] * a[6];  H.m[5] = a[2] * a[3] - a[0] * a[5];
+    H.m[6] = a[3] * a[7] - a[4] * a[6];  H.m[7] = a[1] * a[6] - a[0] * a[7];  H.m[8] = a[0] * a[4] - a[1] * a[3];
+
+    const double determinant = a[0] * H.m[0] + a[1] * H.m[3] + a[2] * H.m[6];
+    if (determinant == 0.0) return Homography();
+
+    // A projective transform is defined up to a scale: divide by m[8] so maps and compositions stay well scaled
+    const double scale = H.m[8] != 0.0 ? 1.0 / H.m[8] : 1.0 / determinant;
+    for (double& value : H.m) value *= scale;
+    return H;
+}
+
+/** @return true when three of the 4 points are on a line, relative to the size of their spread */
+static bool hasCollinearTriple(const Point p[4]) {
+    double extent = 0.0;
+    for (int i = 1; i < 4; i++) extent = std::max(extent, static_cast<double>(distance(p[0], p[i])));
+    for (int skipped = 0; skipped < 4; skipped++) {
+        const Point& a = p[skipped == 0 ? 1 : 0];
+        const Point& b = p[skipped <= 1 ? 2 : 1];
+        const Point& c = p[skipped <= 2 ? 3 : 2];
+        const double area = (static_cast<double>(b.x) - a.x) * (static_cast<double>(c.y) - a.y) -
+                            (static_cast<double>(b.y) - a.y) * (static_cast<double>(c.x) - a.x);
+        if (std::fabs(area) <= 1e-9 * extent * extent) return true;
+    }
+    return false;
+}
+
+bool Homography::solve(const Point from[4], const Point to[4], Homography& H) {
+    if (hasCollinearTriple(from) || hasCollinearTriple(to)) return false;
+
+    // Each pair gives two rows: u = (h0 x + h1 y + h2) / (h6 x + h7 y + 1), same for v with h3 h4 h5
+    double A[8][9];
+    for (int i = 0; i < 4; i++) {
+        const double x = from[i].x, y = from[i].y, u = to[i].x, v = to[i].y;
+        double* r = A[2 * i];
+        r[0] = x; r[1] = y; r[2] = 1.0; r[3] = 0.0; r[4] = 0.0; r[5] = 0.0; r[6] = -u * x; r[7] = -u * y; r[8] = u;
+        r = A[2 * i + 1];
+        r[0] = 0.0; r[1] = 0.0; r[2] = 0.0; r[3] = x; r[4] = y; r[5] = 1.0; r[6] = -v * x; r[7] = -v * y; r[8] = v;
+    }
+
+    // Coordinates are pixels, up to thousands: a relative pivot tolerance keeps the test independent of the scale
+    double largest = 0.0;
+    for (auto& row : A) for (int c = 0; c < 8; c++) largest = std::max(largest, std::fabs(row[c]));
+    const double tolerance = 1e-12 * largest;
+
+    for (int c = 0; c < 8; c++) {
+        int pivot = c;
+        for (int r = c + 1; r < 8; r++) if (std::fabs(A[r][c]) > std::fabs(A[pivot][c])) pivot = r;
+        if (std::fabs(A[pivot][c]) <= tolerance) return false;
+        if (pivot != c) std::swap(A[pivot], A[c]);
+
+        for (int r = c + 1; r < 8; r++) {
+            const double factor = A[r][c] / A[c][c];
+            for (int k = c; k < 9; k++) A[r][k] -= factor * A[c][k];
+        }
+    }
+
+    double h[8];
+    for (int r = 7; r >= 0; r--) {
+        double sum = A[r][8];
+        for (int k = r + 1; k < 8; k++) sum -= A[r][k] * h[k];
+        h[r] = sum / A[r][r];
+    }
+
+    std::copy(h, h + 8, H.m);
+    H.m[8] = 1.0;
+    return true;
+}
+
+} // namespace irl
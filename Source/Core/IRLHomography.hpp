@@ -0,0 +1,96 @@
+//
+//  IRLHomography.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Projective mapping between the rectified page and the document quad of a frame, the
+//  transform behind `CIPerspectiveCorrection`.
+//
+
+#ifndef IRL_HOMOGRAPHY_HPP
+#define IRL_HOMOGRAPHY_HPP
+
+#include "IRLQuad.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace irl {
+
+/**
+ @brief 3x3 projective transform, row major, applied to (x, y, 1).
+ @discussion Coefficients are kept in double: the warp evaluates them at millions of pixels far from the origin.
+ */
+struct Homography {
+    double m[9] = { 1.0, 0.0, 0.0,  0.0, 1.0, 0.0,  0.0, 0.0, 1.0 };
+
+    /** @return The image of `p` */
+    Point map(Point p) const {
+        const double w = m[6] * p.x + m[7] * p.y + m[8];
+        return Point(static_cast<float>((m[0] * p.x + m[1] * p.y + m[2]) / w),
+                     static_cast<float>((m[3] * p.x + m[4] * p.y + m[5]) / w));
+    }
+
+    /** @return The transform applying `other` first, then this one */
+    Homography operator*(const Homography& other) const {
+        Homography H;
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) {
+                H.m[3 * r + c] = m[3 * r] * other.m[c] + m[3 * r + 1] * other.m[3 + c] + m[3 * r + 2] * other.m[6 + c];
+            }
+        }
+        return H;
+    }
+
+    /** @return The inverse transform, normalized so m[8] is 1 when it can be. The identity when this one is singular. */
+    Homography inverse() const;
+
+    /**
+     @brief Solve the transform taking each of the 4 points `from` to the matching point of `to`.
+     @discussion The 8x8 linear system of the correspondences (m[8] = 1), by Gaussian elimination with partial pivoting.
+     @return false when three of the points of `from` or of `to` are on a line, `H` is then left as is
+     */
+    static bool solve(const Point from[4], const Point to[4], Homography& H);
+
+    /**
+     @return The transform taking the rectangle [0, width] x [0, height] to `quad`, corner to corner (top left at the origin).
+     @discussion Closed form of the unit square case (Heckbert), then scaled to the rectangle.
+     */
+    static Homography rectangleToQuad(double width, double height, const Quad& quad) {
+        const double x0 = quad.topLeft.x,     y0 = quad.topLeft.y;
+        const double x1 = quad.topRight.x,    y1 = quad.topRight.y;
+        const double x2 = quad.bottomRight.x, y2 = quad.bottomRight.y;
+        const double x3 = quad.bottomLeft.x,  y3 = quad.bottomLeft.y;
+
+        const double dx3 = x0 - x1 + x2 - x3, dy3 = y0 - y1 + y2 - y3;
+        double g = 0.0, h = 0.0;
+        if (dx3 != 0.0 || dy3 != 0.0) {
+            const double dx1 = x1 - x2, dx2 = x3 - x2;
+            const double dy1 = y1 - y2, dy2 = y3 - y2;
+            const double determinant = dx1 * dy2 - dx2 * dy1;
+            if (determinant != 0.0) {
+                g = (dx3 * dy2 - dx2 * dy3) / determinant;
+                h = (dx1 * dy3 - dx3 * dy1) / determinant;
+            }
+        }
+
+        Homography H;
+        H.m[0] = (x1 - x0 + g * x1) / width;  H.m[1] = (x3 - x0 + h * x3) / height; H.m[2] = x0;
+        H.m[3] = (y1 - y0 + g * y1) / width;  H.m[4] = (y3 - y0 + h * y3) / height; H.m[5] = y0;
+        H.m[6] = g / width;                   H.m[7] = h / height;                  H.m[8] = 1.0;
+        return H;
+    }
+};
+
+/**
+ @brief Size of the page rectified from `quad`, the longest of each pair of opposite sides like `CIPerspectiveCorrection`.
+ */
+inline void rectifiedSize(const Quad& quad, int& width, int& height) {
+    width  = static_cast<int>(std::lround(std::max(distance(quad.topLeft, quad.topRight),   distance(quad.bottomLeft, quad.bottomRight))));
+    height = static_cast<int>(std::lround(std::max(distance(quad.topLeft, quad.bottomLeft), distance(quad.topRight, quad.bottomRight))));
+}
+
+} // namespace irl
+
+#endif /* IRL_HOMOGRAPHY_HPP */
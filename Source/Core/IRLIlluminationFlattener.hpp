@@ -0,0 +1,94 @@
+//
+//  IRLIlluminationFlattener.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Shadow and lamp gradient removal. The paper background is estimated on a small pyramid
+//  level: a morphological close (max then min filter) wipes the text out, a blur smooths the
+//  result. Each pixel is then divided by the background around it, in one streaming pass at
+//  full resolution, so the paper comes out evenly white whatever the lighting.
+//
+//  The estimation works on 1 / 4^level of the pixels, the full resolution pass is a
+//  multiply per channel: the cost is a fixed amount per pixel plus a small fraction for the
+//  background.
+//
+
+#ifndef IRL_ILLUMINATION_FLATTENER_HPP
+#define IRL_ILLUMINATION_FLATTENER_HPP
+
+#include "IRLImage.hpp"
+#include "IRLPyramid.hpp"
+#include "IRLTileExecutor.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace irl {
+
+/** @brief Tuning of `IlluminationFlattener` */
+struct IlluminationOptions {
+    /** Pyramid level of the background estimation: 4 estimates it on 1/16 of the width and height. */
+    int     level           = 4;
+
+    /** Radius of the close, as a fraction of the smaller image dimension. Must exceed half the thickness of the text strokes. */
+    float   closeFraction   = 0.015f;
+
+    /** Blur passes (3x3 binomial) on the closed background. */
+    int     blurPasses      = 3;
+
+    /** Level the paper is brought to. */
+    int     target          = 240;
+
+    /** Largest gain applied to a pixel, so black areas (desk, photos) are not blown out. At most 16. */
+    float   maximumGain     = 6.0f;
+
+    /** Threads of the full resolution pass, 0 to share `TileExecutor::shared()` with the other stages. */
+    int     threads         = 0;
+};
+
+/**
+ @brief Flattens uneven lighting of document images (BGRA8 or Gray8).
+ @discussion Colors are kept: the three channels of a pixel are multiplied by the same gain, computed from the luma.
+ Buffers are kept between calls. Not thread safe, use one instance per queue.
+ */
+class IlluminationFlattener {
+public:
+    explicit IlluminationFlattener(const IlluminationOptions& options = IlluminationOptions());
+
+    const IlluminationOptions&  options() const                             { return _options; }
+    void                        setOptions(const IlluminationOptions& options) { _options = options; }
+
+    /**
+     @brief Flatten `source` into `destination`, same format and size.
+     @param destination At least `source.height` rows of `stride` bytes. May be `source.data` itself.
+     */
+    void apply(const ImageView& source, uint8_t* destination, size_t stride);
+
+    /** @return The background estimated by the last `apply`, at the estimation level */
+    const Plane8& background() const { return _background; }
+
+    /** @return The pyramid level of the last estimation, lower than `options().level` on small sources */
+    int level() const { return _level; }
+
+private:
+    void estimate(const ImageView& source);
+
+    IlluminationOptions             _options;
+    LumaPyramid                     _pyramid;
+    Plane8                          _luma;
+    Plane8                          _background;
+    Plane8                          _scratch;
+    std::vector<uint16_t>           _blurRows;
+    std::vector<uint16_t>           _gains;         // Q12, at the estimation level
+    std::vector<uint16_t>           _expanded;      // Q12, two rows interpolated horizontally per worker
+    std::vector<int32_t>            _columns;       // estimation column on the left of each pixel
+    std::vector<int32_t>            _weights;       // Q8 weight of the column on the right
+    int                             _level = 0;     // level actually used, lowered on small sources
+    std::unique_ptr<TileExecutor>   _executor;      // when `threads` is set
+};
+
+} // namespace irl
+
+#endif /* IRL_ILLUMINATION_FLATTENER_HPP */
@@ -0,0 +1,114 @@
+//
+//  IRLImage.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLImage.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace irl {
+
+void convertToLuma(const ImageView& source, Plane8& destination) {
+    destination.resize(source.width, source.height);
+    if (source.isEmpty()) return;
+
+    if (source.format == PixelFormat::Gray8) {
+        for (int y = 0; y < source.height; y++) {
+            std::memcpy(destination.row(y), source.row(y), static_cast<size_t>(source.width));
+        }
+        return;
+    }
+
+    // BT.601: Y = 0.299 R + 0.587 G + 0.114 B, weights in Q8
+    for (int y = 0; y < source.height; y++) {
+        const uint8_t*  src = source.row(y);
+        uint8_t*        dst = destination.row(y);
+        for (int x = 0; x < source.width; x++, src += 4) {
+            dst[x] = static_cast<uint8_t>((29 * src[0] + 150 * src[1] + 77 * src[2] + 128) >> 8);
+        }
+    }
+}
+
+static inline uint8_t clampByte(int value) {
+    return static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+}
+
+void convertToBGRA(const BiPlanarView& source, uint8_t* destination, size_t stride) {
+    if (source.isEmpty()) return;
+
+    // Full range BT.601, weights in Q14:
+    // R = Y + 1.402 Cr, G = Y - 0.344136 Cb - 0.714136 Cr, B = Y + 1.772 Cb
+    const int kRCr = 22970, kGCb = -5638, kGCr = -11700, kBCb = 29032;
+    const int kRound = 1 << 13;
+
+    const int width = source.luma.width;
+    const int pairs = width / 2;
+    for (int y = 0; y < source.luma.height; y++) {
+        const uint8_t*  luma    = source.luma.row(y);
+        const uint8_t*  chroma  = source.chromaRow(y >> 1);
+        uint8_t*        dst     = destination + static_cast<size_t>(y) * stride;
+
+        // One chroma pair drives two pixels, the last column of an odd width is done alone
+        for (int x = 0; x < (width + 1) / 2; x++) {
+            const int cb = chroma[2 * x] - 128, cr = chroma[2 * x + 1] - 128;
+            const int r  = kRCr * cr + kRound;
+            const int g  = kGCb * cb + kGCr * cr + kRound;
+            const int b  = kBCb * cb + kRound;
+
+            const int count = x < pairs ? 2 : 1;
+            for (int i = 0; i < count; i++) {
+                const int l = luma[2 * x + i] << 14;
+                uint8_t*  p = dst + 8 * x + 4 * i;
+                p[0] = clampByte((l + b) >> 14);
+                p[1] = clampByte((l + g) >> 14);
+                p[2] = clampByte((l + r) >> 14);
+                p[3] = 255;
+            }
+        }
+    }
+}
+
+void smoothBinomial3(const Plane8& source, Plane8& destination) {
+    std::vector<uint16_t> rows(static_cast<size_t>(source.width()) * 3);
+    smoothBinomial3(source, destination, rows.data());
+}
+
+void smoothBinomial3(const Plane8& source, Plane8& destination, uint16_t* rows) {
+    const int width  = source.width();
+    const int height = source.height();
+    destination.resize(width, height);
+    if (width == 0 || height == 0) return;
+
+    // Horizontal pass into a rolling window of three rows
+    auto horizontal = [&](int y, uint16_t* out) {
+        const uint8_t* src = source.row(std::min(std::max(y, 0), height - 1));
+        if (width == 1) { out[0] = static_cast<uint16_t>(src[0] * 4); return; }
+        out[0] = static_cast<uint16_t>(3 * src[0] + src[1]);
+        for (int x = 1; x < width - 1; x++) {
+            out[x] = static_cast<uint16_t>(src[x - 1] + 2 * src[x] + src[x + 1]);
+        }
+        out[width - 1] = static_cast<uint16_t>(src[width - 2] + 3 * src[width - 1]);
+    };
+
+    uint16_t* above  = rows;
+    uint16_t* center = above + width;
+    uint16_t* below  = center + width;
+    horizontal(-1, above);
+    horizontal(0, center);
+
+    for (int y = 0; y < height; y++) {
+        horizontal(y + 1, below);
+        uint8_t* dst = destination.row(y);
+        for (int x = 0; x < width; x++) {
+            dst[x] = static_cast<uint8_t>((above[x] + 2 * center[x] + below[x] + 8) >> 4);
+        }
+        std::swap(above, center);
+        std::swap(center, below);
+    }
+}
+
+} // namespace irl
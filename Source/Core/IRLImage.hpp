@@ -0,0 +1,176 @@
+//
+//  IRLImage.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Portable pixel buffer types shared by the native detection and filtering core.
+//  Nothing in Source/Core depends on UIKit, CoreImage or CoreVideo so the same code
+//  runs on device and on our Linux reprocessing farm.
+//
+
+#ifndef IRL_IMAGE_HPP
+#define IRL_IMAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace irl {
+
+/** @brief Pixel layouts understood by the core. `BGRA8` matches `kCVPixelFormatType_32BGRA`. */
+enum class PixelFormat : uint8_t {
+    Gray8,
+    BGRA8
+};
+
+/** @return Number of bytes used by one pixel of `format` */
+inline int bytesPerPixel(PixelFormat format) {
+    return format == PixelFormat::BGRA8 ? 4 : 1;
+}
+
+/**
+ @brief Non owning view over an interleaved pixel buffer (e.g. a locked CVPixelBuffer).
+ @discussion `stride` is the number of bytes between two rows, as returned by CVPixelBufferGetBytesPerRow.
+ */
+struct ImageView {
+    const uint8_t*  data    = nullptr;
+    int             width   = 0;
+    int             height  = 0;
+    size_t          stride  = 0;
+    PixelFormat     format  = PixelFormat::Gray8;
+
+    ImageView() = default;
+    ImageView(const uint8_t* data, int width, int height, size_t stride, PixelFormat format)
+    : data(data), width(width), height(height), stride(stride), format(format) {}
+
+    /** @return Pointer to the first byte of row `y` */
+    const uint8_t* row(int y) const { return data + static_cast<size_t>(y) * stride; }
+
+    /** @return true when there is nothing to process */
+    bool isEmpty() const { return data == nullptr || width <= 0 || height <= 0; }
+};
+
+/**
+ @brief Non owning view over a 4:2:0 bi-planar buffer (`kCVPixelFormatType_420YpCbCr8BiPlanarFullRange`, a.k.a. NV12).
+ @discussion `luma` is the full resolution Y plane, directly usable as a Gray8 frame by every detector without a copy.
+ `chroma` points to the interleaved Cb Cr plane, half the width and half the height of `luma`, rounded up.
+ */
+struct BiPlanarView {
+    ImageView       luma;
+    const uint8_t*  chroma          = nullptr;
+    size_t          chromaStride    = 0;
+
+    BiPlanarView() = default;
+    BiPlanarView(const uint8_t* luma, int width, int height, size_t lumaStride, const uint8_t* chroma, size_t chromaStride)
+    : luma(luma, width, height, lumaStride, PixelFormat::Gray8), chroma(chroma), chromaStride(chromaStride) {}
+
+    /** @return Pointer to the first Cb Cr pair of chroma row `y`, which covers luma rows 2y and 2y + 1 */
+    const uint8_t* chromaRow(int y) const { return chroma + static_cast<size_t>(y) * chromaStride; }
+
+    /** @return true when there is nothing to process */
+    bool isEmpty() const { return luma.isEmpty() || chroma == nullptr; }
+};
+
+/**
+ @brief Owning single channel 8 bit image.
+ @discussion Rows are padded to 32 bytes so vector kernels can always load full registers.
+ Resizing keeps the allocation when the new size fits, so an instance can be reused from one frame to the next.
+ */
+class Plane8 {
+public:
+    Plane8() = default;
+    Plane8(int width, int height) { resize(width, height); }
+
+    /** @brief Resize the plane. Content is undefined afterwards. */
+    void resize(int width, int height) {
+        _width  = width;
+        _height = height;
+        _stride = (static_cast<size_t>(width) + 31u) & ~static_cast<size_t>(31u);
+        _storage.resize(_stride * static_cast<size_t>(height));
+    }
+
+    int             width()     const { return _width; }
+    int             height()    const { return _height; }
+    size_t          stride()    const { return _stride; }
+    uint8_t*        data()            { return _storage.data(); }
+    const uint8_t*  data()      const { return _storage.data(); }
+
+    uint8_t*        row(int y)        { return _storage.data() + static_cast<size_t>(y) * _stride; }
+    const uint8_t*  row(int y)  const { return _storage.data() + static_cast<size_t>(y) * _stride; }
+
+    /** @return A Gray8 view over the plane */
+    ImageView view() const { return ImageView(_storage.data(), _width, _height, _stride, PixelFormat::Gray8); }
+
+private:
+    std::vector<uint8_t>    _storage;
+    int                     _width  = 0;
+    int                     _height = 0;
+    size_t                  _stride = 0;
+};
+
+/**
+ @brief Owning 1 bit image, packed 8 pixels per byte with the leftmost pixel in the most significant bit.
+ @discussion A set bit is black, like PBM and CCITT (WhiteIsZero) bilevel data, so rows can be handed to such encoders as is.
+ Rows are padded to a whole byte, padding bits are 0.
+ */
+class BitPlane {
+public:
+    BitPlane() = default;
+    BitPlane(int width, int height) { resize(width, height); }
+
+    /** @brief Resize the plane. Content is undefined afterwards. */
+    void resize(int width, int height) {
+        _width  = width;
+        _height = height;
+        _stride = (static_cast<size_t>(width) + 7u) / 8u;
+        _storage.resize(_stride * static_cast<size_t>(height));
+    }
+
+    int             width()     const { return _width; }
+    int             height()    const { return _height; }
+    size_t          stride()    const { return _stride; }
+    uint8_t*        data()            { return _storage.data(); }
+    const uint8_t*  data()      const { return _storage.data(); }
+
+    uint8_t*        row(int y)        { return _storage.data() + static_cast<size_t>(y) * _stride; }
+    const uint8_t*  row(int y)  const { return _storage.data() + static_cast<size_t>(y) * _stride; }
+
+    /** @return true when pixel (x, y) is black */
+    bool isSet(int x, int y) const { return (row(y)[x >> 3] >> (7 - (x & 7))) & 1; }
+
+private:
+    std::vector<uint8_t>    _storage;
+    int                     _width  = 0;
+    int                     _height = 0;
+    size_t                  _stride = 0;
+};
+
+/**
+ @brief Extract the BT.601 luma of `source` into `destination`.
+ @discussion Gray8 sources are copied. The conversion is integer only so results are identical on every platform.
+ */
+void convertToLuma(const ImageView& source, Plane8& destination);
+
+/**
+ @brief Full range BT.601 YCbCr to BGRA conversion of a bi-planar frame, for the few consumers that need color.
+ @discussion Chroma is upsampled by replication, alpha is set to 255. The conversion is integer only (Q14 weights)
+ so results are identical on every platform. Detection should read `source.luma` instead.
+ @param destination At least `source.luma.height` rows of `stride` bytes
+ */
+void convertToBGRA(const BiPlanarView& source, uint8_t* destination, size_t stride);
+
+/**
+ @brief 3x3 binomial blur ([1 2 1] x [1 2 1] / 16), borders are replicated.
+ */
+void smoothBinomial3(const Plane8& source, Plane8& destination);
+
+/**
+ @brief Same as `smoothBinomial3`, without allocating.
+ @param rows Scratch buffer of 3 * source.width() values
+ */
+void smoothBinomial3(const Plane8& source, Plane8& destination, uint16_t* rows);
+
+} // namespace irl
+
+#endif /* IRL_IMAGE_HPP */
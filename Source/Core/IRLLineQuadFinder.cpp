@@ -0,0 +1,413 @@
+//
+//  IRLLineQuadFinder.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLLineQuadFinder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+
+namespace irl {
+
+static const int    kTileSize           = 32;
+static const float  kVoteSpread         = 2.0f;     // each pixel votes for the angles within 2 degrees of its gradient
+static const float  kPeakAngle          = 2.0f;     // accumulator non-maximum suppression window, +- 2 degrees
+static const int    kPeakRho            = 2;        // and +- 2 pixels
+static const float  kSupportAngle       = 4.0f;     // angle tolerance, in degrees, of the pixels supporting a line
+static const float  kSupportDistance    = 1.5f;     // distance tolerance, in pixels, of the pixels supporting a line
+static const int    kCoverageStep       = 4;        // pixels per occupancy bin along a line
+static const float  kParallelAngle      = 30.0f;    // opposite sides of a quad, in degrees
+static const float  kCrossingAngle      = 40.0f;    // adjacent sides of a quad, in degrees
+
+// MARK: - Helpers
+
+/**
+ Cosines and sines of the bin angles k * pi / bins, plus the cosines of the bin boundaries (k + 0.5) * pi / bins.
+ Built with a rotation recurrence from a Taylor series so the tables do not depend on the platform libm.
+ */
+static void buildAngleTables(int bins, float* cosines, float* sines, float* boundaries) {
+    const double step = 3.14159265358979323846 / bins;
+
+    auto rotation = [](double angle, double& c, double& s) {
+        double term = 1.0, cosine = 0.0, sine = 0.0;
+        for (int k = 0; k < 24; k++) {
+            if (k % 2 == 0) cosine += (k % 4 == 0 ? term : -term);
+            else            sine   += (k % 4 == 1 ? term : -term);
+            term *= angle / (k + 1);
+        }
+        c = cosine;
+        s = sine;
+    };
+
+    double cStep, sStep, cHalf, sHalf;
+    rotation(step, cStep, sStep);
+    rotation(0.5 * step, cHalf, sHalf);
+
+    double c = 1.0, s = 0.0;
+    double cb = cHalf, sb = sHalf;
+    for (int k = 0; k < bins; k++) {
+        cosines[k]      = static_cast<float>(c);
+        sines[k]        = static_cast<float>(s);
+        boundaries[k]   = static_cast<float>(cb);
+
+        const double nc = c * cStep - s * sStep, ns = s * cStep + c * sStep;
+        c = nc; s = ns;
+        const double nbc = cb * cStep - sb * sStep, nbs = sb * cStep + cb * sStep;
+        cb = nbc; sb = nbs;
+    }
+}
+
+/** @return Number of bins covering `degrees` */
+static inline int binsFor(float degrees, int bins) {
+    return std::max(1, static_cast<int>(std::ceil(degrees * bins / 180.0f)));
+}
+
+/** @return Distance between two angle bins, on the half circle */
+static inline int angleDistance(int a, int b, int bins) {
+    const int d = std::abs(a - b);
+    return std::min(d, bins - d);
+}
+
+static inline bool intersect(const HoughLine& a, const HoughLine& b, Point& point) {
+    const float det = cross(a.normal, b.normal);
+    if (std::fabs(det) < 1e-6f) return false;
+    point = Point((a.rho * b.normal.y - b.rho * a.normal.y) / det, (a.normal.x * b.rho - b.normal.x * a.rho) / det);
+    return true;
+}
+
+static inline Point direction(const HoughLine& line) {
+    return Point(-line.normal.y, line.normal.x);
+}
+
+// MARK: - LineQuadFinder
+
+LineQuadFinder::LineQuadFinder(const LineQuadFinderOptions& options)
+: _options(options) {}
+
+Span<const QuadCandidate> LineQuadFinder::find(const ImageView& frame) {
+    _arena.reset();
+    _points     = Span<EdgePoint>();
+    _lines      = Span<HoughLine>();
+    _candidates = Span<QuadCandidate>();
+    if (frame.isEmpty()) return _candidates;
+
+    int levels = 0;
+    while ((std::max(frame.width, frame.height) >> levels) > _options.maximumSearchSize
+           && (std::min(frame.width, frame.height) >> (levels + 1)) >= 64) levels++;
+    _level = levels;
+
+    _pyramid.build(frame, levels);
+    convertToLuma(_pyramid.level(levels), _luma);
+    smoothBinomial3(_luma, _smoothed, _arena.allocate<uint16_t>(3 * static_cast<size_t>(_luma.width())));
+    _edgeDetector.detect(_smoothed.view(), _options.edges, _edges);
+
+    // A line spans at most the level diagonal: with bins of pi / (pi * diagonal / 4), its rho drifts by 2 pixels at most
+    const float diagonal = std::sqrt(static_cast<float>(_edges.width()) * _edges.width() + static_cast<float>(_edges.height()) * _edges.height());
+    _angleBins = _options.angleBins > 0 ? std::max(_options.angleBins, 8)
+                                        : static_cast<int>(std::ceil(3.14159265f * diagonal / 4.0f));
+    const int bins = _angleBins;
+    _cosines = _arena.allocate<float>(static_cast<size_t>(bins));
+    _sines   = _arena.allocate<float>(static_cast<size_t>(bins));
+    float* boundaries = _arena.allocate<float>(static_cast<size_t>(bins));
+    buildAngleTables(bins, _cosines, _sines, boundaries);
+
+    collectEdgePoints(_smoothed, boundaries);
+    vote();
+    extractLines();
+    measureSegments();
+    assembleQuads(_edges.width(), _edges.height(), static_cast<float>(1 << levels));
+    return _candidates;
+}
+
+void LineQuadFinder::collectEdgePoints(const Plane8& smoothed, const float* boundaries) {
+    const int width  = _edges.width();
+    const int height = _edges.height();
+    const int bins   = _angleBins;
+
+    size_t count = 0;
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = _edges.row(y);
+        for (int x = 0; x < width; x++) count += row[x] != 0;
+    }
+    _points = Span<EdgePoint>(_arena.allocate<EdgePoint>(count), 0);
+
+    // Tile order: consecutive points are close to each other, so are their votes
+    for (int ty = 0; ty < height; ty += kTileSize) {
+        for (int tx = 0; tx < width; tx += kTileSize) {
+            for (int y = ty; y < std::min(ty + kTileSize, height); y++) {
+                const uint8_t* row = _edges.row(y);
+                for (int x = tx; x < std::min(tx + kTileSize, width); x++) {
+                    if (!row[x]) continue;
+
+                    // Edge pixels never touch the border, the 3x3 neighbourhood is inside the plane
+                    const uint8_t* a = smoothed.row(y - 1);
+                    const uint8_t* c = smoothed.row(y);
+                    const uint8_t* b = smoothed.row(y + 1);
+                    int gx = (a[x + 1] - a[x - 1]) + 2 * (c[x + 1] - c[x - 1]) + (b[x + 1] - b[x - 1]);
+                    int gy = (b[x - 1] + 2 * b[x] + b[x + 1]) - (a[x - 1] + 2 * a[x] + a[x + 1]);
+                    if (gy < 0 || (gy == 0 && gx < 0)) { gx = -gx; gy = -gy; }
+
+                    // The normal angle is in [0, pi], find its bin from the cosine, which decreases on that range
+                    const float cosine = gx / std::sqrt(static_cast<float>(gx * gx + gy * gy));
+                    const int   bin    = static_cast<int>(std::upper_bound(boundaries, boundaries + bins, cosine,
+                                                                           std::greater<float>()) - boundaries);
+
+                    EdgePoint& point = _points.data[_points.count++];
+                    point.x         = static_cast<int16_t>(x);
+                    point.y         = static_cast<int16_t>(y);
+                    point.angleBin  = static_cast<int16_t>(bin % bins);
+                }
+            }
+        }
+    }
+}
+
+void LineQuadFinder::vote() {
+    const int   bins    = _angleBins;
+    const float width   = static_cast<float>(_edges.width());
+    const float height  = static_cast<float>(_edges.height());
+    const int   maxRho  = static_cast<int>(std::ceil(0.5f * std::sqrt(width * width + height * height))) + 1;
+
+    _center  = Point(0.5f * width, 0.5f * height);
+    _rhoBins = 2 * maxRho + 1;
+
+    const size_t cells = static_cast<size_t>(bins) * static_cast<size_t>(_rhoBins);
+    _accumulator = _arena.allocate<uint16_t>(cells);
+    std::memset(_accumulator, 0, cells * sizeof(uint16_t));
+
+    const int spread = binsFor(kVoteSpread, bins);
+    for (const EdgePoint& point : _points) {
+        const float px = point.x + 0.5f - _center.x;
+        const float py = point.y + 0.5f - _center.y;
+        for (int d = -spread; d <= spread; d++) {
+            const int bin = (point.angleBin + d + bins) % bins;
+            const int r   = static_cast<int>(std::floor(px * _cosines[bin] + py * _sines[bin] + 0.5f)) + maxRho;
+            _accumulator[static_cast<size_t>(bin) * _rhoBins + r]++;
+        }
+    }
+}
+
+void LineQuadFinder::extractLines() {
+    const int   bins        = _angleBins;
+    const int   capacity    = std::max(_options.maximumLines, 0);
+    const int   maxRho      = (_rhoBins - 1) / 2;
+    const float minimumSide = _options.minimumFeatureSize * std::min(_edges.width(), _edges.height());
+    const int   minimumVotes = std::max(16, static_cast<int>(0.25f * minimumSide));
+    const int   radius      = binsFor(kPeakAngle, bins);
+
+    _lines = Span<HoughLine>(_arena.allocate<HoughLine>(static_cast<size_t>(capacity)), 0);
+    if (capacity == 0) return;
+
+    for (int bin = 0; bin < bins; bin++) {
+        const uint16_t* row = _accumulator + static_cast<size_t>(bin) * _rhoBins;
+        for (int r = kPeakRho; r < _rhoBins - kPeakRho; r++) {
+            const int votes = row[r];
+            if (votes < minimumVotes) continue;
+            if (_lines.count == capacity && votes <= _lines[capacity - 1].votes) continue;
+
+            // Local maximum, wrapping theta with rho mirrored; ties go to the first cell in memory order
+            const long index = static_cast<long>(bin) * _rhoBins + r;
+            bool isPeak = true;
+            for (int db = -radius; db <= radius && isPeak; db++) {
+                int nb = bin + db;
+                bool mirrored = false;
+                if (nb < 0)          { nb += bins; mirrored = true; }
+                else if (nb >= bins) { nb -= bins; mirrored = true; }
+                for (int dr = -kPeakRho; dr <= kPeakRho; dr++) {
+                    if (db == 0 && dr == 0) continue;
+                    const int  nr = mirrored ? _rhoBins - 1 - (r + dr) : r + dr;
+                    const long neighbour = static_cast<long>(nb) * _rhoBins + nr;
+                    const int  other = _accumulator[neighbour];
+                    if (other > votes || (other == votes && neighbour < index)) { isPeak = false; break; }
+                }
+            }
+            if (!isPeak) continue;
+
+            // Insert, strongest first
+            int position = std::min(_lines.count, capacity - 1);
+            while (position > 0 && _lines[position - 1].votes < votes) {
+                if (position < capacity) _lines[position] = _lines[position - 1];
+                position--;
+            }
+            HoughLine& line = _lines[position];
+            line            = HoughLine();
+            line.normal     = Point(_cosines[bin], _sines[bin]);
+            line.rho        = static_cast<float>(r - maxRho);
+            line.angleBin   = bin;
+            line.votes      = votes;
+            _lines.count    = std::min(_lines.count + 1, capacity);
+        }
+    }
+}
+
+void LineQuadFinder::measureSegments() {
+    const int bins   = _angleBins;
+    const int maxRho = (_rhoBins - 1) / 2;
+    _coverageBins    = (2 * maxRho) / kCoverageStep + 1;
+
+    const int    tolerance = binsFor(kSupportAngle, bins);
+    const size_t stride    = static_cast<size_t>(_coverageBins) + 1;
+    _coverage = _arena.allocate<uint16_t>(stride * static_cast<size_t>(_lines.count));
+    std::memset(_coverage, 0, stride * static_cast<size_t>(_lines.count) * sizeof(uint16_t));
+
+    for (const EdgePoint& point : _points) {
+        const Point p(point.x + 0.5f - _center.x, point.y + 0.5f - _center.y);
+        for (int i = 0; i < _lines.count; i++) {
+            const HoughLine& line = _lines[i];
+            if (angleDistance(point.angleBin, line.angleBin, bins) > tolerance) continue;
+            if (std::fabs(dot(p, line.normal) - line.rho) > kSupportDistance) continue;
+
+            const int bin = static_cast<int>(dot(p, direction(line)) + maxRho) / kCoverageStep;
+            _coverage[static_cast<size_t>(i) * stride + 1 + std::min(std::max(bin, 0), _coverageBins - 1)] = 1;
+        }
+    }
+
+    for (int i = 0; i < _lines.count; i++) {
+        uint16_t*  prefix = _coverage + static_cast<size_t>(i) * stride;
+        HoughLine& line   = _lines[i];
+
+        // Longest run of occupied bins, bridging single empty bins
+        int bestStart = 0, bestEnd = -1, start = -1, gap = 0;
+        for (int b = 0; b < _coverageBins; b++) {
+            if (prefix[b + 1]) {
+                if (start < 0) start = b;
+                gap = 0;
+                if (b - start > bestEnd - bestStart) { bestStart = start; bestEnd = b; }
+            } else if (start >= 0 && ++gap > 1) {
+                start = -1;
+            }
+        }
+        line.segmentStart = static_cast<float>(bestStart * kCoverageStep - maxRho);
+        line.segmentEnd   = static_cast<float>((bestEnd + 1) * kCoverageStep - maxRho);
+
+        for (int b = 1; b <= _coverageBins; b++) prefix[b] = static_cast<uint16_t>(prefix[b] + prefix[b - 1]);
+    }
+}
+
+void LineQuadFinder::assembleQuads(int width, int height, float scale) {
+    const int   bins        = _angleBins;
+    const int   capacity    = std::max(_options.maximumCandidates, 0);
+    const int   maxRho      = (_rhoBins - 1) / 2;
+    const int   parallel    = static_cast<int>(kParallelAngle * bins / 180.0f);
+    const int   crossing    = static_cast<int>(kCrossingAngle * bins / 180.0f);
+    const float minimumSide = _options.minimumFeatureSize * std::min(width, height);
+    const float duplicate   = 0.02f * std::min(width, height);
+    const size_t stride     = static_cast<size_t>(_coverageBins) + 1;
+
+    _candidates = Span<QuadCandidate>(_arena.allocate<QuadCandidate>(static_cast<size_t>(capacity)), 0);
+    if (capacity == 0 || _lines.count < 4) return;
+
+    // Pairs of nearly parallel lines, future opposite sides
+    struct Pair { int16_t a, b; };
+    Span<Pair> pairs(_arena.allocate<Pair>(static_cast<size_t>(_lines.count * (_lines.count - 1) / 2)), 0);
+    for (int i = 0; i < _lines.count; i++) {
+        for (int j = i + 1; j < _lines.count; j++) {
+            if (angleDistance(_lines[i].angleBin, _lines[j].angleBin, bins) <= parallel) {
+                pairs.data[pairs.count++] = Pair{ static_cast<int16_t>(i), static_cast<int16_t>(j) };
+            }
+        }
+    }
+
+    // Fraction of the side [u, v] of `line` covered by its segments, weighted by the side length
+    auto coveredLength = [&](int index, Point u, Point v) {
+        const HoughLine& line = _lines[index];
+        const Point d   = direction(line);
+        float t0 = dot(u, d), t1 = dot(v, d);
+        if (t0 > t1) std::swap(t0, t1);
+        const int lo = std::min(std::max(static_cast<int>(t0 + maxRho) / kCoverageStep, 0), _coverageBins - 1);
+        const int hi = std::min(std::max(static_cast<int>(t1 + maxRho) / kCoverageStep, 0), _coverageBins - 1);
+        const uint16_t* prefix = _coverage + static_cast<size_t>(index) * stride;
+        return distance(u, v) * (prefix[hi + 1] - prefix[lo]) / static_cast<float>(hi - lo + 1);
+    };
+
+    for (int p = 0; p < pairs.count; p++) {
+        for (int q = p + 1; q < pairs.count; q++) {
+            const int sides[4] = { pairs[p].a, pairs[q].a, pairs[p].b, pairs[q].b };
+            bool crossingPairs = true;
+            for (int i = 0; i < 2 && crossingPairs; i++) {
+                for (int j = 0; j < 2; j++) {
+                    if (angleDistance(_lines[sides[2 * i]].angleBin, _lines[sides[2 * j + 1]].angleBin, bins) < crossing) {
+                        crossingPairs = false;
+                        break;
+                    }
+                }
+            }
+            if (!crossingPairs) continue;
+
+            // Corner k joins side k - 1 and side k, so side k runs from corner k to corner k + 1
+            Point corners[4];
+            bool valid = true;
+            for (int k = 0; k < 4 && valid; k++) {
+                valid = intersect(_lines[sides[(k + 3) & 3]], _lines[sides[k]], corners[k]);
+                const Point c = corners[k] + _center;
+                valid = valid && c.x >= -1.0f && c.y >= -1.0f && c.x <= width + 1.0f && c.y <= height + 1.0f;
+            }
+            if (!valid) continue;
+
+            float turns[4], perimeter = 0.0f, covered = 0.0f, shortest = std::numeric_limits<float>::max();
+            for (int k = 0; k < 4; k++) {
+                turns[k] = cross(corners[(k + 1) & 3] - corners[k], corners[(k + 2) & 3] - corners[(k + 1) & 3]);
+                const float length = distance(corners[k], corners[(k + 1) & 3]);
+                shortest   = std::min(shortest, length);
+                perimeter += length;
+                covered   += coveredLength(sides[k], corners[k], corners[(k + 1) & 3]);
+            }
+            const bool convex = (turns[0] > 0 && turns[1] > 0 && turns[2] > 0 && turns[3] > 0)
+                             || (turns[0] < 0 && turns[1] < 0 && turns[2] < 0 && turns[3] < 0);
+            if (!convex || shortest < minimumSide) continue;
+
+            const float coverage = covered / perimeter;
+            if (coverage < _options.minimumCoverage) continue;
+
+            QuadCandidate candidate;
+            int           order[4] = { 0, 1, 2, 3 };
+            if (turns[0] < 0) { order[1] = 3; order[3] = 1; }   // make it clockwise on screen
+
+            // Side lines follow the corner order: when reversed, the side from order[k] to order[k + 1] is the one before order[k]
+            int first = 0;
+            for (int k = 1; k < 4; k++) {
+                const Point a = corners[order[k]], b = corners[order[first]];
+                if (a.x + a.y < b.x + b.y) first = k;
+            }
+            for (int k = 0; k < 4; k++) {
+                const int corner = order[(first + k) & 3];
+                const int next   = order[(first + k + 1) & 3];
+                candidate.quad[k]  = (corners[corner] + _center) * scale;
+                candidate.lines[k] = static_cast<int16_t>(sides[next == ((corner + 1) & 3) ? corner : next]);
+            }
+            candidate.area     = candidate.quad.signedArea();
+            candidate.coverage = coverage;
+            candidate.score    = candidate.area * coverage;
+
+            // Same quad from other line combinations: keep the best one only
+            int existing = -1;
+            for (int c = 0; c < _candidates.count && existing < 0; c++) {
+                float error = 0.0f;
+                for (int k = 0; k < 4; k++) error = std::max(error, distance(_candidates[c].quad[k], candidate.quad[k]));
+                if (error < duplicate * scale) existing = c;
+            }
+            if (existing >= 0) {
+                if (_candidates[existing].score >= candidate.score) continue;
+                for (int c = existing; c + 1 < _candidates.count; c++) _candidates[c] = _candidates[c + 1];
+                _candidates.count--;
+            }
+
+            if (_candidates.count == capacity && candidate.score <= _candidates[capacity - 1].score) continue;
+            int position = std::min(_candidates.count, capacity - 1);
+            while (position > 0 && _candidates[position - 1].score < candidate.score) {
+                if (position < capacity) _candidates[position] = _candidates[position - 1];
+                position--;
+            }
+            _candidates[position] = candidate;
+            _candidates.count = std::min(_candidates.count + 1, capacity);
+        }
+    }
+}
+
+} // namespace irl
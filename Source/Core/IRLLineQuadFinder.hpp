@@ -0,0 +1,158 @@
+//
+//  IRLLineQuadFinder.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Document candidates assembled from straight edges, independent of any region
+//  segmentation: works when the page and the desk have the same brightness, as long as
+//  the page outline is visible.
+//
+//  1. Canny edge map of the (optionally downsampled) luma, `EdgeDetector`.
+//  2. Edge pixels are gathered tile by tile and vote in a 16 bit (theta, rho) Hough
+//     accumulator, only around their own gradient direction. Points of one tile map to a
+//     narrow rho range for every theta, so the accumulator rows touched stay in cache.
+//  3. The strongest peaks become lines. The edge pixels supporting each line are binned
+//     along it, which gives the segments actually present on the line.
+//  4. Pairs of nearly parallel lines are combined with crossing pairs into quads, scored by
+//     area times the fraction of their outline covered by segments.
+//
+//  All per-frame data lives in one `Arena`: after the first frames, `find` does not
+//  touch the heap anymore.
+//
+
+#ifndef IRL_LINE_QUAD_FINDER_HPP
+#define IRL_LINE_QUAD_FINDER_HPP
+
+#include "IRLArena.hpp"
+#include "IRLEdgeMap.hpp"
+#include "IRLImage.hpp"
+#include "IRLPyramid.hpp"
+#include "IRLQuad.hpp"
+
+#include <cstdint>
+
+namespace irl {
+
+/** @brief Tuning of `LineQuadFinder`. `maximumLines` and `maximumCandidates` trade recall against latency. */
+struct LineQuadFinderOptions {
+    /** Smallest accepted quad side, as a fraction of the smaller frame dimension (same meaning as `CIDetectorMinFeatureSize`). */
+    float           minimumFeatureSize  = 0.5f;
+
+    /** Edges are extracted on the first pyramid level whose longer side is at most this size, and at least 64 pixels wide. */
+    int             maximumSearchSize   = 512;
+
+    /** Number of Hough peaks turned into lines. Quad assembly is O(lines^4) in the worst case. */
+    int             maximumLines        = 16;
+
+    /** Maximum number of candidates returned for one frame. */
+    int             maximumCandidates   = 8;
+
+    /** Angular resolution of the accumulator, bins over 180 degrees. 0 picks it from the level size so that a line never spreads over more than 2 rho cells. */
+    int             angleBins           = 0;
+
+    /** Smallest fraction of the quad outline that must be covered by edge segments. */
+    float           minimumCoverage     = 0.6f;
+
+    /** Thresholds of the edge map. */
+    EdgeMapOptions  edges;
+};
+
+/** @brief One line found in the accumulator, in the coordinates of the level searched */
+struct HoughLine {
+    /** Unit normal (cos theta, sin theta) and distance to the level center: n . (p - center) = rho */
+    Point       normal;
+    float       rho         = 0.0f;
+    int         angleBin    = 0;
+    int         votes       = 0;
+
+    /** Longest run of supporting edge pixels, as abscissas along (-sin theta, cos theta) from the foot of the normal */
+    float       segmentStart    = 0.0f;
+    float       segmentEnd      = 0.0f;
+};
+
+/** @brief One candidate quad */
+struct QuadCandidate {
+    /** Corners, in buffer coordinates of the full resolution frame */
+    Quad        quad;
+
+    /** Area of `quad`, in square pixels of the full resolution frame */
+    float       area        = 0.0f;
+
+    /** Fraction of the outline covered by edge segments, 0 ... 1 */
+    float       coverage    = 0.0f;
+
+    /** `area * coverage`, candidates are sorted by decreasing score */
+    float       score       = 0.0f;
+
+    /** Indices in `lines()` of the four sides, top, right, bottom and left */
+    int16_t     lines[4]    = { 0, 0, 0, 0 };
+};
+
+/**
+ @brief Quad candidate generator working on BGRA (kCVPixelFormatType_32BGRA) or Gray8 frames.
+ @discussion An instance keeps its buffers between calls. It is not thread safe, use one instance per queue.
+ */
+class LineQuadFinder {
+public:
+    explicit LineQuadFinder(const LineQuadFinderOptions& options = LineQuadFinderOptions());
+
+    const LineQuadFinderOptions&    options() const                                 { return _options; }
+    void                            setOptions(const LineQuadFinderOptions& options) { _options = options; }
+
+    /**
+     @brief Find document candidates in `frame`.
+     @return The candidates, best first. Valid until the next call.
+     */
+    Span<const QuadCandidate> find(const ImageView& frame);
+
+    /** @return The lines of the last frame, strongest first, in the coordinates of `searchedLevel()` */
+    Span<const HoughLine> lines() const { return _lines; }
+
+    /** @return The pyramid level searched in the last frame */
+    int searchedLevel() const { return _level; }
+
+    /** @return The number of angle bins used for the last frame */
+    int angleBins() const { return _angleBins; }
+
+    /** @return The arena holding the per-frame data */
+    const Arena& arena() const { return _arena; }
+
+private:
+    struct EdgePoint {
+        int16_t     x, y;
+        int16_t     angleBin;
+    };
+
+    void collectEdgePoints(const Plane8& smoothed, const float* boundaries);
+    void vote();
+    void extractLines();
+    void measureSegments();
+    void assembleQuads(int width, int height, float scale);
+
+    LineQuadFinderOptions   _options;
+    int                     _level      = 0;
+    int                     _angleBins  = 0;
+
+    LumaPyramid             _pyramid;
+    Plane8                  _luma;
+    Plane8                  _smoothed;
+    Plane8                  _edges;
+    EdgeDetector            _edgeDetector;
+
+    Arena                   _arena;
+    float*                  _cosines        = nullptr;
+    float*                  _sines          = nullptr;
+    Span<EdgePoint>         _points;
+    uint16_t*               _accumulator    = nullptr;
+    int                     _rhoBins        = 0;
+    Point                   _center;
+    Span<HoughLine>         _lines;
+    uint16_t*               _coverage       = nullptr;      // prefix sums of occupied bins, one row per line
+    int                     _coverageBins   = 0;
+    Span<QuadCandidate>     _candidates;
+};
+
+} // namespace irl
+
+#endif /* IRL_LINE_QUAD_FINDER_HPP */
@@ -0,0 +1,150 @@
+//
+//  IRLPageAspect.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLPageAspect.hpp"
+#include "IRLHomography.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace irl {
+
+namespace {
+/** Portrait sheet, in inches */
+struct Paper {
+    double width, height;
+};
+} // namespace
+
+/** Paper sizes snapped to: ISO A (and B, the same ratio) as A4, US Letter, US Legal, ID-1 card */
+static const Paper kPapers[] = { { 210.0 / 25.4, 297.0 / 25.4 }, { 8.5, 11.0 }, { 8.5, 14.0 }, { 53.98 / 25.4, 85.6 / 25.4 } };
+
+/** Long side of the paper of the pages that do not match one of `kPapers`: an A4 sheet */
+static const double kDefaultPaperLength = 297.0 / 25.4;
+
+/** Below this distance of 1, the two sides of a pair are taken as parallel in the photo: their vanishing point is too far to tell the focal length */
+static const double kParallel = 0.02;
+
+static const double kRadiansPerDegree = 3.14159265358979323846 / 180.0;
+
+CameraIntrinsics CameraIntrinsics::centered(int width, int height, double fieldOfView) {
+    CameraIntrinsics camera;
+    camera.principalPoint = Point(0.5f * width, 0.5f * height);
+    if (fieldOfView > 0.0 && fieldOfView < 180.0) {
+        camera.focalLength = 0.5 * std::max(width, height) / std::tan(0.5 * fieldOfView * kRadiansPerDegree);
+    }
+    return camera;
+}
+
+namespace {
+struct Vector3 {
+    double x, y, z;
+};
+} // namespace
+
+static Vector3 centeredPoint(Point p, Point center) {
+    return Vector3{ static_cast<double>(p.x) - center.x, static_cast<double>(p.y) - center.y, 1.0 };
+}
+
+static Vector3 crossProduct(const Vector3& a, const Vector3& b) {
+    return Vector3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+static double dotProduct(const Vector3& a, const Vector3& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+bool estimatePageAspect(const Quad& quad, const CameraIntrinsics& camera, double& aspect) {
+    // Zhang and He: m1 to m4 are the corners (0, 0), (w, 0), (0, h) and (w, h) of the page, relative to the principal point
+    const Vector3 m1 = centeredPoint(quad.topLeft,     camera.principalPoint);
+    const Vector3 m2 = centeredPoint(quad.topRight,    camera.principalPoint);
+    const Vector3 m3 = centeredPoint(quad.bottomLeft,  camera.principalPoint);
+    const Vector3 m4 = centeredPoint(quad.bottomRight, camera.principalPoint);
+
+    const Vector3 diagonal = crossProduct(m1, m4);
+    const double  d2 = dotProduct(crossProduct(m2, m4), m3);
+    const double  d3 = dotProduct(crossProduct(m3, m4), m2);
+    if (d2 == 0.0 || d3 == 0.0) return false;
+    const double  k2 = dotProduct(diagonal, m3) / d2;
+    const double  k3 = dotProduct(diagonal, m2) / d3;
+    // Depths of the corners relative to the top left one: a quad behind the camera is no page
+    if (!(k2 > 0.0) || !(k3 > 0.0)) return false;
+
+    // Directions of the top and left sides in space, up to the intrinsics
+    const Vector3 n2 = { k2 * m2.x - m1.x, k2 * m2.y - m1.y, k2 - 1.0 };
+    const Vector3 n3 = { k3 * m3.x - m1.x, k3 * m3.y - m1.y, k3 - 1.0 };
+    const double  top  = n2.x * n2.x + n2.y * n2.y;
+    const double  left = n3.x * n3.x + n3.y * n3.y;
+    if (top <= 0.0 || left <= 0.0) return false;
+
+    double f2 = camera.focalLength * camera.focalLength;
+    if (f2 <= 0.0) {
+        const bool topParallel  = std::fabs(n2.z) < kParallel;
+        const bool leftParallel = std::fabs(n3.z) < kParallel;
+        if (topParallel && leftParallel) {
+            // Seen almost face on: the depth terms are too small for the focal length to matter
+            aspect = std::sqrt(top / left);
+            return true;
+        }
+        if (topParallel || leftParallel) return false;
+        // The sides of a rectangle are orthogonal in space
+        f2 = -(n2.x * n3.x + n2.y * n3.y) / (n2.z * n3.z);
+        if (!(f2 > 0.0)) return false;
+    }
+
+    aspect = std::sqrt((top + f2 * n2.z * n2.z) / (left + f2 * n3.z * n3.z));
+    return std::isfinite(aspect) && aspect > 0.0;
+}
+
+/** @return The aspect of the paper close to `aspect`, `aspect` itself when none is. `length` is set to the long side of the paper. */
+static double snapToPaper(double aspect, double tolerance, double& length) {
+    length = kDefaultPaperLength;
+    if (tolerance <= 0.0) return aspect;
+    const double limit = std::log1p(tolerance);
+    for (const Paper& paper : kPapers) {
+        const double ratio = paper.width / paper.height;
+        const bool   portrait = std::fabs(std::log(aspect / ratio)) < limit;
+        if (!portrait && !(std::fabs(std::log(aspect * ratio)) < limit)) continue;
+        length = paper.height;
+        return portrait ? ratio : 1.0 / ratio;
+    }
+    return aspect;
+}
+
+/** Shrink the page to `dpi` on a sheet whose long side is `length` inches, then to `maxPixels` */
+static void limitResolution(int& width, int& height, double length, const PageAspectOptions& options) {
+    if (width <= 0 || height <= 0) return;
+    double scale = 1.0;
+    if (options.dpi > 0.0)       scale = std::min(scale, options.dpi * length / std::max(width, height));
+    if (options.maxPixels > 0)   scale = std::min(scale, std::sqrt(static_cast<double>(options.maxPixels) / width / height));
+    if (scale >= 1.0) return;
+    // Floored so the budget holds, the aspect is kept to the pixel
+    width  = std::max(static_cast<int>(width  * scale), 1);
+    height = std::max(static_cast<int>(height * scale), 1);
+}
+
+void limitPageResolution(int& width, int& height, const PageAspectOptions& options) {
+    limitResolution(width, height, kDefaultPaperLength, options);
+}
+
+void pageSize(const Quad& quad, const CameraIntrinsics& camera, int& width, int& height, const PageAspectOptions& options) {
+    rectifiedSize(quad, width, height);
+    double aspect, length;
+    if (width <= 0 || height <= 0 || !estimatePageAspect(quad, camera, aspect)) {
+        limitPageResolution(width, height, options);
+        return;
+    }
+    aspect = snapToPaper(aspect, options.paperTolerance, length);
+
+    // At least the rectified size on both sides: the side shortened by the perspective gets longer, not the other shorter
+    const double longWidth = std::max(static_cast<double>(width), height * aspect);
+    width  = std::max(static_cast<int>(std::lround(longWidth)), 1);
+    height = std::max(static_cast<int>(std::lround(longWidth / aspect)), 1);
+    limitResolution(width, height, length, options);
+}
+
+} // namespace irl
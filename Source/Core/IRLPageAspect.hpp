@@ -0,0 +1,79 @@
+//
+//  IRLPageAspect.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Aspect ratio of the paper behind a document quad, to size the rectified page once.
+//
+//  The longest of each pair of opposite sides (`rectifiedSize`) is what `CIPerspectiveCorrection`
+//  gives, and it stretches the page along the side tilted away from the camera. The quad is the
+//  image of a rectangle through a pinhole camera, which fixes the ratio of its sides once the
+//  focal length is known (Zhang and He, "Whiteboard scanning and image enhancement"). Without
+//  it the focal length can be estimated from the quad itself, unless two of its sides are
+//  parallel in the photo. Ratios close to a standard paper size are then snapped to it, and the
+//  paper gives the page its size in inches for a target resolution.
+//
+
+#ifndef IRL_PAGE_ASPECT_HPP
+#define IRL_PAGE_ASPECT_HPP
+
+#include "IRLQuad.hpp"
+
+namespace irl {
+
+/** @brief The camera of the photo a quad was found in */
+struct CameraIntrinsics {
+    /** Focal length in pixels of the photo, 0 when unknown: it is then estimated from the quad. */
+    double  focalLength     = 0.0;
+
+    /** Principal point in pixels of the photo, usually its center. */
+    Point   principalPoint;
+
+    /**
+     @return The intrinsics of a `width` x `height` photo centered on the optical axis
+     @param fieldOfView Angle in degrees across the long side of the photo, 0 when unknown
+     */
+    static CameraIntrinsics centered(int width, int height, double fieldOfView = 0.0);
+};
+
+/** @brief Tuning of `pageSize` */
+struct PageAspectOptions {
+    /** Ratios within this relative distance of a paper size (ISO A, US Letter, US Legal, ID-1 card) are snapped to it, 0 to never snap. */
+    double  paperTolerance  = 0.02;
+
+    /**
+     Resolution of the page in dots per inch of the paper, 0 to keep the resolution of the photo. Pages of no snapped paper size
+     are taken as A4 sheets. Pages are shrunk, never enlarged.
+     */
+    double  dpi             = 0.0;
+
+    /** Most pixels of the page, 0 for no limit. Pages are shrunk, never enlarged. */
+    int     maxPixels       = 0;
+};
+
+/**
+ @brief Estimate the width / height ratio of the rectangle `quad` is the perspective image of.
+ @return false when the focal length is unknown and can not be estimated (two sides parallel in the photo, or a quad no camera can see),
+ or when the quad is degenerate. `aspect` is then left as is.
+ */
+bool estimatePageAspect(const Quad& quad, const CameraIntrinsics& camera, double& aspect);
+
+/**
+ @brief Size of the page rectified from `quad` with the aspect ratio of the paper.
+ @discussion The page is at least `rectifiedSize` on both sides: the side shortened by the perspective gets longer, so no direction
+ is sampled more sparsely than by `CIPerspectiveCorrection`. When the aspect ratio can not be estimated it is `rectifiedSize`.
+ It is then shrunk to the `dpi` and `maxPixels` of `options`, if they are set.
+ */
+void pageSize(const Quad& quad, const CameraIntrinsics& camera, int& width, int& height,
+              const PageAspectOptions& options = PageAspectOptions());
+
+/**
+ @brief Shrink a `width` x `height` page to the `dpi` and `maxPixels` of `options`.
+ @discussion For pages sized without `pageSize`: the paper is unknown, the long side of the page is taken as the one of an A4 sheet.
+ */
+void limitPageResolution(int& width, int& height, const PageAspectOptions& options);
+
+} // namespace irl
+
+#endif /* IRL_PAGE_ASPECT_HPP */
@@ -0,0 +1,221 @@
+//
+//  IRLPageRenderer.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLPageRenderer.hpp"
+#include "IRLPerspectiveWarp.hpp"
+#include "IRLWarpKernels.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace irl {
+
+static const int kBandHeight         = 32;
+static const int kWindowedBandHeight = 128;    // with `denoise` or `sharpen`: the rows around a band are sampled twice, taller bands sample fewer of them
+
+static ColorControlsOptions colorOptions(PageFilter filter) {
+    return filter == PageFilter::Enhance ? enhanceColorControls() : contrastColorControls();
+}
+
+static PointFilterOptions grayOptions(PageFilter filter) {
+    PointFilterOptions options;
+    if (filter == PageFilter::UltraContrast) options.curve = &kUltraContrastCurve;
+    return options;
+}
+
+PageRenderer::PageRenderer(const PageRenderOptions& options, SimdLevel level)
+: _options(options), _kernels(detail::warpKernels(level)), _colors(colorOptions(options.filter), level),
+  _grayFilter(grayOptions(options.filter), level) {
+    if (!_kernels) _kernels = detail::warpKernelsScalar();
+}
+
+void PageRenderer::setOptions(const PageRenderOptions& options) {
+    if (options.filter != _options.filter) {
+        _colors.setOptions(colorOptions(options.filter));
+        _grayFilter.setOptions(grayOptions(options.filter));
+    }
+    _options = options;
+}
+
+PixelFormat PageRenderer::outputFormat() const {
+    return _options.filter == PageFilter::UltraContrast || _options.filter == PageFilter::Luma ? PixelFormat::Gray8 : PixelFormat::BGRA8;
+}
+
+void PageRenderer::rectifiedPageSize(const Quad& quad, int& width, int& height, double& scale) const {
+    PageAspectOptions resolution;
+    resolution.dpi       = _options.dpi;
+    resolution.maxPixels = _options.maxPixels;
+    int fullWidth, fullHeight;
+    if (_options.trueAspect) {
+        pageSize(quad, _options.camera, fullWidth, fullHeight);
+        pageSize(quad, _options.camera, width, height, resolution);
+    } else {
+        rectifiedSize(quad, fullWidth, fullHeight);
+        width  = fullWidth;
+        height = fullHeight;
+        limitPageResolution(width, height, resolution);
+    }
+    scale = fullWidth > 0 ? std::min(static_cast<double>(width) / fullWidth, 1.0) : 1.0;
+}
+
+void PageRenderer::outputSize(const Quad& quad, int& width, int& height) const {
+    double scale;
+    rectifiedPageSize(quad, width, height, scale);
+    const int margin = static_cast<int>(std::lround(_options.margin * scale));
+    width  = std::max(width  - 2 * margin, 1);
+    height = std::max(height - 2 * margin, 1);
+}
+
+Quad PageRenderer::frameQuad(const ImageView& source) {
+    Quad quad;
+    quad.topLeft     = Point(0.0f, 0.0f);
+    quad.topRight    = Point(static_cast<float>(source.width), 0.0f);
+    quad.bottomRight = Point(static_cast<float>(source.width), static_cast<float>(source.height));
+    quad.bottomLeft  = Point(0.0f, static_cast<float>(source.height));
+    return quad;
+}
+
+// MARK: - Render
+
+void PageRenderer::prepare(const ImageView& source, const Quad& quad) {
+    // The white balance goes in the color tables, so it costs nothing per pixel. The estimate reads a fixed grid of
+    // the page through the same perspective, once for all the bands.
+    if (_options.filter != PageFilter::Contrast && _options.filter != PageFilter::Enhance) return;
+    ColorControlsOptions colors = colorOptions(_options.filter);
+    if (_options.whiteBalance && !source.isEmpty() && source.format == PixelFormat::BGRA8) {
+        _paperWhite = estimatePaperWhite(source, quad);
+        std::copy(_paperWhite.gains, _paperWhite.gains + 3, colors.gains);
+    }
+    if (!std::equal(colors.gains, colors.gains + 3, _colors.options().gains)) _colors.setOptions(colors);
+}
+
+void PageRenderer::render(const ImageView& source, const Quad& quad, uint8_t* destination, size_t stride) {
+    int width, height;
+    outputSize(quad, width, height);
+    prepare(source, quad);
+    renderRows(source, quad, 0, height, destination, stride);
+}
+
+int PageRenderer::bandRows(int width) const {
+    const size_t rowBytes = bytesPerPixel(outputFormat()) * static_cast<size_t>(std::max(width, 1));
+    return static_cast<int>(std::min(std::max(_options.bandBytes / rowBytes, size_t(1)), size_t(INT_MAX)));
+}
+
+void PageRenderer::renderRows(const ImageView& source, const Quad& quad, int top, int rows, uint8_t* destination, size_t stride) {
+    int rectifiedWidth, rectifiedHeight, width, height;
+    double scale;
+    rectifiedPageSize(quad, rectifiedWidth, rectifiedHeight, scale);
+    outputSize(quad, width, height);
+    rows = std::min(rows, height - top);
+    if (source.isEmpty() || source.format != PixelFormat::BGRA8 || top < 0 || rows <= 0) return;
+
+    const Homography H = Homography::rectangleToQuad(std::max(rectifiedWidth, 1), std::max(rectifiedHeight, 1), quad);
+    const int margin   = static_cast<int>(std::lround(_options.margin * scale));
+    const int marginX  = std::min(margin, std::max(rectifiedWidth - 1, 0) / 2);
+    const int marginY  = std::min(margin, std::max(rectifiedHeight - 1, 0) / 2);
+
+    // Rows are sampled with the kernels of the warp, from its row coordinates. They are stepped from the left edge of the
+    // page, margin included, so the output is exactly the crop of the warped page. A shrunk page averages the footprint
+    // of its pixels.
+    const bool          area          = scale < 1.0;
+    const Interpolation interpolation = area ? Interpolation::Area : Interpolation::Bilinear;
+    const int           span          = marginX + width;
+    detail::WarpSource sampled;
+    sampled.data   = source.data;
+    sampled.stride = source.stride;
+    sampled.width  = source.width;
+    sampled.height = source.height;
+    sampled.right  = source.width  > 1 ? 4 : 0;
+    sampled.down   = source.height > 1 ? source.stride : 0;
+
+    const size_t rowBytes = 4 * static_cast<size_t>(width);
+    TileExecutor& executor = executorForThreads(_options.threads, _executor);
+    if (static_cast<int>(_scratch.size()) < executor.threadCount()) _scratch.resize(static_cast<size_t>(executor.threadCount()));
+    if (_options.denoise) _denoiser.prepare(width);
+    if (_options.sharpen) _sharpener.prepare(width);
+    const bool windowed = _options.denoise || _options.sharpen;
+
+    // Bands of rows: the rows of a band read neighbouring source rows, and the filters are row kernels anyway
+    executor.runBands(width, rows, windowed ? kWindowedBandHeight: kBandHeight, [&](const Tile& band, int worker) {
+        const int first = top + band.y, last = first + band.height;
+        Scratch& scratch = _scratch[static_cast<size_t>(worker)];
+        if (outputFormat() == PixelFormat::Gray8) scratch.row.resize(rowBytes);
+        if (_options.sharpen) _sharpener.beginBand(scratch.sharpening, width, height, PixelFormat::BGRA8, first);
+        if (_options.denoise) {
+            // The sharpener asks for its rows in order, from the first one its window reaches
+            const int needed = _options.sharpen ? _sharpener.pendingRow(scratch.sharpening, first) : first;
+            _denoiser.beginBand(scratch.denoising, width, height, PixelFormat::BGRA8, needed);
+        }
+        scratch.xs.resize(static_cast<size_t>(span));
+        scratch.ys.resize(static_cast<size_t>(span));
+        if (area) {
+            scratch.fxs.resize(static_cast<size_t>(span));
+            scratch.fys.resize(static_cast<size_t>(span));
+        }
+        const int32_t* xs = scratch.xs.data() + marginX;
+        const int32_t* ys = scratch.ys.data() + marginX;
+
+        auto rectify = [&](int y, uint8_t* row) {
+            PerspectiveWarp::coordinatesRow(H, marginY + y, span, source.width, source.height, interpolation, scratch.xs.data(), scratch.ys.data());
+            if (!area) {
+                _kernels->bilinearRow(sampled, xs, ys, width, row);
+                return;
+            }
+            PerspectiveWarp::footprintRow(H, marginY + y, span, scratch.fxs.data(), scratch.fys.data());
+            _kernels->areaRow(sampled, xs, ys, scratch.fxs.data() + marginX, scratch.fys.data() + marginX, width, row);
+        };
+
+        // Rectified row `y`, denoised when asked: the denoiser pulls the rows around it first
+        auto smooth = [&](int y, uint8_t* row) {
+            if (!_options.denoise) {
+                rectify(y, row);
+                return;
+            }
+            for (int pending; (pending = _denoiser.pendingRow(scratch.denoising, y)) >= 0; _denoiser.pushRow(scratch.denoising)) {
+                rectify(pending, _denoiser.rowBuffer(scratch.denoising));
+            }
+            _denoiser.filterRow(scratch.denoising, y, row);
+        };
+
+        // Then sharpened when asked, from the rows around it in turn
+        auto sample = [&](int y, uint8_t* row) {
+            if (!_options.sharpen) {
+                smooth(y, row);
+                return;
+            }
+            for (int pending; (pending = _sharpener.pendingRow(scratch.sharpening, y)) >= 0; _sharpener.pushRow(scratch.sharpening)) {
+                smooth(pending, _sharpener.rowBuffer(scratch.sharpening));
+            }
+            _sharpener.sharpenRow(scratch.sharpening, y, row);
+        };
+
+        for (int y = first; y < last; y++) {
+            uint8_t* dst = destination + stride * static_cast<size_t>(y - top);
+
+            switch (_options.filter) {
+                case PageFilter::None:
+                    sample(y, dst);
+                    break;
+                case PageFilter::Contrast:
+                case PageFilter::Enhance:
+                    // Filtered in place while the row is in cache. BGRA rows only read the tables, shared by the workers.
+                    sample(y, dst);
+                    _colors.apply(ImageView(dst, width, 1, rowBytes, PixelFormat::BGRA8), dst, rowBytes);
+                    break;
+                case PageFilter::UltraContrast:
+                case PageFilter::Luma:
+                    // Luma, then the curve of Ultra Contrast, in the lanes of the point filter
+                    sample(y, scratch.row.data());
+                    _grayFilter.applyLuma(ImageView(scratch.row.data(), width, 1, rowBytes, PixelFormat::BGRA8), dst, stride);
+                    break;
+            }
+        }
+    });
+}
+
+} // namespace irl
@@ -0,0 +1,204 @@
+//
+//  IRLPageRenderer.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Final still of the scanner in a single pass: perspective correction, crop of the borders
+//  and color filter. The CoreImage chain filters the whole photo, rectifies it, then crops
+//  it, with a full size intermediate at every step. Here each output row is sampled from the
+//  source, then filtered while it is still in cache: only pixels kept in the final page are
+//  ever computed, and the working memory is the source, the output and one row per thread
+//  (a few more with `denoise` and `sharpen`, which need the rows around the current one).
+//
+//  Rows are sampled with the row kernels of `PerspectiveWarp`, so a page gets the same pixels
+//  from both. With a target resolution the page is sampled at its final size directly, with
+//  the area filter of the warp, instead of being rendered at the resolution of the photo and
+//  downscaled afterwards.
+//
+//  `renderBands` hands the page over in bands of rows rendered into one buffer, for an encoder
+//  to take them as they come: besides the photo, the memory is a constant of the options even
+//  for a 48MP sensor.
+//
+
+#ifndef IRL_PAGE_RENDERER_HPP
+#define IRL_PAGE_RENDERER_HPP
+
+#include "IRLColorControls.hpp"
+#include "IRLGuidedFilter.hpp"
+#include "IRLHomography.hpp"
+#include "IRLImage.hpp"
+#include "IRLPageAspect.hpp"
+#include "IRLPointFilter.hpp"
+#include "IRLQuad.hpp"
+#include "IRLTileExecutor.hpp"
+#include "IRLUnsharpMask.hpp"
+#include "IRLWhiteBalance.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace irl {
+
+namespace detail { struct WarpKernels; }
+
+/** @brief Color filter of the scanner views */
+enum class PageFilter {
+    /** Colors as captured */
+    None,
+    /** `contrastColorControls()`, IRLScannerViewTypeNormal */
+    Contrast,
+    /** `enhanceColorControls()`, IRLScannerViewTypeBlackAndWhite */
+    Enhance,
+    /** `kUltraContrastCurve` on the luma, IRLScannerViewTypeUltraContrast, through `PointFilter`. The page is Gray8. */
+    UltraContrast,
+    /** The luma of `PointFilter`, for the `Binarizer` of IRLScannerViewTypeBinarized. The page is Gray8. */
+    Luma
+};
+
+/** @brief Tuning of `PageRenderer` */
+struct PageRenderOptions {
+    /** Filter applied to the rectified pixels. */
+    PageFilter  filter  = PageFilter::Contrast;
+
+    /** Pixels dropped on every side of the rectified page, like `-cropBordersWithMargin:`. */
+    int         margin  = 40;
+
+    /** Threads used for one page, 0 to share `TileExecutor::shared()` with the other stages. */
+    int         threads = 0;
+
+    /** Take the color cast of the light off the paper, with the Contrast and Enhance filters. See `estimatePaperWhite`. */
+    bool        whiteBalance = false;
+
+    /** Smooth the sensor noise of the rectified rows, before the other filters, in the same pass. See `GuidedFilter`. */
+    bool        denoise = false;
+
+    /** Sharpen the strokes softened by the resampling, in the same pass. See `UnsharpMask`. */
+    bool        sharpen = false;
+
+    /** Size the page to the aspect ratio of the paper instead of the sides of the quad. See `pageSize`. */
+    bool        trueAspect = false;
+
+    /** Camera of the photos, for `trueAspect`. Its principal point is in their pixels. */
+    CameraIntrinsics camera;
+
+    /**
+     Resolution of the page in dots per inch of the paper, 0 to keep the one of the photo. See `PageAspectOptions`. A page shrunk
+     to it is sampled with an area filter, and the margin shrinks with it.
+     */
+    double      dpi = 0.0;
+
+    /** Most pixels of the page before the margins, 0 for no limit. */
+    int         maxPixels = 0;
+
+    /** Bytes of the band buffer of `renderBands`, which holds at least one row. */
+    size_t      bandBytes = 4 << 20;
+};
+
+/**
+ @brief Rectifies, crops and filters a document in one pass over the output pixels.
+ @discussion Sources are BGRA8. Sampling is bilinear, with an area filter when the page is shrunk to `dpi` or `maxPixels`.
+ Borders replicate the closest source pixel.
+ Bands of rows are rendered on all the cores, the result does not depend on the thread count.
+ Not thread safe, use one instance per queue.
+ */
+class PageRenderer {
+public:
+    /** @param level Kernel variant of the sampling and the filters. An unsupported level falls back to the scalar reference. */
+    explicit PageRenderer(const PageRenderOptions& options = PageRenderOptions(), SimdLevel level = bestSimdLevel());
+
+    const PageRenderOptions&    options() const { return _options; }
+    void                        setOptions(const PageRenderOptions& options);
+
+    /** @return Format of the rendered page: Gray8 for `PageFilter::UltraContrast` and `PageFilter::Luma`, BGRA8 otherwise */
+    PixelFormat outputFormat() const;
+
+    /**
+     @brief Size of the page rendered for `quad`: its rectified size (`pageSize` with `trueAspect`), shrunk to `dpi` and `maxPixels`,
+     less the margins, at least 1x1
+     */
+    void outputSize(const Quad& quad, int& width, int& height) const;
+
+    /**
+     @brief Render the page of `quad` (buffer coordinates of `source`).
+     @param destination `outputSize` rows of `stride` bytes, in `outputFormat`. Must not overlap `source`.
+     */
+    void render(const ImageView& source, const Quad& quad, uint8_t* destination, size_t stride);
+
+    /**
+     @brief Set the render of the page of `quad` up: with `whiteBalance`, the paper white is estimated once, from a fixed grid of the page.
+     @discussion `render` and `renderBands` call it. Call it once before the `renderRows` of a page.
+     */
+    void prepare(const ImageView& source, const Quad& quad);
+
+    /**
+     @brief Rows `top` to `top + rows - 1` of the page of `render`, the same bytes whatever the rows asked for.
+     @discussion Uses the paper white of the last `prepare`.
+     @param destination `rows` rows of `stride` bytes, in `outputFormat`, the first one for row `top`. Must not overlap `source`.
+     */
+    void renderRows(const ImageView& source, const Quad& quad, int top, int rows, uint8_t* destination, size_t stride);
+
+    /**
+     @brief Same as `render`, in bands of rows from the top, each handed to `consume(const ImageView& band, int top)` in turn.
+     @discussion The bands share one buffer of `PageRenderOptions::bandBytes`, overwritten once `consume` returns: it must encode or
+     copy the rows it keeps. Return false from `consume` to stop there.
+     */
+    template <typename Consumer>
+    void renderBands(const ImageView& source, const Quad& quad, Consumer&& consume);
+
+    /** @return Rows of a `width` pixels wide page in each band of `renderBands` */
+    int bandRows(int width) const;
+
+    /** @return The paper white estimated by the last `prepare` with `whiteBalance` set */
+    const PaperWhite& paperWhite() const { return _paperWhite; }
+
+    /** @return The quad of the whole `source`, to crop and filter a photo without a detected document */
+    static Quad frameQuad(const ImageView& source);
+
+private:
+    /** Size of the page of `quad` before the margins. `scale` is set to its ratio to the size at the resolution of the photo. */
+    void rectifiedPageSize(const Quad& quad, int& width, int& height, double& scale) const;
+
+    /** Row buffers of one worker */
+    struct Scratch {
+        std::vector<int32_t>    xs, ys, fxs, fys;
+        std::vector<uint8_t>    row;
+        GuidedFilter::Band      denoising;
+        UnsharpMask::Band       sharpening;
+    };
+
+    PageRenderOptions               _options;
+    const detail::WarpKernels*      _kernels;
+    ColorControls                   _colors;
+    PointFilter                     _grayFilter;    // the Gray8 pages
+    GuidedFilter                    _denoiser;
+    UnsharpMask                     _sharpener;
+    PaperWhite                      _paperWhite;
+    std::vector<Scratch>            _scratch;
+    std::unique_ptr<TileExecutor>   _executor;  // when `threads` is set
+};
+
+// MARK: - Implementation
+
+template <typename Consumer>
+void PageRenderer::renderBands(const ImageView& source, const Quad& quad, Consumer&& consume) {
+    int width, height;
+    outputSize(quad, width, height);
+    if (source.isEmpty() || source.format != PixelFormat::BGRA8) return;
+
+    const PixelFormat           format = outputFormat();
+    const int                   rows   = std::min(bandRows(width), height);
+    const size_t                stride = bytesPerPixel(format) * static_cast<size_t>(width);
+    std::unique_ptr<uint8_t[]>  band(new uint8_t[stride * static_cast<size_t>(rows)]);
+    prepare(source, quad);
+    for (int top = 0; top < height; top += rows) {
+        const int count = std::min(rows, height - top);
+        renderRows(source, quad, top, count, band.get(), stride);
+        if (!consume(ImageView(band.get(), width, count, stride, format), top)) break;
+    }
+}
+
+} // namespace irl
+
+#endif /* IRL_PAGE_RENDERER_HPP */
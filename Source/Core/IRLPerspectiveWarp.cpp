@@ -0,0 +1,275 @@
+//
+//  IRLPerspectiveWarp.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLPerspectiveWarp.hpp"
+#include "IRLWarpKernels.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cmath>
+
+namespace irl {
+namespace detail {
+
+// MARK: - Scalar kernels
+
+static void bilinearRowScalar(const WarpSource& source, const int32_t* xs, const int32_t* ys, int count, uint8_t* destination) {
+    for (int i = 0; i < count; i++, destination += 4) {
+        const int x = xs[i] >> kWarpShift, wx = (xs[i] >> (kWarpShift - 8)) & 255;
+        const int y = ys[i] >> kWarpShift, wy = (ys[i] >> (kWarpShift - 8)) & 255;
+        const uint8_t* top    = source.data + static_cast<size_t>(y) * source.stride + 4 * static_cast<size_t>(x);
+        const uint8_t* bottom = top + source.down;
+
+        for (int c = 0; c < 4; c++) {
+            const int upper = (top[c]    * (256 - wx) + top[source.right + c]    * wx + 128) >> 8;
+            const int lower = (bottom[c] * (256 - wx) + bottom[source.right + c] * wx + 128) >> 8;
+            destination[c] = static_cast<uint8_t>((upper * (256 - wy) + lower * wy + 128) >> 8);
+        }
+    }
+}
+
+static void bicubicRowScalar(const WarpSource& source, const int32_t* xs, const int32_t* ys, int count, const int16_t (*weights)[4], uint8_t* destination) {
+    const int phaseShift = kWarpShift - 8;
+    const int round      = 1 << (2 * kCubicShift - 1);
+    for (int i = 0; i < count; i++, destination += 4) {
+        const int x0 = xs[i] >> kWarpShift, y0 = ys[i] >> kWarpShift;
+        const int16_t* wx = weights[(xs[i] >> phaseShift) & (kCubicPhases - 1)];
+        const int16_t* wy = weights[(ys[i] >> phaseShift) & (kCubicPhases - 1)];
+
+        int32_t sums[4] = { 0, 0, 0, 0 };
+        for (int j = 0; j < 4; j++) {
+            uint32_t spare[4];
+            const uint8_t* taps = cubicTaps(source, x0, y0 - 1 + j, spare);
+            for (int c = 0; c < 4; c++) {
+                const int32_t row = wx[0] * taps[c] + wx[1] * taps[4 + c] + wx[2] * taps[8 + c] + wx[3] * taps[12 + c];
+                sums[c] += wy[j] * row;
+            }
+        }
+        for (int c = 0; c < 4; c++) destination[c] = static_cast<uint8_t>(std::min(std::max((sums[c] + round) >> (2 * kCubicShift), 0), 255));
+    }
+}
+
+static void areaRowScalar(const WarpSource& source, const int32_t* xs, const int32_t* ys, const int32_t* fxs, const int32_t* fys, int count, uint8_t* destination) {
+    const int round = 1 << (kAreaShift - 1);
+    int16_t wx[kAreaTaps], wy[kAreaTaps];
+    for (int i = 0; i < count; i++, destination += 4) {
+        int x0, y0;
+        const int columns = areaTaps(xs[i], fxs[i], source.width,  x0, wx);
+        const int rows    = areaTaps(ys[i], fys[i], source.height, y0, wy);
+
+        int32_t sums[4] = { 0, 0, 0, 0 };
+        for (int j = 0; j < rows; j++) {
+            const uint8_t* taps = source.data + static_cast<size_t>(y0 + j) * source.stride + 4 * static_cast<size_t>(x0);
+            int32_t row[4] = { 0, 0, 0, 0 };
+            for (int k = 0; k < columns; k++) {
+                for (int c = 0; c < 4; c++) row[c] += wx[k] * taps[4 * k + c];
+            }
+            for (int c = 0; c < 4; c++) sums[c] += wy[j] * ((row[c] + round) >> kAreaShift);
+        }
+        for (int c = 0; c < 4; c++) destination[c] = static_cast<uint8_t>((sums[c] + round) >> kAreaShift);
+    }
+}
+
+const WarpKernels* warpKernelsScalar() {
+    static const WarpKernels kernels = { bilinearRowScalar, bicubicRowScalar, areaRowScalar };
+    return &kernels;
+}
+
+const WarpKernels* warpKernels(SimdLevel level) {
+    if (!isSimdLevelSupported(level)) return nullptr;
+    switch (level) {
+        case SimdLevel::Scalar: return warpKernelsScalar();
+        case SimdLevel::SSE41:  return warpKernelsSSE41();
+        case SimdLevel::AVX2:   return warpKernelsAVX2();
+        case SimdLevel::NEON:   return warpKernelsNEON();
+    }
+    return nullptr;
+}
+
+// MARK: - Bicubic weights
+
+namespace {
+struct CubicTable {
+    int16_t weights[kCubicPhases][4];
+
+    CubicTable() {
+        // Catmull-Rom (a = -0.5), rounded, then the largest tap takes the rounding error so every set sums to one
+        const int one = 1 << kCubicShift;
+        for (int p = 0; p < kCubicPhases; p++) {
+            const double t = static_cast<double>(p) / kCubicPhases, t2 = t * t, t3 = t2 * t;
+            const double taps[4] = { 0.5 * (-t3 + 2.0 * t2 - t), 0.5 * (3.0 * t3 - 5.0 * t2 + 2.0),
+                                     0.5 * (-3.0 * t3 + 4.0 * t2 + t), 0.5 * (t3 - t2) };
+            int sum = 0;
+            for (int k = 0; k < 4; k++) sum += weights[p][k] = static_cast<int16_t>(std::lround(taps[k] * one));
+            weights[p][t < 0.5 ? 1 : 2] = static_cast<int16_t>(weights[p][t < 0.5 ? 1 : 2] + one - sum);
+        }
+    }
+};
+} // namespace
+
+const int16_t (*cubicWeights())[4] {
+    static const CubicTable table;
+    return table.weights;
+}
+
+} // namespace detail
+
+// MARK: - PerspectiveWarp
+
+static const int    kBandHeight = 32;
+static const int    kSpan       = 16;           // pixels between two exact projections of a row
+static const double kLimit      = 16384.0;      // source coordinates beyond are clamped, they are past any photo anyway
+
+PerspectiveWarp::PerspectiveWarp(const WarpOptions& options, SimdLevel level)
+: _options(options)
+, _level(level)
+, _kernels(detail::warpKernels(level)) {
+    if (!_kernels) {
+        _level   = SimdLevel::Scalar;
+        _kernels = detail::warpKernelsScalar();
+    }
+}
+
+void PerspectiveWarp::coordinatesRow(const Homography& transform, int y, int width, int sourceWidth, int sourceHeight,
+                                     Interpolation interpolation, int32_t* xs, int32_t* ys) {
+    const double* m  = transform.m;
+    const double  cy = y + 0.5;
+    double X = m[0] * 0.5 + m[1] * cy + m[2];
+    double Y = m[3] * 0.5 + m[4] * cy + m[5];
+    double W = m[6] * 0.5 + m[7] * cy + m[8];
+
+    // Bilinear pairs must stay in the source, one unit is enough to keep their right and bottom pixels in
+    const int32_t inset = interpolation == Interpolation::Bilinear ? 1 : 0;
+    const int32_t maxX  = std::max((sourceWidth  - 1) * (1 << detail::kWarpShift) - inset, 0);
+    const int32_t maxY  = std::max((sourceHeight - 1) * (1 << detail::kWarpShift) - inset, 0);
+
+    // Pixel centers are at .5 in the continuous coordinates of the homography
+    auto project = [](double value, double w) {
+        const double pixel = w != 0.0 ? value / w - 0.5 : 0.0;
+        return static_cast<int64_t>(std::lround(std::min(std::max(pixel, -kLimit), kLimit) * (1 << detail::kWarpShift)));
+    };
+
+    int64_t knotX = project(X, W), knotY = project(Y, W);
+    for (int x = 0; x < width; x += kSpan) {
+        X += m[0] * kSpan;
+        Y += m[3] * kSpan;
+        W += m[6] * kSpan;
+        const int64_t nextX = project(X, W), nextY = project(Y, W);
+        const int64_t stepX = (nextX - knotX) / kSpan, stepY = (nextY - knotY) / kSpan;
+
+        const int count = std::min(kSpan, width - x);
+        for (int i = 0; i < count; i++) {
+            xs[x + i] = static_cast<int32_t>(std::min(std::max(knotX + stepX * i, int64_t(0)), int64_t(maxX)));
+            ys[x + i] = static_cast<int32_t>(std::min(std::max(knotY + stepY * i, int64_t(0)), int64_t(maxY)));
+        }
+        knotX = nextX;
+        knotY = nextY;
+    }
+}
+
+void PerspectiveWarp::footprintRow(const Homography& transform, int y, int width, int32_t* fxs, int32_t* fys) {
+    const double* m  = transform.m;
+    const double  cy = y + 0.5;
+    const double  one = 1 << detail::kWarpShift;
+
+    // d(X / W) = (dX - (X / W) dW) / W along the output x and y, then its length on each source axis
+    auto footprint = [&](double cx, int64_t& fx, int64_t& fy) {
+        const double W = m[6] * cx + m[7] * cy + m[8];
+        const double x = W != 0.0 ? (m[0] * cx + m[1] * cy + m[2]) / W : 0.0;
+        const double v = W != 0.0 ? (m[3] * cx + m[4] * cy + m[5]) / W : 0.0;
+        const double scale = W != 0.0 ? 1.0 / std::fabs(W) : 0.0;
+        const double sizeX = std::hypot(m[0] - x * m[6], m[1] - x * m[7]) * scale;
+        const double sizeY = std::hypot(m[3] - v * m[6], m[4] - v * m[7]) * scale;
+        const double limit = detail::kAreaTaps - 1;
+        fx = std::lround(std::min(std::max(sizeX, 1.0), limit) * one);
+        fy = std::lround(std::min(std::max(sizeY, 1.0), limit) * one);
+    };
+
+    int64_t knotX, knotY;
+    footprint(0.5, knotX, knotY);
+    for (int x = 0; x < width; x += kSpan) {
+        int64_t nextX, nextY;
+        footprint(x + kSpan + 0.5, nextX, nextY);
+        const int64_t stepX = (nextX - knotX) / kSpan, stepY = (nextY - knotY) / kSpan;
+
+        const int count = std::min(kSpan, width - x);
+        for (int i = 0; i < count; i++) {
+            fxs[x + i] = static_cast<int32_t>(knotX + stepX * i);
+            fys[x + i] = static_cast<int32_t>(knotY + stepY * i);
+        }
+        knotX = nextX;
+        knotY = nextY;
+    }
+}
+
+void PerspectiveWarp::warp(const ImageView& source, const Homography& transform, uint8_t* destination, size_t stride, int width, int height) {
+    warpRows(source, transform, width, 0, height, destination, stride);
+}
+
+void PerspectiveWarp::warpRows(const ImageView& source, const Homography& transform, int width, int top, int rows,
+                               uint8_t* destination, size_t stride) {
+    assert(source.format == PixelFormat::BGRA8);
+    if (source.isEmpty() || width <= 0 || rows <= 0) return;
+
+    detail::WarpSource sampled;
+    sampled.data   = source.data;
+    sampled.stride = source.stride;
+    sampled.width  = source.width;
+    sampled.height = source.height;
+    sampled.right  = source.width  > 1 ? 4 : 0;
+    sampled.down   = source.height > 1 ? source.stride : 0;
+
+    const Interpolation       interpolation = _options.interpolation;
+    const int16_t           (*weights)[4]   = detail::cubicWeights();
+    TileExecutor& executor = executorForThreads(_options.threads, _executor);
+    if (static_cast<int>(_scratch.size()) < executor.threadCount()) _scratch.resize(static_cast<size_t>(executor.threadCount()));
+
+    executor.runBands(width, rows, kBandHeight, [&](const Tile& band, int worker) {
+        Scratch& scratch = _scratch[static_cast<size_t>(worker)];
+        scratch.xs.resize(static_cast<size_t>(width));
+        scratch.ys.resize(static_cast<size_t>(width));
+        if (interpolation == Interpolation::Area) {
+            scratch.fxs.resize(static_cast<size_t>(width));
+            scratch.fys.resize(static_cast<size_t>(width));
+        }
+
+        for (int y = band.y; y < band.y + band.height; y++) {
+            uint8_t* dst = destination + stride * static_cast<size_t>(y);
+            coordinatesRow(transform, top + y, width, source.width, source.height, interpolation, scratch.xs.data(), scratch.ys.data());
+            switch (interpolation) {
+                case Interpolation::Bilinear:
+                    _kernels->bilinearRow(sampled, scratch.xs.data(), scratch.ys.data(), width, dst);
+                    break;
+                case Interpolation::Bicubic:
+                    _kernels->bicubicRow(sampled, scratch.xs.data(), scratch.ys.data(), width, weights, dst);
+                    break;
+                case Interpolation::Area:
+                    footprintRow(transform, top + y, width, scratch.fxs.data(), scratch.fys.data());
+                    _kernels->areaRow(sampled, scratch.xs.data(), scratch.ys.data(), scratch.fxs.data(), scratch.fys.data(), width, dst);
+                    break;
+            }
+        }
+    });
+}
+
+int PerspectiveWarp::bandRows(int width) const {
+    const size_t rowBytes = 4 * static_cast<size_t>(std::max(width, 1));
+    return static_cast<int>(std::min(std::max(_options.bandBytes / rowBytes, size_t(1)), size_t(INT_MAX)));
+}
+
+void PerspectiveWarp::rectify(const ImageView& source, const Quad& quad, uint8_t* destination, size_t stride) {
+    int width, height;
+    rectifiedSize(quad, width, height);
+    rectify(source, quad, width, height, destination, stride);
+}
+
+void PerspectiveWarp::rectify(const ImageView& source, const Quad& quad, int width, int height, uint8_t* destination, size_t stride) {
+    warp(source, Homography::rectangleToQuad(std::max(width, 1), std::max(height, 1), quad), destination, stride, width, height);
+}
+
+} // namespace irl
@@ -0,0 +1,190 @@
+//
+//  IRLPerspectiveWarpAVX2.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  AVX2 samplers. Bilinear: 8 pixels per iteration, each corner of their 2x2 taps fetched with
+//  one gather. Bicubic: two pixels per iteration, one in each 128 bit lane, with the pairing
+//  shuffle and multiply-adds of the SSE4.1 kernel. Area: one pixel per iteration, two rows of its
+//  taps at a time, one in each 128 bit lane.
+//
+
+#include "IRLWarpKernels.hpp"
+
+#include <cstring>
+
+#if IRL_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace irl {
+namespace detail {
+
+#if IRL_SIMD_X86
+
+IRL_TARGET_AVX2 static inline __m256i blend16(__m256i a, __m256i b, __m256i weight) {
+    // (a (256 - w) + b w + 128) >> 8, at most 65408: unsigned 16 bit lanes are enough
+    const __m256i complement = _mm256_sub_epi16(_mm256_set1_epi16(256), weight);
+    const __m256i sum = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(a, complement), _mm256_mullo_epi16(b, weight)), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(sum, 8);
+}
+
+IRL_TARGET_AVX2 static void bilinearRowAVX2(const WarpSource& source, const int32_t* xs, const int32_t* ys, int count, uint8_t* destination) {
+    const __m256i zero     = _mm256_setzero_si256();
+    const __m256i byteMask = _mm256_set1_epi32(255);
+    const __m256i stride   = _mm256_set1_epi32(static_cast<int32_t>(source.stride));
+    // Weight of pixel 0 and 1 (2 and 3) of each lane on their 4 channel lanes, as the in lane unpacks order them
+    const __m256i spreadLow  = _mm256_setr_epi8(0, -1, 0, -1, 0, -1, 0, -1, 4, -1, 4, -1, 4, -1, 4, -1,
+                                                0, -1, 0, -1, 0, -1, 0, -1, 4, -1, 4, -1, 4, -1, 4, -1);
+    const __m256i spreadHigh = _mm256_setr_epi8(8, -1, 8, -1, 8, -1, 8, -1, 12, -1, 12, -1, 12, -1, 12, -1,
+                                                8, -1, 8, -1, 8, -1, 8, -1, 12, -1, 12, -1, 12, -1, 12, -1);
+    const int* top    = reinterpret_cast<const int*>(source.data);
+    const int* bottom = reinterpret_cast<const int*>(source.data + source.down);
+    const int  right  = source.right;
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(xs + i));
+        const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ys + i));
+        const __m256i offsets = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_srai_epi32(y, kWarpShift), stride),
+                                                 _mm256_slli_epi32(_mm256_srai_epi32(x, kWarpShift), 2));
+        const __m256i wx = _mm256_and_si256(_mm256_srli_epi32(x, kWarpShift - 8), byteMask);
+        const __m256i wy = _mm256_and_si256(_mm256_srli_epi32(y, kWarpShift - 8), byteMask);
+
+        const __m256i topLeft     = _mm256_i32gather_epi32(top, offsets, 1);
+        const __m256i bottomLeft  = _mm256_i32gather_epi32(bottom, offsets, 1);
+        const __m256i shifted     = _mm256_add_epi32(offsets, _mm256_set1_epi32(right));
+        const __m256i topRight    = _mm256_i32gather_epi32(top, shifted, 1);
+        const __m256i bottomRight = _mm256_i32gather_epi32(bottom, shifted, 1);
+
+        const __m256i wxLow  = _mm256_shuffle_epi8(wx, spreadLow),  wxHigh = _mm256_shuffle_epi8(wx, spreadHigh);
+        const __m256i wyLow  = _mm256_shuffle_epi8(wy, spreadLow),  wyHigh = _mm256_shuffle_epi8(wy, spreadHigh);
+
+        const __m256i upperLow  = blend16(_mm256_unpacklo_epi8(topLeft, zero),    _mm256_unpacklo_epi8(topRight, zero),    wxLow);
+        const __m256i lowerLow  = blend16(_mm256_unpacklo_epi8(bottomLeft, zero), _mm256_unpacklo_epi8(bottomRight, zero), wxLow);
+        const __m256i upperHigh = blend16(_mm256_unpackhi_epi8(topLeft, zero),    _mm256_unpackhi_epi8(topRight, zero),    wxHigh);
+        const __m256i lowerHigh = blend16(_mm256_unpackhi_epi8(bottomLeft, zero), _mm256_unpackhi_epi8(bottomRight, zero), wxHigh);
+
+        // The in lane pack puts the pixels back in order: 0 to 3 in the low lane, 4 to 7 in the high one
+        const __m256i result = _mm256_packus_epi16(blend16(upperLow, lowerLow, wyLow), blend16(upperHigh, lowerHigh, wyHigh));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + 4 * i), result);
+    }
+    if (i < count) warpKernelsScalar()->bilinearRow(source, xs + i, ys + i, count - i, destination + 4 * i);
+}
+
+IRL_TARGET_AVX2 static inline int32_t tapPair(const int16_t* w, int k) {
+    return static_cast<int32_t>(static_cast<uint16_t>(w[k]) | static_cast<uint32_t>(static_cast<uint16_t>(w[k + 1])) << 16);
+}
+
+IRL_TARGET_AVX2 static void bicubicRowAVX2(const WarpSource& source, const int32_t* xs, const int32_t* ys, int count, const int16_t (*weights)[4], uint8_t* destination) {
+    // Taps 0 and 1 (2 and 3) of each channel next to each other, in each lane
+    const __m256i pairs = _mm256_setr_epi8(0, 4, 1, 5, 2, 6, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15,
+                                           0, 4, 1, 5, 2, 6, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15);
+    const __m256i zero  = _mm256_setzero_si256();
+    const __m256i round = _mm256_set1_epi32(1 << (2 * kCubicShift - 1));
+    const int     phaseShift = kWarpShift - 8;
+
+    int i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const int a0 = xs[i] >> kWarpShift,     b0 = ys[i] >> kWarpShift;
+        const int a1 = xs[i + 1] >> kWarpShift, b1 = ys[i + 1] >> kWarpShift;
+        const int16_t* wx0 = weights[(xs[i] >> phaseShift) & (kCubicPhases - 1)];
+        const int16_t* wy0 = weights[(ys[i] >> phaseShift) & (kCubicPhases - 1)];
+        const int16_t* wx1 = weights[(xs[i + 1] >> phaseShift) & (kCubicPhases - 1)];
+        const int16_t* wy1 = weights[(ys[i + 1] >> phaseShift) & (kCubicPhases - 1)];
+        const __m256i first  = _mm256_setr_m128i(_mm_set1_epi32(tapPair(wx0, 0)), _mm_set1_epi32(tapPair(wx1, 0)));
+        const __m256i second = _mm256_setr_m128i(_mm_set1_epi32(tapPair(wx0, 2)), _mm_set1_epi32(tapPair(wx1, 2)));
+
+        __m256i sum = zero;
+        for (int j = 0; j < 4; j++) {
+            uint32_t spare0[4], spare1[4];
+            const __m128i low  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cubicTaps(source, a0, b0 - 1 + j, spare0)));
+            const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cubicTaps(source, a1, b1 - 1 + j, spare1)));
+            const __m256i taps = _mm256_shuffle_epi8(_mm256_setr_m128i(low, high), pairs);
+            const __m256i row  = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi8(taps, zero), first),
+                                                  _mm256_madd_epi16(_mm256_unpackhi_epi8(taps, zero), second));
+            sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(row, _mm256_setr_m128i(_mm_set1_epi32(wy0[j]), _mm_set1_epi32(wy1[j]))));
+        }
+        const __m256i pixel = _mm256_srai_epi32(_mm256_add_epi32(sum, round), 2 * kCubicShift);
+        const __m256i bytes = _mm256_packus_epi16(_mm256_packs_epi32(pixel, pixel), zero);
+        const int32_t value0 = _mm_cvtsi128_si32(_mm256_castsi256_si128(bytes));
+        const int32_t value1 = _mm_cvtsi128_si32(_mm256_extracti128_si256(bytes, 1));
+        std::memcpy(destination + 4 * i,     &value0, 4);
+        std::memcpy(destination + 4 * i + 4, &value1, 4);
+    }
+    if (i < count) warpKernelsScalar()->bicubicRow(source, xs + i, ys + i, count - i, weights, destination + 4 * i);
+}
+
+/** Weighted sums of the `count` taps from `top` (low lane) and from `bottom` (high lane), one channel per 32 bit lane */
+IRL_TARGET_AVX2 static inline __m256i areaTapRows(const uint8_t* top, const uint8_t* bottom, const int16_t* weights, int count) {
+    const __m256i pairs = _mm256_setr_epi8(0, 4, 1, 5, 2, 6, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15,
+                                           0, 4, 1, 5, 2, 6, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15);
+    const __m256i zero  = _mm256_setzero_si256();
+    __m256i sum = zero;
+    int k = 0;
+    for (; k + 4 <= count; k += 4) {
+        const __m128i low   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(top + 4 * k));
+        const __m128i high  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + 4 * k));
+        const __m256i bytes = _mm256_shuffle_epi8(_mm256_setr_m128i(low, high), pairs);
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_unpacklo_epi8(bytes, zero), _mm256_set1_epi32(tapPair(weights, k))));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_unpackhi_epi8(bytes, zero), _mm256_set1_epi32(tapPair(weights, k + 2))));
+    }
+    // Loads never go past the last tap: the source may end there
+    if (k + 2 <= count) {
+        const __m128i low   = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(top + 4 * k));
+        const __m128i high  = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(bottom + 4 * k));
+        const __m256i bytes = _mm256_shuffle_epi8(_mm256_setr_m128i(low, high), pairs);
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_unpacklo_epi8(bytes, zero), _mm256_set1_epi32(tapPair(weights, k))));
+        k += 2;
+    }
+    if (k < count) {
+        int32_t low, high;
+        std::memcpy(&low, top + 4 * k, 4);
+        std::memcpy(&high, bottom + 4 * k, 4);
+        const __m256i bytes = _mm256_shuffle_epi8(_mm256_setr_m128i(_mm_cvtsi32_si128(low), _mm_cvtsi32_si128(high)), pairs);
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_unpacklo_epi8(bytes, zero), _mm256_set1_epi32(static_cast<uint16_t>(weights[k]))));
+    }
+    return sum;
+}
+
+IRL_TARGET_AVX2 static void areaRowAVX2(const WarpSource& source, const int32_t* xs, const int32_t* ys, const int32_t* fxs, const int32_t* fys, int count, uint8_t* destination) {
+    const __m256i round = _mm256_set1_epi32(1 << (kAreaShift - 1));
+    int16_t wx[kAreaTaps], wy[kAreaTaps];
+
+    for (int i = 0; i < count; i++) {
+        int x0, y0;
+        const int columns = areaTaps(xs[i], fxs[i], source.width,  x0, wx);
+        const int rows    = areaTaps(ys[i], fys[i], source.height, y0, wy);
+        const uint8_t* taps = source.data + static_cast<size_t>(y0) * source.stride + 4 * static_cast<size_t>(x0);
+
+        // An odd last row pairs with itself, with a zero weight
+        __m256i sum = _mm256_setzero_si256();
+        for (int j = 0; j < rows; j += 2) {
+            const bool    pair   = j + 1 < rows;
+            const uint8_t* top   = taps + static_cast<size_t>(j) * source.stride;
+            const __m256i  row   = _mm256_srai_epi32(_mm256_add_epi32(areaTapRows(top, pair ? top + source.stride : top, wx, columns), round), kAreaShift);
+            const __m256i  scale = _mm256_setr_m128i(_mm_set1_epi32(wy[j]), _mm_set1_epi32(pair ? wy[j + 1] : 0));
+            sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(row, scale));
+        }
+        const __m128i total = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        const __m128i pixel = _mm_srai_epi32(_mm_add_epi32(total, _mm256_castsi256_si128(round)), kAreaShift);
+        const __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(pixel, pixel), _mm_setzero_si128());
+        const int32_t value = _mm_cvtsi128_si32(bytes);
+        std::memcpy(destination + 4 * i, &value, 4);
+    }
+}
+
+const WarpKernels* warpKernelsAVX2() {
+    static const WarpKernels kernels = { bilinearRowAVX2, bicubicRowAVX2, areaRowAVX2 };
+    return &kernels;
+}
+
+#else
+
+const WarpKernels* warpKernelsAVX2() { return nullptr; }
+
+#endif
+
+} // namespace detail
+} // namespace irl
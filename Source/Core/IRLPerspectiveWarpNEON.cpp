@@ -0,0 +1,158 @@
+//
+//  IRLPerspectiveWarpNEON.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  NEON samplers. Bilinear: 4 pixels per iteration blended on 16 bit lanes, the weights spread
+//  to the channels with a table lookup. Bicubic: one pixel per iteration, the 4 taps of a row
+//  widened from one 16 byte load and accumulated with multiply-accumulates by scalar. Area: one
+//  pixel per iteration, the taps of a row widened two at a time the same way.
+//
+
+#include "IRLWarpKernels.hpp"
+
+#include <cstring>
+
+#if IRL_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace irl {
+namespace detail {
+
+#if IRL_SIMD_NEON
+
+static inline uint16x8_t blend16(uint16x8_t a, uint16x8_t b, uint16x8_t weight) {
+    // (a (256 - w) + b w + 128) >> 8, at most 65408: unsigned 16 bit lanes are enough
+    const uint16x8_t complement = vsubq_u16(vdupq_n_u16(256), weight);
+    return vshrq_n_u16(vaddq_u16(vmlaq_u16(vmulq_u16(a, complement), b, weight), vdupq_n_u16(128)), 8);
+}
+
+static void bilinearRowNEON(const WarpSource& source, const int32_t* xs, const int32_t* ys, int count, uint8_t* destination) {
+    // Weight of pixel 0 and 1 (2 and 3) on the 4 channel lanes of each, index 255 reads 0
+    static const uint8_t kSpreadLow[16]  = { 0, 255, 0, 255, 0, 255, 0, 255, 4, 255, 4, 255, 4, 255, 4, 255 };
+    static const uint8_t kSpreadHigh[16] = { 8, 255, 8, 255, 8, 255, 8, 255, 12, 255, 12, 255, 12, 255, 12, 255 };
+    const uint8x16_t spreadLow  = vld1q_u8(kSpreadLow);
+    const uint8x16_t spreadHigh = vld1q_u8(kSpreadHigh);
+    const uint32x4_t byteMask   = vdupq_n_u32(255);
+    const int        right      = source.right;
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const uint32x4_t x = vreinterpretq_u32_s32(vld1q_s32(xs + i));
+        const uint32x4_t y = vreinterpretq_u32_s32(vld1q_s32(ys + i));
+        const uint8x16_t wx = vreinterpretq_u8_u32(vandq_u32(vshrq_n_u32(x, kWarpShift - 8), byteMask));
+        const uint8x16_t wy = vreinterpretq_u8_u32(vandq_u32(vshrq_n_u32(y, kWarpShift - 8), byteMask));
+
+        uint32_t tl[4], tr[4], bl[4], br[4];
+        for (int k = 0; k < 4; k++) {
+            const uint8_t* top = source.data + static_cast<size_t>(ys[i + k] >> kWarpShift) * source.stride + 4 * static_cast<size_t>(xs[i + k] >> kWarpShift);
+            const uint8_t* bottom = top + source.down;
+            std::memcpy(tl + k, top, 4);
+            std::memcpy(tr + k, top + right, 4);
+            std::memcpy(bl + k, bottom, 4);
+            std::memcpy(br + k, bottom + right, 4);
+        }
+        const uint8x16_t topLeft     = vreinterpretq_u8_u32(vld1q_u32(tl));
+        const uint8x16_t topRight    = vreinterpretq_u8_u32(vld1q_u32(tr));
+        const uint8x16_t bottomLeft  = vreinterpretq_u8_u32(vld1q_u32(bl));
+        const uint8x16_t bottomRight = vreinterpretq_u8_u32(vld1q_u32(br));
+
+        const uint16x8_t wxLow  = vreinterpretq_u16_u8(vqtbl1q_u8(wx, spreadLow)),  wxHigh = vreinterpretq_u16_u8(vqtbl1q_u8(wx, spreadHigh));
+        const uint16x8_t wyLow  = vreinterpretq_u16_u8(vqtbl1q_u8(wy, spreadLow)),  wyHigh = vreinterpretq_u16_u8(vqtbl1q_u8(wy, spreadHigh));
+
+        const uint16x8_t upperLow  = blend16(vmovl_u8(vget_low_u8(topLeft)),     vmovl_u8(vget_low_u8(topRight)),     wxLow);
+        const uint16x8_t lowerLow  = blend16(vmovl_u8(vget_low_u8(bottomLeft)),  vmovl_u8(vget_low_u8(bottomRight)),  wxLow);
+        const uint16x8_t upperHigh = blend16(vmovl_u8(vget_high_u8(topLeft)),    vmovl_u8(vget_high_u8(topRight)),    wxHigh);
+        const uint16x8_t lowerHigh = blend16(vmovl_u8(vget_high_u8(bottomLeft)), vmovl_u8(vget_high_u8(bottomRight)), wxHigh);
+
+        // Blended values are at most 255, the narrowing keeps them as they are
+        const uint8x16_t result = vcombine_u8(vmovn_u16(blend16(upperLow, lowerLow, wyLow)), vmovn_u16(blend16(upperHigh, lowerHigh, wyHigh)));
+        vst1q_u8(destination + 4 * i, result);
+    }
+    if (i < count) warpKernelsScalar()->bilinearRow(source, xs + i, ys + i, count - i, destination + 4 * i);
+}
+
+static void bicubicRowNEON(const WarpSource& source, const int32_t* xs, const int32_t* ys, int count, const int16_t (*weights)[4], uint8_t* destination) {
+    const int32x4_t round = vdupq_n_s32(1 << (2 * kCubicShift - 1));
+    const int       phaseShift = kWarpShift - 8;
+
+    for (int i = 0; i < count; i++) {
+        const int x0 = xs[i] >> kWarpShift, y0 = ys[i] >> kWarpShift;
+        const int16_t* wx = weights[(xs[i] >> phaseShift) & (kCubicPhases - 1)];
+        const int16_t* wy = weights[(ys[i] >> phaseShift) & (kCubicPhases - 1)];
+
+        int32x4_t sum = vdupq_n_s32(0);
+        for (int j = 0; j < 4; j++) {
+            uint32_t spare[4];
+            const uint8x16_t taps  = vld1q_u8(cubicTaps(source, x0, y0 - 1 + j, spare));
+            const int16x8_t  left  = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(taps)));     // taps 0 and 1
+            const int16x8_t  right = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(taps)));    // taps 2 and 3
+            int32x4_t row = vmull_n_s16(vget_low_s16(left), wx[0]);
+            row = vmlal_n_s16(row, vget_high_s16(left),  wx[1]);
+            row = vmlal_n_s16(row, vget_low_s16(right),  wx[2]);
+            row = vmlal_n_s16(row, vget_high_s16(right), wx[3]);
+            sum = vmlaq_n_s32(sum, row, wy[j]);
+        }
+        const int32x4_t  pixel = vshrq_n_s32(vaddq_s32(sum, round), 2 * kCubicShift);
+        const uint16x4_t clamped = vqmovun_s32(pixel);
+        const uint8x8_t  bytes = vqmovn_u16(vcombine_u16(clamped, clamped));
+        vst1_lane_u32(reinterpret_cast<uint32_t*>(destination + 4 * i), vreinterpret_u32_u8(bytes), 0);
+    }
+}
+
+/** Weighted sums of the `count` taps from `taps`, one channel per 32 bit lane */
+static inline int32x4_t areaTapRow(const uint8_t* taps, const int16_t* weights, int count) {
+    int32x4_t sum = vdupq_n_s32(0);
+    int k = 0;
+    for (; k + 2 <= count; k += 2) {
+        const int16x8_t pair = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(taps + 4 * k)));
+        sum = vmlal_n_s16(sum, vget_low_s16(pair),  weights[k]);
+        sum = vmlal_n_s16(sum, vget_high_s16(pair), weights[k + 1]);
+    }
+    // The last tap alone: the source may end there
+    if (k < count) {
+        uint32_t value;
+        std::memcpy(&value, taps + 4 * k, 4);
+        const int16x8_t pixel = vreinterpretq_s16_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(value))));
+        sum = vmlal_n_s16(sum, vget_low_s16(pixel), weights[k]);
+    }
+    return sum;
+}
+
+static void areaRowNEON(const WarpSource& source, const int32_t* xs, const int32_t* ys, const int32_t* fxs, const int32_t* fys, int count, uint8_t* destination) {
+    const int32x4_t round = vdupq_n_s32(1 << (kAreaShift - 1));
+    int16_t wx[kAreaTaps], wy[kAreaTaps];
+
+    for (int i = 0; i < count; i++) {
+        int x0, y0;
+        const int columns = areaTaps(xs[i], fxs[i], source.width,  x0, wx);
+        const int rows    = areaTaps(ys[i], fys[i], source.height, y0, wy);
+
+        int32x4_t sum = vdupq_n_s32(0);
+        for (int j = 0; j < rows; j++) {
+            const uint8_t*  taps = source.data + static_cast<size_t>(y0 + j) * source.stride + 4 * static_cast<size_t>(x0);
+            const int32x4_t row  = vshrq_n_s32(vaddq_s32(areaTapRow(taps, wx, columns), round), kAreaShift);
+            sum = vmlaq_n_s32(sum, row, wy[j]);
+        }
+        const int32x4_t  pixel   = vshrq_n_s32(vaddq_s32(sum, round), kAreaShift);
+        const uint16x4_t clamped = vqmovun_s32(pixel);
+        const uint8x8_t  bytes   = vqmovn_u16(vcombine_u16(clamped, clamped));
+        vst1_lane_u32(reinterpret_cast<uint32_t*>(destination + 4 * i), vreinterpret_u32_u8(bytes), 0);
+    }
+}
+
+const WarpKernels* warpKernelsNEON() {
+    static const WarpKernels kernels = { bilinearRowNEON, bicubicRowNEON, areaRowNEON };
+    return &kernels;
+}
+
+#else
+
+const WarpKernels* warpKernelsNEON() { return nullptr; }
+
+#endif
+
+} // namespace detail
+} // namespace irl
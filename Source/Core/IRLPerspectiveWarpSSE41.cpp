@@ -0,0 +1,185 @@
+//
+//  IRLPerspectiveWarpSSE41.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  SSE4.1 samplers. Bilinear: 4 pixels per iteration, their 2x2 taps loaded as pairs and blended
+//  on 16 bit lanes. Bicubic: one pixel per iteration, each tap row one 16 byte load whose bytes
+//  are paired per channel so a multiply-add applies two horizontal taps at once. Area: one pixel
+//  per iteration, footprints of up to 4x4 taps like the bicubic ones, larger ones row by row.
+//
+
+#include "IRLWarpKernels.hpp"
+
+#include <cstring>
+
+#if IRL_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace irl {
+namespace detail {
+
+#if IRL_SIMD_X86
+
+IRL_TARGET_SSE41 static inline __m128i blend16(__m128i a, __m128i b, __m128i weight) {
+    // (a (256 - w) + b w + 128) >> 8, at most 65408: unsigned 16 bit lanes are enough
+    const __m128i complement = _mm_sub_epi16(_mm_set1_epi16(256), weight);
+    const __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(a, complement), _mm_mullo_epi16(b, weight)), _mm_set1_epi16(128));
+    return _mm_srli_epi16(sum, 8);
+}
+
+IRL_TARGET_SSE41 static inline int32_t load32(const uint8_t* p) {
+    int32_t value;
+    std::memcpy(&value, p, 4);
+    return value;
+}
+
+IRL_TARGET_SSE41 static void bilinearRowSSE41(const WarpSource& source, const int32_t* xs, const int32_t* ys, int count, uint8_t* destination) {
+    const __m128i zero     = _mm_setzero_si128();
+    const __m128i byteMask = _mm_set1_epi32(255);
+    // Weight of pixel 0 and 1 (2 and 3) on the 4 channel lanes of each
+    const __m128i spreadLow  = _mm_setr_epi8(0, -1, 0, -1, 0, -1, 0, -1, 4, -1, 4, -1, 4, -1, 4, -1);
+    const __m128i spreadHigh = _mm_setr_epi8(8, -1, 8, -1, 8, -1, 8, -1, 12, -1, 12, -1, 12, -1, 12, -1);
+    const int     right = source.right;
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(xs + i));
+        const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ys + i));
+        const __m128i wx = _mm_and_si128(_mm_srli_epi32(x, kWarpShift - 8), byteMask);
+        const __m128i wy = _mm_and_si128(_mm_srli_epi32(y, kWarpShift - 8), byteMask);
+
+        int32_t tl[4], tr[4], bl[4], br[4];
+        for (int k = 0; k < 4; k++) {
+            const uint8_t* top = source.data + static_cast<size_t>(ys[i + k] >> kWarpShift) * source.stride + 4 * static_cast<size_t>(xs[i + k] >> kWarpShift);
+            const uint8_t* bottom = top + source.down;
+            tl[k] = load32(top);
+            tr[k] = load32(top + right);
+            bl[k] = load32(bottom);
+            br[k] = load32(bottom + right);
+        }
+        const __m128i topLeft     = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tl));
+        const __m128i topRight    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tr));
+        const __m128i bottomLeft  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bl));
+        const __m128i bottomRight = _mm_loadu_si128(reinterpret_cast<const __m128i*>(br));
+
+        const __m128i wxLow  = _mm_shuffle_epi8(wx, spreadLow),  wxHigh = _mm_shuffle_epi8(wx, spreadHigh);
+        const __m128i wyLow  = _mm_shuffle_epi8(wy, spreadLow),  wyHigh = _mm_shuffle_epi8(wy, spreadHigh);
+
+        const __m128i upperLow  = blend16(_mm_cvtepu8_epi16(topLeft),    _mm_cvtepu8_epi16(topRight),    wxLow);
+        const __m128i lowerLow  = blend16(_mm_cvtepu8_epi16(bottomLeft), _mm_cvtepu8_epi16(bottomRight), wxLow);
+        const __m128i upperHigh = blend16(_mm_unpackhi_epi8(topLeft, zero),    _mm_unpackhi_epi8(topRight, zero),    wxHigh);
+        const __m128i lowerHigh = blend16(_mm_unpackhi_epi8(bottomLeft, zero), _mm_unpackhi_epi8(bottomRight, zero), wxHigh);
+
+        const __m128i result = _mm_packus_epi16(blend16(upperLow, lowerLow, wyLow), blend16(upperHigh, lowerHigh, wyHigh));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + 4 * i), result);
+    }
+    if (i < count) warpKernelsScalar()->bilinearRow(source, xs + i, ys + i, count - i, destination + 4 * i);
+}
+
+IRL_TARGET_SSE41 static void bicubicRowSSE41(const WarpSource& source, const int32_t* xs, const int32_t* ys, int count, const int16_t (*weights)[4], uint8_t* destination) {
+    // Taps 0 and 1 (2 and 3) of each channel next to each other: [b0 b1 g0 g1 r0 r1 a0 a1 | b2 b3 g2 g3 ...]
+    const __m128i pairs = _mm_setr_epi8(0, 4, 1, 5, 2, 6, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15);
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(1 << (2 * kCubicShift - 1));
+    const int     phaseShift = kWarpShift - 8;
+
+    for (int i = 0; i < count; i++) {
+        const int x0 = xs[i] >> kWarpShift, y0 = ys[i] >> kWarpShift;
+        const int16_t* wx = weights[(xs[i] >> phaseShift) & (kCubicPhases - 1)];
+        const int16_t* wy = weights[(ys[i] >> phaseShift) & (kCubicPhases - 1)];
+        const __m128i first  = _mm_set1_epi32(static_cast<int32_t>(static_cast<uint16_t>(wx[0]) | static_cast<uint32_t>(static_cast<uint16_t>(wx[1])) << 16));
+        const __m128i second = _mm_set1_epi32(static_cast<int32_t>(static_cast<uint16_t>(wx[2]) | static_cast<uint32_t>(static_cast<uint16_t>(wx[3])) << 16));
+
+        __m128i sum = zero;
+        for (int j = 0; j < 4; j++) {
+            uint32_t spare[4];
+            const __m128i taps = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cubicTaps(source, x0, y0 - 1 + j, spare))), pairs);
+            const __m128i row  = _mm_add_epi32(_mm_madd_epi16(_mm_cvtepu8_epi16(taps), first), _mm_madd_epi16(_mm_unpackhi_epi8(taps, zero), second));
+            sum = _mm_add_epi32(sum, _mm_mullo_epi32(row, _mm_set1_epi32(wy[j])));
+        }
+        const __m128i pixel = _mm_srai_epi32(_mm_add_epi32(sum, round), 2 * kCubicShift);
+        const __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(pixel, pixel), zero);
+        const int32_t value = _mm_cvtsi128_si32(bytes);
+        std::memcpy(destination + 4 * i, &value, 4);
+    }
+}
+
+IRL_TARGET_SSE41 static inline __m128i weightPair(int16_t first, int16_t second) {
+    return _mm_set1_epi32(static_cast<int32_t>(static_cast<uint16_t>(first) | static_cast<uint32_t>(static_cast<uint16_t>(second)) << 16));
+}
+
+/** Weighted sums of the `count` taps from `taps`, one channel per 32 bit lane */
+IRL_TARGET_SSE41 static inline __m128i areaTapRow(const uint8_t* taps, const int16_t* weights, int count) {
+    const __m128i pairs = _mm_setr_epi8(0, 4, 1, 5, 2, 6, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15);
+    __m128i sum = _mm_setzero_si128();
+    int k = 0;
+    for (; k + 4 <= count; k += 4) {
+        const __m128i bytes = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(taps + 4 * k)), pairs);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_cvtepu8_epi16(bytes), weightPair(weights[k], weights[k + 1])));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(bytes, 8)), weightPair(weights[k + 2], weights[k + 3])));
+    }
+    // Loads never go past the last tap: the source may end there
+    if (k + 2 <= count) {
+        const __m128i bytes = _mm_shuffle_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(taps + 4 * k)), pairs);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_cvtepu8_epi16(bytes), weightPair(weights[k], weights[k + 1])));
+        k += 2;
+    }
+    if (k < count) {
+        const __m128i bytes = _mm_shuffle_epi8(_mm_cvtsi32_si128(load32(taps + 4 * k)), pairs);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_cvtepu8_epi16(bytes), weightPair(weights[k], 0)));
+    }
+    return sum;
+}
+
+IRL_TARGET_SSE41 static void areaRowSSE41(const WarpSource& source, const int32_t* xs, const int32_t* ys, const int32_t* fxs, const int32_t* fys, int count, uint8_t* destination) {
+    const __m128i pairs = _mm_setr_epi8(0, 4, 1, 5, 2, 6, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15);
+    const __m128i zero  = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi32(1 << (kAreaShift - 1));
+    int16_t wx[kAreaTaps], wy[kAreaTaps];
+
+    for (int i = 0; i < count; i++) {
+        int x0, y0;
+        const int columns = areaTaps(xs[i], fxs[i], source.width,  x0, wx);
+        const int rows    = areaTaps(ys[i], fys[i], source.height, y0, wy);
+
+        __m128i sum = zero;
+        if (columns <= 4) {
+            // 4 taps per row, the ones past the footprint weighted zero
+            const __m128i first  = weightPair(wx[0], wx[1]);
+            const __m128i second = weightPair(wx[2], wx[3]);
+            for (int j = 0; j < rows; j++) {
+                uint32_t spare[4];
+                const __m128i taps = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(cubicTaps(source, x0 + 1, y0 + j, spare))), pairs);
+                const __m128i row  = _mm_add_epi32(_mm_madd_epi16(_mm_cvtepu8_epi16(taps), first), _mm_madd_epi16(_mm_unpackhi_epi8(taps, zero), second));
+                sum = _mm_add_epi32(sum, _mm_mullo_epi32(_mm_srai_epi32(_mm_add_epi32(row, round), kAreaShift), _mm_set1_epi32(wy[j])));
+            }
+        } else {
+            for (int j = 0; j < rows; j++) {
+                const uint8_t* taps = source.data + static_cast<size_t>(y0 + j) * source.stride + 4 * static_cast<size_t>(x0);
+                const __m128i  row  = _mm_srai_epi32(_mm_add_epi32(areaTapRow(taps, wx, columns), round), kAreaShift);
+                sum = _mm_add_epi32(sum, _mm_mullo_epi32(row, _mm_set1_epi32(wy[j])));
+            }
+        }
+        const __m128i pixel = _mm_srai_epi32(_mm_add_epi32(sum, round), kAreaShift);
+        const __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(pixel, pixel), zero);
+        const int32_t value = _mm_cvtsi128_si32(bytes);
+        std::memcpy(destination + 4 * i, &value, 4);
+    }
+}
+
+const WarpKernels* warpKernelsSSE41() {
+    static const WarpKernels kernels = { bilinearRowSSE41, bicubicRowSSE41, areaRowSSE41 };
+    return &kernels;
+}
+
+#else
+
+const WarpKernels* warpKernelsSSE41() { return nullptr; }
+
+#endif
+
+} // namespace detail
+} // namespace irl
@@ -0,0 +1,152 @@
+//
+//  IRLPointFilter.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLPointFilter.hpp"
+
+#include <cassert>
+#include <cmath>
+
+namespace irl {
+namespace detail {
+
+// MARK: - Scalar kernels
+
+static void colorRowScalar(const uint8_t* source, uint8_t* destination, int width, const PointConstants& constants) {
+    for (int x = 0; x < width; x++) pointPixel(source + 4 * x, destination + 4 * x, constants);
+}
+
+static void grayRowScalar(const uint8_t* source, uint8_t* destination, int width, const PointConstants& constants) {
+    for (int x = 0; x < width; x++) destination[x] = pointGray(source[x], constants);
+}
+
+static void lumaRowScalar(const uint8_t* source, uint8_t* destination, int width, const PointConstants& constants) {
+    for (int x = 0; x < width; x++) destination[x] = pointLumaGray(source + 4 * x, constants);
+}
+
+const PointFilterKernels* pointFilterKernelsScalar() {
+    static const PointFilterKernels kernels = { colorRowScalar, grayRowScalar, lumaRowScalar };
+    return &kernels;
+}
+
+const PointFilterKernels* pointFilterKernels(SimdLevel level) {
+    if (!isSimdLevelSupported(level)) return nullptr;
+    switch (level) {
+        case SimdLevel::Scalar: return pointFilterKernelsScalar();
+        case SimdLevel::SSE41:  return pointFilterKernelsSSE41();
+        case SimdLevel::AVX2:   return pointFilterKernelsAVX2();
+        case SimdLevel::NEON:   return pointFilterKernelsNEON();
+    }
+    return nullptr;
+}
+
+// MARK: - Constants
+
+PointConstants pointConstants(const PointFilterOptions& options) {
+    PointConstants constants = {};
+    const double saturation = std::min(std::max(static_cast<double>(options.saturation), 0.0), 1.0);
+    constants.saturation = static_cast<uint16_t>(std::min(std::lround(saturation * 65536.0), 0xFFFFL));
+    constants.complement = static_cast<uint16_t>(std::min(65536 - constants.saturation, 0xFFFF));
+
+    // The offset is computed with the contrast actually applied, so both errors do not add up
+    const long   contrast  = std::min(std::max(std::lround(options.contrast * 16384.0), 0L), 0xFFFFL);
+    const double slope     = contrast / 16384.0;
+    const double offset    = (255.0 * (options.brightness - 0.5) * slope + 127.5) * (1 << kPointShift) + (1 << (kPointShift - 1));
+    const long   rounded   = std::min(std::max(std::lround(offset), -0xFFFFL), 0xFFFFL);
+    constants.contrast  = static_cast<uint16_t>(contrast);
+    constants.negative  = rounded < 0;
+    constants.offset    = static_cast<uint16_t>(rounded < 0 ? -rounded : rounded);
+
+    constants.curve       = options.curve ? options.curve->values : nullptr;
+    constants.thresholded = options.threshold >= 0;
+    constants.threshold   = static_cast<uint8_t>(std::min(std::max(options.threshold, 0), 255));
+    return constants;
+}
+
+// MARK: - Float chain
+
+void pointFilterRowFloat(const uint8_t* source, uint8_t* destination, int width, int channels, const PointFilterOptions& options) {
+    const float saturation = std::min(std::max(options.saturation, 0.0f), 1.0f);
+    const float contrast   = std::min(std::max(options.contrast, 0.0f), 4.0f);
+    const float offset     = 255.0f * (options.brightness - 0.5f) * contrast + 127.5f;
+    const int   threshold  = options.threshold;
+
+    auto affine = [&](float value) {
+        uint8_t out = static_cast<uint8_t>(std::min(std::max(value * contrast + offset, 0.0f), 255.0f) + 0.5f);
+        if (options.curve) out = (*options.curve)[out];
+        if (threshold < 0) return out;
+        return static_cast<uint8_t>(out >= threshold ? 255 : 0);
+    };
+
+    if (channels == 1) {
+        for (int x = 0; x < width; x++) destination[x] = affine(source[x]);
+        return;
+    }
+    for (int x = 0; x < width; x++) {
+        const uint8_t* p = source + 4 * x;
+        const float b = p[0], g = p[1], r = p[2];
+        const float luma = (1.0f - saturation) * (0.0721f * b + 0.7154f * g + 0.2125f * r);
+        uint8_t* q = destination + 4 * x;
+        q[0] = affine(saturation * b + luma);
+        q[1] = affine(saturation * g + luma);
+        q[2] = affine(saturation * r + luma);
+        q[3] = p[3];
+    }
+}
+
+void pointFilterLumaRowFloat(const uint8_t* source, uint8_t* destination, int width, const PointFilterOptions& options) {
+    const float contrast  = std::min(std::max(options.contrast, 0.0f), 4.0f);
+    const float offset    = 255.0f * (options.brightness - 0.5f) * contrast + 127.5f;
+    const int   threshold = options.threshold;
+
+    for (int x = 0; x < width; x++) {
+        const uint8_t* p = source + 4 * x;
+        const float luma = 0.0721f * p[0] + 0.7154f * p[1] + 0.2125f * p[2];
+        uint8_t out = static_cast<uint8_t>(std::min(std::max(luma * contrast + offset, 0.0f), 255.0f) + 0.5f);
+        if (options.curve) out = (*options.curve)[out];
+        destination[x] = threshold < 0 ? out : static_cast<uint8_t>(out >= threshold ? 255 : 0);
+    }
+}
+
+} // namespace detail
+
+// MARK: - PointFilter
+
+PointFilter::PointFilter(const PointFilterOptions& options, SimdLevel level)
+: _level(level)
+, _kernels(detail::pointFilterKernels(level)) {
+    if (!_kernels) {
+        _level   = SimdLevel::Scalar;
+        _kernels = detail::pointFilterKernelsScalar();
+    }
+    setOptions(options);
+}
+
+void PointFilter::setOptions(const PointFilterOptions& options) {
+    _options   = options;
+    _constants = detail::pointConstants(options);
+}
+
+void PointFilter::apply(const ImageView& source, uint8_t* destination, size_t stride) const {
+    assert(source.format == PixelFormat::BGRA8 || source.format == PixelFormat::Gray8);
+    if (source.isEmpty()) return;
+
+    const bool color = source.format == PixelFormat::BGRA8;
+    for (int y = 0; y < source.height; y++) {
+        uint8_t* dst = destination + static_cast<size_t>(y) * stride;
+        if (color)  _kernels->colorRow(source.row(y), dst, source.width, _constants);
+        else        _kernels->grayRow(source.row(y), dst, source.width, _constants);
+    }
+}
+
+void PointFilter::applyLuma(const ImageView& source, uint8_t* destination, size_t stride) const {
+    assert(source.format == PixelFormat::BGRA8);
+    if (source.isEmpty()) return;
+
+    for (int y = 0; y < source.height; y++) _kernels->lumaRow(source.row(y), destination + static_cast<size_t>(y) * stride, source.width, _constants);
+}
+
+} // namespace irl
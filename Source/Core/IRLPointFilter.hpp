@@ -0,0 +1,85 @@
+//
+//  IRLPointFilter.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Desaturation, brightness, contrast, a tone curve and threshold on encoded 8 bit values, in
+//  fixed point, in one pass. The Ultra Contrast and luma pages of `PageRenderer` go through it.
+//
+//  The float way (what the CoreImage CPU path does) widens every byte to 32 bits: 4 values
+//  per 128 bit register. Here the values stay in Q8.8 on 16 bit lanes, products keep their
+//  high half and clamping comes from saturating adds and narrowing: 8 values per register,
+//  and every output byte within 1 of the formula evaluated in double precision. The curve is
+//  looked up with byte shuffles, like `ToneMapper`, before the bytes are stored.
+//
+
+#ifndef IRL_POINT_FILTER_HPP
+#define IRL_POINT_FILTER_HPP
+
+#include "IRLImage.hpp"
+#include "IRLPointFilterKernels.hpp"
+#include "IRLSimd.hpp"
+#include "IRLToneCurve.hpp"
+
+namespace irl {
+
+/**
+ @brief Parameters of `PointFilter`. The chain is `curve[(mix(channel, luma, saturation) / 255 + brightness - 0.5) * contrast + 0.5]`,
+ then the threshold.
+ */
+struct PointFilterOptions {
+    /** 0 gives the Rec. 709 luma of the encoded values, 1 keeps the colors. Clamped to [0, 1]. */
+    float   saturation  = 1.0f;
+
+    /** Added to every channel, 1 is white. */
+    float   brightness  = 0.0f;
+
+    /** Slope around mid gray. Clamped to [0, 4). */
+    float   contrast    = 1.0f;
+
+    /** Looked up on the bytes after the contrast, e.g. `&kUltraContrastCurve`. nullptr for none. Must outlive the filter. */
+    const ToneCurve* curve = nullptr;
+
+    /** 0 ... 255: channels at or above it after the chain become 255, the others 0. -1 for no threshold. */
+    int     threshold   = -1;
+};
+
+/**
+ @brief Point operations on BGRA8 and Gray8 images, in fixed point.
+ @discussion Every kernel variant gives the same bytes as the scalar reference. Stateless apart from the constants,
+ an instance can be shared between queues once configured.
+ */
+class PointFilter {
+public:
+    /** @param level Kernel variant. An unsupported level falls back to the scalar reference. */
+    explicit PointFilter(const PointFilterOptions& options = PointFilterOptions(), SimdLevel level = bestSimdLevel());
+
+    const PointFilterOptions&   options() const { return _options; }
+    void                        setOptions(const PointFilterOptions& options);
+
+    /** @return The kernel variant actually used */
+    SimdLevel simdLevel() const { return _level; }
+
+    /**
+     @brief Filter `source` into `destination`, same format and size.
+     @param destination At least `source.height` rows of `stride` bytes. May be `source.data` itself.
+     */
+    void apply(const ImageView& source, uint8_t* destination, size_t stride) const;
+
+    /**
+     @brief The luma of BGRA8 `source` through the chain, into Gray8 rows: one value per pixel, the saturation has no effect.
+     @param destination At least `source.height` rows of `stride` bytes, `source.width` of them written.
+     */
+    void applyLuma(const ImageView& source, uint8_t* destination, size_t stride) const;
+
+private:
+    PointFilterOptions                  _options;
+    SimdLevel                           _level;
+    const detail::PointFilterKernels*   _kernels;
+    detail::PointConstants              _constants;
+};
+
+} // namespace irl
+
+#endif /* IRL_POINT_FILTER_HPP */
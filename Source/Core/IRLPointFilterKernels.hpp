@@ -0,0 +1,135 @@
+//
+//  IRLPointFilterKernels.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Row kernels behind `PointFilter`, one table per instruction set, and the float chain they
+//  replace. Not part of the public API: exposed for the accuracy tests and the benchmarks only.
+//
+
+#ifndef IRL_POINT_FILTER_KERNELS_HPP
+#define IRL_POINT_FILTER_KERNELS_HPP
+
+#include "IRLSimd.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace irl {
+
+struct PointFilterOptions;
+
+namespace detail {
+
+/** Rec. 709 luma weights in Q15 (0.0721, 0.7154, 0.2125), summing to 1 */
+static const int kPointLumaB = 2363;
+static const int kPointLumaG = 23442;
+static const int kPointLumaR = 6963;
+
+/** The affine part ends in Q6: 8 bits of value, 6 of fraction, 2 of headroom for contrasts up to 4 */
+static const int kPointShift = 6;
+
+/**
+ @brief Fixed point constants of one `PointFilterOptions`, shared by every kernel variant.
+ @discussion Channels are mixed in Q8.8, 16 bit lanes: `((channel << 8) * saturation + luma * complement) >> 16`.
+ The product by the contrast keeps the high half, in Q6, the offset is added with unsigned saturation, which clamps
+ the low end, and the narrowing to bytes clamps the high end.
+ */
+struct PointConstants {
+    /** Weight of the channel, Q16, at most 65535 */
+    uint16_t    saturation;
+
+    /** Weight of the luma, Q16, at most 65535 */
+    uint16_t    complement;
+
+    /** Q14, at most 65535 */
+    uint16_t    contrast;
+
+    /** |offset| in Q6 with the rounding of the final shift, added or subtracted depending on `negative` */
+    uint16_t    offset;
+    bool        negative;
+
+    /** 256 bytes looked up after the contrast, nullptr for none */
+    const uint8_t* curve;
+
+    /** Bytes at or above it become 255, the others 0. Ignored when `thresholded` is false. */
+    uint8_t     threshold;
+    bool        thresholded;
+};
+
+/** @return The constants of `options` */
+PointConstants pointConstants(const PointFilterOptions& options);
+
+/** @brief Row kernels of one instruction set. `source` and `destination` may be the same row. */
+struct PointFilterKernels {
+    /** `width` BGRA pixels, alpha is kept */
+    void (*colorRow)(const uint8_t* source, uint8_t* destination, int width, const PointConstants& constants);
+
+    /** `width` Gray8 pixels, the saturation has no effect */
+    void (*grayRow)(const uint8_t* source, uint8_t* destination, int width, const PointConstants& constants);
+
+    /** `width` BGRA pixels into their `width` Gray8 lumas, the saturation has no effect */
+    void (*lumaRow)(const uint8_t* source, uint8_t* destination, int width, const PointConstants& constants);
+};
+
+/** @return The kernels of `level`, nullptr when the level is not compiled in or not supported by the CPU */
+const PointFilterKernels* pointFilterKernels(SimdLevel level);
+
+const PointFilterKernels* pointFilterKernelsScalar();
+const PointFilterKernels* pointFilterKernelsSSE41();
+const PointFilterKernels* pointFilterKernelsAVX2();
+const PointFilterKernels* pointFilterKernelsNEON();
+
+/**
+ @brief The same chain on 32 bit floats, one pixel at a time: the cost of doing it the way the CoreImage CPU path does.
+ @param channels 4 for BGRA (alpha kept), 1 for Gray8.
+ */
+void pointFilterRowFloat(const uint8_t* source, uint8_t* destination, int width, int channels, const PointFilterOptions& options);
+
+/** @brief `lumaRow` on 32 bit floats: `width` BGRA pixels into Gray8 */
+void pointFilterLumaRowFloat(const uint8_t* source, uint8_t* destination, int width, const PointFilterOptions& options);
+
+// MARK: - Scalar reference, also used by the vector variants on row ends
+
+/** Luma of a BGRA pixel in Q8.8 */
+inline uint16_t pointLuma(const uint8_t* p) {
+    return static_cast<uint16_t>((kPointLumaB * p[0] + kPointLumaG * p[1] + kPointLumaR * p[2] + 64) >> 7);
+}
+
+/** Contrast, brightness, clamping, curve and threshold of a Q8.8 value */
+inline uint8_t pointAffine(uint16_t value, const PointConstants& constants) {
+    const int product = static_cast<int>((static_cast<uint32_t>(value) * constants.contrast) >> 16);
+    const int sum     = constants.negative ? std::max(product - constants.offset, 0) : std::min(product + constants.offset, 0xFFFF);
+    uint8_t out = static_cast<uint8_t>(std::min(sum >> kPointShift, 255));
+    if (constants.curve) out = constants.curve[out];
+    if (!constants.thresholded) return out;
+    return out >= constants.threshold ? 255 : 0;
+}
+
+inline uint8_t pointChannel(uint8_t channel, uint16_t luma, const PointConstants& constants) {
+    const uint16_t mixed = static_cast<uint16_t>(((static_cast<uint32_t>(channel << 8) * constants.saturation) >> 16) +
+                                                 ((static_cast<uint32_t>(luma) * constants.complement) >> 16));
+    return pointAffine(mixed, constants);
+}
+
+inline void pointPixel(const uint8_t* source, uint8_t* destination, const PointConstants& constants) {
+    const uint16_t luma = pointLuma(source);
+    const uint8_t  b = pointChannel(source[0], luma, constants);
+    const uint8_t  g = pointChannel(source[1], luma, constants);
+    const uint8_t  r = pointChannel(source[2], luma, constants);
+    destination[0] = b; destination[1] = g; destination[2] = r; destination[3] = source[3];
+}
+
+inline uint8_t pointGray(uint8_t value, const PointConstants& constants) {
+    return pointAffine(static_cast<uint16_t>(value << 8), constants);
+}
+
+inline uint8_t pointLumaGray(const uint8_t* source, const PointConstants& constants) {
+    return pointAffine(pointLuma(source), constants);
+}
+
+} // namespace detail
+} // namespace irl
+
+#endif /* IRL_POINT_FILTER_KERNELS_HPP */
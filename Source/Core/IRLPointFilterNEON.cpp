@@ -0,0 +1,128 @@
+//
+//  IRLPointFilterNEON.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  NEON point filter, 16 pixels per iteration. Structured loads split the channels, so the
+//  luma is computed once per pixel without any shuffle. The curve is looked up 64 entries at a
+//  time, as in IRLToneCurveNEON.cpp.
+//
+
+#include "IRLPointFilterKernels.hpp"
+
+#if IRL_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace irl {
+namespace detail {
+
+#if IRL_SIMD_NEON
+
+static inline uint16x8_t mulhi(uint16x8_t a, uint16x8_t b) {
+    return vcombine_u16(vshrn_n_u32(vmull_u16(vget_low_u16(a), vget_low_u16(b)), 16),
+                        vshrn_n_u32(vmull_u16(vget_high_u16(a), vget_high_u16(b)), 16));
+}
+
+/** Contrast, offset and the narrowing to bytes, which clamps the high end */
+static inline uint8x8_t affine(uint16x8_t mixed, const PointConstants& constants) {
+    const uint16x8_t product = mulhi(mixed, vdupq_n_u16(constants.contrast));
+    const uint16x8_t offset  = vdupq_n_u16(constants.offset);
+    const uint16x8_t sum     = constants.negative ? vqsubq_u16(product, offset) : vqaddq_u16(product, offset);
+    return vqshrn_n_u16(sum, kPointShift);
+}
+
+/** curve[bytes]: tbl writes 0 for indices past 63, tbx keeps the previous value, each quarter fills its own bytes */
+static inline uint8x16_t lookup(uint8x16_t bytes, const uint8_t* curve) {
+    const uint8x16_t quarter = vdupq_n_u8(64);
+    uint8x16_t result = vqtbl4q_u8(vld1q_u8_x4(curve), bytes);
+    for (int offset = 64; offset < 256; offset += 64) {
+        bytes  = vsubq_u8(bytes, quarter);
+        result = vqtbx4q_u8(result, vld1q_u8_x4(curve + offset), bytes);
+    }
+    return result;
+}
+
+static inline uint8x16_t threshold(uint8x16_t bytes, const PointConstants& constants) {
+    if (!constants.thresholded) return bytes;
+    return vcgeq_u8(bytes, vdupq_n_u8(constants.threshold));
+}
+
+/** The curve, if any, then the threshold */
+static inline uint8x16_t finish(uint8x16_t bytes, const PointConstants& constants) {
+    if (constants.curve) bytes = lookup(bytes, constants.curve);
+    return threshold(bytes, constants);
+}
+
+static inline uint32x4_t lumaSum(uint16x4_t b, uint16x4_t g, uint16x4_t r) {
+    return vmlal_n_u16(vmlal_n_u16(vmull_n_u16(b, kPointLumaB), g, kPointLumaG), r, kPointLumaR);
+}
+
+/** Luma of 8 pixels in Q8.8, rounded like the scalar reference */
+static inline uint16x8_t luma(uint16x8_t b, uint16x8_t g, uint16x8_t r) {
+    return vcombine_u16(vrshrn_n_u32(lumaSum(vget_low_u16(b), vget_low_u16(g), vget_low_u16(r)), 7),
+                        vrshrn_n_u32(lumaSum(vget_high_u16(b), vget_high_u16(g), vget_high_u16(r)), 7));
+}
+
+static inline uint8x8_t channel(uint16x8_t value, uint16x8_t weightedLuma, const PointConstants& constants) {
+    return affine(vaddq_u16(mulhi(vshlq_n_u16(value, 8), vdupq_n_u16(constants.saturation)), weightedLuma), constants);
+}
+
+static void colorRowNEON(const uint8_t* source, uint8_t* destination, int width, const PointConstants& constants) {
+    const uint16x8_t complement = vdupq_n_u16(constants.complement);
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        uint8x16x4_t pixels = vld4q_u8(source + 4 * x);
+        const uint16x8_t b0 = vmovl_u8(vget_low_u8(pixels.val[0])), b1 = vmovl_u8(vget_high_u8(pixels.val[0]));
+        const uint16x8_t g0 = vmovl_u8(vget_low_u8(pixels.val[1])), g1 = vmovl_u8(vget_high_u8(pixels.val[1]));
+        const uint16x8_t r0 = vmovl_u8(vget_low_u8(pixels.val[2])), r1 = vmovl_u8(vget_high_u8(pixels.val[2]));
+        const uint16x8_t l0 = mulhi(luma(b0, g0, r0), complement);
+        const uint16x8_t l1 = mulhi(luma(b1, g1, r1), complement);
+
+        pixels.val[0] = finish(vcombine_u8(channel(b0, l0, constants), channel(b1, l1, constants)), constants);
+        pixels.val[1] = finish(vcombine_u8(channel(g0, l0, constants), channel(g1, l1, constants)), constants);
+        pixels.val[2] = finish(vcombine_u8(channel(r0, l0, constants), channel(r1, l1, constants)), constants);
+        vst4q_u8(destination + 4 * x, pixels);
+    }
+    for (; x < width; x++) pointPixel(source + 4 * x, destination + 4 * x, constants);
+}
+
+static void grayRowNEON(const uint8_t* source, uint8_t* destination, int width, const PointConstants& constants) {
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const uint8x16_t values = vld1q_u8(source + x);
+        const uint8x8_t  low    = affine(vshll_n_u8(vget_low_u8(values), 8), constants);
+        const uint8x8_t  high   = affine(vshll_n_u8(vget_high_u8(values), 8), constants);
+        vst1q_u8(destination + x, finish(vcombine_u8(low, high), constants));
+    }
+    for (; x < width; x++) destination[x] = pointGray(source[x], constants);
+}
+
+static void lumaRowNEON(const uint8_t* source, uint8_t* destination, int width, const PointConstants& constants) {
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const uint8x16x4_t pixels = vld4q_u8(source + 4 * x);
+        const uint8x8_t low  = affine(luma(vmovl_u8(vget_low_u8(pixels.val[0])),  vmovl_u8(vget_low_u8(pixels.val[1])),
+                                           vmovl_u8(vget_low_u8(pixels.val[2]))),  constants);
+        const uint8x8_t high = affine(luma(vmovl_u8(vget_high_u8(pixels.val[0])), vmovl_u8(vget_high_u8(pixels.val[1])),
+                                           vmovl_u8(vget_high_u8(pixels.val[2]))), constants);
+        vst1q_u8(destination + x, finish(vcombine_u8(low, high), constants));
+    }
+    for (; x < width; x++) destination[x] = pointLumaGray(source + 4 * x, constants);
+}
+
+const PointFilterKernels* pointFilterKernelsNEON() {
+    static const PointFilterKernels kernels = { colorRowNEON, grayRowNEON, lumaRowNEON };
+    return &kernels;
+}
+
+#else
+
+const PointFilterKernels* pointFilterKernelsNEON() { return nullptr; }
+
+#endif
+
+} // namespace detail
+} // namespace irl
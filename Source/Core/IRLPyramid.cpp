@@ -0,0 +1,94 @@
+//
+//  IRLPyramid.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLPyramid.hpp"
+
+#include <algorithm>
+
+namespace irl {
+
+void downsampleLuma2x(const ImageView& source, Plane8& destination) {
+    const int width  = source.width / 2;
+    const int height = source.height / 2;
+    destination.resize(width, height);
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t*  top     = source.row(2 * y);
+        const uint8_t*  bottom  = source.row(2 * y + 1);
+        uint8_t*        dst     = destination.row(y);
+
+        if (source.format == PixelFormat::Gray8) {
+            for (int x = 0; x < width; x++) {
+                dst[x] = static_cast<uint8_t>((top[2 * x] + top[2 * x + 1] + bottom[2 * x] + bottom[2 * x + 1] + 2) >> 2);
+            }
+        } else {
+            // Sum the four pixels per channel, then apply the Q8 luma weights once: 4 * 256 = 1024
+            for (int x = 0; x < width; x++, top += 8, bottom += 8) {
+                int b = top[0] + top[4] + bottom[0] + bottom[4];
+                int g = top[1] + top[5] + bottom[1] + bottom[5];
+                int r = top[2] + top[6] + bottom[2] + bottom[6];
+                dst[x] = static_cast<uint8_t>((29 * b + 150 * g + 77 * r + 512) >> 10);
+            }
+        }
+    }
+}
+
+void extractLuma(const ImageView& source, int x, int y, int width, int height, Plane8& window) {
+    window.resize(width, height);
+    for (int j = 0; j < height; j++) {
+        const uint8_t*  src = source.row(std::min(std::max(y + j, 0), source.height - 1));
+        uint8_t*        dst = window.row(j);
+        for (int i = 0; i < width; i++) {
+            const int sx = std::min(std::max(x + i, 0), source.width - 1);
+            if (source.format == PixelFormat::Gray8) {
+                dst[i] = src[sx];
+            } else {
+                const uint8_t* p = src + 4 * sx;
+                dst[i] = static_cast<uint8_t>((29 * p[0] + 150 * p[1] + 77 * p[2] + 128) >> 8);
+            }
+        }
+    }
+}
+
+void extractLumaDownsampled(const ImageView& source, int level, int x, int y, int width, int height, Plane8& window) {
+    if (level <= 0) { extractLuma(source, x, y, width, height, window); return; }
+
+    const int size  = 1 << level;
+    const int shift = 2 * level;
+    window.resize(width, height);
+    for (int j = 0; j < height; j++) {
+        uint8_t* dst = window.row(j);
+        for (int i = 0; i < width; i++) {
+            int sum = 0;
+            for (int v = 0; v < size; v++) {
+                const uint8_t* src = source.row(std::min(std::max((y + j) * size + v, 0), source.height - 1));
+                for (int u = 0; u < size; u++) {
+                    const int sx = std::min(std::max((x + i) * size + u, 0), source.width - 1);
+                    if (source.format == PixelFormat::Gray8) {
+                        sum += src[sx];
+                    } else {
+                        const uint8_t* p = src + 4 * sx;
+                        sum += (29 * p[0] + 150 * p[1] + 77 * p[2] + 128) >> 8;
+                    }
+                }
+            }
+            dst[i] = static_cast<uint8_t>((sum + (1 << (shift - 1))) >> shift);
+        }
+    }
+}
+
+void LumaPyramid::build(const ImageView& source, int levels) {
+    _source = source;
+    _count  = std::max(levels, 0);
+    if (_levels.size() < static_cast<size_t>(_count)) _levels.resize(static_cast<size_t>(_count));
+
+    for (int i = 1; i <= _count; i++) {
+        downsampleLuma2x(level(i - 1), _levels[static_cast<size_t>(i - 1)]);
+    }
+}
+
+} // namespace irl
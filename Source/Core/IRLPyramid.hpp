@@ -0,0 +1,66 @@
+//
+//  IRLPyramid.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Luma pyramid used by the multi-scale detector. Level n is the source luma downsampled
+//  by 2^n with a 2x2 box filter. Level 0 is never materialised: the source buffer is read
+//  directly, and only in small windows.
+//
+
+#ifndef IRL_PYRAMID_HPP
+#define IRL_PYRAMID_HPP
+
+#include "IRLImage.hpp"
+
+#include <vector>
+
+namespace irl {
+
+/**
+ @brief Half resolution luma of `source` (2x2 box average).
+ @discussion BGRA sources are converted and downsampled in the same pass, with the BT.601 weights of `convertToLuma`.
+ An odd last row or column is dropped.
+ */
+void downsampleLuma2x(const ImageView& source, Plane8& destination);
+
+/**
+ @brief Copy the luma of a window of `source` into `window`.
+ @discussion The window may overlap the image borders, outside pixels replicate the closest border pixel.
+ */
+void extractLuma(const ImageView& source, int x, int y, int width, int height, Plane8& window);
+
+/**
+ @brief Copy a window of pyramid level `level` of `source`, without building the level.
+ @discussion `x`, `y`, `width` and `height` are in level pixels. Each window pixel is the box average of the
+ 2^level x 2^level source pixels it covers, borders replicate the closest source pixel.
+ */
+void extractLumaDownsampled(const ImageView& source, int level, int x, int y, int width, int height, Plane8& window);
+
+/** @brief Successive 2x downsamplings of a frame luma */
+class LumaPyramid {
+public:
+    /**
+     @brief Build `levels` levels on top of `source`.
+     @discussion `source` must stay valid while the pyramid is used. Buffers are reused between calls.
+     */
+    void build(const ImageView& source, int levels);
+
+    /** @return Number of levels built on top of the source */
+    int levels() const { return _count; }
+
+    /** @return Level `index`. Level 0 is the source itself (possibly BGRA), the others are Gray8. */
+    ImageView level(int index) const {
+        return index == 0 ? _source : _levels[static_cast<size_t>(index - 1)].view();
+    }
+
+private:
+    ImageView           _source;
+    std::vector<Plane8> _levels;
+    int                 _count = 0;
+};
+
+} // namespace irl
+
+#endif /* IRL_PYRAMID_HPP */
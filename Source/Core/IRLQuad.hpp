@@ -0,0 +1,122 @@
+//
+//  IRLQuad.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Value types describing a detected document. Coordinates are continuous pixel
+//  coordinates in buffer space: origin at the top left corner of the first pixel,
+//  y pointing down, pixel (i, j) covering [i, i+1) x [j, j+1).
+//  The Objective-C bridge flips y to CoreImage space (origin bottom left).
+//
+
+#ifndef IRL_QUAD_HPP
+#define IRL_QUAD_HPP
+
+#include <cmath>
+
+namespace irl {
+
+/** @brief A 2D point, in pixels */
+struct Point {
+    float x = 0.0f;
+    float y = 0.0f;
+
+    Point() = default;
+    Point(float x, float y) : x(x), y(y) {}
+};
+
+inline Point operator+(Point a, Point b)    { return Point(a.x + b.x, a.y + b.y); }
+inline Point operator-(Point a, Point b)    { return Point(a.x - b.x, a.y - b.y); }
+inline Point operator*(Point a, float s)    { return Point(a.x * s, a.y * s); }
+
+/** @return z component of the cross product of `a` and `b` */
+inline float cross(Point a, Point b)        { return a.x * b.y - a.y * b.x; }
+
+/** @return Dot product of `a` and `b` */
+inline float dot(Point a, Point b)          { return a.x * b.x + a.y * b.y; }
+
+/** @return Euclidean distance between `a` and `b` */
+inline float distance(Point a, Point b)     { return std::hypot(a.x - b.x, a.y - b.y); }
+
+/**
+ @brief Four corners of a document, with the same semantic as `IRLRectangleFeatureProtocol`.
+ @discussion Corners are stored clockwise on screen, starting at the top left one.
+ */
+struct Quad {
+    Point topLeft;
+    Point topRight;
+    Point bottomRight;
+    Point bottomLeft;
+
+    /** @return Corner `index` in clockwise order (0: topLeft ... 3: bottomLeft) */
+    Point&          operator[](int index)       { return this->*corner(index); }
+    const Point&    operator[](int index) const { return this->*corner(index); }
+
+    /** @return Signed area, positive when the corners are clockwise on screen */
+    float signedArea() const {
+        const Quad& q = *this;
+        float sum = 0.0f;
+        for (int i = 0; i < 4; i++) sum += cross(q[i], q[(i + 1) & 3]);
+        return 0.5f * sum;
+    }
+
+    /** @return Average of the four corners */
+    Point center() const {
+        return (topLeft + topRight + bottomRight + bottomLeft) * 0.25f;
+    }
+
+private:
+    static Point Quad::* corner(int index) {
+        static Point Quad::* const corners[4] = { &Quad::topLeft, &Quad::topRight, &Quad::bottomRight, &Quad::bottomLeft };
+        return corners[index];
+    }
+};
+
+/**
+ @return Monotonic stand-in for `atan2(d.y, d.x)`, in [-2, 2]: one division, no trigonometry. 0 for a null vector.
+ */
+inline float pseudoAngle(Point d) {
+    const float length = std::fabs(d.x) + std::fabs(d.y);
+    return length > 0.0f ? std::copysign(1.0f - d.x / length, d.y) : 0.0f;
+}
+
+/**
+ @brief Name 4 corners given in any order, the convention of every quad of the pipeline.
+ @discussion The corners are put clockwise on screen around the center of their bounding box, then the one closest to the
+ origin (smallest x + y) becomes the top left one. Sorted by `pseudoAngle` with a 5 comparison network: nothing is
+ allocated, so it can run on every frame.
+ */
+inline Quad canonicalQuad(const Point corners[4]) {
+    const float minX = std::fmin(std::fmin(corners[0].x, corners[1].x), std::fmin(corners[2].x, corners[3].x));
+    const float maxX = std::fmax(std::fmax(corners[0].x, corners[1].x), std::fmax(corners[2].x, corners[3].x));
+    const float minY = std::fmin(std::fmin(corners[0].y, corners[1].y), std::fmin(corners[2].y, corners[3].y));
+    const float maxY = std::fmax(std::fmax(corners[0].y, corners[1].y), std::fmax(corners[2].y, corners[3].y));
+    const Point center(0.5f * (minX + maxX), 0.5f * (minY + maxY));
+
+    // Increasing angles are clockwise on screen, y pointing down
+    float angles[4];
+    int   order[4] = { 0, 1, 2, 3 };
+    for (int k = 0; k < 4; k++) angles[k] = pseudoAngle(corners[k] - center);
+    static const int kNetwork[5][2] = { { 0, 1 }, { 2, 3 }, { 0, 2 }, { 1, 3 }, { 1, 2 } };
+    for (const auto& pair : kNetwork) {
+        const int a = order[pair[0]], b = order[pair[1]];
+        const bool swap = angles[b] < angles[a];
+        order[pair[0]] = swap ? b : a;
+        order[pair[1]] = swap ? a : b;
+    }
+
+    int first = 0;
+    for (int k = 1; k < 4; k++) {
+        const Point& p = corners[order[k]];
+        const Point& f = corners[order[first]];
+        if (p.x + p.y < f.x + f.y) first = k;
+    }
+    Quad quad;
+    for (int k = 0; k < 4; k++) quad[k] = corners[order[(first + k) & 3]];
+    return quad;
+}
+
+} // namespace irl
+
+#endif /* IRL_QUAD_HPP */
@@ -0,0 +1,349 @@
+//
+//  IRLQuadDetector.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLQuadDetector.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace irl {
+
+// MARK: - Helpers
+
+int otsuThreshold(const Plane8& plane) {
+    uint32_t histogram[256] = { 0 };
+    for (int y = 0; y < plane.height(); y++) {
+        const uint8_t* row = plane.row(y);
+        for (int x = 0; x < plane.width(); x++) histogram[row[x]]++;
+    }
+
+    double total = static_cast<double>(plane.width()) * plane.height();
+    double sum   = 0.0;
+    for (int i = 0; i < 256; i++) sum += static_cast<double>(i) * histogram[i];
+
+    double sumBackground    = 0.0;
+    double weightBackground = 0.0;
+    double bestVariance     = -1.0;
+    int    threshold        = 0;
+
+    for (int i = 0; i < 256; i++) {
+        weightBackground += histogram[i];
+        if (weightBackground == 0.0) continue;
+
+        double weightForeground = total - weightBackground;
+        if (weightForeground == 0.0) break;
+
+        sumBackground += static_cast<double>(i) * histogram[i];
+        double meanBackground = sumBackground / weightBackground;
+        double meanForeground = (sum - sumBackground) / weightForeground;
+        double delta          = meanBackground - meanForeground;
+        double variance       = weightBackground * weightForeground * delta * delta;
+
+        if (variance > bestVariance) {
+            bestVariance = variance;
+            threshold    = i;
+        }
+    }
+    return threshold;
+}
+
+static inline float turn(Point o, Point a, Point b) {
+    return cross(a - o, b - o);
+}
+
+void convexHull(const std::vector<Point>& points, std::vector<Point>& hull) {
+    hull.clear();
+    const size_t n = points.size();
+    if (n < 3) { hull = points; return; }
+
+    hull.resize(2 * n);
+    size_t k = 0;
+    for (size_t i = 0; i < n; i++) {
+        while (k >= 2 && turn(hull[k - 2], hull[k - 1], points[i]) <= 0.0f) k--;
+        hull[k++] = points[i];
+    }
+    for (size_t i = n - 1, lower = k + 1; i > 0; i--) {
+        while (k >= lower && turn(hull[k - 2], hull[k - 1], points[i - 1]) <= 0.0f) k--;
+        hull[k++] = points[i - 1];
+    }
+    hull.resize(k - 1);
+
+    // Points are sorted by (y, x): the chain comes out mirrored, make it clockwise on screen
+    float area = 0.0f;
+    for (size_t i = 0; i < hull.size(); i++) area += cross(hull[i], hull[(i + 1) % hull.size()]);
+    if (area < 0.0f) std::reverse(hull.begin(), hull.end());
+}
+
+static inline float triangleArea(Point a, Point b, Point c) {
+    return 0.5f * (cross(a, b) + cross(b, c) + cross(c, a));
+}
+
+bool largestInscribedQuad(const std::vector<Point>& hull, Quad& quad) {
+    const int n = static_cast<int>(hull.size());
+    if (n < 4) return false;
+
+    // Start from the diagonal extremes: top left, top right, bottom right, bottom left
+    int index[4] = { 0, 0, 0, 0 };
+    for (int i = 1; i < n; i++) {
+        const Point& p = hull[i];
+        if (p.x + p.y < hull[index[0]].x + hull[index[0]].y) index[0] = i;
+        if (p.x - p.y > hull[index[1]].x - hull[index[1]].y) index[1] = i;
+        if (p.x + p.y > hull[index[2]].x + hull[index[2]].y) index[2] = i;
+        if (p.x - p.y < hull[index[3]].x - hull[index[3]].y) index[3] = i;
+    }
+
+    auto offset = [&](int i) { return (index[i] - index[0] + n) % n; };
+    if (!(0 < offset(1) && offset(1) < offset(2) && offset(2) < offset(3))) {
+        // Diamond like shapes make extremes collide, spread the corners instead
+        for (int i = 1; i < 4; i++) index[i] = (index[0] + i * n / 4) % n;
+    }
+
+    // Move one corner at a time along the hull while the area grows
+    for (int iteration = 0; iteration < 32; iteration++) {
+        bool improved = false;
+        for (int k = 0; k < 4; k++) {
+            const int previous = index[(k + 3) & 3];
+            const int next     = index[(k + 1) & 3];
+            int   best     = index[k];
+            float bestArea = triangleArea(hull[previous], hull[best], hull[next]);
+            for (int j = (previous + 1) % n; j != next; j = (j + 1) % n) {
+                float area = triangleArea(hull[previous], hull[j], hull[next]);
+                if (area > bestArea) {
+                    bestArea = area;
+                    best     = j;
+                }
+            }
+            if (best != index[k]) {
+                index[k] = best;
+                improved = true;
+            }
+        }
+        if (!improved) break;
+    }
+
+    // Name the corners: top left is the one closest to the origin, the others follow clockwise
+    const Point corners[4] = { hull[index[0]], hull[index[1]], hull[index[2]], hull[index[3]] };
+    quad = canonicalQuad(corners);
+
+    return quad.signedArea() > 0.0f;
+}
+
+// MARK: - QuadDetector
+
+QuadDetector::QuadDetector(const QuadDetectorOptions& options)
+: _options(options) {
+}
+
+void QuadDetector::labelRegions(const Plane8& luma, int threshold) {
+    const int width  = luma.width();
+    const int height = luma.height();
+
+    _labels.assign(static_cast<size_t>(width) * height, 0);
+    _regions.clear();
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row = luma.row(y);
+        for (int x = 0; x < width; x++) {
+            const size_t seed = static_cast<size_t>(y) * width + x;
+            if (row[x] <= threshold || _labels[seed] != 0) continue;
+
+            Region region;
+            region.label = static_cast<int32_t>(_regions.size()) + 1;
+            region.area  = 0;
+            region.minX  = region.maxX = x;
+            region.minY  = region.maxY = y;
+
+            // 4-connected flood fill with an explicit stack
+            _labels[seed] = region.label;
+            _stack.clear();
+            _stack.push_back(static_cast<int32_t>(seed));
+            while (!_stack.empty()) {
+                const int32_t index = _stack.back();
+                _stack.pop_back();
+                const int px = index % width;
+                const int py = index / width;
+
+                region.area++;
+                region.minX = std::min(region.minX, px);
+                region.maxX = std::max(region.maxX, px);
+                region.minY = std::min(region.minY, py);
+                region.maxY = std::max(region.maxY, py);
+
+                auto visit = [&](int nx, int ny) {
+                    const int32_t neighbour = ny * width + nx;
+                    if (_labels[neighbour] == 0 && luma.row(ny)[nx] > threshold) {
+                        _labels[neighbour] = region.label;
+                        _stack.push_back(neighbour);
+                    }
+                };
+                if (px > 0)          visit(px - 1, py);
+                if (px < width - 1)  visit(px + 1, py);
+                if (py > 0)          visit(px, py - 1);
+                if (py < height - 1) visit(px, py + 1);
+            }
+            _regions.push_back(region);
+        }
+    }
+}
+
+bool QuadDetector::fitQuad(const Region& region, DetectedQuad& result) {
+    const int width = _smoothed.width();
+
+    // Left and right boundary of every row. Top and bottom rows also contribute their outer edge.
+    // The spans also give the region area with its holes (text, pictures) filled
+    _outline.clear();
+    int64_t spanArea = 0;
+    for (int y = region.minY; y <= region.maxY; y++) {
+        const int32_t* labels = _labels.data() + static_cast<size_t>(y) * width;
+        int left = region.minX;
+        while (labels[left] != region.label) left++;
+        int right = region.maxX;
+        while (labels[right] != region.label) right--;
+        spanArea += right - left + 1;
+
+        const float fy = static_cast<float>(y);
+        if (y == region.minY) {
+            _outline.emplace_back(static_cast<float>(left), fy);
+            _outline.emplace_back(static_cast<float>(right + 1), fy);
+        }
+        _outline.emplace_back(static_cast<float>(left), fy + 0.5f);
+        _outline.emplace_back(static_cast<float>(right + 1), fy + 0.5f);
+        if (y == region.maxY) {
+            _outline.emplace_back(static_cast<float>(left), fy + 1.0f);
+            _outline.emplace_back(static_cast<float>(right + 1), fy + 1.0f);
+        }
+    }
+
+    convexHull(_outline, _hull);
+
+    Quad quad;
+    if (!largestInscribedQuad(_hull, quad)) return false;
+
+    const float area = quad.signedArea();
+    const float sideWidth  = 0.5f * (distance(quad.topLeft, quad.topRight) + distance(quad.bottomLeft, quad.bottomRight));
+    const float sideHeight = 0.5f * (distance(quad.topLeft, quad.bottomLeft) + distance(quad.topRight, quad.bottomRight));
+    const float minimumSide = _options.minimumFeatureSize * std::min(_smoothed.width(), _smoothed.height());
+    if (std::min(sideWidth, sideHeight) < minimumSide) return false;
+
+    const float fillRatio = static_cast<float>(spanArea) / area;
+    if (fillRatio < _options.minimumFillRatio) return false;
+
+    result.quad      = quad;
+    result.area      = area;
+    result.fillRatio = fillRatio;
+    return true;
+}
+
+std::vector<DetectedQuad> QuadDetector::detectSingleScale(const ImageView& frame) {
+    std::vector<DetectedQuad> results;
+
+    convertToLuma(frame, _luma);
+    smoothBinomial3(_luma, _smoothed);
+
+    _threshold = otsuThreshold(_smoothed);
+    labelRegions(_smoothed, _threshold);
+
+    // Biggest regions first, skipping the ones whose bounding box is already too small
+    const float minimumSide = _options.minimumFeatureSize * std::min(frame.width, frame.height);
+    std::vector<size_t> order(_regions.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        if (_regions[a].area != _regions[b].area) return _regions[a].area > _regions[b].area;
+        return a < b;
+    });
+
+    for (size_t i : order) {
+        if (static_cast<int>(results.size()) >= _options.maximumFeatures) break;
+        const Region& region = _regions[i];
+        if (region.maxX - region.minX + 1 < minimumSide || region.maxY - region.minY + 1 < minimumSide) continue;
+
+        DetectedQuad detected;
+        if (fitQuad(region, detected)) results.push_back(detected);
+    }
+
+    return results;
+}
+
+void QuadDetector::refineCorners(const ImageView& level, Quad& quad) {
+    const int radius = std::max(_options.refinementRadius, 2);
+    const int size   = 2 * radius;
+    Quad refined = quad;
+
+    for (int k = 0; k < 4; k++) {
+        const Point corner = quad[k];
+
+        // Outward bisector: the corner is the foreground pixel going furthest along it
+        Point toPrevious = corner - quad[(k + 3) & 3];
+        Point toNext     = corner - quad[(k + 1) & 3];
+        Point outward    = toPrevious * (1.0f / std::max(distance(toPrevious, Point()), 1e-3f))
+                         + toNext     * (1.0f / std::max(distance(toNext, Point()), 1e-3f));
+        float length = distance(outward, Point());
+        if (length < 1e-3f) continue;
+        outward = outward * (1.0f / length);
+
+        const int x0 = static_cast<int>(std::floor(corner.x)) - radius;
+        const int y0 = static_cast<int>(std::floor(corner.y)) - radius;
+        extractLuma(level, x0, y0, size, size, _window);
+        smoothBinomial3(_window, _smoothedWindow);
+
+        // Local threshold when the window sees both the page and the background, handles uneven lighting
+        int darkest = 255, brightest = 0;
+        for (int j = 0; j < size; j++) {
+            const uint8_t* row = _smoothedWindow.row(j);
+            for (int i = 0; i < size; i++) {
+                darkest   = std::min(darkest, static_cast<int>(row[i]));
+                brightest = std::max(brightest, static_cast<int>(row[i]));
+            }
+        }
+        const int threshold = brightest - darkest >= 24 ? (darkest + brightest + 1) / 2 : _threshold;
+
+        float best = -1e30f;
+        int   bestX = -1, bestY = -1;
+        for (int j = 0; j < size; j++) {
+            const uint8_t* row = _smoothedWindow.row(j);
+            for (int i = 0; i < size; i++) {
+                if (row[i] <= threshold) continue;
+                float projection = dot(Point(x0 + i + 0.5f, y0 + j + 0.5f), outward);
+                if (projection > best) {
+                    best  = projection;
+                    bestX = x0 + i;
+                    bestY = y0 + j;
+                }
+            }
+        }
+        if (bestX < 0) continue;
+
+        // Report the outer corner of the winning pixel, as the single scale outline does
+        refined[k] = Point(bestX + 0.5f, bestY + 0.5f) + outward * 0.7071f;
+    }
+
+    quad = refined;
+}
+
+std::vector<DetectedQuad> QuadDetector::detect(const ImageView& frame) {
+    if (frame.isEmpty()) return std::vector<DetectedQuad>();
+    if (_options.pyramidLevels <= 0) return detectSingleScale(frame);
+
+    // Keep the top level big enough to still see a document
+    int levels = _options.pyramidLevels;
+    while (levels > 0 && (std::min(frame.width, frame.height) >> levels) < 64) levels--;
+
+    _pyramid.build(frame, levels);
+    std::vector<DetectedQuad> results = detectSingleScale(_pyramid.level(levels));
+
+    for (DetectedQuad& detected : results) {
+        for (int level = levels - 1; level >= 0; level--) {
+            for (int k = 0; k < 4; k++) detected.quad[k] = detected.quad[k] * 2.0f;
+            refineCorners(_pyramid.level(level), detected.quad);
+        }
+        detected.area = detected.quad.signedArea();
+    }
+    return results;
+}
+
+} // namespace irl
@@ -0,0 +1,129 @@
+//
+//  IRLQuadDetector.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Portable replacement for `CIDetectorTypeRectangle`.
+//
+//  The detector segments the frame luma with an Otsu threshold, keeps the biggest bright
+//  regions and fits the largest quadrilateral inscribed in the convex hull of each region.
+//  In multi-scale mode this runs on a 1/4 or 1/8 pyramid level only, then every corner is
+//  refined level by level in a small window, down to the full resolution frame.
+//  Every step is integer or single precision float arithmetic with a fixed evaluation
+//  order, so a frame gives the same corners on device and on Linux.
+//
+
+#ifndef IRL_QUAD_DETECTOR_HPP
+#define IRL_QUAD_DETECTOR_HPP
+
+#include "IRLImage.hpp"
+#include "IRLPyramid.hpp"
+#include "IRLQuad.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace irl {
+
+/** @brief Tuning of `QuadDetector` */
+struct QuadDetectorOptions {
+    /** Smallest accepted quad side, as a fraction of the smaller frame dimension (same meaning as `CIDetectorMinFeatureSize`). */
+    float   minimumFeatureSize  = 0.5f;
+
+    /** Smallest accepted ratio between the region area and the area of its fitted quad. Rejects blobs that are not quads. */
+    float   minimumFillRatio    = 0.85f;
+
+    /** Maximum number of quads returned for one frame. */
+    int     maximumFeatures     = 4;
+
+    /** Number of 2x downsamplings before detection: 0 detects on the full frame, 2 on 1/4, 3 on 1/8. */
+    int     pyramidLevels       = 0;
+
+    /** Half size, in pixels of the level being refined, of the window searched around each corner. */
+    int     refinementRadius    = 6;
+};
+
+/** @brief One detection result */
+struct DetectedQuad {
+    /** Corners, in buffer coordinates */
+    Quad    quad;
+
+    /** Area of `quad`, in square pixels */
+    float   area        = 0.0f;
+
+    /** Region area (holes included) divided by quad area, 1.0 for a perfect quad */
+    float   fillRatio   = 0.0f;
+};
+
+/**
+ @brief Document quadrilateral detector working on BGRA (kCVPixelFormatType_32BGRA) or Gray8 frames.
+ @discussion An instance keeps its working buffers between calls. It is not thread safe, use one instance per queue.
+ */
+class QuadDetector {
+public:
+    explicit QuadDetector(const QuadDetectorOptions& options = QuadDetectorOptions());
+
+    const QuadDetectorOptions&  options() const                             { return _options; }
+    void                        setOptions(const QuadDetectorOptions& options) { _options = options; }
+
+    /**
+     @brief Detect document candidates in `frame`.
+     @param frame A BGRA or Gray8 buffer
+     @return The detected quads, biggest first. Empty when nothing qualifies.
+     */
+    std::vector<DetectedQuad> detect(const ImageView& frame);
+
+    /** @return The luma threshold used for the last frame */
+    int lastThreshold() const { return _threshold; }
+
+private:
+    struct Region {
+        int32_t label;
+        int32_t area;
+        int     minX, minY, maxX, maxY;
+    };
+
+    std::vector<DetectedQuad>   detectSingleScale(const ImageView& frame);
+    void                        labelRegions(const Plane8& luma, int threshold);
+    bool                        fitQuad(const Region& region, DetectedQuad& result);
+    void                        refineCorners(const ImageView& level, Quad& quad);
+
+    QuadDetectorOptions     _options;
+    int                     _threshold = 0;
+
+    Plane8                  _luma;
+    Plane8                  _smoothed;
+    std::vector<int32_t>    _labels;
+    std::vector<int32_t>    _stack;
+    std::vector<Region>     _regions;
+    std::vector<Point>      _outline;
+    std::vector<Point>      _hull;
+
+    LumaPyramid             _pyramid;
+    Plane8                  _window;
+    Plane8                  _smoothedWindow;
+};
+
+/**
+ @brief Otsu threshold of an 8 bit plane.
+ @return The threshold t maximizing the between class variance of { v <= t } and { v > t }
+ */
+int otsuThreshold(const Plane8& plane);
+
+/**
+ @brief Convex hull of `points` sorted by (y, x), Andrew's monotone chain.
+ @discussion The hull is clockwise on screen (positive signed area in buffer coordinates), without duplicated closing point.
+ */
+void convexHull(const std::vector<Point>& sortedPoints, std::vector<Point>& hull);
+
+/**
+ @brief Largest quadrilateral with its corners on `hull`.
+ @discussion Starts from the four diagonal extremes and improves one corner at a time until no move increases the area.
+ @return false when the hull has less than four usable vertices
+ */
+bool largestInscribedQuad(const std::vector<Point>& hull, Quad& quad);
+
+} // namespace irl
+
+#endif /* IRL_QUAD_DETECTOR_HPP */
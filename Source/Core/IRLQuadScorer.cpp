@@ -0,0 +1,166 @@
+//
+//  IRLQuadScorer.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLQuadScorer.hpp"
+#include "IRLCornerRefiner.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace irl {
+
+static inline float clamp01(float value) {
+    return std::min(std::max(value, 0.0f), 1.0f);
+}
+
+/** Twice the signed area of triangle (a, b, c) */
+static inline float triangle2(float ax, float ay, float bx, float by, float cx, float cy) {
+    return (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+}
+
+QuadScorer::QuadScorer(const QuadScorerOptions& options)
+: _options(options) {}
+
+void QuadScorer::clear() {
+    for (int k = 0; k < 4; k++) {
+        _x[k].clear();
+        _y[k].clear();
+    }
+    _area.clear();
+    _convexity.clear();
+    _angles.clear();
+    _edgeSupport.clear();
+    _temporal.clear();
+    _total.clear();
+}
+
+void QuadScorer::add(const Quad& quad) {
+    for (int k = 0; k < 4; k++) {
+        _x[k].push_back(quad[k].x);
+        _y[k].push_back(quad[k].y);
+    }
+    _area.push_back(0.0f);
+    _convexity.push_back(0.0f);
+    _angles.push_back(0.0f);
+    _edgeSupport.push_back(0.0f);
+    _temporal.push_back(0.0f);
+    _total.push_back(0.0f);
+}
+
+Quad QuadScorer::candidate(int index) const {
+    Quad quad;
+    for (int k = 0; k < 4; k++) quad[k] = Point(_x[k][index], _y[k][index]);
+    return quad;
+}
+
+QuadScore QuadScorer::scoreOf(int index) const {
+    QuadScore score;
+    score.area          = _area[index];
+    score.convexity     = _convexity[index];
+    score.angles        = _angles[index];
+    score.edgeSupport   = _edgeSupport[index];
+    score.temporal      = _temporal[index];
+    score.total         = _total[index];
+    return score;
+}
+
+int QuadScorer::score(const ImageView& frame, int width, int height, const Quad* previous) {
+    const int n = count();
+    if (n == 0) return -1;
+    if (!frame.isEmpty()) {
+        width  = frame.width;
+        height = frame.height;
+    }
+
+    const float* x0 = _x[0].data(); const float* y0 = _y[0].data();
+    const float* x1 = _x[1].data(); const float* y1 = _y[1].data();
+    const float* x2 = _x[2].data(); const float* y2 = _y[2].data();
+    const float* x3 = _x[3].data(); const float* y3 = _y[3].data();
+
+    // Area relative to the frame, and convexity: quad area over the area of the hull of its corners
+    const float frameArea = std::max(static_cast<float>(width) * height, 1.0f);
+    for (int i = 0; i < n; i++) {
+        const float a012 = triangle2(x0[i], y0[i], x1[i], y1[i], x2[i], y2[i]);
+        const float a023 = triangle2(x0[i], y0[i], x2[i], y2[i], x3[i], y3[i]);
+        const float a013 = triangle2(x0[i], y0[i], x1[i], y1[i], x3[i], y3[i]);
+        const float a123 = triangle2(x1[i], y1[i], x2[i], y2[i], x3[i], y3[i]);
+        const float quad = 0.5f * (a012 + a023);
+
+        // Hull of four points: the largest of the three quads through them (0132, 0213), or of the four triangles
+        const float other1 = 0.5f * std::fabs(a013 - a023);
+        const float other2 = 0.5f * std::fabs(a013 - a012);
+        float hull = std::max(std::fabs(quad), std::max(other1, other2));
+        hull = std::max(hull, 0.5f * std::max(std::max(std::fabs(a012), std::fabs(a023)), std::max(std::fabs(a013), std::fabs(a123))));
+
+        _area[i]      = clamp01(quad / frameArea);
+        _convexity[i] = hull > 0.0f ? clamp01(quad / hull) : 0.0f;
+    }
+
+    // Right angles: 1 - mean |cos| of the interior angles
+    for (int i = 0; i < n; i++) {
+        const float xs[4] = { x0[i], x1[i], x2[i], x3[i] };
+        const float ys[4] = { y0[i], y1[i], y2[i], y3[i] };
+        float sum = 0.0f;
+        for (int k = 0; k < 4; k++) {
+            const int p = (k + 3) & 3, q = (k + 1) & 3;
+            const float ax = xs[p] - xs[k], ay = ys[p] - ys[k];
+            const float bx = xs[q] - xs[k], by = ys[q] - ys[k];
+            const float norms = std::sqrt((ax * ax + ay * ay) * (bx * bx + by * by));
+            sum += norms > 0.0f ? std::fabs(ax * bx + ay * by) / norms : 1.0f;
+        }
+        _angles[i] = clamp01(1.0f - 0.25f * sum);
+    }
+
+    // Edge support: fraction of the samples along the sides with a luma step across the side
+    const bool hasFrame = !frame.isEmpty() && _options.weights.edgeSupport > 0.0f;
+    const int  samples  = std::max(_options.edgeSamples, 1);
+    for (int i = 0; i < n; i++) {
+        if (!hasFrame) { _edgeSupport[i] = 0.0f; continue; }
+        const Quad q = candidate(i);
+        int supported = 0;
+        for (int k = 0; k < 4; k++) {
+            const Point a = q[k], b = q[(k + 1) & 3];
+            const float length = distance(a, b);
+            if (length <= 0.0f) continue;
+            const Point normal = Point(a.y - b.y, b.x - a.x) * (_options.edgeOffset / length);
+            for (int s = 0; s < samples; s++) {
+                const Point p = a + (b - a) * ((s + 0.5f) / samples);
+                const Point inside = p + normal, outside = p - normal;
+                const float step = sampleLuma(frame, inside.x, inside.y) - sampleLuma(frame, outside.x, outside.y);
+                if (std::fabs(step) >= _options.minimumContrast) supported++;
+            }
+        }
+        _edgeSupport[i] = static_cast<float>(supported) / (4 * samples);
+    }
+
+    // Temporal consistency: mean corner distance to the previous selection
+    const bool  hasPrevious = previous && _options.weights.temporal > 0.0f;
+    const float reach = std::max(_options.temporalDistance * std::sqrt(static_cast<float>(width) * width + static_cast<float>(height) * height), 1.0f);
+    for (int i = 0; i < n; i++) {
+        if (!hasPrevious) { _temporal[i] = 0.0f; continue; }
+        float sum = 0.0f;
+        for (int k = 0; k < 4; k++) sum += distance(Point(_x[k][i], _y[k][i]), (*previous)[k]);
+        _temporal[i] = clamp01(1.0f - 0.25f * sum / reach);
+    }
+
+    // Weighted mean of the evaluated criteria, first best wins
+    const QuadScoreWeights& w = _options.weights;
+    const float wEdges      = hasFrame ? w.edgeSupport : 0.0f;
+    const float wTemporal   = hasPrevious ? w.temporal : 0.0f;
+    const float sum         = w.area + w.convexity + w.angles + wEdges + wTemporal;
+    const float norm        = sum > 0.0f ? 1.0f / sum : 0.0f;
+
+    int best = 0;
+    for (int i = 0; i < n; i++) {
+        _total[i] = norm * (w.area * _area[i] + w.convexity * _convexity[i] + w.angles * _angles[i]
+                            + wEdges * _edgeSupport[i] + wTemporal * _temporal[i]);
+        if (_total[i] > _total[best]) best = i;
+    }
+    return best;
+}
+
+} // namespace irl
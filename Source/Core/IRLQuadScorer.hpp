@@ -0,0 +1,115 @@
+//
+//  IRLQuadScorer.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Selection of the document among the candidate quads of a frame.
+//
+//  Every candidate gets five criteria in [0, 1]: relative area, convexity, closeness of its
+//  interior angles to right angles, fraction of its sides backed by a luma edge, and closeness
+//  to the quad selected on the previous frame. The score is the weighted mean of the criteria
+//  that can be evaluated. Candidates are stored as a structure of arrays and scored criterion
+//  by criterion in one pass; the best score wins, the first candidate on ties, so a frame always
+//  selects the same quad.
+//
+
+#ifndef IRL_QUAD_SCORER_HPP
+#define IRL_QUAD_SCORER_HPP
+
+#include "IRLImage.hpp"
+#include "IRLQuad.hpp"
+
+#include <vector>
+
+namespace irl {
+
+/** @brief Relative weights of the criteria. A zero weight ignores the criterion. */
+struct QuadScoreWeights {
+    float   area            = 1.0f;
+    float   convexity       = 1.0f;
+    float   angles          = 1.0f;
+    float   edgeSupport     = 2.0f;
+    float   temporal        = 1.0f;
+};
+
+/** @brief Tuning of `QuadScorer` */
+struct QuadScorerOptions {
+    QuadScoreWeights    weights;
+
+    /** Luma samples read along each side for the edge support. */
+    int                 edgeSamples         = 24;
+
+    /** Distance, in pixels, of the samples read on each side of an edge. */
+    float               edgeOffset          = 2.0f;
+
+    /** Smallest luma difference across a side for a sample to support it. */
+    float               minimumContrast     = 16.0f;
+
+    /** Mean corner distance to the previous quad, as a fraction of the frame diagonal, at which the temporal criterion drops to 0. */
+    float               temporalDistance    = 0.1f;
+};
+
+/** @brief Criteria of one candidate, for inspection */
+struct QuadScore {
+    float   area            = 0.0f;
+    float   convexity       = 0.0f;
+    float   angles          = 0.0f;
+    float   edgeSupport     = 0.0f;
+    float   temporal        = 0.0f;
+    float   total           = 0.0f;
+};
+
+/**
+ @brief Scores a batch of candidate quads in a BGRA (kCVPixelFormatType_32BGRA) or Gray8 frame.
+ @discussion Arrays grow to the largest batch seen and are reused afterwards. Not thread safe, use one instance per queue.
+ */
+class QuadScorer {
+public:
+    explicit QuadScorer(const QuadScorerOptions& options = QuadScorerOptions());
+
+    const QuadScorerOptions&    options() const                             { return _options; }
+    void                        setOptions(const QuadScorerOptions& options) { _options = options; }
+
+    /** @brief Remove every candidate */
+    void clear();
+
+    /** @brief Append a candidate, in buffer coordinates */
+    void add(const Quad& quad);
+
+    /** @return Number of candidates */
+    int count() const { return static_cast<int>(_total.size()); }
+
+    /** @return Candidate `index` */
+    Quad candidate(int index) const;
+
+    /**
+     @brief Score every candidate.
+     @param frame    The frame the candidates were found in. When empty, the edge support is not evaluated.
+     @param width    Frame width, used for the area and temporal criteria when `frame` is empty
+     @param height   Frame height
+     @param previous The quad selected on the previous frame, or nullptr to skip the temporal criterion
+     @return The index of the best candidate, -1 when there is none
+     */
+    int score(const ImageView& frame, int width, int height, const Quad* previous);
+
+    /** @return The criteria of candidate `index`, valid after `score` */
+    QuadScore scoreOf(int index) const;
+
+private:
+    QuadScorerOptions       _options;
+
+    // Structure of arrays: corner coordinates, then one array per criterion
+    std::vector<float>      _x[4];
+    std::vector<float>      _y[4];
+    std::vector<float>      _area;
+    std::vector<float>      _convexity;
+    std::vector<float>      _angles;
+    std::vector<float>      _edgeSupport;
+    std::vector<float>      _temporal;
+    std::vector<float>      _total;
+};
+
+} // namespace irl
+
+#endif /* IRL_QUAD_SCORER_HPP */
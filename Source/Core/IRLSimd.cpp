@@ -0,0 +1,53 @@
+//
+//  IRLSimd.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLSimd.hpp"
+
+#include <initializer_list>
+
+namespace irl {
+
+bool isSimdLevelSupported(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Scalar:
+            return true;
+#if IRL_SIMD_X86
+        case SimdLevel::SSE41:
+            return __builtin_cpu_supports("sse4.1");
+        case SimdLevel::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+#if IRL_SIMD_NEON
+        case SimdLevel::NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+SimdLevel bestSimdLevel() {
+    static const SimdLevel best = [] {
+        for (SimdLevel level : { SimdLevel::NEON, SimdLevel::AVX2, SimdLevel::SSE41 }) {
+            if (isSimdLevelSupported(level)) return level;
+        }
+        return SimdLevel::Scalar;
+    }();
+    return best;
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Scalar: return "scalar";
+        case SimdLevel::SSE41:  return "sse4.1";
+        case SimdLevel::AVX2:   return "avx2";
+        case SimdLevel::NEON:   return "neon";
+    }
+    return "unknown";
+}
+
+} // namespace irl
@@ -0,0 +1,55 @@
+//
+//  IRLSimd.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Instruction set selection for the vector kernels of the core.
+//
+//  Every vectorized module ships a scalar reference plus one variant per instruction set,
+//  each in its own translation unit. x86 variants are compiled with per function target
+//  attributes, so the library itself keeps the baseline ISA and picks the best variant at
+//  runtime. NEON is part of the arm64 baseline and is always used on device.
+//
+
+#ifndef IRL_SIMD_HPP
+#define IRL_SIMD_HPP
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define IRL_SIMD_X86    1
+#define IRL_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define IRL_TARGET_AVX2  __attribute__((target("avx2")))
+#else
+#define IRL_SIMD_X86    0
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define IRL_SIMD_NEON   1
+#else
+#define IRL_SIMD_NEON   0
+#endif
+
+namespace irl {
+
+/** @brief Kernel variants, from the scalar reference to the widest vector unit */
+enum class SimdLevel : uint8_t {
+    Scalar,
+    SSE41,
+    AVX2,
+    NEON
+};
+
+/** @return true when the running CPU can execute `level` kernels */
+bool isSimdLevelSupported(SimdLevel level);
+
+/** @return The widest level supported by the running CPU, detected once */
+SimdLevel bestSimdLevel();
+
+/** @return A short printable name ("scalar", "sse4.1", "avx2", "neon") */
+const char* simdLevelName(SimdLevel level);
+
+} // namespace irl
+
+#endif /* IRL_SIMD_HPP */
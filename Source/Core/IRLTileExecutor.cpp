@@ -0,0 +1,158 @@
+//
+//  IRLTileExecutor.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLTileExecutor.hpp"
+
+#include <algorithm>
+
+namespace irl {
+
+TileExecutor::TileExecutor(int threads)
+: _queues(static_cast<size_t>(std::max(1, threads > 0 ? threads : static_cast<int>(std::thread::hardware_concurrency())))),
+  _remaining(0) {
+    _threads.reserve(_queues.size() - 1);
+    for (int worker = 1; worker < threadCount(); worker++) _threads.emplace_back(&TileExecutor::loop, this, worker);
+}
+
+TileExecutor::~TileExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _wake.notify_all();
+    for (std::thread& thread : _threads) thread.join();
+}
+
+TileExecutor& TileExecutor::shared() {
+    static TileExecutor executor;
+    return executor;
+}
+
+TileExecutor& executorForThreads(int threads, std::unique_ptr<TileExecutor>& owned) {
+    if (threads <= 0) return TileExecutor::shared();
+    if (!owned || owned->threadCount() != threads) owned.reset(new TileExecutor(threads));
+    return *owned;
+}
+
+// MARK: - Dispatch
+
+void TileExecutor::dispatch(int width, int height, int tileWidth, int tileHeight, Invoke invoke, void* body) {
+    if (width <= 0 || height <= 0) return;
+    tileWidth  = std::max(1, std::min(tileWidth, width));
+    tileHeight = std::max(1, std::min(tileHeight, height));
+    const int columns = (width + tileWidth - 1) / tileWidth;
+    const int count   = columns * ((height + tileHeight - 1) / tileHeight);
+
+    std::lock_guard<std::mutex> serial(_dispatch);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _invoke     = invoke;
+        _body       = body;
+        _width      = width;
+        _height     = height;
+        _tileWidth  = tileWidth;
+        _tileHeight = tileHeight;
+        _columns    = columns;
+        _remaining.store(count);
+
+        // Contiguous runs, in grid order
+        const int workers = threadCount();
+        for (int worker = 0; worker < workers; worker++) {
+            Queue& queue = _queues[static_cast<size_t>(worker)];
+            std::lock_guard<std::mutex> queueLock(queue.mutex);
+            queue.begin = static_cast<int>(static_cast<long long>(count) * worker / workers);
+            queue.end   = static_cast<int>(static_cast<long long>(count) * (worker + 1) / workers);
+        }
+        _generation++;
+    }
+    _wake.notify_all();
+
+    work(0);
+
+    // Workers still finishing a tile, or not awake yet, must be done with this run before `body` goes away
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this] { return _remaining.load() == 0 && _busy == 0; });
+    _invoke = nullptr;
+    _body   = nullptr;
+}
+
+void TileExecutor::loop(int worker) {
+    unsigned seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [&] { return _stop || _generation != seen; });
+            if (_stop) return;
+            seen = _generation;
+            _busy++;
+        }
+        work(worker);
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _busy--;
+        }
+        _done.notify_all();
+    }
+}
+
+void TileExecutor::work(int worker) {
+    int index;
+    while (pop(worker, index) || steal(worker, index)) {
+        Tile tile;
+        tile.index  = index;
+        tile.x      = (index % _columns) * _tileWidth;
+        tile.y      = (index / _columns) * _tileHeight;
+        tile.width  = std::min(_tileWidth,  _width  - tile.x);
+        tile.height = std::min(_tileHeight, _height - tile.y);
+        _invoke(_body, tile, worker);
+
+        if (--_remaining == 0) {
+            // Taking the lock orders the wake up after the waiter checked the count
+            std::lock_guard<std::mutex> lock(_mutex);
+            _done.notify_all();
+        }
+    }
+}
+
+// MARK: - Queues
+
+bool TileExecutor::pop(int worker, int& tile) {
+    Queue& queue = _queues[static_cast<size_t>(worker)];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.begin >= queue.end) return false;
+    tile = queue.begin++;
+    return true;
+}
+
+bool TileExecutor::steal(int worker, int& tile) {
+    const int workers = threadCount();
+    for (int offset = 1; offset < workers; offset++) {
+        Queue& victim = _queues[static_cast<size_t>((worker + offset) % workers)];
+        int begin, end;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            const int left = victim.end - victim.begin;
+            if (left <= 0) continue;
+            // The upper half, away from where the victim is working
+            end   = victim.end;
+            begin = victim.end - (left + 1) / 2;
+            victim.end = begin;
+        }
+
+        tile = begin;
+        if (begin + 1 < end) {
+            Queue& queue = _queues[static_cast<size_t>(worker)];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.begin = begin + 1;
+            queue.end   = end;
+        }
+        return true;
+    }
+    return false;
+}
+
+} // namespace irl
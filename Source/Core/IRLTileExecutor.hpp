@@ -0,0 +1,121 @@
+//
+//  IRLTileExecutor.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Runs the full resolution stages of the still (filters, warp, binarization) on every core.
+//  An image is cut into fixed size tiles, dealt in contiguous runs to the workers so each one
+//  walks neighbouring memory. A worker that runs out of tiles steals the upper half of the run
+//  left to another one, so uneven tiles (page borders, text against blank paper) do not leave
+//  cores idle while one finishes.
+//
+
+#ifndef IRL_TILE_EXECUTOR_HPP
+#define IRL_TILE_EXECUTOR_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace irl {
+
+/** @brief A rectangle of pixels, the unit of work of `TileExecutor` */
+struct Tile {
+    int x       = 0;
+    int y       = 0;
+    int width   = 0;
+    int height  = 0;
+    int index   = 0;    ///< row major index in the grid
+};
+
+/**
+ @brief Pool of one worker per core with work stealing.
+ @discussion The thread calling `run` works as well, as worker 0, then waits for the others. Calls from several threads run
+ one after the other. Dispatch does not allocate.
+ */
+class TileExecutor {
+public:
+    /** @param threads Workers, the calling thread included. 0 for one per core. */
+    explicit TileExecutor(int threads = 0);
+    ~TileExecutor();
+
+    TileExecutor(const TileExecutor&) = delete;
+    TileExecutor& operator=(const TileExecutor&) = delete;
+
+    /** @return Number of workers, the calling thread included */
+    int threadCount() const { return static_cast<int>(_queues.size()); }
+
+    /**
+     @brief Call `body(const Tile&, int worker)` for every tile of a `width` x `height` image, and return once all are done.
+     @discussion `worker` is in [0, threadCount()) and is the same for all the tiles a thread runs: use it to index per thread
+     scratch buffers. Edge tiles are cut to the image. `body` must not throw, nor call `run` on the same executor.
+     */
+    template <typename Body>
+    void run(int width, int height, int tileWidth, int tileHeight, Body&& body) {
+        dispatch(width, height, tileWidth, tileHeight, &invoke<typename std::remove_reference<Body>::type>, &body);
+    }
+
+    /** @brief Same as `run` with full width tiles of `bandHeight` rows */
+    template <typename Body>
+    void runBands(int width, int height, int bandHeight, Body&& body) {
+        run(width, height, width, bandHeight, static_cast<Body&&>(body));
+    }
+
+    /** @return The executor with one worker per core shared by the stages */
+    static TileExecutor& shared();
+
+private:
+    typedef void (*Invoke)(void* body, const Tile& tile, int worker);
+
+    template <typename Body>
+    static void invoke(void* body, const Tile& tile, int worker) { (*static_cast<Body*>(body))(tile, worker); }
+
+    /** Tiles left to a worker, [begin, end) of the grid. Aligned so neighbours do not share a cache line. */
+    struct alignas(64) Queue {
+        std::mutex  mutex;
+        int         begin   = 0;
+        int         end     = 0;
+    };
+
+    void dispatch(int width, int height, int tileWidth, int tileHeight, Invoke invoke, void* body);
+    void work(int worker);
+    bool pop(int worker, int& tile);
+    bool steal(int worker, int& tile);
+    void loop(int worker);
+
+    std::vector<Queue>          _queues;
+    std::vector<std::thread>    _threads;
+
+    std::mutex                  _dispatch;      // one run at a time
+    std::mutex                  _mutex;
+    std::condition_variable     _wake;
+    std::condition_variable     _done;
+    unsigned                    _generation = 0;
+    int                         _busy       = 0;
+    bool                        _stop       = false;
+
+    // Current run
+    Invoke                      _invoke     = nullptr;
+    void*                       _body       = nullptr;
+    int                         _width      = 0;
+    int                         _height     = 0;
+    int                         _tileWidth  = 0;
+    int                         _tileHeight = 0;
+    int                         _columns    = 0;
+    std::atomic<int>            _remaining;
+};
+
+/**
+ @return The shared executor for 0 `threads`, otherwise `owned`, created again when its size differs.
+ @discussion Lets a stage take a thread count option and still share the pool by default.
+ */
+TileExecutor& executorForThreads(int threads, std::unique_ptr<TileExecutor>& owned);
+
+} // namespace irl
+
+#endif /* IRL_TILE_EXECUTOR_HPP */
@@ -0,0 +1,65 @@
+//
+//  IRLToneCurve.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLToneCurve.hpp"
+#include "IRLToneCurveKernels.hpp"
+
+#include <cassert>
+
+namespace irl {
+namespace detail {
+
+// MARK: - Scalar kernels
+
+static void lookupRowScalar(const uint8_t* source, uint8_t* destination, int width, const uint8_t* table) {
+    for (int x = 0; x < width; x++) destination[x] = table[source[x]];
+}
+
+const ToneCurveKernels* toneCurveKernelsScalar() {
+    static const ToneCurveKernels kernels = { lookupRowScalar };
+    return &kernels;
+}
+
+const ToneCurveKernels* toneCurveKernels(SimdLevel level) {
+    if (!isSimdLevelSupported(level)) return nullptr;
+    switch (level) {
+        case SimdLevel::Scalar: return toneCurveKernelsScalar();
+        case SimdLevel::SSE41:  return toneCurveKernelsSSE41();
+        case SimdLevel::AVX2:   return toneCurveKernelsAVX2();
+        case SimdLevel::NEON:   return toneCurveKernelsNEON();
+    }
+    return nullptr;
+}
+
+} // namespace detail
+
+// MARK: - ToneMapper
+
+ToneMapper::ToneMapper(SimdLevel level)
+: _level(level)
+, _kernels(detail::toneCurveKernels(level)) {
+    if (!_kernels) {
+        _level   = SimdLevel::Scalar;
+        _kernels = detail::toneCurveKernelsScalar();
+    }
+}
+
+void ToneMapper::apply(const ImageView& source, const ToneCurve& curve, Plane8& destination) const {
+    // Resizing would drop the pixels of an in place mapping, their size already is right
+    if (source.data != destination.data()) destination.resize(source.width, source.height);
+    apply(source, curve, destination.data(), destination.stride());
+}
+
+void ToneMapper::apply(const ImageView& source, const ToneCurve& curve, uint8_t* destination, size_t stride) const {
+    assert(source.format == PixelFormat::Gray8);
+    if (source.isEmpty()) return;
+    for (int y = 0; y < source.height; y++) {
+        _kernels->lookupRow(source.row(y), destination + static_cast<size_t>(y) * stride, source.width, curve.values);
+    }
+}
+
+} // namespace irl
@@ -0,0 +1,111 @@
+//
+//  IRLToneCurve.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  256 entries tone curves applied to luma planes, and the sigmoid curve of the Ultra Contrast
+//  view, generated at compile time.
+//
+//  The lookup has a scalar reference and SSE4.1, AVX2 and NEON variants built on byte
+//  shuffles (16 and 64 entries sub tables), all giving the same bytes.
+//
+
+#ifndef IRL_TONE_CURVE_HPP
+#define IRL_TONE_CURVE_HPP
+
+#include "IRLImage.hpp"
+#include "IRLSimd.hpp"
+
+#include <cstdint>
+
+namespace irl {
+
+/** @brief Output value of every input byte */
+struct ToneCurve {
+    uint8_t values[256] = {};
+
+    constexpr uint8_t operator[](int index) const { return values[index]; }
+};
+
+namespace detail {
+
+/** exp(x) for |x| < 8 or so: x / 32 through a Taylor series, squared 5 times */
+constexpr double constexprExp(double x) {
+    const double reduced = x / 32.0;
+    double sum = 1.0, term = 1.0;
+    for (int n = 1; n < 16; n++) {
+        term *= reduced / n;
+        sum  += term;
+    }
+    for (int i = 0; i < 5; i++) sum *= sum;
+    return sum;
+}
+
+constexpr int constexprCeil(double x) {
+    const int truncated = static_cast<int>(x);
+    return truncated < x ? truncated + 1 : truncated;
+}
+
+} // namespace detail
+
+/**
+ @brief The Ultra Contrast curve: black below `256 * threshold`, then a sigmoid ramp 200 values wide, then white.
+ @discussion Same values as the 256x1 gradient image the scanner used to draw with UIKit for `CIColorMap`: 200 gray
+ rectangles `256 * threshold² + 200 - i` wide, i = 0 ... 199, filled with sigmoid((100 - i) / 20), each one over the
+ previous one, and the black rectangle over them all. The value of a byte is the color drawn last on its pixel center.
+ @param threshold Between 0 and 1. The scanner uses 0.3.
+ */
+constexpr ToneCurve ultraContrastCurve(double threshold) {
+    ToneCurve curve;
+    const double black = 256.0 * threshold;
+    const double ramp  = 256.0 * threshold * threshold + 200.0;
+    for (int x = 0; x < 256; x++) {
+        const double center = x + 0.5;
+        int i = detail::constexprCeil(ramp - center) - 1;
+        i = i > 199 ? 199 : i;
+
+        double white = 1.0;
+        if (center < black)  white = 0.0;
+        else if (i >= 0)     white = 1.0 / (1.0 + detail::constexprExp(-(10.0 * (100 - i) / 200.0)));
+        curve.values[x] = static_cast<uint8_t>(white * 255.0 + 0.5);
+    }
+    return curve;
+}
+
+/** @brief The curve of the Ultra Contrast view (threshold 0.3), built by the compiler */
+constexpr ToneCurve kUltraContrastCurve = ultraContrastCurve(0.3);
+
+namespace detail { struct ToneCurveKernels; }
+
+/**
+ @brief Applies a tone curve to Gray8 planes, one table lookup per pixel.
+ @discussion The cost per pixel is fixed, whatever the curve. Stateless apart from the kernel choice, an instance can be
+ shared between queues.
+ */
+class ToneMapper {
+public:
+    /** @param level Kernel variant. An unsupported level falls back to the scalar reference. */
+    explicit ToneMapper(SimdLevel level = bestSimdLevel());
+
+    /** @return The kernel variant actually used */
+    SimdLevel simdLevel() const { return _level; }
+
+    /**
+     @brief `curve` applied to every pixel of `source`.
+     @param source A Gray8 view, e.g. the Y plane of a bi-planar frame. BGRA8 frames go through `convertToLuma` first.
+     @param destination Resized to the size of `source`. May be the plane `source` views, for an in place mapping.
+     */
+    void apply(const ImageView& source, const ToneCurve& curve, Plane8& destination) const;
+
+    /** @brief Same as above, into `height` rows of `stride` bytes */
+    void apply(const ImageView& source, const ToneCurve& curve, uint8_t* destination, size_t stride) const;
+
+private:
+    SimdLevel                           _level;
+    const detail::ToneCurveKernels*     _kernels;
+};
+
+} // namespace irl
+
+#endif /* IRL_TONE_CURVE_HPP */
@@ -0,0 +1,56 @@
+//
+//  IRLToneCurveAVX2.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  AVX2 tone curve lookup, 32 pixels per iteration with 16 shuffles of 16 entries each.
+//
+
+#include "IRLToneCurveKernels.hpp"
+
+#if IRL_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace irl {
+namespace detail {
+
+#if IRL_SIMD_X86
+
+IRL_TARGET_AVX2 static void lookupRowAVX2(const uint8_t* source, uint8_t* destination, int width, const uint8_t* table) {
+    // vpshufb shuffles within each 128 bit lane, so every sub table is broadcast to both lanes
+    __m256i parts[16];
+    for (int g = 0; g < 16; g++) {
+        parts[g] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(table + 16 * g)));
+    }
+
+    // See the SSE4.1 variant: the bytes outside of sub table g get their top bit set and read as 0
+    const __m256i outside = _mm256_set1_epi8(0x70);
+
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        const __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + x));
+        __m256i result = _mm256_setzero_si256();
+        for (int g = 0; g < 16; g++) {
+            const __m256i index = _mm256_adds_epu8(_mm256_xor_si256(values, _mm256_set1_epi8(static_cast<char>(16 * g))), outside);
+            result = _mm256_or_si256(result, _mm256_shuffle_epi8(parts[g], index));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + x), result);
+    }
+    for (; x < width; x++) destination[x] = table[source[x]];
+}
+
+const ToneCurveKernels* toneCurveKernelsAVX2() {
+    static const ToneCurveKernels kernels = { lookupRowAVX2 };
+    return &kernels;
+}
+
+#else
+
+const ToneCurveKernels* toneCurveKernelsAVX2() { return nullptr; }
+
+#endif
+
+} // namespace detail
+} // namespace irl
@@ -0,0 +1,38 @@
+//
+//  IRLToneCurveKernels.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Row kernels behind `ToneMapper`, one table per instruction set. Not part of the public
+//  API: exposed for the bit-exactness tests and the benchmarks only.
+//
+
+#ifndef IRL_TONE_CURVE_KERNELS_HPP
+#define IRL_TONE_CURVE_KERNELS_HPP
+
+#include "IRLSimd.hpp"
+
+#include <cstdint>
+
+namespace irl {
+namespace detail {
+
+/** @brief Row kernels of one instruction set */
+struct ToneCurveKernels {
+    /** destination[x] = table[source[x]] for `width` bytes. `source` and `destination` may be the same row. */
+    void (*lookupRow)(const uint8_t* source, uint8_t* destination, int width, const uint8_t* table);
+};
+
+/** @return The kernels of `level`, nullptr when the level is not compiled in or not supported by the CPU */
+const ToneCurveKernels* toneCurveKernels(SimdLevel level);
+
+const ToneCurveKernels* toneCurveKernelsScalar();
+const ToneCurveKernels* toneCurveKernelsSSE41();
+const ToneCurveKernels* toneCurveKernelsAVX2();
+const ToneCurveKernels* toneCurveKernelsNEON();
+
+} // namespace detail
+} // namespace irl
+
+#endif /* IRL_TONE_CURVE_KERNELS_HPP */
@@ -0,0 +1,56 @@
+//
+//  IRLToneCurveNEON.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  NEON tone curve lookup, 16 pixels per iteration with four 64 entries table lookups.
+//
+
+#include "IRLToneCurveKernels.hpp"
+
+#if IRL_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+namespace irl {
+namespace detail {
+
+#if IRL_SIMD_NEON
+
+static void lookupRowNEON(const uint8_t* source, uint8_t* destination, int width, const uint8_t* table) {
+    const uint8x16x4_t q0 = vld1q_u8_x4(table);
+    const uint8x16x4_t q1 = vld1q_u8_x4(table + 64);
+    const uint8x16x4_t q2 = vld1q_u8_x4(table + 128);
+    const uint8x16x4_t q3 = vld1q_u8_x4(table + 192);
+    const uint8x16_t   quarter = vdupq_n_u8(64);
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        // tbl writes 0 for indices past 63, tbx keeps the previous value: each quarter fills its own bytes
+        uint8x16_t index  = vld1q_u8(source + x);
+        uint8x16_t result = vqtbl4q_u8(q0, index);
+        index  = vsubq_u8(index, quarter);
+        result = vqtbx4q_u8(result, q1, index);
+        index  = vsubq_u8(index, quarter);
+        result = vqtbx4q_u8(result, q2, index);
+        index  = vsubq_u8(index, quarter);
+        result = vqtbx4q_u8(result, q3, index);
+        vst1q_u8(destination + x, result);
+    }
+    for (; x < width; x++) destination[x] = table[source[x]];
+}
+
+const ToneCurveKernels* toneCurveKernelsNEON() {
+    static const ToneCurveKernels kernels = { lookupRowNEON };
+    return &kernels;
+}
+
+#else
+
+const ToneCurveKernels* toneCurveKernelsNEON() { return nullptr; }
+
+#endif
+
+} // namespace detail
+} // namespace irl
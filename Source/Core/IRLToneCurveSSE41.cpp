@@ -0,0 +1,54 @@
+//
+//  IRLToneCurveSSE41.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  SSE4.1 tone curve lookup, 16 pixels per iteration with 16 shuffles of 16 entries each.
+//
+
+#include "IRLToneCurveKernels.hpp"
+
+#if IRL_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace irl {
+namespace detail {
+
+#if IRL_SIMD_X86
+
+IRL_TARGET_SSE41 static void lookupRowSSE41(const uint8_t* source, uint8_t* destination, int width, const uint8_t* table) {
+    __m128i parts[16];
+    for (int g = 0; g < 16; g++) parts[g] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(table + 16 * g));
+
+    // Sub table g only sees the bytes of 16g ... 16g + 15: once xored with 16g they are below 16, every other
+    // byte becomes 16 or more and the saturating add sets its top bit, which makes the shuffle write 0
+    const __m128i outside = _mm_set1_epi8(0x70);
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + x));
+        __m128i result = _mm_setzero_si128();
+        for (int g = 0; g < 16; g++) {
+            const __m128i index = _mm_adds_epu8(_mm_xor_si128(values, _mm_set1_epi8(static_cast<char>(16 * g))), outside);
+            result = _mm_or_si128(result, _mm_shuffle_epi8(parts[g], index));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + x), result);
+    }
+    for (; x < width; x++) destination[x] = table[source[x]];
+}
+
+const ToneCurveKernels* toneCurveKernelsSSE41() {
+    static const ToneCurveKernels kernels = { lookupRowSSE41 };
+    return &kernels;
+}
+
+#else
+
+const ToneCurveKernels* toneCurveKernelsSSE41() { return nullptr; }
+
+#endif
+
+} // namespace detail
+} // namespace irl
@@ -0,0 +1,140 @@
+//
+//  IRLUnsharpMask.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLUnsharpMask.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace irl {
+
+static const int kBandHeight    = 64;
+static const int kMaximumRadius = 32;
+
+UnsharpMask::UnsharpMask(const UnsharpMaskOptions& options) {
+    setOptions(options);
+}
+
+void UnsharpMask::setOptions(const UnsharpMaskOptions& options) {
+    _options = options;
+    _radius  = std::min(std::max(options.radius, 1), kMaximumRadius);
+
+    // Soft threshold: the grain is left as is and edges start from 0, so there is no step at the threshold
+    const int threshold = std::max(options.threshold, 0);
+    for (int difference = -255; difference <= 255; difference++) {
+        const int excess = difference > threshold ? difference - threshold : difference < -threshold ? difference + threshold : 0;
+        _change[difference + 255] = static_cast<int>(std::lround(options.amount * excess));
+    }
+}
+
+void UnsharpMask::prepare(int width) {
+    _inverseColumns.resize(static_cast<size_t>(std::max(width, 0)));
+    for (int x = 0; x < width; x++) {
+        _inverseColumns[static_cast<size_t>(x)] = 1.0f / static_cast<float>(std::min(x + _radius, width - 1) - std::max(x - _radius, 0) + 1);
+    }
+}
+
+// MARK: - Streaming
+
+void UnsharpMask::beginBand(Band& band, int width, int height, PixelFormat format, int first) const {
+    const size_t count = static_cast<size_t>(width);
+    band.width    = width;
+    band.height   = height;
+    band.channels = static_cast<int>(bytesPerPixel(format));
+    band.next     = std::max(first - _radius, 0);
+    band.low      = band.next;
+    band.pixels.resize(count * band.channels * ringSize());
+    band.luma.resize(count * ringSize());
+    band.columnSums.assign(count, 0);
+    band.boxSums.resize(count);
+}
+
+int UnsharpMask::pendingRow(const Band& band, int y) const {
+    return band.next <= std::min(y + _radius, band.height - 1) ? band.next : -1;
+}
+
+uint8_t* UnsharpMask::rowBuffer(Band& band) const {
+    return band.pixels.data() + static_cast<size_t>(band.next % ringSize()) * band.width * band.channels;
+}
+
+void UnsharpMask::pushRow(Band& band) const {
+    const size_t    slot   = static_cast<size_t>(band.next % ringSize());
+    const uint8_t*  pixels = band.pixels.data() + slot * band.width * band.channels;
+    uint8_t*        luma   = band.luma.data() + slot * band.width;
+    int32_t*        sums   = band.columnSums.data();
+
+    if (band.channels == 1) {
+        std::memcpy(luma, pixels, static_cast<size_t>(band.width));
+    } else {
+        // BT.601 in Q8, as `convertToLuma`
+        for (int x = 0; x < band.width; x++, pixels += 4) {
+            luma[x] = static_cast<uint8_t>((29 * pixels[0] + 150 * pixels[1] + 77 * pixels[2] + 128) >> 8);
+        }
+    }
+    for (int x = 0; x < band.width; x++) sums[x] += luma[x];
+    band.next++;
+}
+
+void UnsharpMask::sharpenRow(Band& band, int y, uint8_t* destination) const {
+    const int width = band.width;
+    int32_t*  sums  = band.columnSums.data();
+
+    // Rows that left the window. They are still in the ring, which holds one row more than the window.
+    for (; band.low < y - _radius; band.low++) {
+        const uint8_t* luma = band.luma.data() + static_cast<size_t>(band.low % ringSize()) * width;
+        for (int x = 0; x < width; x++) sums[x] -= luma[x];
+    }
+
+    // Horizontal running sum of the column sums
+    int32_t* box = band.boxSums.data();
+    int32_t  sum = 0;
+    for (int x = 0; x <= std::min(_radius, width - 1); x++) sum += sums[x];
+    for (int x = 0; x < width; x++) {
+        box[x] = sum;
+        if (x + _radius + 1 < width) sum += sums[x + _radius + 1];
+        if (x - _radius >= 0)        sum -= sums[x - _radius];
+    }
+
+    const size_t    slot        = static_cast<size_t>(y % ringSize());
+    const uint8_t*  luma        = band.luma.data() + slot * width;
+    const uint8_t*  pixels      = band.pixels.data() + slot * width * band.channels;
+    const float     inverseRows = 1.0f / static_cast<float>(std::min(y + _radius, band.height - 1) - std::max(y - _radius, 0) + 1);
+    for (int x = 0; x < width; x++) {
+        const int blur   = static_cast<int>(static_cast<float>(box[x]) * (inverseRows * _inverseColumns[static_cast<size_t>(x)]) + 0.5f);
+        const int change = _change[luma[x] - blur + 255];
+        if (band.channels == 1) {
+            destination[x] = static_cast<uint8_t>(std::min(std::max(pixels[x] + change, 0), 255));
+        } else {
+            for (int c = 0; c < 3; c++) destination[4 * x + c] = static_cast<uint8_t>(std::min(std::max(pixels[4 * x + c] + change, 0), 255));
+            destination[4 * x + 3] = pixels[4 * x + 3];
+        }
+    }
+}
+
+// MARK: - Apply
+
+void UnsharpMask::apply(const ImageView& source, uint8_t* destination, size_t stride) {
+    if (source.isEmpty()) return;
+
+    TileExecutor& executor = executorForThreads(_options.threads, _executor);
+
+    const size_t rowBytes = static_cast<size_t>(source.width) * bytesPerPixel(source.format);
+    prepare(source.width);
+    if (static_cast<int>(_bands.size()) < executor.threadCount()) _bands.resize(static_cast<size_t>(executor.threadCount()));
+
+    executor.runBands(source.width, source.height, kBandHeight, [&](const Tile& tile, int worker) {
+        Band& band = _bands[static_cast<size_t>(worker)];
+        beginBand(band, source.width, source.height, source.format, tile.y);
+        for (int y = tile.y; y < tile.y + tile.height; y++) {
+            for (int row; (row = pendingRow(band, y)) >= 0; pushRow(band)) std::memcpy(rowBuffer(band), source.row(row), rowBytes);
+            sharpenRow(band, y, destination + stride * static_cast<size_t>(y));
+        }
+    });
+}
+
+} // namespace irl
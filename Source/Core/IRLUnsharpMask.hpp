@@ -0,0 +1,105 @@
+//
+//  IRLUnsharpMask.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Sharpening of text strokes softened by the resampling of the perspective correction. The
+//  luma is compared to its box blur and the difference, past a small threshold so the paper
+//  grain is left alone, is added back to the three channels. The blur is separable and made of
+//  running sums: one add and one subtract per pixel and direction whatever the radius.
+//
+//  Rows are streamed: a band pulls its source rows one at a time and only keeps the 2 radius + 2
+//  rows around the current one, so the page renderer can produce the rows it samples and sharpen
+//  them in its output pass instead of sharpening the whole page afterwards.
+//
+
+#ifndef IRL_UNSHARP_MASK_HPP
+#define IRL_UNSHARP_MASK_HPP
+
+#include "IRLImage.hpp"
+#include "IRLTileExecutor.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace irl {
+
+/** @brief Tuning of `UnsharpMask`, defaults for text on a page rendered at the photo resolution */
+struct UnsharpMaskOptions {
+    /** Half size of the blur: 2 averages 5x5 pixels, a little wider than a resampled stroke edge. At most 32. */
+    int     radius      = 2;
+
+    /** Part of the difference to the blur added back. */
+    float   amount      = 1.0f;
+
+    /** Differences up to this many levels are taken as grain and not amplified. */
+    int     threshold   = 3;
+
+    /** Threads used by `apply`, 0 to share `TileExecutor::shared()` with the other stages. */
+    int     threads     = 0;
+};
+
+/**
+ @brief Unsharp mask of BGRA8 or Gray8 images, on the luma.
+ @discussion The options and tables are read only during a pass, so the workers of one image share the instance and keep
+ their rows in a `Band` each. Not thread safe otherwise, use one instance per queue.
+ */
+class UnsharpMask {
+public:
+    /** @brief Streaming state of one band of rows. Buffers are kept between bands. */
+    struct Band {
+        std::vector<uint8_t>    pixels;         // ring of source rows, row `y` in slot y % (2 radius + 2)
+        std::vector<uint8_t>    luma;           // and their luma
+        std::vector<int32_t>    columnSums;     // luma summed over the rows of the current window
+        std::vector<int32_t>    boxSums;        // and over the window of each pixel
+        int                     width       = 0;
+        int                     height      = 0;
+        int                     channels    = 0;
+        int                     next        = 0;    // next source row to push
+        int                     low         = 0;    // first row in `columnSums`
+    };
+
+    explicit UnsharpMask(const UnsharpMaskOptions& options = UnsharpMaskOptions());
+
+    const UnsharpMaskOptions&   options() const { return _options; }
+    void                        setOptions(const UnsharpMaskOptions& options);
+
+    /** @brief Prepare a pass over images `width` wide. Call before the bands start, they only read the tables. */
+    void prepare(int width);
+
+    /** @brief Start `band` at output row `first` of an image `height` rows high, in `format` */
+    void beginBand(Band& band, int width, int height, PixelFormat format, int first) const;
+
+    /** @return The next source row `band` needs before output row `y` can be sharpened, or -1 when it has them all */
+    int pendingRow(const Band& band, int y) const;
+
+    /** @return Where to write the pixels of source row `pendingRow`, then call `pushRow` */
+    uint8_t* rowBuffer(Band& band) const;
+
+    /** @brief Take the row written in `rowBuffer` */
+    void pushRow(Band& band) const;
+
+    /** @brief Write output row `y`, once `pendingRow(band, y)` is -1 */
+    void sharpenRow(Band& band, int y, uint8_t* destination) const;
+
+    /**
+     @brief Sharpen `source` into `destination`, same format and size, in bands on all the cores.
+     @param destination At least `source.height` rows of `stride` bytes. Must not overlap `source`.
+     */
+    void apply(const ImageView& source, uint8_t* destination, size_t stride);
+
+private:
+    int ringSize() const { return 2 * _radius + 2; }
+
+    UnsharpMaskOptions              _options;
+    int                             _radius = 2;
+    int                             _change[511];       // luma change per difference to the blur, +255
+    std::vector<float>              _inverseColumns;    // 1 / columns in the window of each x
+    std::vector<Band>               _bands;             // of `apply`, one per worker
+    std::unique_ptr<TileExecutor>   _executor;          // when `threads` is set
+};
+
+} // namespace irl
+
+#endif /* IRL_UNSHARP_MASK_HPP */
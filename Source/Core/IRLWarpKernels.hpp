@@ -0,0 +1,148 @@
+//
+//  IRLWarpKernels.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Sampler kernels behind `PerspectiveWarp`, one table per instruction set. Not part of the
+//  public API: exposed for the bit-exactness tests and the benchmarks only.
+//
+//  Kernels read source coordinates already projected and clamped, so every variant does the
+//  same integer arithmetic and the results are identical to the byte.
+//
+
+#ifndef IRL_WARP_KERNELS_HPP
+#define IRL_WARP_KERNELS_HPP
+
+#include "IRLSimd.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace irl {
+namespace detail {
+
+/** Fraction bits of the source coordinates */
+static const int kWarpShift = 16;
+
+/** Phases of the bicubic weights, taken from the top 8 fraction bits */
+static const int kCubicPhases = 256;
+
+/** Fraction bits of the bicubic weights, so the 16 taps of a channel sum in 32 bits */
+static const int kCubicShift = 11;
+
+/** Fraction bits of the area weights, rounded per pass so the taps of a channel sum in 32 bits */
+static const int kAreaShift = 12;
+
+/** Most taps of the area sampler along one axis: footprints are clamped to kAreaTaps - 1 source pixels */
+static const int kAreaTaps = 32;
+
+/** @brief Source of one row of samples */
+struct WarpSource {
+    const uint8_t*  data;
+    size_t          stride;
+    int             width;
+    int             height;
+    int             right;      // bytes to the next pixel of the bilinear pairs: 4, 0 when the source is 1 pixel wide
+    size_t          down;       // bytes to the next row of the bilinear pairs: stride, 0 when the source is 1 row high
+};
+
+/** @brief Sampler kernels of one instruction set, on BGRA8 */
+struct WarpKernels {
+    /**
+     Bilinear samples at `xs`, `ys`, in 1 << kWarpShift units of the source pixel centers. Coordinates are clamped so
+     the pairs stay in the source: [0, (width - 1) << kWarpShift) and the same for y. Weights are Q8, rounded per pass.
+     */
+    void (*bilinearRow)(const WarpSource& source, const int32_t* xs, const int32_t* ys, int count, uint8_t* destination);
+
+    /**
+     Catmull-Rom samples at `xs`, `ys`, clamped to [0, (width - 1) << kWarpShift]. Taps past the borders replicate them.
+     `weights` holds the 4 taps of each of the kCubicPhases phases, in 1 << kCubicShift units.
+     */
+    void (*bicubicRow)(const WarpSource& source, const int32_t* xs, const int32_t* ys, int count, const int16_t (*weights)[4], uint8_t* destination);
+
+    /**
+     Box filter samples: the average of the `fxs` x `fys` source pixels centered on `xs`, `ys`, weighted by their coverage
+     (`areaTaps`). Coordinates are clamped to [0, (width - 1) << kWarpShift], footprints to [1, kAreaTaps - 1] << kWarpShift.
+     */
+    void (*areaRow)(const WarpSource& source, const int32_t* xs, const int32_t* ys, const int32_t* fxs, const int32_t* fys, int count, uint8_t* destination);
+};
+
+/** @return The kernels of `level`, nullptr when the level is not compiled in or not supported by the CPU */
+const WarpKernels* warpKernels(SimdLevel level);
+
+const WarpKernels* warpKernelsScalar();
+const WarpKernels* warpKernelsSSE41();
+const WarpKernels* warpKernelsAVX2();
+const WarpKernels* warpKernelsNEON();
+
+/** @return The Catmull-Rom weights of the kCubicPhases phases, each set summing to 1 << kCubicShift */
+const int16_t (*cubicWeights())[4];
+
+/** @return The source bytes of bicubic tap column `x`, row `y`, replicating the borders */
+inline const uint8_t* cubicTap(const WarpSource& source, int x, int y) {
+    x = x < 0 ? 0 : x >= source.width  ? source.width - 1  : x;
+    y = y < 0 ? 0 : y >= source.height ? source.height - 1 : y;
+    return source.data + static_cast<size_t>(y) * source.stride + 4 * static_cast<size_t>(x);
+}
+
+/**
+ @brief The 4 taps of bicubic tap row `y` around column `x0` as 16 contiguous bytes.
+ @return A pointer into the source when the 4 taps are inside it, else `spare` filled with the replicated ones
+ */
+inline const uint8_t* cubicTaps(const WarpSource& source, int x0, int y, uint32_t spare[4]) {
+    if (x0 >= 1 && x0 + 2 < source.width) return cubicTap(source, x0 - 1, y);
+    for (int i = 0; i < 4; i++) {
+        const uint8_t* tap = cubicTap(source, x0 - 1 + i, y);
+        spare[i] = static_cast<uint32_t>(tap[0]) | static_cast<uint32_t>(tap[1]) << 8 | static_cast<uint32_t>(tap[2]) << 16 | static_cast<uint32_t>(tap[3]) << 24;
+    }
+    return reinterpret_cast<const uint8_t*>(spare);
+}
+
+/**
+ @brief Weights of the box filter along one axis: the `footprint` wide span centered on `center`, clipped to the `size` source pixels.
+ @discussion `center` and `footprint` are in 1 << kWarpShift units, clamped like the arguments of `areaRow`. Each weight is the part of
+ the span covering a pixel, the largest one takes the rounding error so they sum to 1 << kAreaShift. A span of one pixel gives the
+ bilinear weights. At least 4 weights are set, zero past the span: spans of up to 4 pixels, the common case, are sampled with 4 taps
+ like the bicubic ones, without a branch on their count.
+ @return The number of pixels covered, from `first`, at most kAreaTaps
+ */
+inline int areaTaps(int32_t center, int32_t footprint, int size, int& first, int16_t weights[kAreaTaps]) {
+    // Pixel k covers [k, k + 1) << kWarpShift: its center is at k + 1/2 in these edge coordinates
+    const int32_t one   = 1 << kWarpShift;
+    const int32_t start = center + one / 2 - footprint / 2;
+    const int32_t left  = std::max(start, 0);
+    const int32_t right = std::min(start + footprint, size << kWarpShift);
+    first = left >> kWarpShift;
+    const int count = ((right - 1) >> kWarpShift) - first + 1;
+    // One division per span: the coverages are scaled by a 32 bit fraction of its reciprocal
+    const int64_t reciprocal = (int64_t(1) << (kAreaShift + 32)) / (right - left);
+    auto weight = [&](int k) {
+        const int32_t pixel    = (first + k) << kWarpShift;
+        const int32_t coverage = std::max(std::min(right, pixel + one) - std::max(left, pixel), 0);
+        return static_cast<int>((coverage * reciprocal + (int64_t(1) << 31)) >> 32);
+    };
+
+    if (count <= 4) {
+        int w[4] = { weight(0), weight(1), weight(2), weight(3) };
+        const int a = w[1] > w[0] ? 1 : 0, b = w[3] > w[2] ? 3 : 2;
+        const int largest = w[b] > w[a] ? b : a;
+        w[largest] += (1 << kAreaShift) - (w[0] + w[1] + w[2] + w[3]);
+        for (int k = 0; k < 4; k++) weights[k] = static_cast<int16_t>(w[k]);
+        return count;
+    }
+    int sum = 0, largest = 0;
+    for (int k = 0; k < count; k++) {
+        weights[k] = static_cast<int16_t>(weight(k));
+        sum += weights[k];
+        largest = weights[k] > weights[largest] ? k : largest;
+    }
+    weights[largest] = static_cast<int16_t>(weights[largest] + (1 << kAreaShift) - sum);
+    return count;
+}
+
+} // namespace detail
+} // namespace irl
+
+#endif /* IRL_WARP_KERNELS_HPP */
@@ -0,0 +1,99 @@
+//
+//  IRLWhiteBalance.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLWhiteBalance.hpp"
+#include "IRLHomography.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace irl {
+
+/** Samples of one luma value: their count and the sums of their channels */
+struct WhiteBin {
+    uint32_t count, blue, green, red;
+};
+
+static const int kHistograms = 4;
+
+static double decodeSRGB(double v) {
+    return v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4);
+}
+
+PaperWhite estimatePaperWhite(const ImageView& source, const Quad& quad, const WhiteBalanceOptions& options) {
+    PaperWhite result;
+    if (source.isEmpty() || source.format != PixelFormat::BGRA8) return result;
+
+    // Neighbouring samples of a page mostly land in the same bin: spreading them over a few histograms
+    // keeps consecutive increments independent instead of waiting on one another
+    WhiteBin bins[kHistograms][256];
+    std::memset(bins, 0, sizeof(bins));
+
+    const int        grid = std::min(std::max(options.grid, 2), 1024);
+    const Homography H    = Homography::rectangleToQuad(grid, grid, quad);
+    const int        maxX = source.width - 1, maxY = source.height - 1;
+    for (int gy = 0; gy < grid; gy++) {
+        for (int gx = 0; gx < grid; gx++) {
+            const Point p = H.map(Point(gx + 0.5f, gy + 0.5f));
+            const int   x = std::min(std::max(static_cast<int>(p.x), 0), maxX);
+            const int   y = std::min(std::max(static_cast<int>(p.y), 0), maxY);
+            const uint8_t* pixel = source.row(y) + 4 * x;
+
+            // BT.601 like convertToLuma
+            WhiteBin& bin = bins[gx & (kHistograms - 1)][(29 * pixel[0] + 150 * pixel[1] + 77 * pixel[2] + 128) >> 8];
+            bin.count++;
+            bin.blue  += pixel[0];
+            bin.green += pixel[1];
+            bin.red   += pixel[2];
+        }
+    }
+
+    // Down from white: skip the highlights, then average the paper
+    const double total   = static_cast<double>(grid) * grid;
+    const double clipped = std::floor(total * std::min(std::max(options.clipFraction, 0.0f), 1.0f));
+    const double wanted  = std::max(1.0, std::floor(total * std::min(std::max(options.paperFraction, 0.0f), 1.0f)));
+    double skipped = 0.0, count = 0.0, sums[3] = { 0.0, 0.0, 0.0 };
+    int    lowest  = 255;
+    for (int v = 255; v >= 0 && count < wanted; v--) {
+        for (int h = 0; h < kHistograms; h++) {
+            const WhiteBin& bin = bins[h][v];
+            double taken = bin.count;
+            if (skipped < clipped) {
+                const double skip = std::min(taken, clipped - skipped);
+                skipped += skip;
+                taken   -= skip;
+            }
+            taken = std::min(taken, wanted - count);
+            if (taken <= 0.0) continue;
+
+            // A partly taken bin contributes its mean color
+            const double share = taken / bin.count;
+            sums[0] += bin.blue * share;
+            sums[1] += bin.green * share;
+            sums[2] += bin.red * share;
+            count   += taken;
+            lowest   = v;
+        }
+    }
+    if (count < wanted || lowest < options.minimumLuma) return result;
+
+    double linear[3], brightest = 0.0;
+    for (int c = 0; c < 3; c++) {
+        result.color[c] = static_cast<float>(sums[c] / count);
+        linear[c] = decodeSRGB(sums[c] / count / 255.0);
+        brightest = std::max(brightest, linear[c]);
+    }
+    const double maximum = std::max(static_cast<double>(options.maximumGain), 1.0);
+    for (int c = 0; c < 3; c++) {
+        result.gains[c] = static_cast<float>(std::min(brightest / std::max(linear[c], 1e-6), maximum));
+    }
+    result.valid = true;
+    return result;
+}
+
+} // namespace irl
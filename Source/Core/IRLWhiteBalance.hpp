@@ -0,0 +1,63 @@
+//
+//  IRLWhiteBalance.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Paper white estimation, to take the color cast of yellow or tungsten light off a page.
+//
+//  The page is sampled on a fixed grid through the perspective of its quad, so the estimate
+//  costs the same whatever the photo size and never needs the rectified page. The samples go
+//  into a luma histogram that also sums their channels: walking it down from white gives the
+//  mean color of the brightest part of the page, which is the paper on a document. The gains
+//  bring that color to gray, in linear light, and are applied by `ColorControls` in the same
+//  pass as the other point filters.
+//
+
+#ifndef IRL_WHITE_BALANCE_HPP
+#define IRL_WHITE_BALANCE_HPP
+
+#include "IRLImage.hpp"
+#include "IRLQuad.hpp"
+
+namespace irl {
+
+/** @brief Tuning of `estimatePaperWhite` */
+struct WhiteBalanceOptions {
+    /** Samples per side of the page: 128 reads 16K pixels. */
+    int     grid            = 128;
+
+    /** Brightest share of the samples skipped first: specular highlights and clipped pixels. */
+    float   clipFraction    = 0.005f;
+
+    /** Share of the samples, below the clipped ones, averaged as the paper. */
+    float   paperFraction   = 0.15f;
+
+    /** Largest gain of a channel, in linear light, so a colored page is not turned gray. */
+    float   maximumGain     = 3.0f;
+
+    /** Papers darker than this (encoded luma) are left as they are: not enough light to tell the cast. */
+    int     minimumLuma     = 40;
+};
+
+/** @brief Estimated paper color and the gains neutralizing it */
+struct PaperWhite {
+    /** Mean blue, green and red of the paper samples, encoded */
+    float   color[3]    = { 0.0f, 0.0f, 0.0f };
+
+    /** Blue, green and red gains on linear values, for `ColorControlsOptions::gains`. 1 when nothing was estimated. */
+    float   gains[3]    = { 1.0f, 1.0f, 1.0f };
+
+    /** false when the page is too small or too dark, the gains are then 1 */
+    bool    valid       = false;
+};
+
+/**
+ @brief Estimate the paper white of the page of `quad` in `source`, BGRA8.
+ @discussion The brightest channel of the paper keeps its level, the two others are raised to it.
+ */
+PaperWhite estimatePaperWhite(const ImageView& source, const Quad& quad, const WhiteBalanceOptions& options = WhiteBalanceOptions());
+
+} // namespace irl
+
+#endif /* IRL_WHITE_BALANCE_HPP */
@@ -0,0 +1,20 @@
+//
+//  CIImage+ToneCurve.h
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+@import CoreImage;
+
+/** @brief Color maps built from the tone curves of the native core (Source/Core/IRLToneCurve.hpp) */
+@interface CIImage (ToneCurve)
+
+/**
+ @brief The 256x1 gradient of the Ultra Contrast view, for `CIColorMap`.
+ @discussion The curve is computed by the compiler for the default threshold (0.3), at runtime otherwise. No drawing is involved.
+ @param threshold A float from 0 to 1, the fraction of the input range mapped to black
+ @return a CIImage
+ */
++ (CIImage * _Nonnull)ultraContrastColorMapWithThreshold:(CGFloat)threshold;
+
+@end
@@ -0,0 +1,30 @@
+//
+//  CIImage+ToneCurve.mm
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#import "CIImage+ToneCurve.h"
+
+#include "IRLToneCurve.hpp"
+
+@implementation CIImage (ToneCurve)
+
++ (CIImage *)ultraContrastColorMapWithThreshold:(CGFloat)threshold {
+    const irl::ToneCurve curve = threshold == 0.3 ? irl::kUltraContrastCurve : irl::ultraContrastCurve(threshold);
+
+    NSMutableData *pixels = [NSMutableData dataWithLength:256 * 4];
+    uint8_t *bytes = (uint8_t *)pixels.mutableBytes;
+    for (int x = 0; x < 256; x++) {
+        bytes[4 * x + 0] = bytes[4 * x + 1] = bytes[4 * x + 2] = curve[x];
+        bytes[4 * x + 3] = 255;
+    }
+
+    // Same color space as the UIKit bitmap the gradient used to be drawn in
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateWithName(kCGColorSpaceSRGB);
+    CIImage *image = [CIImage imageWithBitmapData:pixels bytesPerRow:256 * 4 size:CGSizeMake(256, 1) format:kCIFormatBGRA8 colorSpace:colorSpace];
+    CGColorSpaceRelease(colorSpace);
+    return image;
+}
+
+@end
@@ -31,8 +31,8 @@
 /** @brief Extending CIImage to provide some feature  */
 @interface CIImage (Utilities)
 
-/** @brief Image fradient
- @param threshold A float from 0 to 100 definining the gradient threshold
+/** @brief Image gradient, same as `+ultraContrastColorMapWithThreshold:`
+ @param threshold A float from 0 to 1 definining the gradient threshold
  @return a CIImage
  */
 + (CIImage * _Nonnull)imageGradientImage:(CGFloat)threshold;
@@ -54,10 +54,14 @@
  */
 - (CIImage * _Nonnull)filteredImageUsingUltraContrastWithGradient:(CIImage * _Nonnull)gradient ;
 /**
+ @brief CIColorControls, contrast 1.14 and saturation 0.
+ @discussion Kept for the preview: CoreImage runs it in the GPU program that draws the frame, where the CPU engine
+ (Source/Core/IRLColorControls.hpp) would add a pass over the frame and a texture upload. The stills use the engine.
  @return Filtered CIImage using Enhance
  */
 - (CIImage * _Nonnull)filteredImageUsingEnhanceFilter ;
 /**
+ @brief CIColorControls, contrast 1.1. Kept for the preview, see `-filteredImageUsingEnhanceFilter`.
  @return Filtered CIImage using Contrast
  */
 - (CIImage * _Nonnull)filteredImageUsingContrastFilter ;
@@ -69,6 +73,7 @@
 - (CIImage * _Nonnull)cropBordersWithMargin:(CGFloat)margin;
 
 /**
+ @discussion The image is rendered and rectified right away by `IRLNativeWarper`. Images without a finite extent go through `CIPerspectiveCorrection`.
  @param rectangleFeature A `IRLRectangleFeatureProtocol` feature
  @return Cropped Corrected CIImage image
  */
@@ -98,8 +103,8 @@
 
 @end
 
-/** @brief Extending CIFeature*/
-@interface IRLRectangleFeature : CIFeature <IRLRectangleFeatureProtocol>
+/** @brief Rectangle feature we can build ourself (e.g. from the native detector). Being a CIRectangleFeature it works with all the CIRectangleFeature helpers.  */
+@interface IRLRectangleFeature : CIRectangleFeature <IRLRectangleFeatureProtocol>
 /** @return Top Left corner of rectangle Feature  */
 @property (readwrite) CGPoint topLeft;
 /** @return Top Right corner of rectangle Feature  */
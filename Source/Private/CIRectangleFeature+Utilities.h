@@ -29,6 +29,8 @@
 /**
  @brief Helper method to extract the buggest detected rectangel
  
+ @discussion Only the top and left sides are compared, which favors skewed or oversized false positives. The camera view selects with `-[IRLNativeDetector bestFeatureInFeatures:extent:pixelBuffer:previous:]` instead.
+ 
  @param rectangles Array of CIRectangleFeature
  @return the Biggest CIRectangleFeature
  */
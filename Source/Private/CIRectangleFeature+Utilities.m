@@ -62,6 +62,21 @@
 
 @implementation CIRectangleFeature (Utilities)
 
+// Closed polygon of the corners on the stack: the getters below run on every preview frame
+static void closedCorners(CIRectangleFeature *feature, CGPoint points[5]) {
+    points[0] = feature.topLeft;
+    points[1] = feature.topRight;
+    points[2] = feature.bottomRight;
+    points[3] = feature.bottomLeft;
+    points[4] = feature.topLeft;
+}
+
+static CGFloat polygonArea(const CGPoint points[5]) {
+    CGFloat area = 0;
+    for (NSUInteger i = 0; i < 4; i++) area += points[i].x * points[i + 1].y - points[i + 1].x * points[i].y;
+    return area / 2.0f;
+}
+
 #pragma mark - Private Getter
 
 - (NSArray*)allPoints {
@@ -77,12 +92,24 @@
 #pragma mark - Getters
 
 - (CGFloat)signedArea  {
-    return [CIRectangleFeature polygoneArea:[self allPoints]];
-    
+    CGPoint points[5];
+    closedCorners(self, points);
+    return polygonArea(points);
 }
 
 - (CGPoint)centroid {
-    return [CIRectangleFeature centroid:[self allPoints]];
+    CGPoint points[5];
+    closedCorners(self, points);
+    
+    CGFloat area = polygonArea(points);
+    CGFloat Cx   = 0;            // Accumulates X
+    CGFloat Cy   = 0;            // Accumulates Y
+    for (NSUInteger i = 0; i < 4; i++) {
+        CGFloat cross = points[i].x * points[i + 1].y - points[i + 1].x * points[i].y;
+        Cx += (points[i].x + points[i + 1].x) * cross;
+        Cy += (points[i].y + points[i + 1].y) * cross;
+    }
+    return CGPointMake(Cx / (6.0f * area), Cy / (6.0f * area));
 }
 
 - (CGPoint)computedCenter {
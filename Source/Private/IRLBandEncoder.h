@@ -0,0 +1,29 @@
+//
+//  IRLBandEncoder.h
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+@import Foundation;
+@import CoreGraphics;
+
+/**
+ @brief Renders the `rows` rows of the page from row `top` into `band`, `rowBytes` apart.
+ */
+typedef void (^IRLBandRenderer)(int top, int rows, uint8_t * _Nonnull band, size_t rowBytes);
+
+/**
+ @brief Encode a page to JPEG while it is rendered, `bandRows` rows at a time.
+ 
+ @discussion ImageIO pulls the rows in order while it compresses them: the page is never whole in memory, only one band of it.
+ 
+ @param width       Pixels of a page row
+ @param height      Rows of the page
+ @param gray        YES for a Gray8 page, NO for a BGRA page, its alpha ignored
+ @param bandRows    Rows rendered by each call of `render`
+ @param quality     The `kCGImageDestinationLossyCompressionQuality`, from 0 to 1
+ @param render      Called for the bands in order, again from the top if the encoder rewinds
+ 
+ @return The JPEG file, or nil when the page is empty or the encoder failed
+ */
+FOUNDATION_EXTERN NSData * _Nullable IRLJPEGDataWithBands(int width, int height, BOOL gray, int bandRows, CGFloat quality, IRLBandRenderer _Nonnull render);
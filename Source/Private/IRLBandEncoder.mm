@@ -0,0 +1,89 @@
+//
+//  IRLBandEncoder.mm
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#import "IRLBandEncoder.h"
+
+#import <ImageIO/ImageIO.h>
+
+#include <algorithm>
+#include <vector>
+
+// Rows of the page rendered a band at a time, as the encoder asks for their bytes
+struct PageStream {
+    IRLBandRenderer         render;
+    size_t                  rowBytes = 0;
+    int                     height   = 0;
+    int                     bandRows = 0;
+    std::vector<uint8_t>    band;
+    int                     top      = 0;   // first page row in `band`
+    int                     rows     = 0;   // page rows in `band`
+    size_t                  offset   = 0;   // next byte of the page to read
+};
+
+static size_t readPageBytes(void *info, void *buffer, size_t count) {
+    PageStream *stream = (PageStream *)info;
+    const size_t total = stream->rowBytes * (size_t)stream->height;
+    size_t copied = 0;
+    while (copied < count && stream->offset < total) {
+        const int row = (int)(stream->offset / stream->rowBytes);
+        if (row < stream->top || row >= stream->top + stream->rows) {
+            stream->top  = row;
+            stream->rows = std::min(stream->bandRows, stream->height - row);
+            stream->render(row, stream->rows, stream->band.data(), stream->rowBytes);
+        }
+        const size_t start  = stream->offset - stream->rowBytes * (size_t)stream->top;
+        const size_t length = std::min(count - copied, stream->rowBytes * (size_t)stream->rows - start);
+        memcpy((uint8_t *)buffer + copied, stream->band.data() + start, length);
+        copied         += length;
+        stream->offset += length;
+    }
+    return copied;
+}
+
+static off_t skipPageBytes(void *info, off_t count) {
+    PageStream *stream = (PageStream *)info;
+    const size_t total = stream->rowBytes * (size_t)stream->height;
+    const size_t skip  = std::min((size_t)std::max(count, (off_t)0), total - stream->offset);
+    stream->offset += skip;
+    return (off_t)skip;
+}
+
+static void rewindPage(void *info) {
+    ((PageStream *)info)->offset = 0;
+}
+
+NSData *IRLJPEGDataWithBands(int width, int height, BOOL gray, int bandRows, CGFloat quality, IRLBandRenderer render) {
+    if (width <= 0 || height <= 0 || !render) return nil;
+
+    PageStream stream;
+    stream.render   = render;
+    stream.rowBytes = (gray ? 1 : 4) * (size_t)width;
+    stream.height   = height;
+    stream.bandRows = std::max(std::min(bandRows, height), 1);
+    stream.band.resize(stream.rowBytes * (size_t)stream.bandRows);
+
+    const CGDataProviderSequentialCallbacks callbacks = { 0, readPageBytes, skipPageBytes, rewindPage, NULL };
+    CGDataProviderRef provider = CGDataProviderCreateSequential(&stream, &callbacks);
+    CGColorSpaceRef   space    = gray ? CGColorSpaceCreateDeviceGray() : CGColorSpaceCreateDeviceRGB();
+    CGBitmapInfo      info     = gray ? (CGBitmapInfo)kCGImageAlphaNone : (CGBitmapInfo)(kCGBitmapByteOrder32Little | kCGImageAlphaNoneSkipFirst);
+    CGImageRef        page     = CGImageCreate(width, height, 8, gray ? 8 : 32, stream.rowBytes, space, info, provider, NULL, false,
+                                               kCGRenderingIntentDefault);
+    CGColorSpaceRelease(space);
+    CGDataProviderRelease(provider);
+    if (!page) return nil;
+
+    NSMutableData *data = [NSMutableData data];
+    CGImageDestinationRef destination = CGImageDestinationCreateWithData((__bridge CFMutableDataRef)data, CFSTR("public.jpeg"), 1, NULL);
+    BOOL finalized = NO;
+    if (destination) {
+        NSDictionary *properties = @{ (__bridge NSString *)kCGImageDestinationLossyCompressionQuality: @(quality) };
+        CGImageDestinationAddImage(destination, page, (__bridge CFDictionaryRef)properties);
+        finalized = CGImageDestinationFinalize(destination);
+        CFRelease(destination);
+    }
+    CGImageRelease(page);
+    return finalized ? data : nil;
+}
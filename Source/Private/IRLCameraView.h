@@ -50,6 +50,26 @@
  */
 @property (nonatomic, readonly)     NSUInteger      maximumConfidenceForFullDetection;  // Default 100
 
+/**
+ @return detectionBudget Average time, in seconds, that rectangle detection and tracking may take per preview frame. Detections are spaced out to stay within it, and back off while the scene is static and confident. Default 0.008
+ */
+@property (nonatomic, assign)       NSTimeInterval  detectionBudget;
+
+/**
+ @return logsDetectionDecisions When YES, each frame logs whether it was detected or tracked, why, and the measured latencies. Default NO
+ */
+@property (nonatomic, assign)       BOOL            logsDetectionDecisions;
+
+/**
+ @return detectionFrames Number of preview frames a rectangle detection ran on. Tracked frames in between are not counted.
+ */
+@property (nonatomic, readonly)     NSUInteger      detectionFrames;
+
+/**
+ @return bandDetectionFrames Number of `detectionFrames` served by a re-detection around the previous rectangle instead of a full frame detection
+ */
+@property (nonatomic, readonly)     NSUInteger      bandDetectionFrames;
+
 /**
  @return The color use for overlay. Default is [UIColor red]
  */
@@ -80,9 +100,15 @@
 
 /**
  @return detectorType The  Detector Type we use for detecting the document edges. Default: IRLScannerDetectorTypeAccuracy
+ @discussion Only the native types follow the rectangle between detections with the corner tracker and search around it in bands, the CoreImage ones get every rectangle from `CIDetector`.
  */
 @property (nonatomic,assign)    IRLScannerDetectorType               detectorType;
 
+/**
+ @return pageDPI Resolution of the captured page in dots per inch of the paper. The photo is rectified straight to it with an area filter, instead of at its own resolution. 0 keeps the resolution of the photo. Default 0
+ */
+@property (nonatomic,assign)    CGFloat                              pageDPI;
+
 /**
  @return enableDrawCenter Will draw a rectangle in the center
  */
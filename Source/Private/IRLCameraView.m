@@ -8,6 +8,11 @@
 #import "IRLCameraView.h"
 #import "CIRectangleFeature+Utilities.h"
 #import "CIImage+Utilities.h"
+#import "IRLNativeBinarizer.h"
+#import "IRLNativeDetector.h"
+#import "IRLNativeFlattener.h"
+#import "IRLNativePageRenderer.h"
+#import "IRLNativeWarper.h"
 #import <ImageIO/ImageIO.h>
 
 @interface IRLCameraView () <AVCaptureVideoDataOutputSampleBufferDelegate> {
@@ -17,8 +22,6 @@
 
     BOOL                    _isStopped;
     
-    NSTimer*                _borderDetectTimeKeeper;
-    BOOL                    _borderDetectFrame;
     CIRectangleFeature*     _borderDetectLastRectangleFeature;
     BOOL                    _FocusCurrentRectangleDone;
 
@@ -37,13 +40,20 @@
 
 @property (nonatomic, assign)       BOOL                            forceStop;
 @property (nonatomic, strong)       CIImage*                        gradient;
+@property (nonatomic, strong)       IRLNativeDetector*              nativeDetector;
+@property (nonatomic, strong)       IRLNativeBinarizer*             nativeBinarizer;
+@property (nonatomic, strong)       IRLNativeFlattener*             nativeFlattener;
+@property (nonatomic, strong)       IRLNativePageRenderer*          nativePageRenderer;
 
-@property (nonatomic, strong)       CIImage*                        latestCorrectedImage;
+@property (nonatomic, strong)       CIImage*                        latestFrameImage;     // Rectified on demand by -latestCorrectedUIImage
+@property (nonatomic, strong)       CIRectangleFeature*             latestFrameFeature;
 @property (nonatomic, readwrite)    NSUInteger                      maximumConfidenceForFullDetection;  // Default 100
 @property (readwrite, strong)       UIImageView* transitionSnapsot;
 
 @property (atomic, readwrite)       GLKView*                        glkView;
 @property (nonatomic, readwrite)    CGFloat                         imageDedectionConfidence;
+@property (nonatomic, readwrite)    NSUInteger                      detectionFrames;
+@property (nonatomic, readwrite)    NSUInteger                      bandDetectionFrames;
 
 
 @end
@@ -57,6 +67,13 @@ BOOL rectangleDetectionConfidenceHighEnough(float confidence) {
     return (confidence > 1.0);
 }
 
+// Sensor gain of a still, from its EXIF attachment. High gains are low light: the photo is grainy.
+BOOL isLowLightStill(CMSampleBufferRef sampleBuffer) {
+    CFDictionaryRef exif = CMGetAttachment(sampleBuffer, kCGImagePropertyExifDictionary, NULL);
+    NSArray *isoSpeeds = exif ? ((__bridge NSDictionary *)exif)[(__bridge NSString *)kCGImagePropertyExifISOSpeedRatings] : nil;
+    return [isoSpeeds.firstObject integerValue] >= 400;
+}
+
 - (AVCaptureVideoOrientation) videoOrientationFromCurrentDeviceOrientation {
     switch ([[UIApplication sharedApplication] statusBarOrientation]) {
         case UIInterfaceOrientationPortrait:            return AVCaptureVideoOrientationPortrait;
@@ -80,9 +97,32 @@ UIImageOrientation imageOrientationForCurrentDeviceOrientation() {
     return UIImageOrientationUp;
 }
 
+// Rendered by CoreImage a band of rows at a time into the bitmap of the page: CoreImage never holds the page whole besides it
 UIImage* makeUIImageFromCIImage(CIImage *ciImage) {
     CIContext *context = [CIContext contextWithOptions:nil];
-    CGImageRef cgImage = [context createCGImage:ciImage fromRect:[ciImage extent]];
+    CGRect extent = CGRectIntegral(ciImage.extent);
+    if (CGRectIsEmpty(extent) || CGRectIsInfinite(extent)) return nil;
+    
+    const int    width    = (int)CGRectGetWidth(extent);
+    const int    height   = (int)CGRectGetHeight(extent);
+    const size_t rowBytes = 4 * (size_t)width;
+    const int    bandRows = (int)MAX((4 << 20) / rowBytes, (size_t)1);
+    NSMutableData *pixels = [NSMutableData dataWithLength:rowBytes * (size_t)height];
+    if (!pixels) return nil;
+    
+    CGColorSpaceRef rgb = CGColorSpaceCreateDeviceRGB();
+    for (int top = 0; top < height; top += bandRows) {
+        // Bitmaps are y down, the first rows of the page are the top of the extent
+        const int rows = MIN(bandRows, height - top);
+        CGRect bounds = CGRectMake(CGRectGetMinX(extent), CGRectGetMaxY(extent) - top - rows, width, rows);
+        [context render:ciImage toBitmap:(uint8_t *)pixels.mutableBytes + rowBytes * (size_t)top rowBytes:rowBytes bounds:bounds format:kCIFormatBGRA8 colorSpace:rgb];
+    }
+    
+    CGDataProviderRef provider = CGDataProviderCreateWithCFData((__bridge CFDataRef)pixels);
+    CGImageRef cgImage = CGImageCreate(width, height, 8, 32, rowBytes, rgb, (CGBitmapInfo)(kCGBitmapByteOrder32Little | kCGImageAlphaPremultipliedFirst),
+                                       provider, NULL, false, kCGRenderingIntentDefault);
+    CGDataProviderRelease(provider);
+    CGColorSpaceRelease(rgb);
     
     UIImage* uiImage = [UIImage imageWithCGImage:cgImage];
     CGImageRelease(cgImage);
@@ -254,7 +294,8 @@ CGImagePropertyOrientation imagePropertyOrientationForUIImageOrientation(UIImage
     // Add Video Sample Buffer Output
     AVCaptureVideoDataOutput *dataOutput = [[AVCaptureVideoDataOutput alloc] init];
     [dataOutput setAlwaysDiscardsLateVideoFrames:YES];
-    [dataOutput setVideoSettings:@{(id)kCVPixelBufferPixelFormatTypeKey:@(kCVPixelFormatType_32BGRA)}];
+    // Bi-planar frames: detection reads the Y plane as is, CoreImage converts to RGB on the GPU for the preview only
+    [dataOutput setVideoSettings:@{(id)kCVPixelBufferPixelFormatTypeKey:@(kCVPixelFormatType_420YpCbCr8BiPlanarFullRange)}];
     
     dispatch_queue_t queue = dispatch_queue_create("ScanSampleBufferQueue", NULL);
     [dataOutput setSampleBufferDelegate:self queue:queue];
@@ -288,6 +329,10 @@ CGImagePropertyOrientation imagePropertyOrientationForUIImageOrientation(UIImage
     
     [session commitConfiguration];
     
+    // Pages are sized for the paper they show, which is better known with the angle of view of the camera
+    [IRLNativeWarper sharedWarper].fieldOfView = device.activeFormat.videoFieldOfView;
+    self.nativePageRenderer.fieldOfView = device.activeFormat.videoFieldOfView;
+    
     [self setCaptureSession: session];
 }
 
@@ -305,8 +350,6 @@ CGImagePropertyOrientation imagePropertyOrientationForUIImageOrientation(UIImage
     
     [self.captureSession startRunning];
     
-    _borderDetectTimeKeeper = [NSTimer scheduledTimerWithTimeInterval:0.5f target:self selector:@selector(enableBorderDetectFrame) userInfo:nil repeats:YES];
-    
     [self hideGLKView:NO completion:nil];
 }
 
@@ -315,7 +358,9 @@ CGImagePropertyOrientation imagePropertyOrientationForUIImageOrientation(UIImage
     
     [self.captureSession stopRunning];
     
-    [_borderDetectTimeKeeper invalidate];
+    // Frames of the next session have nothing to do with the tracked rectangle
+    [self.nativeDetector stopTracking];
+    _borderDetectLastRectangleFeature = nil;
     
     [self hideGLKView:YES completion:nil];
 }
@@ -412,37 +457,76 @@ CGImagePropertyOrientation imagePropertyOrientationForUIImageOrientation(UIImage
                 enhancedImage = [enhancedImage imageByApplyingOrientation:imagePropertyOrientationForUIImageOrientation(imageOrientationForCurrentDeviceOrientation())];
             }
             
+            // The native renderer filters, rectifies and crops in one pass over the final page, from the unfiltered photo.
+            // The binarized page is rendered as luma straight into the binarizer.
+            BOOL binarized   = weakSelf.cameraViewType == IRLScannerViewTypeBinarized;
+            BOOL fusedRender = isiOS10OrLater && ([IRLNativePageRenderer supportsViewType:weakSelf.cameraViewType] || binarized);
+            
             // perform any filters
-            switch (self.cameraViewType) {
-                case IRLScannerViewTypeBlackAndWhite:
-                    enhancedImage = [enhancedImage filteredImageUsingEnhanceFilter];
-                    break;
-                case IRLScannerViewTypeNormal:
-                    enhancedImage = [enhancedImage filteredImageUsingContrastFilter];
-                    break;
-                case IRLScannerViewTypeUltraContrast:
-                    enhancedImage = [enhancedImage filteredImageUsingUltraContrastWithGradient:weakSelf.gradient];
-                    break;
-                default:
-                    break;
+            if (!fusedRender) {
+                switch (self.cameraViewType) {
+                    case IRLScannerViewTypeBlackAndWhite:
+                        enhancedImage = [enhancedImage filteredImageUsingEnhanceFilter];
+                        break;
+                    case IRLScannerViewTypeNormal:
+                        enhancedImage = [enhancedImage filteredImageUsingContrastFilter];
+                        break;
+                    case IRLScannerViewTypeUltraContrast:
+                        enhancedImage = [enhancedImage filteredImageUsingUltraContrastWithGradient:weakSelf.gradient];
+                        break;
+                    case IRLScannerViewTypeBinarized:
+                    case IRLScannerViewTypeShadowRemoval:
+                        // Thresholds and background are computed on the rectified page below
+                        break;
+                    default:
+                        break;
+                }
             }
             
             // crop and correct perspective
+            CIRectangleFeature *rectangleFeature = nil;
             if (rectangleDetectionConfidenceHighEnough(weakSelf.imageDedectionConfidence)) {
-                 CIRectangleFeature *rectangleFeature = [CIRectangleFeature biggestRectangleInRectangles:(NSArray<CIRectangleFeature*>*)[[weakSelf detector] featuresInImage:enhancedImage]];
+                 rectangleFeature = [weakSelf bestRectangleInImage:enhancedImage pixelBuffer:NULL previous:nil];
                  
                  if (rectangleFeature) {
-                     enhancedImage = [enhancedImage correctPerspectiveWithFeatures:rectangleFeature];
+                     // Detected corners are a few pixels off on a full resolution still, which shows as slanted text once rectified
+                     rectangleFeature = [weakSelf.nativeDetector refinedFeature:rectangleFeature inImage:enhancedImage context:nil];
                  }
             }
             
-            enhancedImage = [enhancedImage cropBordersWithMargin:40.0f];
-
-            if (isiOS10OrLater) {
-                finalImage = makeUIImageFromCIImage(enhancedImage);
+            if (fusedRender) {
+                // Torch and low light stills are grainy, which costs sharpness and JPEG bytes
+                weakSelf.nativePageRenderer.denoise = weakSelf.isTorchEnabled || isLowLightStill(imageSampleBuffer);
+                // The text views are read, not looked at: their strokes get back the edge the resampling took off
+                weakSelf.nativePageRenderer.sharpen = weakSelf.cameraViewType != IRLScannerViewTypeNormal;
+                // A page wanted below the resolution of the photo is sampled at its final size, never at full size first
+                weakSelf.nativePageRenderer.dpi = weakSelf.pageDPI;
+                if (binarized) {
+                    // Binarized as the bands of the page are rendered, the page is never whole in memory
+                    finalImage = [weakSelf.nativePageRenderer bilevelImageWithImage:enhancedImage feature:rectangleFeature margin:40.0f
+                                                                          binarizer:weakSelf.nativeBinarizer context:nil];
+                } else {
+                    // Rendered straight into the bitmap of the returned image, which stays a decoded bitmap for the delegate:
+                    // how and at what quality the page is encoded is up to the app (`-pageJPEGDataWithImage:...` streams it)
+                    finalImage = [weakSelf.nativePageRenderer pageImageWithImage:enhancedImage feature:rectangleFeature viewType:weakSelf.cameraViewType
+                                                                          margin:40.0f context:nil];
+                }
             }
-            else {
-                finalImage = [enhancedImage orientationCorrecterUIImage];
+            
+            if (!finalImage) {
+                [IRLNativeWarper sharedWarper].dpi = weakSelf.pageDPI;
+                if (rectangleFeature) enhancedImage = [enhancedImage correctPerspectiveWithFeatures:rectangleFeature];
+                enhancedImage = [enhancedImage cropBordersWithMargin:40.0f];
+                
+                if (isiOS10OrLater) {
+                    if (weakSelf.cameraViewType == IRLScannerViewTypeBinarized) finalImage = [weakSelf.nativeBinarizer bilevelImageWithImage:enhancedImage context:nil];
+                    // Rendered whole: the background of the page is estimated on all of it before it is divided out
+                    if (weakSelf.cameraViewType == IRLScannerViewTypeShadowRemoval) finalImage = [weakSelf.nativeFlattener flattenedImageWithImage:enhancedImage context:nil];
+                    if (!finalImage) finalImage = makeUIImageFromCIImage(enhancedImage);
+                }
+                else {
+                    finalImage = [enhancedImage orientationCorrecterUIImage];
+                }
             }
         }
         else {
@@ -460,10 +544,6 @@ CGImagePropertyOrientation imagePropertyOrientationForUIImageOrientation(UIImage
 #pragma mark -
 #pragma mark Instance Methods Private
 
-- (void)enableBorderDetectFrame {
-    _borderDetectFrame = YES;
-}
-
 - (void)hideGLKView:(BOOL)hidden completion:(void(^)(void))completion {
     __weak typeof(self) weakSelf = self;
     [UIView animateWithDuration:0.1 animations:^{
@@ -561,6 +641,74 @@ CGImagePropertyOrientation imagePropertyOrientationForUIImageOrientation(UIImage
     
 }
 
+- (NSTimeInterval)detectionBudget {
+    return self.nativeDetector.detectionBudget;
+}
+
+- (void)setDetectionBudget:(NSTimeInterval)detectionBudget {
+    self.nativeDetector.detectionBudget = detectionBudget;
+}
+
+- (BOOL)logsDetectionDecisions {
+    return self.nativeDetector.logsDetectionDecisions;
+}
+
+- (void)setLogsDetectionDecisions:(BOOL)logsDetectionDecisions {
+    self.nativeDetector.logsDetectionDecisions = logsDetectionDecisions;
+}
+
+- (IRLNativeBinarizer*)nativeBinarizer {
+    if (!_nativeBinarizer) _nativeBinarizer = [IRLNativeBinarizer new];
+    return _nativeBinarizer;
+}
+
+- (IRLNativeFlattener*)nativeFlattener {
+    if (!_nativeFlattener) _nativeFlattener = [IRLNativeFlattener new];
+    return _nativeFlattener;
+}
+
+- (IRLNativePageRenderer*)nativePageRenderer {
+    if (!_nativePageRenderer) _nativePageRenderer = [IRLNativePageRenderer new];
+    return _nativePageRenderer;
+}
+
+- (IRLNativeDetector*)nativeDetector {
+    if (!_nativeDetector) {
+        _nativeDetector = [IRLNativeDetector new];
+        _nativeDetector.minimumFeatureSize = 0.5f;
+    }
+    return _nativeDetector;
+}
+
+- (BOOL)usesNativeDetector {
+    return self.detectorType != IRLScannerDetectorTypeAccuracy && self.detectorType != IRLScannerDetectorTypePerformance;
+}
+
+- (CIRectangleFeature*)bestRectangleInImage:(CIImage*)image pixelBuffer:(CVPixelBufferRef)pixelBuffer previous:(CIRectangleFeature*)previous {
+    
+    self.nativeDetector.usesLineCandidates = (self.detectorType == IRLScannerDetectorTypeNativeLines);
+    
+    switch (self.detectorType) {
+        case IRLScannerDetectorTypeNativeLines:
+            break;
+        case IRLScannerDetectorTypeNative:                  self.nativeDetector.pyramidLevels = 0;
+            break;
+        case IRLScannerDetectorTypeNativePyramidQuarter:    self.nativeDetector.pyramidLevels = 2;
+            break;
+        case IRLScannerDetectorTypeNativePyramidEighth:     self.nativeDetector.pyramidLevels = 3;
+            break;
+        case IRLScannerDetectorTypeAccuracy:
+        case IRLScannerDetectorTypePerformance:
+        default: {
+            NSArray<CIRectangleFeature*> *rectangles = (NSArray<CIRectangleFeature*>*)[[self detector] featuresInImage:image];
+            return [self.nativeDetector bestFeatureInFeatures:rectangles extent:image.extent pixelBuffer:pixelBuffer previous:previous];
+        }
+    }
+    
+    if (pixelBuffer) return [self.nativeDetector bestFeatureInPixelBuffer:pixelBuffer previous:previous];
+    return [self.nativeDetector bestFeatureInFeatures:[self.nativeDetector featuresInImage:image context:nil] extent:image.extent pixelBuffer:NULL previous:previous];
+}
+
 - (UIColor*)overlayColor {
     if (!_overlayColor) {
         _overlayColor = [UIColor redColor];
@@ -569,7 +717,10 @@ CGImagePropertyOrientation imagePropertyOrientationForUIImageOrientation(UIImage
 }
 
 - (UIImage*)latestCorrectedUIImage {
-    return [self.latestCorrectedImage makeUIImageWithContext:_coreImageContext];
+    CIImage *frame = self.latestFrameImage;
+    CIRectangleFeature *feature = self.latestFrameFeature;
+    if (!frame || !feature) return nil;
+    return [[frame correctPerspectiveWithFeatures:feature] makeUIImageWithContext:_coreImageContext];
 }
 
 #pragma mark -
@@ -595,6 +746,10 @@ CGImagePropertyOrientation imagePropertyOrientationForUIImageOrientation(UIImage
             break;
         case IRLScannerViewTypeUltraContrast:        image = [image filteredImageUsingUltraContrastWithGradient:self.gradient ];
             break;
+        case IRLScannerViewTypeBinarized:            image = [self.nativeBinarizer binarizedImageWithPixelBuffer:pixelBuffer] ?: image;
+            break;
+        case IRLScannerViewTypeShadowRemoval:        image = [self.nativeFlattener flattenedImageWithPixelBuffer:pixelBuffer] ?: image;
+            break;
         default:
             break;
     }
@@ -605,10 +760,29 @@ CGImagePropertyOrientation imagePropertyOrientationForUIImageOrientation(UIImage
         NSUInteger confidence   =  _imageDedectionConfidence;
         confidence = confidence > 100 ? 100 : confidence;
         
-        // Fix the last rectangle detected
-        if (_borderDetectFrame && confidence < self.minimumConfidenceForFullDetection) {
-            _borderDetectLastRectangleFeature = [CIRectangleFeature biggestRectangleInRectangles:(NSArray<CIRectangleFeature*>*)[[self detector] featuresInImage:image]];
-            _borderDetectFrame = NO;
+        // The CoreImage detector types keep every rectangle CIDetector's: no native tracking nor band search for them
+        const BOOL nativeDetection = [self usesNativeDetector];
+        
+        // Follow the last rectangle on every frame, a few corner patches are much cheaper than a detection
+        CIRectangleFeature *previousRectangleFeature = _borderDetectLastRectangleFeature;
+        if (previousRectangleFeature && nativeDetection) {
+            _borderDetectLastRectangleFeature = [self.nativeDetector trackedFeatureInPixelBuffer:pixelBuffer];
+        }
+        
+        // Detection to acquire the rectangle or correct the tracking drift, at a cadence fitting the budget.
+        // Search around the last known rectangle first, the whole frame only when it is not there anymore.
+        if ([self.nativeDetector shouldDetectWhileTracking:(_borderDetectLastRectangleFeature != nil) confident:(confidence >= self.minimumConfidenceForFullDetection)]) {
+            CFTimeInterval start = CACurrentMediaTime();
+            CIRectangleFeature *around   = _borderDetectLastRectangleFeature ?: previousRectangleFeature;
+            CIRectangleFeature *detected = (around && nativeDetection) ? [self.nativeDetector featureInPixelBuffer:pixelBuffer near:around] : nil;
+            if (detected) self.bandDetectionFrames += 1;
+            else detected = [self bestRectangleInImage:image pixelBuffer:pixelBuffer previous:around];
+            self.detectionFrames += 1;
+            if (detected) {
+                _borderDetectLastRectangleFeature = detected;
+                if (nativeDetection) [self.nativeDetector startTrackingFeature:detected inPixelBuffer:pixelBuffer];
+            }
+            [self.nativeDetector recordDetectionDuration:CACurrentMediaTime() - start];
         }
         
         // Create teh Overlay
@@ -642,8 +816,9 @@ CGImagePropertyOrientation imagePropertyOrientationForUIImageOrientation(UIImage
                 alpha = alpha > 0.8f ? 0.8f : alpha;
             }
             
-            // Keep Ref to the latest corrected Image:
-            self.latestCorrectedImage = [image correctPerspectiveWithFeatures:_borderDetectLastRectangleFeature];
+            // Keep Ref to the latest frame, the warp runs only when the corrected image is asked for
+            self.latestFrameImage = image;
+            self.latestFrameFeature = _borderDetectLastRectangleFeature;
             
             // Draw OverLay
             image = [image drawHighlightOverlayWithcolor:[self.overlayColor colorWithAlphaComponent:alpha] CIRectangleFeature:_borderDetectLastRectangleFeature];
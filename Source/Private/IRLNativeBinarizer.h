@@ -0,0 +1,60 @@
+//
+//  IRLNativeBinarizer.h
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+@import UIKit;
+@import CoreImage;
+@import CoreVideo;
+
+#import "IRLBandEncoder.h"
+
+/**
+ @brief Objective-C front end of the adaptive binarization of the native core (Source/Core/IRLBinarizer.hpp).
+ 
+ @discussion Each pixel is compared with a threshold computed from the mean and deviation of the luma around it (Sauvola), so shadows and uneven lighting keep text black and paper white. Used by `IRLScannerViewTypeBinarized`.
+ */
+@interface IRLNativeBinarizer : NSObject
+
+/**
+ @return windowFraction Half size of the threshold window, as a fraction of the smaller image dimension. Default 0.01
+ */
+@property (nonatomic, assign)   CGFloat     windowFraction;
+
+/**
+ @brief Binarize a camera frame for the preview.
+ 
+ @discussion The frame is binarized at half its resolution, a quarter of the pixels, then scaled back up: a preview shows no more.
+ 
+ @param pixelBuffer A bi-planar 420 buffer (its Y plane is read as is) or a kCVPixelFormatType_32BGRA one
+ 
+ @return A black and white image of the frame extent, or nil when the buffer can not be read
+ */
+- (CIImage * _Nullable)binarizedImageWithPixelBuffer:(CVPixelBufferRef _Nonnull)pixelBuffer;
+
+/**
+ @brief Binarize the final still into a 1 bit image, ready for bilevel encoders (TIFF G4, PDF JBIG2 / CCITT).
+ 
+ @discussion The image is rendered to luma a few bands of rows at a time, as they are binarized on all the cores. Stills with
+ their corners go through `-[IRLNativePageRenderer bilevelImageWithImage:...]` instead, which never renders the page whole.
+ 
+ @param image   The rectified and cropped document
+ @param context The context used to render `image`. If nil a default context is created.
+ 
+ @return A 1 bit per pixel gray image, or nil when `image` is empty
+ */
+- (UIImage * _Nullable)bilevelImageWithImage:(CIImage * _Nonnull)image context:(CIContext * _Nullable)context;
+
+/**
+ @brief Binarize a `width` x `height` page into a 1 bit image as its luma is rendered, a few bands of rows at a time.
+ 
+ @discussion Only the bits of the page and the rows of one band per core are in memory.
+ 
+ @param render  Writes Gray8 rows of the page, called in turn for the bands and the rows of the threshold window around them
+ 
+ @return A 1 bit per pixel gray image, or nil when the page is empty
+ */
+- (UIImage * _Nullable)bilevelImageWithWidth:(int)width height:(int)height rows:(IRLBandRenderer _Nonnull)render;
+
+@end
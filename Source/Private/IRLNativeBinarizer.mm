@@ -0,0 +1,104 @@
+//
+//  IRLNativeBinarizer.mm
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#import "IRLNativeBinarizer.h"
+
+#include "IRLBinarizer.hpp"
+#include "IRLPyramid.hpp"
+
+#include <vector>
+
+@implementation IRLNativeBinarizer {
+    irl::Binarizer          _binarizer;
+    irl::Plane8             _luma;
+    irl::Plane8             _gray;
+    irl::BitPlane           _bits;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _windowFraction = _binarizer.options().windowFraction;
+    }
+    return self;
+}
+
+- (void)setWindowFraction:(CGFloat)windowFraction {
+    _windowFraction = windowFraction;
+    irl::BinarizerOptions options = _binarizer.options();
+    options.windowFraction = (float)windowFraction;
+    _binarizer.setOptions(options);
+}
+
+- (CIImage *)binarizedImageWithPixelBuffer:(CVPixelBufferRef)pixelBuffer {
+    @synchronized (self) {
+        OSType format = CVPixelBufferGetPixelFormatType(pixelBuffer);
+        BOOL biPlanar = format == kCVPixelFormatType_420YpCbCr8BiPlanarFullRange || format == kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange;
+        if (!biPlanar && format != kCVPixelFormatType_32BGRA) return nil;
+
+        // Half resolution luma in one pass, from the Y plane or the BGRA pixels
+        CVPixelBufferLockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
+        if (biPlanar) {
+            irl::ImageView luma((const uint8_t*)CVPixelBufferGetBaseAddressOfPlane(pixelBuffer, 0),
+                                (int)CVPixelBufferGetWidthOfPlane(pixelBuffer, 0), (int)CVPixelBufferGetHeightOfPlane(pixelBuffer, 0),
+                                CVPixelBufferGetBytesPerRowOfPlane(pixelBuffer, 0), irl::PixelFormat::Gray8);
+            irl::downsampleLuma2x(luma, _luma);
+        } else {
+            irl::ImageView frame((const uint8_t*)CVPixelBufferGetBaseAddress(pixelBuffer),
+                                 (int)CVPixelBufferGetWidth(pixelBuffer), (int)CVPixelBufferGetHeight(pixelBuffer),
+                                 CVPixelBufferGetBytesPerRow(pixelBuffer), irl::PixelFormat::BGRA8);
+            irl::downsampleLuma2x(frame, _luma);
+        }
+        CVPixelBufferUnlockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
+        if (_luma.width() <= 0 || _luma.height() <= 0) return nil;
+        _binarizer.binarize(_luma.view(), _gray);
+
+        NSData *pixels = [NSData dataWithBytes:_gray.data() length:_gray.stride() * (size_t)_gray.height()];
+        CIImage *binarized = [CIImage imageWithBitmapData:pixels bytesPerRow:_gray.stride() size:CGSizeMake(_gray.width(), _gray.height())
+                                                   format:kCIFormatL8 colorSpace:nil];
+        return [binarized imageByApplyingTransform:CGAffineTransformMakeScale(2.0, 2.0)];
+    }
+}
+
+- (UIImage *)bilevelImageWithImage:(CIImage *)image context:(CIContext *)context {
+    CGRect extent = CGRectIntegral(image.extent);
+    if (CGRectIsEmpty(extent) || CGRectIsInfinite(extent)) return nil;
+    if (!context) context = [CIContext contextWithOptions:nil];
+
+    const int width  = (int)CGRectGetWidth(extent);
+    CGColorSpaceRef gray = CGColorSpaceCreateDeviceGray();
+    UIImage *result = [self bilevelImageWithWidth:width height:(int)CGRectGetHeight(extent) rows:^(int top, int rows, uint8_t *band, size_t rowBytes) {
+        // Bitmaps are y down, the first rows of the page are the top of the extent
+        CGRect bounds = CGRectMake(CGRectGetMinX(extent), CGRectGetMaxY(extent) - top - rows, width, rows);
+        [context render:image toBitmap:band rowBytes:rowBytes bounds:bounds format:kCIFormatL8 colorSpace:gray];
+    }];
+    CGColorSpaceRelease(gray);
+    return result;
+}
+
+- (UIImage *)bilevelImageWithWidth:(int)width height:(int)height rows:(IRLBandRenderer)render {
+    @synchronized (self) {
+        if (width <= 0 || height <= 0) return nil;
+        _binarizer.binarize(width, height, [&](int top, int rows, uint8_t *band, size_t rowBytes) { render(top, rows, band, rowBytes); }, _bits);
+
+        // A set bit is black: decode 1 as 0 (black) and 0 as 1 (white)
+        static const CGFloat decode[] = { 1.0, 0.0 };
+        NSData *bits = [NSData dataWithBytes:_bits.data() length:_bits.stride() * (size_t)_bits.height()];
+        CGDataProviderRef provider = CGDataProviderCreateWithCFData((__bridge CFDataRef)bits);
+        CGColorSpaceRef gray = CGColorSpaceCreateDeviceGray();
+        CGImageRef bilevel = CGImageCreate(_bits.width(), _bits.height(), 1, 1, _bits.stride(), gray, (CGBitmapInfo)kCGImageAlphaNone,
+                                           provider, decode, false, kCGRenderingIntentDefault);
+        CGDataProviderRelease(provider);
+        CGColorSpaceRelease(gray);
+        if (!bilevel) return nil;
+
+        UIImage *result = [UIImage imageWithCGImage:bilevel];
+        CGImageRelease(bilevel);
+        return result;
+    }
+}
+
+@end
@@ -0,0 +1,180 @@
+//
+//  IRLNativeDetector.h
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+@import Foundation;
+@import CoreImage;
+@import CoreVideo;
+
+@class IRLRectangleFeature;
+
+/** @brief Relative weights of the criteria used to select the document among the candidates. A zero weight ignores the criterion. */
+typedef struct {
+    CGFloat area;           // Area relative to the frame
+    CGFloat convexity;      // Quad area over the area of the hull of its corners
+    CGFloat angles;         // Closeness of the interior angles to right angles
+    CGFloat edgeSupport;    // Fraction of the sides backed by a luma edge, needs the frame pixels
+    CGFloat temporal;       // Closeness to the rectangle selected on the previous frame
+} IRLQuadScoreWeights;
+
+/** @brief The 4 corners of a document in CoreImage coordinates, as a value: nothing is allocated to pass or return them. */
+typedef struct {
+    CGPoint topLeft;
+    CGPoint topRight;
+    CGPoint bottomRight;
+    CGPoint bottomLeft;
+} IRLCorners;
+
+/**
+ @brief Name 4 corners given in any order, with the convention of the native detectors (Source/Core/IRLQuad.hpp, `canonicalQuad`).
+ 
+ @discussion Clockwise on screen, the top left corner being the one closest to the top left of the image. Nothing is allocated, no trigonometry: cheap enough for every frame.
+ */
+FOUNDATION_EXTERN IRLCorners IRLCanonicalCorners(CGPoint a, CGPoint b, CGPoint c, CGPoint d);
+
+/**
+ @brief Objective-C front end of the portable C++ quad detector (Source/Core).
+ 
+ @discussion Same role as a `CIDetectorTypeRectangle` CIDetector, but the engine can be profiled, tuned and run on Linux. Returned features are expressed in CoreImage coordinates (origin bottom left) so they can be used anywhere a CIRectangleFeature is expected.
+ */
+@interface IRLNativeDetector : NSObject
+
+/**
+ @return minimumFeatureSize Smallest accepted document side, as a fraction of the smaller image dimension. Same meaning as CIDetectorMinFeatureSize. Default 0.5
+ */
+@property (nonatomic, assign)   CGFloat     minimumFeatureSize;
+
+/**
+ @return pyramidLevels Number of 2x downsamplings before detection (0: full frame, 2: 1/4, 3: 1/8). Corners are then refined up to full resolution. Default 0
+ */
+@property (nonatomic, assign)   NSInteger   pyramidLevels;
+
+/**
+ @return usesLineCandidates When YES, documents are assembled from straight edges (Hough lines) instead of bright regions. `pyramidLevels` is then ignored, the search level is picked from the frame size. Default NO
+ */
+@property (nonatomic, assign)   BOOL        usesLineCandidates;
+
+/**
+ @return maximumCandidates Maximum number of rectangles returned for one frame. Fewer candidates means less work per frame with `usesLineCandidates`. Default 4
+ */
+@property (nonatomic, assign)   NSInteger   maximumCandidates;
+
+/**
+ @return scoreWeights Weights of the candidate selection. Default area 1, convexity 1, angles 1, edge support 2, temporal 1
+ */
+@property (nonatomic, assign)   IRLQuadScoreWeights scoreWeights;
+
+/**
+ @brief Detect documents in a camera frame.
+ 
+ @param pixelBuffer A kCVPixelFormatType_420YpCbCr8BiPlanarFullRange buffer, as delivered by our AVCaptureVideoDataOutput, or a kCVPixelFormatType_32BGRA one
+ 
+ @return The detected rectangles, best first
+ */
+- (NSArray<IRLRectangleFeature*> * _Nonnull)featuresInPixelBuffer:(CVPixelBufferRef _Nonnull)pixelBuffer;
+
+/**
+ @brief Detect the document in a camera frame: every candidate is scored and only the best one is returned.
+ 
+ @param pixelBuffer A kCVPixelFormatType_420YpCbCr8BiPlanarFullRange buffer, as delivered by our AVCaptureVideoDataOutput, or a kCVPixelFormatType_32BGRA one
+ @param previous    The rectangle selected on the previous frame, if any, in CoreImage coordinates
+ 
+ @return The best candidate, or nil when nothing was detected
+ */
+- (IRLRectangleFeature * _Nullable)bestFeatureInPixelBuffer:(CVPixelBufferRef _Nonnull)pixelBuffer previous:(CIRectangleFeature * _Nullable)previous;
+
+/**
+ @brief Select the document among rectangles found by another detector (CIDetector), with the same scoring as `bestFeatureInPixelBuffer:previous:`.
+ 
+ @param features    The candidates, in CoreImage coordinates
+ @param extent      The extent of the image the candidates were found in
+ @param pixelBuffer The pixels of that image (bi-planar or BGRA), for the edge support. May be NULL, the edge support is then ignored.
+ @param previous    The rectangle selected on the previous frame, if any
+ 
+ @return One of `features`, or nil when `features` is empty
+ */
+- (CIRectangleFeature * _Nullable)bestFeatureInFeatures:(NSArray<CIRectangleFeature*> * _Nonnull)features extent:(CGRect)extent pixelBuffer:(CVPixelBufferRef _Nullable)pixelBuffer previous:(CIRectangleFeature * _Nullable)previous;
+
+/**
+ @brief Detect documents in a CIImage. The image is rendered to a BGRA bitmap first.
+ 
+ @param image   The image to inspect
+ @param context The context used to render `image`. If nil a default context is created.
+ 
+ @return The detected rectangles, best first
+ */
+- (NSArray<IRLRectangleFeature*> * _Nonnull)featuresInImage:(CIImage * _Nonnull)image context:(CIContext * _Nullable)context;
+
+/**
+ @brief Detect the document again near its previous position, reading bands around the sides of `previous` only.
+ 
+ @discussion Several times cheaper than a detection on the whole frame while the phone is held over the page. When nil is returned, fall back to `featuresInPixelBuffer:`.
+ 
+ @param pixelBuffer A bi-planar 420 or kCVPixelFormatType_32BGRA buffer
+ @param previous    The last known rectangle, in CoreImage coordinates
+ 
+ @return The rectangle in this frame, or nil when it is not within the bands anymore
+ */
+- (IRLRectangleFeature * _Nullable)featureInPixelBuffer:(CVPixelBufferRef _Nonnull)pixelBuffer near:(CIRectangleFeature * _Nonnull)previous;
+
+/**
+ @brief Sub-pixel refinement of a selected rectangle. Straight edges are fitted by least squares along each side and intersected.
+ 
+ @discussion Only thin strips along the sides of `feature` are rendered and read, so the cost does not depend on the image size.
+ 
+ @param feature A rectangle detected in `image`, in CoreImage coordinates
+ @param image   The image `feature` was detected in
+ @param context The context used to render the strips. If nil a default context is created.
+ 
+ @return A refined copy of `feature`, or `feature` itself when no corner could be refined
+ */
+- (CIRectangleFeature * _Nonnull)refinedFeature:(CIRectangleFeature * _Nonnull)feature inImage:(CIImage * _Nonnull)image context:(CIContext * _Nullable)context;
+
+/**
+ @brief Start following `feature` from frame to frame, with small patches matched around its corners.
+ 
+ @param feature     A rectangle detected in `pixelBuffer`, in CoreImage coordinates
+ @param pixelBuffer A bi-planar 420 or kCVPixelFormatType_32BGRA buffer
+ */
+- (void)startTrackingFeature:(CIRectangleFeature * _Nonnull)feature inPixelBuffer:(CVPixelBufferRef _Nonnull)pixelBuffer;
+
+/**
+ @brief Follow the tracked rectangle in the next camera frame. Costs a fraction of a detection.
+ 
+ @param pixelBuffer A bi-planar 420 or kCVPixelFormatType_32BGRA buffer
+ 
+ @return The rectangle in this frame, or nil when nothing is tracked or the rectangle was lost
+ */
+- (IRLRectangleFeature * _Nullable)trackedFeatureInPixelBuffer:(CVPixelBufferRef _Nonnull)pixelBuffer;
+
+/** @brief Forget the tracked rectangle, and restart the detection cadence */
+- (void)stopTracking;
+
+/**
+ @return detectionBudget Average time, in seconds, that detection plus tracking may take per frame. Detections are spaced out to stay within it. Default 0.008
+ */
+@property (nonatomic, assign)   NSTimeInterval  detectionBudget;
+
+/**
+ @return logsDetectionDecisions When YES, every scheduling decision is logged with the measured latencies and motion, for benchmarking. Default NO
+ */
+@property (nonatomic, assign)   BOOL            logsDetectionDecisions;
+
+/**
+ @brief Decide whether the current frame runs a detection, from the measured latencies, the motion of the tracked corners and the confidence.
+ 
+ @discussion Detections run as often as the budget allows while nothing is tracked or the phone moves fast, at a regular interval otherwise, and less and less often while the scene is static and confident.
+ 
+ @param tracking  YES when `trackedFeatureInPixelBuffer:` followed the rectangle on this frame
+ @param confident YES when the detection confidence is high enough to back off
+ 
+ @return YES to run a detection on this frame
+ */
+- (BOOL)shouldDetectWhileTracking:(BOOL)tracking confident:(BOOL)confident;
+
+/** @brief Report how long a detection took, whatever the detector, so the cadence follows the actual cost */
+- (void)recordDetectionDuration:(NSTimeInterval)duration;
+
+@end
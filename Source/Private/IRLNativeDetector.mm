@@ -0,0 +1,371 @@
+//
+//  IRLNativeDetector.mm
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#import "IRLNativeDetector.h"
+#import "CIImage+Utilities.h"
+
+#include "IRLBandDetector.hpp"
+#include "IRLCornerRefiner.hpp"
+#include "IRLCornerTracker.hpp"
+#include "IRLDetectionScheduler.hpp"
+#include "IRLLineQuadFinder.hpp"
+#include "IRLQuadDetector.hpp"
+#include "IRLQuadScorer.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+@interface IRLNativeDetector () {
+    irl::QuadDetector       _detector;
+    irl::LineQuadFinder     _lineFinder;
+    irl::CornerTracker      _tracker;
+    irl::BandDetector       _bandDetector;
+    irl::QuadScorer         _scorer;
+    irl::DetectionScheduler _scheduler;
+    float                   _frameDiagonal;
+    std::vector<uint8_t>    _bitmap;
+}
+@end
+
+@implementation IRLNativeDetector
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _minimumFeatureSize = _detector.options().minimumFeatureSize;
+        _pyramidLevels      = _detector.options().pyramidLevels;
+        _maximumCandidates  = _detector.options().maximumFeatures;
+        _detectionBudget    = _scheduler.options().frameBudget / 1000.0;
+        
+        const irl::QuadScoreWeights weights = _scorer.options().weights;
+        _scoreWeights = (IRLQuadScoreWeights){ weights.area, weights.convexity, weights.angles, weights.edgeSupport, weights.temporal };
+        
+        irl::LineQuadFinderOptions lineOptions = _lineFinder.options();
+        lineOptions.maximumCandidates = (int)_maximumCandidates;
+        _lineFinder.setOptions(lineOptions);
+    }
+    return self;
+}
+
+#pragma mark - Setters
+
+- (void)setMinimumFeatureSize:(CGFloat)minimumFeatureSize {
+    _minimumFeatureSize = minimumFeatureSize;
+    
+    irl::QuadDetectorOptions options = _detector.options();
+    options.minimumFeatureSize = (float)minimumFeatureSize;
+    _detector.setOptions(options);
+    
+    irl::LineQuadFinderOptions lineOptions = _lineFinder.options();
+    lineOptions.minimumFeatureSize = (float)minimumFeatureSize;
+    _lineFinder.setOptions(lineOptions);
+    
+    irl::BandDetectorOptions bandOptions = _bandDetector.options();
+    bandOptions.minimumFeatureSize = (float)minimumFeatureSize;
+    _bandDetector.setOptions(bandOptions);
+}
+
+- (void)setPyramidLevels:(NSInteger)pyramidLevels {
+    _pyramidLevels = pyramidLevels;
+    
+    irl::QuadDetectorOptions options = _detector.options();
+    options.pyramidLevels = (int)pyramidLevels;
+    _detector.setOptions(options);
+}
+
+- (void)setMaximumCandidates:(NSInteger)maximumCandidates {
+    _maximumCandidates = maximumCandidates;
+    
+    irl::QuadDetectorOptions options = _detector.options();
+    options.maximumFeatures = (int)maximumCandidates;
+    _detector.setOptions(options);
+    
+    irl::LineQuadFinderOptions lineOptions = _lineFinder.options();
+    lineOptions.maximumCandidates = (int)maximumCandidates;
+    _lineFinder.setOptions(lineOptions);
+}
+
+- (void)setScoreWeights:(IRLQuadScoreWeights)scoreWeights {
+    _scoreWeights = scoreWeights;
+    
+    irl::QuadScorerOptions options = _scorer.options();
+    options.weights.area        = (float)scoreWeights.area;
+    options.weights.convexity   = (float)scoreWeights.convexity;
+    options.weights.angles      = (float)scoreWeights.angles;
+    options.weights.edgeSupport = (float)scoreWeights.edgeSupport;
+    options.weights.temporal    = (float)scoreWeights.temporal;
+    _scorer.setOptions(options);
+}
+
+- (void)setDetectionBudget:(NSTimeInterval)detectionBudget {
+    _detectionBudget = detectionBudget;
+    
+    @synchronized (self) {
+        irl::DetectionSchedulerOptions options = _scheduler.options();
+        options.frameBudget = (float)(detectionBudget * 1000.0);
+        _scheduler.setOptions(options);
+    }
+}
+
+#pragma mark - Corners
+
+IRLCorners IRLCanonicalCorners(CGPoint a, CGPoint b, CGPoint c, CGPoint d) {
+    // Mirrored to y down, the naming does not depend on where the origin is
+    const irl::Point corners[4] = { irl::Point((float)a.x, (float)-a.y), irl::Point((float)b.x, (float)-b.y),
+                                    irl::Point((float)c.x, (float)-c.y), irl::Point((float)d.x, (float)-d.y) };
+    const irl::Quad quad = irl::canonicalQuad(corners);
+    IRLCorners result;
+    result.topLeft     = CGPointMake(quad.topLeft.x,     -quad.topLeft.y);
+    result.topRight    = CGPointMake(quad.topRight.x,    -quad.topRight.y);
+    result.bottomRight = CGPointMake(quad.bottomRight.x, -quad.bottomRight.y);
+    result.bottomLeft  = CGPointMake(quad.bottomLeft.x,  -quad.bottomLeft.y);
+    return result;
+}
+
+#pragma mark - Detection
+
+// Buffer space is y down, CoreImage space is y up
+static CGPoint coreImagePoint(irl::Point point, CGRect extent) {
+    return CGPointMake(CGRectGetMinX(extent) + point.x, CGRectGetMaxY(extent) - point.y);
+}
+
+static irl::Point bufferPoint(CGPoint point, CGRect extent) {
+    return irl::Point((float)(point.x - CGRectGetMinX(extent)), (float)(CGRectGetMaxY(extent) - point.y));
+}
+
+static IRLRectangleFeature* featureWithQuad(const irl::Quad& quad, CGRect extent) {
+    IRLRectangleFeature *feature = [IRLRectangleFeature new];
+    feature.topLeft     = coreImagePoint(quad.topLeft,     extent);
+    feature.topRight    = coreImagePoint(quad.topRight,    extent);
+    feature.bottomRight = coreImagePoint(quad.bottomRight, extent);
+    feature.bottomLeft  = coreImagePoint(quad.bottomLeft,  extent);
+    return feature;
+}
+
+- (NSArray<IRLRectangleFeature*> *)featuresFromFrame:(const irl::ImageView&)frame extent:(CGRect)extent {
+    NSMutableArray<IRLRectangleFeature*> *features = [NSMutableArray array];
+    
+    if (self.usesLineCandidates) {
+        for (const irl::QuadCandidate& candidate : _lineFinder.find(frame)) {
+            [features addObject:featureWithQuad(candidate.quad, extent)];
+        }
+        return features;
+    }
+    
+    for (const irl::DetectedQuad& detected : _detector.detect(frame)) {
+        [features addObject:featureWithQuad(detected.quad, extent)];
+    }
+    return features;
+}
+
+static irl::Quad quadWithFeature(CIRectangleFeature *feature, CGRect extent) {
+    irl::Quad quad;
+    quad.topLeft     = bufferPoint(feature.topLeft,     extent);
+    quad.topRight    = bufferPoint(feature.topRight,    extent);
+    quad.bottomRight = bufferPoint(feature.bottomRight, extent);
+    quad.bottomLeft  = bufferPoint(feature.bottomLeft,  extent);
+    return quad;
+}
+
+/** Bi-planar frames are read through their Y plane, without any copy or conversion: detection only needs the luma */
+static irl::ImageView lockedFrame(CVPixelBufferRef pixelBuffer) {
+    OSType format = CVPixelBufferGetPixelFormatType(pixelBuffer);
+    CVPixelBufferLockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
+    if (format == kCVPixelFormatType_420YpCbCr8BiPlanarFullRange || format == kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange) {
+        return irl::ImageView((const uint8_t*)CVPixelBufferGetBaseAddressOfPlane(pixelBuffer, 0),
+                              (int)CVPixelBufferGetWidthOfPlane(pixelBuffer, 0), (int)CVPixelBufferGetHeightOfPlane(pixelBuffer, 0),
+                              CVPixelBufferGetBytesPerRowOfPlane(pixelBuffer, 0), irl::PixelFormat::Gray8);
+    }
+    NSCAssert(format == kCVPixelFormatType_32BGRA, @"IRLNativeDetector expects kCVPixelFormatType_32BGRA or 420YpCbCr8BiPlanar buffers");
+    return irl::ImageView((const uint8_t*)CVPixelBufferGetBaseAddress(pixelBuffer),
+                          (int)CVPixelBufferGetWidth(pixelBuffer), (int)CVPixelBufferGetHeight(pixelBuffer),
+                          CVPixelBufferGetBytesPerRow(pixelBuffer), irl::PixelFormat::BGRA8);
+}
+
+- (NSArray<IRLRectangleFeature*> *)featuresInPixelBuffer:(CVPixelBufferRef)pixelBuffer {
+    @synchronized (self) {
+        irl::ImageView frame = lockedFrame(pixelBuffer);
+        NSArray *features = [self featuresFromFrame:frame extent:CGRectMake(0, 0, frame.width, frame.height)];
+        CVPixelBufferUnlockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
+        return features;
+    }
+}
+
+- (IRLRectangleFeature *)bestFeatureInPixelBuffer:(CVPixelBufferRef)pixelBuffer previous:(CIRectangleFeature *)previous {
+    @synchronized (self) {
+        irl::ImageView frame  = lockedFrame(pixelBuffer);
+        CGRect         extent = CGRectMake(0, 0, frame.width, frame.height);
+        
+        // Candidates go straight from the engine to the scorer, only the winner becomes an object
+        _scorer.clear();
+        if (self.usesLineCandidates) {
+            for (const irl::QuadCandidate& candidate : _lineFinder.find(frame)) _scorer.add(candidate.quad);
+        } else {
+            for (const irl::DetectedQuad& detected : _detector.detect(frame)) _scorer.add(detected.quad);
+        }
+        
+        irl::Quad previousQuad;
+        if (previous) previousQuad = quadWithFeature(previous, extent);
+        int best = _scorer.score(frame, frame.width, frame.height, previous ? &previousQuad : nullptr);
+        
+        CVPixelBufferUnlockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
+        return best < 0 ? nil : featureWithQuad(_scorer.candidate(best), extent);
+    }
+}
+
+- (CIRectangleFeature *)bestFeatureInFeatures:(NSArray<CIRectangleFeature*> *)features extent:(CGRect)extent pixelBuffer:(CVPixelBufferRef)pixelBuffer previous:(CIRectangleFeature *)previous {
+    if (features.count == 0) return nil;
+    
+    @synchronized (self) {
+        irl::ImageView frame;
+        if (pixelBuffer) frame = lockedFrame(pixelBuffer);
+        
+        _scorer.clear();
+        for (CIRectangleFeature *feature in features) _scorer.add(quadWithFeature(feature, extent));
+        
+        irl::Quad previousQuad;
+        if (previous) previousQuad = quadWithFeature(previous, extent);
+        int best = _scorer.score(frame, (int)CGRectGetWidth(extent), (int)CGRectGetHeight(extent), previous ? &previousQuad : nullptr);
+        
+        if (pixelBuffer) CVPixelBufferUnlockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
+        return features[(NSUInteger)best];
+    }
+}
+
+- (IRLRectangleFeature *)featureInPixelBuffer:(CVPixelBufferRef)pixelBuffer near:(CIRectangleFeature *)previous {
+    @synchronized (self) {
+        irl::ImageView frame  = lockedFrame(pixelBuffer);
+        CGRect         extent = CGRectMake(0, 0, frame.width, frame.height);
+        
+        irl::Quad quad;
+        bool found = _bandDetector.detect(frame, quadWithFeature(previous, extent), quad);
+        CVPixelBufferUnlockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
+        
+        return found ? featureWithQuad(quad, extent) : nil;
+    }
+}
+
+- (NSArray<IRLRectangleFeature*> *)featuresInImage:(CIImage *)image context:(CIContext *)context {
+    CGRect extent = CGRectIntegral(image.extent);
+    if (CGRectIsEmpty(extent) || CGRectIsInfinite(extent)) return @[];
+    
+    if (!context) context = [CIContext contextWithOptions:nil];
+    
+    @synchronized (self) {
+        int     width    = (int)CGRectGetWidth(extent);
+        int     height   = (int)CGRectGetHeight(extent);
+        size_t  rowBytes = (size_t)width * 4;
+        _bitmap.resize(rowBytes * height);
+        
+        [context render:image toBitmap:_bitmap.data() rowBytes:rowBytes bounds:extent format:kCIFormatBGRA8 colorSpace:nil];
+        
+        irl::ImageView frame(_bitmap.data(), width, height, rowBytes, irl::PixelFormat::BGRA8);
+        return [self featuresFromFrame:frame extent:extent];
+    }
+}
+
+#pragma mark - Refinement
+
+- (CIRectangleFeature *)refinedFeature:(CIRectangleFeature *)feature inImage:(CIImage *)image context:(CIContext *)context {
+    CGRect extent = CGRectIntegral(image.extent);
+    if (CGRectIsEmpty(extent) || CGRectIsInfinite(extent)) return feature;
+    
+    if (!context) context = [CIContext contextWithOptions:nil];
+    
+    irl::Quad quad = quadWithFeature(feature, extent);
+    
+    const irl::CornerRefinerOptions options;
+    const CGFloat margin = options.searchRadius + 2;
+    
+    irl::EdgeLine   lines[4];
+    bool            fitted[4];
+    
+    @synchronized (self) {
+        for (int k = 0; k < 4; k++) {
+            irl::Point from = quad[k], to = quad[(k + 1) & 3];
+            
+            // Bounding box of the strip read along this side, in buffer coordinates
+            CGRect strip = CGRectMake(MIN(from.x, to.x) - margin, MIN(from.y, to.y) - margin,
+                                      fabs(from.x - to.x) + 2 * margin, fabs(from.y - to.y) + 2 * margin);
+            strip = CGRectIntegral(CGRectIntersection(strip, CGRectMake(0, 0, CGRectGetWidth(extent), CGRectGetHeight(extent))));
+            if (CGRectIsEmpty(strip)) { fitted[k] = false; continue; }
+            
+            int     width    = (int)CGRectGetWidth(strip);
+            int     height   = (int)CGRectGetHeight(strip);
+            size_t  rowBytes = (size_t)width * 4;
+            _bitmap.resize(rowBytes * height);
+            
+            CGRect bounds = CGRectMake(CGRectGetMinX(extent) + CGRectGetMinX(strip), CGRectGetMaxY(extent) - CGRectGetMaxY(strip), width, height);
+            [context render:image toBitmap:_bitmap.data() rowBytes:rowBytes bounds:bounds format:kCIFormatBGRA8 colorSpace:nil];
+            
+            irl::ImageView  view(_bitmap.data(), width, height, rowBytes, irl::PixelFormat::BGRA8);
+            irl::Point      origin((float)CGRectGetMinX(strip), (float)CGRectGetMinY(strip));
+            fitted[k] = irl::fitEdgeLine(view, from - origin, to - origin, options, lines[k]);
+            lines[k].point = lines[k].point + origin;
+        }
+    }
+    
+    if (irl::applyEdgeLines(lines, fitted, options, quad) == 0) return feature;
+    return featureWithQuad(quad, extent);
+}
+
+#pragma mark - Tracking
+
+- (void)startTrackingFeature:(CIRectangleFeature *)feature inPixelBuffer:(CVPixelBufferRef)pixelBuffer {
+    @synchronized (self) {
+        irl::ImageView frame = lockedFrame(pixelBuffer);
+        // Keep the velocity when a detection only corrects the drift of a quad still being followed
+        _tracker.start(frame, quadWithFeature(feature, CGRectMake(0, 0, frame.width, frame.height)), _tracker.isTracking());
+        CVPixelBufferUnlockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
+    }
+}
+
+- (IRLRectangleFeature *)trackedFeatureInPixelBuffer:(CVPixelBufferRef)pixelBuffer {
+    @synchronized (self) {
+        if (!_tracker.isTracking()) return nil;
+        
+        auto start = std::chrono::steady_clock::now();
+        irl::ImageView frame = lockedFrame(pixelBuffer);
+        bool tracked = _tracker.track(frame);
+        CVPixelBufferUnlockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
+        
+        _frameDiagonal = std::hypot((float)frame.width, (float)frame.height);
+        if (tracked) _scheduler.recordTracking(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count());
+        return tracked ? featureWithQuad(_tracker.quad(), CGRectMake(0, 0, frame.width, frame.height)) : nil;
+    }
+}
+
+- (void)stopTracking {
+    @synchronized (self) {
+        _tracker.stop();
+        _scheduler.reset();
+    }
+}
+
+#pragma mark - Scheduling
+
+- (BOOL)shouldDetectWhileTracking:(BOOL)tracking confident:(BOOL)confident {
+    @synchronized (self) {
+        const float motion = (tracking && _frameDiagonal > 0.0f) ? _tracker.motion() / _frameDiagonal : 0.0f;
+        const irl::ScheduleDecision decision = _scheduler.next(tracking, motion, confident);
+        
+        if (self.logsDetectionDecisions) {
+            NSLog(@"IRLNativeDetector frame %u %@ interval %d (%s) detection %.2f ms tracking %.3f ms motion %.4f",
+                  decision.frame, decision.detect ? @"detect" : @"track", decision.interval, irl::scheduleReasonName(decision.reason),
+                  decision.detectionLatency, decision.trackingLatency, decision.motion);
+        }
+        return decision.detect;
+    }
+}
+
+- (void)recordDetectionDuration:(NSTimeInterval)duration {
+    @synchronized (self) {
+        _scheduler.recordDetection((float)(duration * 1000.0));
+    }
+}
+
+@end
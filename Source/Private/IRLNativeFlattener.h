@@ -0,0 +1,46 @@
+//
+//  IRLNativeFlattener.h
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+@import UIKit;
+@import CoreImage;
+@import CoreVideo;
+
+/**
+ @brief Objective-C front end of the illumination flattening of the native core (Source/Core/IRLIlluminationFlattener.hpp).
+ 
+ @discussion The paper background is estimated on a small copy of the image and divided out, so lamp gradients and soft shadows disappear while colors are kept. Used by `IRLScannerViewTypeShadowRemoval`.
+ */
+@interface IRLNativeFlattener : NSObject
+
+/**
+ @return level Pyramid level the background is estimated on: 4 works on 1/16 of the width and height. Default 4
+ */
+@property (nonatomic, assign)   NSInteger   level;
+
+/**
+ @brief Flatten a camera frame for the preview.
+ 
+ @param pixelBuffer A bi-planar 420 buffer (converted to BGRA first) or a kCVPixelFormatType_32BGRA one
+ 
+ @return A BGRA image of the frame extent, or nil when the buffer can not be read
+ */
+- (CIImage * _Nullable)flattenedImageWithPixelBuffer:(CVPixelBufferRef _Nonnull)pixelBuffer;
+
+/**
+ @brief Flatten the final still.
+ 
+ @discussion The image is rendered whole to a BGRA bitmap and flattened in place: the background is estimated on the whole
+ page before it is divided out, so unlike the other stills this one is not streamed in bands, and a 48MP page holds its
+ full size bitmap while it is flattened.
+ 
+ @param image   The rectified and cropped document
+ @param context The context used to render `image`. If nil a default context is created.
+ 
+ @return The flattened page, or nil when `image` is empty
+ */
+- (UIImage * _Nullable)flattenedImageWithImage:(CIImage * _Nonnull)image context:(CIContext * _Nullable)context;
+
+@end
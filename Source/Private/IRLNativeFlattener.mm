@@ -0,0 +1,99 @@
+//
+//  IRLNativeFlattener.mm
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#import "IRLNativeFlattener.h"
+
+#include "IRLIlluminationFlattener.hpp"
+
+#include <vector>
+
+@implementation IRLNativeFlattener {
+    irl::IlluminationFlattener  _flattener;
+    std::vector<uint8_t>        _pixels;
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _level = _flattener.options().level;
+    }
+    return self;
+}
+
+- (void)setLevel:(NSInteger)level {
+    _level = level;
+    irl::IlluminationOptions options = _flattener.options();
+    options.level = (int)level;
+    _flattener.setOptions(options);
+}
+
+- (CIImage *)flattenedImageWithPixelBuffer:(CVPixelBufferRef)pixelBuffer {
+    @synchronized (self) {
+        OSType format = CVPixelBufferGetPixelFormatType(pixelBuffer);
+        BOOL biPlanar = format == kCVPixelFormatType_420YpCbCr8BiPlanarFullRange || format == kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange;
+        if (!biPlanar && format != kCVPixelFormatType_32BGRA) return nil;
+
+        CVPixelBufferLockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
+        const int width  = (int)CVPixelBufferGetWidth(pixelBuffer);
+        const int height = (int)CVPixelBufferGetHeight(pixelBuffer);
+        const size_t stride = 4 * (size_t)width;
+        _pixels.resize(stride * (size_t)height);
+
+        if (biPlanar) {
+            // Flattening needs the color: convert once, then flatten in place
+            irl::BiPlanarView frame((const uint8_t*)CVPixelBufferGetBaseAddressOfPlane(pixelBuffer, 0), width, height,
+                                    CVPixelBufferGetBytesPerRowOfPlane(pixelBuffer, 0),
+                                    (const uint8_t*)CVPixelBufferGetBaseAddressOfPlane(pixelBuffer, 1),
+                                    CVPixelBufferGetBytesPerRowOfPlane(pixelBuffer, 1));
+            irl::convertToBGRA(frame, _pixels.data(), stride);
+            _flattener.apply(irl::ImageView(_pixels.data(), width, height, stride, irl::PixelFormat::BGRA8), _pixels.data(), stride);
+        } else {
+            irl::ImageView frame((const uint8_t*)CVPixelBufferGetBaseAddress(pixelBuffer), width, height,
+                                 CVPixelBufferGetBytesPerRow(pixelBuffer), irl::PixelFormat::BGRA8);
+            _flattener.apply(frame, _pixels.data(), stride);
+        }
+        CVPixelBufferUnlockBaseAddress(pixelBuffer, kCVPixelBufferLock_ReadOnly);
+
+        NSData *pixels = [NSData dataWithBytes:_pixels.data() length:_pixels.size()];
+        return [CIImage imageWithBitmapData:pixels bytesPerRow:stride size:CGSizeMake(width, height)
+                                     format:kCIFormatBGRA8 colorSpace:nil];
+    }
+}
+
+- (UIImage *)flattenedImageWithImage:(CIImage *)image context:(CIContext *)context {
+    @synchronized (self) {
+        CGRect extent = CGRectIntegral(image.extent);
+        if (CGRectIsEmpty(extent) || CGRectIsInfinite(extent)) return nil;
+        if (!context) context = [CIContext contextWithOptions:nil];
+
+        const int width  = (int)extent.size.width;
+        const int height = (int)extent.size.height;
+        const size_t stride = 4 * (size_t)width;
+        NSMutableData *pixels = [NSMutableData dataWithLength:stride * (size_t)height];
+        if (!pixels) return nil;
+
+        CGColorSpaceRef rgb = CGColorSpaceCreateDeviceRGB();
+        [context render:image toBitmap:pixels.mutableBytes rowBytes:stride bounds:extent format:kCIFormatBGRA8 colorSpace:rgb];
+
+        // In place: the still only holds the rendered page and the small background
+        uint8_t *bytes = (uint8_t *)pixels.mutableBytes;
+        _flattener.apply(irl::ImageView(bytes, width, height, stride, irl::PixelFormat::BGRA8), bytes, stride);
+
+        CGDataProviderRef provider = CGDataProviderCreateWithCFData((__bridge CFDataRef)pixels);
+        CGImageRef flattened = CGImageCreate(width, height, 8, 32, stride, rgb,
+                                             (CGBitmapInfo)(kCGBitmapByteOrder32Little | kCGImageAlphaPremultipliedFirst),
+                                             provider, NULL, false, kCGRenderingIntentDefault);
+        CGDataProviderRelease(provider);
+        CGColorSpaceRelease(rgb);
+        if (!flattened) return nil;
+
+        UIImage *result = [UIImage imageWithCGImage:flattened];
+        CGImageRelease(flattened);
+        return result;
+    }
+}
+
+@end
@@ -0,0 +1,107 @@
+//
+//  IRLNativePageRenderer.h
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+@import UIKit;
+@import CoreImage;
+
+#import "CIImage+Utilities.h"
+#import "IRLScannerViewController.h"
+
+@class IRLNativeBinarizer;
+
+/**
+ @brief Objective-C front end of the fused still renderer of the native core (Source/Core/IRLPageRenderer.hpp).
+ 
+ @discussion Perspective correction, border crop and the color filter of the view type run in a single pass over the pixels of the final page,
+ instead of filtering, rectifying and cropping full size CoreImage intermediates. The memory needed is the decoded photo plus the page,
+ or plus one band of it when the page is encoded as it is rendered (`-pageJPEGDataWithImage:...`).
+ The Normal view also gets the color cast of the light taken off its paper (Source/Core/IRLWhiteBalance.hpp).
+ */
+@interface IRLNativePageRenderer : NSObject
+
+/**
+ @brief Smooth the sensor noise of the page, keeping edges and text (Source/Core/IRLGuidedFilter.hpp).
+ @discussion Applied to the rectified rows in the same pass as the render, before the filter: the background cut off
+ the page is never filtered. Meant for torch and low light stills. Defaults to NO.
+ */
+@property (nonatomic, assign)   BOOL        denoise;
+
+/**
+ @brief Sharpen the text softened by the perspective correction, in the same pass as the render (Source/Core/IRLUnsharpMask.hpp).
+ @discussion Defaults to NO.
+ */
+@property (nonatomic, assign)   BOOL        sharpen;
+
+/**
+ @brief Angle of view of the camera in degrees across the long side of the photos, as `AVCaptureDeviceFormat.videoFieldOfView`.
+ @discussion The page is sized with the aspect ratio of the paper (Source/Core/IRLPageAspect.hpp). 0 when unknown, the default:
+ the focal length is then estimated from the corners, when they allow it.
+ */
+@property (nonatomic, assign)   CGFloat     fieldOfView;
+
+/**
+ @brief Resolution of the page in dots per inch of the paper, the photo is rectified straight to it with an area filter.
+ @discussion 0, the default, keeps the resolution of the photo. Never enlarges the page.
+ */
+@property (nonatomic, assign)   CGFloat     dpi;
+
+/**
+ @brief Bytes of the page rendered at once by `-pageJPEGDataWithImage:...`, whatever the size of the photo.
+ @discussion 0, the default, for 4 MB.
+ */
+@property (nonatomic, assign)   NSUInteger  bandBytes;
+
+/**
+ @return YES when `type` is one of the filters the renderer applies itself (Normal, Black and White, Ultra Contrast)
+ */
++ (BOOL)supportsViewType:(IRLScannerViewType)type;
+
+/**
+ @brief Render the final page of a still.
+ 
+ @param image    The photo, unfiltered, already oriented
+ @param feature  Corners of the document in `image`, or nil to keep the whole photo
+ @param type     The filter to apply, see `+supportsViewType:`
+ @param margin   Pixels cropped on every side of the rectified page, as in `-cropBordersWithMargin:`
+ @param context  The context used to decode `image`. If nil a default context is created.
+ 
+ @return The page, or nil when `image` is empty
+ */
+- (UIImage * _Nullable)pageImageWithImage:(CIImage * _Nonnull)image
+                                  feature:(id<IRLRectangleFeatureProtocol> _Nullable)feature
+                                 viewType:(IRLScannerViewType)type
+                                   margin:(CGFloat)margin
+                                  context:(CIContext * _Nullable)context;
+
+/**
+ @brief Render the final page of a still like above and encode it to JPEG as it is rendered, in bands of `bandBytes`.
+ @discussion The page is never whole in memory: besides the decoded photo, a 48MP still needs the band and the encoder only.
+ 
+ @param quality  The `kCGImageDestinationLossyCompressionQuality`, from 0 to 1
+ 
+ @return The JPEG file, or nil when `image` is empty or the encoder failed
+ */
+- (NSData * _Nullable)pageJPEGDataWithImage:(CIImage * _Nonnull)image
+                                    feature:(id<IRLRectangleFeatureProtocol> _Nullable)feature
+                                   viewType:(IRLScannerViewType)type
+                                     margin:(CGFloat)margin
+                         compressionQuality:(CGFloat)quality
+                                    context:(CIContext * _Nullable)context;
+
+/**
+ @brief Render the luma of the final page of a still like above, straight into `binarizer`, for `IRLScannerViewTypeBinarized`.
+ @discussion The luma of the page is rendered a few bands at a time as they are binarized: besides the decoded photo, the memory is
+ the 1 bit page and one band per core.
+ 
+ @return The 1 bit page of `-[IRLNativeBinarizer bilevelImageWithWidth:height:rows:]`, or nil when `image` is empty
+ */
+- (UIImage * _Nullable)bilevelImageWithImage:(CIImage * _Nonnull)image
+                                     feature:(id<IRLRectangleFeatureProtocol> _Nullable)feature
+                                      margin:(CGFloat)margin
+                                   binarizer:(IRLNativeBinarizer * _Nonnull)binarizer
+                                     context:(CIContext * _Nullable)context;
+
+@end
@@ -0,0 +1,143 @@
+//
+//  IRLNativePageRenderer.mm
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#import "IRLNativePageRenderer.h"
+#import "IRLBandEncoder.h"
+#import "IRLNativeBinarizer.h"
+
+#include "IRLPageRenderer.hpp"
+
+#include <vector>
+
+// Buffer space is y down, CoreImage space is y up
+static irl::Point bufferPoint(CGPoint point, CGRect extent) {
+    return irl::Point((float)(point.x - CGRectGetMinX(extent)), (float)(CGRectGetMaxY(extent) - point.y));
+}
+
+static irl::PageFilter pageFilter(IRLScannerViewType type) {
+    switch (type) {
+        case IRLScannerViewTypeNormal:          return irl::PageFilter::Contrast;
+        case IRLScannerViewTypeBlackAndWhite:   return irl::PageFilter::Enhance;
+        case IRLScannerViewTypeUltraContrast:   return irl::PageFilter::UltraContrast;
+        case IRLScannerViewTypeBinarized:       return irl::PageFilter::Luma;
+        default:                                return irl::PageFilter::None;
+    }
+}
+
+@implementation IRLNativePageRenderer {
+    irl::PageRenderer   _renderer;
+}
+
++ (BOOL)supportsViewType:(IRLScannerViewType)type {
+    return type == IRLScannerViewTypeNormal || type == IRLScannerViewTypeBlackAndWhite || type == IRLScannerViewTypeUltraContrast;
+}
+
+// Decodes the photo and sets the renderer up, then hands the photo, the quad and the page size to `body`
+- (BOOL)renderImage:(CIImage *)image feature:(id<IRLRectangleFeatureProtocol>)feature viewType:(IRLScannerViewType)type margin:(CGFloat)margin
+            context:(CIContext *)context body:(BOOL (^)(const irl::ImageView& photo, const irl::Quad& quad, int pageWidth, int pageHeight))body {
+    CGRect extent = CGRectIntegral(image.extent);
+    if (CGRectIsEmpty(extent) || CGRectIsInfinite(extent)) return NO;
+    if (!context) context = [CIContext contextWithOptions:nil];
+
+    irl::PageRenderOptions options;
+    options.filter = pageFilter(type);
+    options.margin = (int)lround(margin);
+    // The Normal view keeps the colors, and so the cast of yellow or tungsten light without it
+    options.whiteBalance = type == IRLScannerViewTypeNormal;
+    options.denoise = self.denoise;
+    options.sharpen = self.sharpen;
+    // Sized once for the paper, not stretched along the side tilted away from the camera
+    const int width  = (int)CGRectGetWidth(extent);
+    const int height = (int)CGRectGetHeight(extent);
+    options.trueAspect = true;
+    options.camera = irl::CameraIntrinsics::centered(width, height, self.fieldOfView);
+    options.dpi = self.dpi;
+    if (self.bandBytes > 0) options.bandBytes = self.bandBytes;
+    _renderer.setOptions(options);
+
+    // The decoded photo only lives for the render
+    std::vector<uint8_t> source(4 * (size_t)width * (size_t)height);
+    CGColorSpaceRef rgb = CGColorSpaceCreateDeviceRGB();
+    [context render:image toBitmap:source.data() rowBytes:4 * (size_t)width bounds:extent format:kCIFormatBGRA8 colorSpace:rgb];
+    CGColorSpaceRelease(rgb);
+    irl::ImageView photo(source.data(), width, height, 4 * (size_t)width, irl::PixelFormat::BGRA8);
+
+    irl::Quad quad = irl::PageRenderer::frameQuad(photo);
+    if (feature) {
+        quad.topLeft     = bufferPoint(feature.topLeft,     extent);
+        quad.topRight    = bufferPoint(feature.topRight,    extent);
+        quad.bottomRight = bufferPoint(feature.bottomRight, extent);
+        quad.bottomLeft  = bufferPoint(feature.bottomLeft,  extent);
+    }
+
+    int pageWidth, pageHeight;
+    _renderer.outputSize(quad, pageWidth, pageHeight);
+    if (pageWidth <= 0 || pageHeight <= 0) return NO;
+    return body(photo, quad, pageWidth, pageHeight);
+}
+
+- (UIImage *)pageImageWithImage:(CIImage *)image feature:(id<IRLRectangleFeatureProtocol>)feature viewType:(IRLScannerViewType)type margin:(CGFloat)margin context:(CIContext *)context {
+    @synchronized (self) {
+        __block UIImage *result = nil;
+        [self renderImage:image feature:feature viewType:type margin:margin context:context
+                     body:^BOOL(const irl::ImageView& photo, const irl::Quad& quad, int pageWidth, int pageHeight) {
+            const BOOL    gray     = self->_renderer.outputFormat() == irl::PixelFormat::Gray8;
+            const size_t  rowBytes = (gray ? 1 : 4) * (size_t)pageWidth;
+            NSMutableData *pixels  = [NSMutableData dataWithLength:rowBytes * (size_t)pageHeight];
+            if (!pixels) return NO;
+            self->_renderer.render(photo, quad, (uint8_t *)pixels.mutableBytes, rowBytes);
+
+            CGColorSpaceRef space = gray ? CGColorSpaceCreateDeviceGray() : CGColorSpaceCreateDeviceRGB();
+            CGBitmapInfo    info  = gray ? (CGBitmapInfo)kCGImageAlphaNone : (CGBitmapInfo)(kCGBitmapByteOrder32Little | kCGImageAlphaPremultipliedFirst);
+            CGDataProviderRef provider = CGDataProviderCreateWithCFData((__bridge CFDataRef)pixels);
+            CGImageRef page = CGImageCreate(pageWidth, pageHeight, 8, gray ? 8 : 32, rowBytes, space, info, provider, NULL, false, kCGRenderingIntentDefault);
+            CGDataProviderRelease(provider);
+            CGColorSpaceRelease(space);
+            if (!page) return NO;
+
+            result = [UIImage imageWithCGImage:page];
+            CGImageRelease(page);
+            return YES;
+        }];
+        return result;
+    }
+}
+
+- (NSData *)pageJPEGDataWithImage:(CIImage *)image feature:(id<IRLRectangleFeatureProtocol>)feature viewType:(IRLScannerViewType)type margin:(CGFloat)margin
+               compressionQuality:(CGFloat)quality context:(CIContext *)context {
+    @synchronized (self) {
+        __block NSData *data = nil;
+        [self renderImage:image feature:feature viewType:type margin:margin context:context
+                     body:^BOOL(const irl::ImageView& photo, const irl::Quad& quad, int pageWidth, int pageHeight) {
+            const BOOL gray = self->_renderer.outputFormat() == irl::PixelFormat::Gray8;
+            // The paper white of the page, once for all its bands
+            self->_renderer.prepare(photo, quad);
+            data = IRLJPEGDataWithBands(pageWidth, pageHeight, gray, self->_renderer.bandRows(pageWidth), quality, ^(int top, int rows, uint8_t *band, size_t rowBytes) {
+                self->_renderer.renderRows(photo, quad, top, rows, band, rowBytes);
+            });
+            return data != nil;
+        }];
+        return data;
+    }
+}
+
+- (UIImage *)bilevelImageWithImage:(CIImage *)image feature:(id<IRLRectangleFeatureProtocol>)feature margin:(CGFloat)margin
+                         binarizer:(IRLNativeBinarizer *)binarizer context:(CIContext *)context {
+    @synchronized (self) {
+        __block UIImage *result = nil;
+        [self renderImage:image feature:feature viewType:IRLScannerViewTypeBinarized margin:margin context:context
+                     body:^BOOL(const irl::ImageView& photo, const irl::Quad& quad, int pageWidth, int pageHeight) {
+            self->_renderer.prepare(photo, quad);
+            result = [binarizer bilevelImageWithWidth:pageWidth height:pageHeight rows:^(int top, int rows, uint8_t *band, size_t rowBytes) {
+                self->_renderer.renderRows(photo, quad, top, rows, band, rowBytes);
+            }];
+            return result != nil;
+        }];
+        return result;
+    }
+}
+
+@end
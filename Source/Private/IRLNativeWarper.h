@@ -0,0 +1,81 @@
+//
+//  IRLNativeWarper.h
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+@import UIKit;
+@import CoreImage;
+
+/**
+ @brief Objective-C front end of the perspective warp of the native core (Source/Core/IRLPerspectiveWarp.hpp).
+
+ @discussion Replaces `CIPerspectiveCorrection`: the image is rendered to a BGRA bitmap once and rectified with the SIMD samplers,
+ on all the cores. The page is sized once with the aspect ratio of the paper (Source/Core/IRLPageAspect.hpp), not stretched along
+ the side tilted away from the camera.
+ */
+@interface IRLNativeWarper : NSObject
+
+/**
+ @return The warper of `-[CIImage correctPerspectiveWithFeatures:]`
+ */
++ (instancetype _Nonnull)sharedWarper;
+
+/**
+ @brief Angle of view of the camera in degrees across the long side of the images, as `AVCaptureDeviceFormat.videoFieldOfView`.
+ @discussion 0 when unknown, the default: the focal length is then estimated from the corners, when they allow it.
+ */
+@property (nonatomic, assign)   CGFloat     fieldOfView;
+
+/**
+ @brief Sample with a bicubic (Catmull-Rom) filter instead of a bilinear one: sharper text for about twice the time.
+ @discussion Defaults to NO.
+ */
+@property (nonatomic, assign)   BOOL        bicubic;
+
+/**
+ @brief Resolution of the page in dots per inch of the paper.
+ @discussion 0, the default, keeps the resolution of the image. A smaller page is sampled straight from the image with an area
+ filter instead of `bicubic`, without rectifying at full size first. Never enlarges the page.
+ */
+@property (nonatomic, assign)   CGFloat     dpi;
+
+/**
+ @brief Bytes of the page warped at once by `-JPEGDataWithImage:...`, whatever the size of the image.
+ @discussion 0, the default, for 4 MB.
+ */
+@property (nonatomic, assign)   NSUInteger  bandBytes;
+
+/**
+ @brief Rectify the quadrilateral of `image` delimited by the 4 corners.
+
+ @param image   The image, with a finite extent
+ @param topLeft Corners in the space of `image` (y up), in order around the page
+ @param context The context used to render `image`. If nil a default context is created.
+
+ @return A BGRA image of the rectified page with its origin at zero, or nil when `image` is empty or infinite
+ */
+- (CIImage * _Nullable)correctedImageWithImage:(CIImage * _Nonnull)image
+                                       topLeft:(CGPoint)topLeft
+                                      topRight:(CGPoint)topRight
+                                   bottomRight:(CGPoint)bottomRight
+                                    bottomLeft:(CGPoint)bottomLeft
+                                       context:(CIContext * _Nullable)context;
+
+/**
+ @brief Rectify the quadrilateral like above and encode the page to JPEG as it is warped, in bands of `bandBytes`.
+ @discussion The page is never whole in memory: besides the decoded image, a 48MP still needs the band and the encoder only.
+
+ @param quality The `kCGImageDestinationLossyCompressionQuality`, from 0 to 1
+
+ @return The JPEG file, or nil when `image` is empty or infinite or the encoder failed
+ */
+- (NSData * _Nullable)JPEGDataWithImage:(CIImage * _Nonnull)image
+                                topLeft:(CGPoint)topLeft
+                               topRight:(CGPoint)topRight
+                            bottomRight:(CGPoint)bottomRight
+                             bottomLeft:(CGPoint)bottomLeft
+                     compressionQuality:(CGFloat)quality
+                                context:(CIContext * _Nullable)context;
+
+@end
@@ -0,0 +1,119 @@
+//
+//  IRLNativeWarper.mm
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#import "IRLNativeWarper.h"
+#import "IRLBandEncoder.h"
+
+#include "IRLPageAspect.hpp"
+#include "IRLPerspectiveWarp.hpp"
+
+#include <vector>
+
+// Buffer space is y down, CoreImage space is y up
+static irl::Point bufferPoint(CGPoint point, CGRect extent) {
+    return irl::Point((float)(point.x - CGRectGetMinX(extent)), (float)(CGRectGetMaxY(extent) - point.y));
+}
+
+@implementation IRLNativeWarper {
+    irl::PerspectiveWarp    _warp;
+}
+
++ (instancetype)sharedWarper {
+    static IRLNativeWarper *warper;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        warper = [self new];
+    });
+    return warper;
+}
+
+- (void)setBicubic:(BOOL)bicubic {
+    _bicubic = bicubic;
+    irl::WarpOptions options = _warp.options();
+    options.interpolation = bicubic ? irl::Interpolation::Bicubic : irl::Interpolation::Bilinear;
+    _warp.setOptions(options);
+}
+
+// Rectifies the image, then hands the decoded source, the quad and the page size to `body`
+- (BOOL)warpImage:(CIImage *)image topLeft:(CGPoint)topLeft topRight:(CGPoint)topRight bottomRight:(CGPoint)bottomRight bottomLeft:(CGPoint)bottomLeft
+          context:(CIContext *)context body:(BOOL (^)(const irl::ImageView& source, const irl::Quad& quad, int pageWidth, int pageHeight))body {
+    CGRect extent = CGRectIntegral(image.extent);
+    if (CGRectIsEmpty(extent) || CGRectIsInfinite(extent)) return NO;
+    if (!context) context = [CIContext contextWithOptions:nil];
+
+    irl::Quad quad;
+    quad.topLeft     = bufferPoint(topLeft,     extent);
+    quad.topRight    = bufferPoint(topRight,    extent);
+    quad.bottomRight = bufferPoint(bottomRight, extent);
+    quad.bottomLeft  = bufferPoint(bottomLeft,  extent);
+
+    // Sized once for the paper: nothing downstream needs to resample the page to the right proportions
+    const int width  = (int)CGRectGetWidth(extent);
+    const int height = (int)CGRectGetHeight(extent);
+    const irl::CameraIntrinsics camera = irl::CameraIntrinsics::centered(width, height, self.fieldOfView);
+    int fullWidth, fullHeight, pageWidth, pageHeight;
+    irl::pageSize(quad, camera, fullWidth, fullHeight);
+    irl::PageAspectOptions aspect;
+    aspect.dpi = self.dpi;
+    irl::pageSize(quad, camera, pageWidth, pageHeight, aspect);
+    if (pageWidth <= 0 || pageHeight <= 0) return NO;
+
+    // Shrunk, every page pixel averages its whole footprint on the image
+    irl::WarpOptions options = _warp.options();
+    const irl::Interpolation interpolation = options.interpolation;
+    if (pageWidth < fullWidth || pageHeight < fullHeight) options.interpolation = irl::Interpolation::Area;
+    options.bandBytes = self.bandBytes > 0 ? self.bandBytes : irl::WarpOptions().bandBytes;
+    _warp.setOptions(options);
+
+    // The decoded image only lives for the warp
+    std::vector<uint8_t> source(4 * (size_t)width * (size_t)height);
+    CGColorSpaceRef rgb = CGColorSpaceCreateDeviceRGB();
+    [context render:image toBitmap:source.data() rowBytes:4 * (size_t)width bounds:extent format:kCIFormatBGRA8 colorSpace:rgb];
+    CGColorSpaceRelease(rgb);
+    const BOOL done = body(irl::ImageView(source.data(), width, height, 4 * (size_t)width, irl::PixelFormat::BGRA8), quad, pageWidth, pageHeight);
+
+    options.interpolation = interpolation;
+    _warp.setOptions(options);
+    return done;
+}
+
+- (CIImage *)correctedImageWithImage:(CIImage *)image topLeft:(CGPoint)topLeft topRight:(CGPoint)topRight bottomRight:(CGPoint)bottomRight bottomLeft:(CGPoint)bottomLeft context:(CIContext *)context {
+    @synchronized (self) {
+        __block CIImage *result = nil;
+        [self warpImage:image topLeft:topLeft topRight:topRight bottomRight:bottomRight bottomLeft:bottomLeft context:context
+                   body:^BOOL(const irl::ImageView& source, const irl::Quad& quad, int pageWidth, int pageHeight) {
+            const size_t   rowBytes = 4 * (size_t)pageWidth;
+            NSMutableData *pixels   = [NSMutableData dataWithLength:rowBytes * (size_t)pageHeight];
+            if (!pixels) return NO;
+            self->_warp.rectify(source, quad, pageWidth, pageHeight, (uint8_t *)pixels.mutableBytes, rowBytes);
+
+            CGColorSpaceRef rgb = CGColorSpaceCreateDeviceRGB();
+            result = [CIImage imageWithBitmapData:pixels bytesPerRow:rowBytes size:CGSizeMake(pageWidth, pageHeight)
+                                           format:kCIFormatBGRA8 colorSpace:rgb];
+            CGColorSpaceRelease(rgb);
+            return YES;
+        }];
+        return result;
+    }
+}
+
+- (NSData *)JPEGDataWithImage:(CIImage *)image topLeft:(CGPoint)topLeft topRight:(CGPoint)topRight bottomRight:(CGPoint)bottomRight bottomLeft:(CGPoint)bottomLeft
+           compressionQuality:(CGFloat)quality context:(CIContext *)context {
+    @synchronized (self) {
+        __block NSData *data = nil;
+        const BOOL encoded = [self warpImage:image topLeft:topLeft topRight:topRight bottomRight:bottomRight bottomLeft:bottomLeft context:context
+                                        body:^BOOL(const irl::ImageView& source, const irl::Quad& quad, int pageWidth, int pageHeight) {
+            const irl::Homography transform = irl::Homography::rectangleToQuad(pageWidth, pageHeight, quad);
+            data = IRLJPEGDataWithBands(pageWidth, pageHeight, NO, self->_warp.bandRows(pageWidth), quality, ^(int top, int rows, uint8_t *band, size_t rowBytes) {
+                self->_warp.warpRows(source, transform, pageWidth, top, rows, band, rowBytes);
+            });
+            return data != nil;
+        }];
+        return encoded ? data : nil;
+    }
+}
+
+@end
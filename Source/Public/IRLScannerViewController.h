@@ -25,7 +25,13 @@ typedef NS_ENUM(NSInteger,IRLScannerViewType)
     IRLScannerViewTypeBlackAndWhite,
     
     /** Use a black/white Ultra contrasted camera */
-    IRLScannerViewTypeUltraContrast
+    IRLScannerViewTypeUltraContrast,
+    
+    /** Pure black and white with a local threshold, robust to shadows. The captured image has 1 bit per pixel. */
+    IRLScannerViewTypeBinarized,
+    
+    /** Colors kept, lamp gradients and soft shadows removed so the paper comes out evenly white */
+    IRLScannerViewTypeShadowRemoval
 };
 
 /**
@@ -37,7 +43,19 @@ typedef NS_ENUM(NSInteger,IRLScannerDetectorType)
     IRLScannerDetectorTypeAccuracy,
     
     /** Use Fast detection */
-    IRLScannerDetectorTypePerformance
+    IRLScannerDetectorTypePerformance,
+    
+    /** Use our portable native detector instead of CoreImage (same engine as our Linux tools) */
+    IRLScannerDetectorTypeNative,
+    
+    /** Native detector finding the document on a 1/4 scale luma, corners refined up to full resolution */
+    IRLScannerDetectorTypeNativePyramidQuarter,
+    
+    /** Native detector finding the document on a 1/8 scale luma, corners refined up to full resolution */
+    IRLScannerDetectorTypeNativePyramidEighth,
+    
+    /** Native detector assembling the document from straight edges, works on low contrast backgrounds as long as the page outline is visible */
+    IRLScannerDetectorTypeNativeLines
 };
 
 
@@ -150,6 +168,15 @@ NS_CLASS_AVAILABLE(NA, 8_0)
  */
 @property (readonly, nonatomic) IRLScannerDetectorType               detectorType;
 
+/**
+ @brief Resolution of the scanned page, in dots per inch of the paper (e.g. 200 for a 1700x2200 Letter page).
+ 
+ @discussion The photo is rectified straight to that size with an area filter, so large sensors do not pay for a full resolution page that is shrunk afterwards. The page is never enlarged.
+ 
+ @warning Default value is 0: the page keeps the resolution of the photo.
+ */
+@property (readwrite, nonatomic)      CGFloat                       pageDPI;
+
 /**
  @brief This Boolan will show/hide the controlls of the camera. The controlls includ flash_toggle (If available), contrast_type, detect_toggle
  
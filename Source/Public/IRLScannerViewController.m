@@ -84,6 +84,11 @@
     [self.cameraView setDetectorType:detectorType];
 }
 
+- (void)setPageDPI:(CGFloat)pageDPI {
+    _pageDPI = pageDPI;
+    [self.cameraView setPageDPI:pageDPI];
+}
+
 - (void)setShowControls:(BOOL)showControls {
     _showControls = showControls;
     [self updateTitleLabel:nil];
@@ -104,6 +109,7 @@
     [self.cameraView setOverlayColor:self.detectionOverlayColor];
     [self.cameraView setDetectorType:self.detectorType];
     [self.cameraView setCameraViewType:self.cameraViewType];
+    [self.cameraView setPageDPI:self.pageDPI];
     [self.cameraView setEnableShowAutoFocus:self.showAutoFocusWhiteRectangle];
 
     if (![self.cameraView hasFlash]){
@@ -176,6 +182,12 @@
             [self setCameraViewType:IRLScannerViewTypeUltraContrast];
             break;
         case IRLScannerViewTypeUltraContrast:
+            [self setCameraViewType:IRLScannerViewTypeBinarized];
+            break;
+        case IRLScannerViewTypeBinarized:
+            [self setCameraViewType:IRLScannerViewTypeShadowRemoval];
+            break;
+        case IRLScannerViewTypeShadowRemoval:
             [self setCameraViewType:IRLScannerViewTypeBlackAndWhite];
             break;
         default:
@@ -246,6 +258,13 @@
         case IRLScannerViewTypeUltraContrast:
             [self.contrast_type setHighlighted:YES];
             break;
+        case IRLScannerViewTypeBinarized:
+            [self.contrast_type setSelected:YES];
+            [self.contrast_type setHighlighted:YES];
+            break;
+        case IRLScannerViewTypeShadowRemoval:
+            // A color page, like Normal
+            break;
         default:
             break;
     }
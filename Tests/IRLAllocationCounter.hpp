@@ -0,0 +1,49 @@
+//
+//  IRLAllocationCounter.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Counts heap allocations of the whole process by replacing the global operator new.
+//  Include it in exactly one translation unit of a test or benchmark executable.
+//
+
+#ifndef IRL_ALLOCATION_COUNTER_HPP
+#define IRL_ALLOCATION_COUNTER_HPP
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace irl {
+namespace test {
+
+inline std::atomic<long>& allocationCounter() {
+    static std::atomic<long> counter(0);
+    return counter;
+}
+
+/** @return Number of operator new calls since the start of the process */
+inline long allocationCount() {
+    return allocationCounter().load();
+}
+
+} // namespace test
+} // namespace irl
+
+void* operator new(std::size_t size) {
+    irl::test::allocationCounter()++;
+    if (void* pointer = std::malloc(size ? size : 1)) return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* pointer) noexcept             { std::free(pointer); }
+void operator delete[](void* pointer) noexcept           { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept   { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { std::free(pointer); }
+
+#endif /* IRL_ALLOCATION_COUNTER_HPP */
@@ -0,0 +1,55 @@
+//
+//  IRLArenaTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLArena.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+using namespace irl;
+
+TEST(Arena, AllocationsAreAlignedAndDisjoint) {
+    Arena arena(1024);
+    uint8_t*  a = arena.allocate<uint8_t>(3);
+    uint16_t* b = arena.allocate<uint16_t>(10);
+    float*    c = arena.allocate<float>(1);
+
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % 64, 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 64, 0u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(c) % 64, 0u);
+    EXPECT_GE(reinterpret_cast<uint8_t*>(b), a + 3);
+    EXPECT_GE(reinterpret_cast<uint8_t*>(c), reinterpret_cast<uint8_t*>(b + 10));
+    EXPECT_EQ(arena.used(), 192u);
+}
+
+TEST(Arena, ResetReusesTheBlock) {
+    Arena arena(4096);
+    const int allocations = arena.heapAllocations();
+    void* first = arena.allocate<uint8_t>(100);
+    arena.reset();
+    EXPECT_EQ(arena.used(), 0u);
+    EXPECT_EQ(arena.allocate<uint8_t>(100), first);
+    EXPECT_EQ(arena.heapAllocations(), allocations);
+}
+
+TEST(Arena, GrowsToTheLastFrameAfterOverflow) {
+    Arena arena(256);
+    for (int i = 0; i < 10; i++) arena.allocate<uint32_t>(100);     // 10 * 448 bytes, overflows
+    const int overflowed = arena.heapAllocations();
+    EXPECT_GT(overflowed, 1);
+
+    // The next frame fits in the new block: a single allocation, then none
+    arena.reset();
+    EXPECT_GE(arena.capacity(), 4480u);
+    EXPECT_EQ(arena.heapAllocations(), overflowed + 1);
+    for (int frame = 0; frame < 3; frame++) {
+        for (int i = 0; i < 10; i++) arena.allocate<uint32_t>(100);
+        arena.reset();
+    }
+    EXPECT_EQ(arena.heapAllocations(), overflowed + 1);
+}
@@ -0,0 +1,67 @@
+//
+//  IRLBandDetectorTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLBandDetector.hpp"
+#include "IRLFrameSequence.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace irl;
+using namespace irl::test;
+
+TEST(BandDetector, FollowsHandHeldSequence) {
+    const FrameSequence sequence;
+    BandDetector detector;
+
+    // Each frame is searched around the quad found in the previous one
+    Quad previous = sequence.corners(0);
+    float worst = 0.0f;
+    for (int i = 1; i <= 40; i++) {
+        Quad quad;
+        ASSERT_TRUE(detector.detect(sequence.frame(i).view(), previous, quad)) << "frame " << i;
+        worst = std::max(worst, cornerError(quad, sequence.corners(i)));
+        previous = quad;
+    }
+    EXPECT_LT(worst, 0.5f);
+    EXPECT_EQ(detector.counters().attempts, 40u);
+    EXPECT_EQ(detector.counters().served, 40u);
+    EXPECT_FLOAT_EQ(detector.counters().servedFraction(), 1.0f);
+}
+
+TEST(BandDetector, FallsBackWhenPageLeaves) {
+    SyntheticPage empty;
+    empty.width   = 960;
+    empty.height  = 720;
+    empty.corners = pageCorners(empty.width, empty.height, 0.45f, 0.0f);
+    empty.text    = false;
+    Frame frame   = renderPage(empty);
+
+    BandDetector detector;
+    const Quad previous = pageCorners(empty.width, empty.height, 0.18f, 19.0f);
+    Quad quad = previous;
+    EXPECT_FALSE(detector.detect(frame.view(), previous, quad));
+    EXPECT_EQ(cornerError(quad, previous), 0.0f);
+    EXPECT_EQ(detector.counters().attempts, 1u);
+    EXPECT_EQ(detector.counters().served, 0u);
+}
+
+TEST(BandDetector, FallsBackWhenPageJumpsOutOfBand) {
+    SyntheticPage page;
+    page.width   = 960;
+    page.height  = 720;
+    page.corners = pageCorners(page.width, page.height, 0.18f, 19.0f);
+    Frame frame  = renderPage(page);
+
+    BandDetector detector;
+    Quad quad;
+    EXPECT_TRUE(detector.detect(frame.view(), page.corners, quad));
+
+    Quad moved = page.corners;
+    for (int k = 0; k < 4; k++) moved[k] = moved[k] + Point(90.0f, 70.0f);
+    EXPECT_FALSE(detector.detect(frame.view(), moved, quad));
+    EXPECT_FLOAT_EQ(detector.counters().servedFraction(), 0.5f);
+}
@@ -0,0 +1,145 @@
+//
+//  IRLBinarizerTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLBinarizer.hpp"
+#include "IRLSyntheticPage.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace irl;
+using namespace irl::test;
+
+/** Text lines on paper under a strong shadow: a quarter of the light on the left side, all of it on the right */
+struct ShadedText {
+    Plane8 luma;
+    Plane8 ink;     // 1 on text pixels
+
+    ShadedText(int width, int height) : luma(width, height), ink(width, height) {
+        XorShift random(21);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                const bool  text  = y % 16 >= 6 && y % 16 < 10 && (x + 7 * (y / 16)) % 40 < 30;
+                const float light = 0.25f + 0.75f * x / width;
+                const int   value = static_cast<int>((text ? 50.0f : 210.0f) * light + 0.5f) + random.noise(3);
+                luma.row(y)[x] = static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+                ink.row(y)[x]  = text ? 1 : 0;
+            }
+        }
+    }
+
+    float errorRate(const BitPlane& bits) const {
+        int wrong = 0;
+        for (int y = 0; y < luma.height(); y++) {
+            for (int x = 0; x < luma.width(); x++) wrong += bits.isSet(x, y) != (ink.row(y)[x] != 0);
+        }
+        return static_cast<float>(wrong) / (luma.width() * luma.height());
+    }
+};
+
+TEST(Binarizer, KeepsTextUnderShadows) {
+    ShadedText page(640, 400);
+
+    // A global threshold turns the shadowed paper black
+    BitPlane global(640, 400);
+    for (int y = 0; y < 400; y++) {
+        std::fill(global.row(y), global.row(y) + global.stride(), 0);
+        for (int x = 0; x < 640; x++) if (page.luma.row(y)[x] < 128) global.row(y)[x >> 3] |= 0x80 >> (x & 7);
+    }
+    EXPECT_GT(page.errorRate(global), 0.2f);
+
+    for (ThresholdMethod method : { ThresholdMethod::Sauvola, ThresholdMethod::Bradley }) {
+        BinarizerOptions options;
+        options.method       = method;
+        options.windowRadius = 12;
+        BitPlane bits;
+        Binarizer(options).binarize(page.luma.view(), bits);
+        EXPECT_LT(page.errorRate(bits), 0.02f) << (method == ThresholdMethod::Sauvola ? "sauvola" : "bradley");
+    }
+}
+
+TEST(Binarizer, BandsAndThreadsDoNotChangeTheResult) {
+    ShadedText page(333, 257);
+
+    BinarizerOptions options;
+    options.windowRadius = 9;
+    options.bandHeight   = 1000;
+    options.threads      = 1;
+    BitPlane expected;
+    Binarizer(options).binarize(page.luma.view(), expected);
+
+    for (int bandHeight : { 1, 7, 64 }) {
+        for (int threads : { 1, 3 }) {
+            options.bandHeight = bandHeight;
+            options.threads    = threads;
+            BitPlane bits;
+            Binarizer(options).binarize(page.luma.view(), bits);
+            ASSERT_EQ(bits.stride(), expected.stride());
+            for (int y = 0; y < bits.height(); y++) {
+                ASSERT_EQ(0, std::memcmp(bits.row(y), expected.row(y), bits.stride())) << "band " << bandHeight << " threads " << threads << " row " << y;
+            }
+        }
+    }
+}
+
+TEST(Binarizer, StreamedRowsGiveTheBitsOfTheWholeImage) {
+    ShadedText page(333, 257);
+
+    BinarizerOptions options;
+    options.windowRadius = 9;
+    options.threads      = 1;
+    BitPlane expected;
+    Binarizer(options).binarize(page.luma.view(), expected);
+
+    for (int bandHeight : { 1, 40 }) {
+        for (int threads : { 1, 3 }) {
+            options.bandHeight = bandHeight;
+            options.threads    = threads;
+            int asked = 0, most = 0;
+            BitPlane bits;
+            Binarizer(options).binarize(page.luma.width(), page.luma.height(), [&](int top, int count, uint8_t* destination, size_t stride) {
+                for (int y = 0; y < count; y++) std::memcpy(destination + stride * static_cast<size_t>(y), page.luma.row(top + y), static_cast<size_t>(page.luma.width()));
+                asked += count;
+                most = std::max(most, count);
+            }, bits);
+
+            ASSERT_EQ(bits.stride(), expected.stride());
+            for (int y = 0; y < bits.height(); y++) {
+                ASSERT_EQ(0, std::memcmp(bits.row(y), expected.row(y), bits.stride())) << "band " << bandHeight << " threads " << threads << " row " << y;
+            }
+            // Every row once, plus the window radius around every step, and never the whole image at once
+            EXPECT_GE(asked, page.luma.height());
+            EXPECT_LT(most, page.luma.height());
+        }
+    }
+}
+
+TEST(Binarizer, PacksLeftmostPixelInTopBit) {
+    // One dark pixel per row on a flat bright plane, 13 columns so the last byte has padding
+    Plane8 luma(13, 13);
+    for (int y = 0; y < 13; y++) {
+        for (int x = 0; x < 13; x++) luma.row(y)[x] = x == y ? 20 : 200;
+    }
+
+    BinarizerOptions options;
+    options.windowRadius = 3;
+    BitPlane bits;
+    Binarizer(options).binarize(luma.view(), bits);
+    ASSERT_EQ(bits.stride(), 2u);
+    for (int y = 0; y < 13; y++) {
+        for (int x = 0; x < 13; x++) EXPECT_EQ(bits.isSet(x, y), x == y) << x << "," << y;
+        EXPECT_EQ(bits.row(y)[1] & 0x07, 0) << "padding of row " << y;
+    }
+    EXPECT_EQ(bits.row(0)[0], 0x80);
+
+    Plane8 gray;
+    Binarizer(options).binarize(luma.view(), gray);
+    EXPECT_EQ(gray.row(4)[4], 0);
+    EXPECT_EQ(gray.row(4)[5], 255);
+}
@@ -0,0 +1,203 @@
+//
+//  IRLColorControlsTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  The fused tables must stay within 1 of the CIColorControls chain evaluated in double precision,
+//  and every vector variant must give the same bits as the scalar reference.
+//
+
+#include "IRLColorControls.hpp"
+#include "IRLColorKernels.hpp"
+#include "IRLSyntheticPage.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+
+using namespace irl;
+using namespace irl::test;
+
+static std::vector<uint8_t> randomPixels(int count, uint32_t seed) {
+    XorShift random(seed);
+    std::vector<uint8_t> pixels(static_cast<size_t>(count) * 4);
+    for (uint8_t& value : pixels) value = static_cast<uint8_t>(random.next() >> 24);
+    return pixels;
+}
+
+/** CIColorControls in a linear sRGB working space, as rendered by a default CIContext */
+static void referencePixel(const uint8_t* source, uint8_t* destination, const ColorControlsOptions& options) {
+    auto decode = [](double v) { return v <= 0.04045 ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4); };
+    auto encode = [](double v) { return v <= 0.0031308 ? v * 12.92 : 1.055 * std::pow(v, 1.0 / 2.4) - 0.055; };
+
+    double c[3];
+    for (int i = 0; i < 3; i++) c[i] = decode(source[i] / 255.0);
+    const double luma = 0.0721 * c[0] + 0.7154 * c[1] + 0.2125 * c[2];
+    for (int i = 0; i < 3; i++) {
+        double v = luma + options.saturation * (c[i] - luma);
+        v = (v + options.brightness - 0.5) * options.contrast + 0.5;
+        v = std::min(std::max(v, 0.0), 1.0);
+        destination[i] = static_cast<uint8_t>(std::lround(encode(v) * 255.0));
+    }
+    destination[3] = source[3];
+}
+
+static void expectMatchesReference(const ColorControlsOptions& options, const char* name) {
+    std::vector<uint8_t> pixels = randomPixels(4096, 3);
+    for (int v = 0; v < 256; v++) std::memset(&pixels[4 * v], v, 4);
+
+    ColorControls controls(options, SimdLevel::Scalar);
+    std::vector<uint8_t> filtered(pixels.size());
+    controls.apply(ImageView(pixels.data(), 4096, 1, pixels.size(), PixelFormat::BGRA8), filtered.data(), filtered.size());
+
+    int worst = 0;
+    for (size_t p = 0; p < pixels.size(); p += 4) {
+        uint8_t expected[4];
+        referencePixel(&pixels[p], expected, options);
+        for (int i = 0; i < 4; i++) worst = std::max(worst, std::abs(expected[i] - filtered[p + i]));
+    }
+    EXPECT_LE(worst, 1) << name;
+}
+
+TEST(ColorControls, MatchesCoreImageFormula) {
+    expectMatchesReference(enhanceColorControls(), "enhance");
+    expectMatchesReference(contrastColorControls(), "contrast");
+
+    ColorControlsOptions options;
+    options.saturation  = 0.35f;
+    options.brightness  = 0.04f;
+    options.contrast    = 0.8f;
+    expectMatchesReference(options, "mixed");
+}
+
+/**
+ Gray ramp 0 ... 255 through CIColorControls with saturation 0, as a default CIContext renders it on the GPU: sRGB
+ decoded to float16 (RGBAh) linear values, the kernel in float, its result stored in float16, then encoded to sRGB bytes.
+ Generated from that model of the CoreImage pipeline, not captured from a device.
+ */
+static const uint8_t kCoreImageRamp110[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   4,  10,  15,
+     19,  22,  25,  28,  31,  33,  36,  38,  40,  42,  44,  46,  48,  50,  52,  53,
+     55,  57,  58,  60,  62,  63,  65,  66,  68,  69,  71,  72,  74,  75,  76,  78,
+     79,  81,  82,  83,  85,  86,  87,  89,  90,  91,  93,  94,  95,  96,  98,  99,
+    100, 102, 103, 104, 105, 107, 108, 109, 110, 111, 113, 114, 115, 116, 117, 119,
+    120, 121, 122, 123, 125, 126, 127, 128, 129, 131, 132, 133, 134, 135, 136, 138,
+    139, 140, 141, 142, 143, 144, 146, 147, 148, 149, 150, 151, 152, 153, 155, 156,
+    157, 158, 159, 160, 161, 162, 164, 165, 166, 167, 168, 169, 170, 171, 173, 174,
+    175, 176, 177, 178, 179, 180, 181, 183, 184, 185, 186, 187, 188, 189, 190, 191,
+    193, 194, 195, 196, 197, 198, 199, 200, 201, 202, 203, 204, 206, 207, 208, 209,
+    210, 211, 212, 213, 214, 215, 216, 218, 219, 220, 221, 222, 223, 224, 225, 226,
+    227, 228, 229, 230, 232, 233, 234, 235, 236, 237, 238, 239, 240, 241, 242, 243,
+    244, 246, 247, 248, 249, 250, 251, 252, 253, 254, 255, 255, 255, 255, 255, 255,
+};
+
+static const uint8_t kCoreImageRamp114[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   6,  13,  18,  22,  26,  29,  32,  35,  38,
+     40,  43,  45,  47,  49,  51,  53,  55,  57,  59,  61,  63,  64,  66,  68,  70,
+     71,  73,  74,  76,  78,  79,  81,  82,  84,  85,  87,  88,  89,  91,  92,  94,
+     95,  97,  98,  99, 101, 102, 103, 105, 106, 107, 109, 110, 111, 113, 114, 115,
+    116, 118, 119, 120, 122, 123, 124, 125, 127, 128, 129, 130, 132, 133, 134, 135,
+    136, 138, 139, 140, 141, 143, 144, 145, 146, 147, 149, 150, 151, 152, 153, 154,
+    156, 157, 158, 159, 160, 162, 163, 164, 165, 166, 167, 169, 170, 171, 172, 173,
+    174, 175, 177, 178, 179, 180, 181, 182, 183, 185, 186, 187, 188, 189, 190, 191,
+    193, 194, 195, 196, 197, 198, 199, 201, 202, 203, 204, 205, 206, 207, 208, 210,
+    211, 212, 213, 214, 215, 216, 217, 219, 220, 221, 222, 223, 224, 225, 226, 227,
+    229, 230, 231, 232, 233, 234, 235, 236, 237, 238, 240, 241, 242, 243, 244, 245,
+    246, 247, 248, 250, 251, 252, 253, 254, 255, 255, 255, 255, 255, 255, 255, 255,
+};
+
+TEST(ColorControls, MatchesTheCoreImageRamps) {
+    struct Ramp { float contrast; const uint8_t* samples; };
+    for (const Ramp& ramp : { Ramp{ 1.1f, kCoreImageRamp110 }, Ramp{ 1.14f, kCoreImageRamp114 } }) {
+        ColorControlsOptions options;
+        options.saturation = 0.0f;
+        options.contrast   = ramp.contrast;
+
+        std::vector<uint8_t> pixels(4 * 256), filtered(pixels.size());
+        for (int v = 0; v < 256; v++) std::memset(&pixels[4 * v], v, 4);
+        ColorControls(options).apply(ImageView(pixels.data(), 256, 1, pixels.size(), PixelFormat::BGRA8), filtered.data(), filtered.size());
+
+        // The float16 working values round differently from the Q14 tables: 1 at most, the tolerance of IRLColorControls.hpp
+        int worst = 0;
+        for (int v = 0; v < 256; v++) worst = std::max(worst, std::abs(filtered[4 * v] - ramp.samples[v]));
+        EXPECT_LE(worst, 1) << "contrast " << ramp.contrast;
+    }
+}
+
+TEST(ColorControls, VectorVariantsAreBitExact) {
+    ColorControlsOptions mixed;
+    mixed.saturation = 0.6f;
+    mixed.contrast   = 1.3f;
+    ColorControlsOptions balanced = contrastColorControls();
+    balanced.gains[0] = 1.2f;
+    balanced.gains[2] = 0.9f;
+    ColorControlsOptions dark = enhanceColorControls();
+    dark.brightness = -0.2f;
+
+    for (SimdLevel level : { SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::NEON }) {
+        if (!detail::colorKernels(level)) continue;
+        for (const ColorControlsOptions& options : { enhanceColorControls(), contrastColorControls(), mixed, balanced, dark }) {
+            // Odd width so the row ends go through the scalar tail
+            const int width = 333, height = 7;
+            std::vector<uint8_t> pixels = randomPixels(width * height, 11);
+            ImageView view(pixels.data(), width, height, static_cast<size_t>(width) * 4, PixelFormat::BGRA8);
+
+            std::vector<uint8_t> expected(pixels.size()), actual(pixels.size());
+            ColorControls(options, SimdLevel::Scalar).apply(view, expected.data(), view.stride);
+            ColorControls vector(options, level);
+            ASSERT_EQ(vector.simdLevel(), level);
+            vector.apply(view, actual.data(), view.stride);
+            EXPECT_EQ(expected, actual) << simdLevelName(level) << " saturation " << options.saturation;
+        }
+    }
+}
+
+TEST(ColorControls, FiltersInPlace) {
+    std::vector<uint8_t> pixels = randomPixels(97 * 5, 5);
+    ImageView view(pixels.data(), 97, 5, 97 * 4, PixelFormat::BGRA8);
+
+    ColorControls controls(enhanceColorControls());
+    std::vector<uint8_t> expected(pixels.size());
+    controls.apply(view, expected.data(), view.stride);
+    controls.apply(view, pixels.data(), view.stride);
+    EXPECT_EQ(expected, pixels);
+}
+
+TEST(ColorControls, GrayAndBiPlanarSourcesMatchTheirBGRA) {
+    SyntheticPage page;
+    page.width   = 161;
+    page.height  = 97;
+    page.corners = pageCorners(page.width, page.height, 0.2f, 6.0f);
+    Frame bgra   = renderPage(page);
+    Frame gray   = renderPage(page, PixelFormat::Gray8);
+    BiPlanarFrame nv12 = encodeBiPlanar(bgra);
+
+    ColorControls controls(contrastColorControls());
+    const size_t stride = bgra.stride;
+
+    // Gray8 is filtered like a BGRA frame with three equal channels
+    std::vector<uint8_t> expanded(stride * page.height), expected(expanded.size()), actual(expanded.size());
+    for (size_t i = 0; i < gray.pixels.size(); i++) {
+        std::memset(&expanded[4 * i], gray.pixels[i], 3);
+        expanded[4 * i + 3] = 255;
+    }
+    controls.apply(ImageView(expanded.data(), page.width, page.height, stride, PixelFormat::BGRA8), expected.data(), stride);
+    controls.apply(gray.view(), actual.data(), stride);
+    EXPECT_EQ(expected, actual);
+
+    // Bi-planar is filtered like its BGRA conversion
+    std::vector<uint8_t> converted(stride * page.height);
+    convertToBGRA(nv12.view(), converted.data(), stride);
+    controls.apply(ImageView(converted.data(), page.width, page.height, stride, PixelFormat::BGRA8), expected.data(), stride);
+    controls.apply(nv12.view(), actual.data(), stride);
+    EXPECT_EQ(expected, actual);
+}
@@ -0,0 +1,91 @@
+//
+//  IRLCornerRefinerTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLCornerRefiner.hpp"
+#include "IRLSyntheticPage.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace irl;
+using namespace irl::test;
+
+static Quad perturbed(const Quad& quad, float amplitude, uint32_t seed) {
+    XorShift random(seed);
+    Quad result = quad;
+    for (int k = 0; k < 4; k++) {
+        result[k].x += amplitude * (static_cast<float>(random.next() % 2001) / 1000.0f - 1.0f);
+        result[k].y += amplitude * (static_cast<float>(random.next() % 2001) / 1000.0f - 1.0f);
+    }
+    return result;
+}
+
+TEST(CornerRefiner, RecoversSubPixelCornersOnStill) {
+    SyntheticPage page;
+    page.width   = 4032;
+    page.height  = 3024;
+    page.corners = pageCorners(page.width, page.height, 0.11f, 97.3f);
+    Frame frame  = renderPage(page);
+
+    for (uint32_t seed = 1; seed <= 4; seed++) {
+        Quad quad = perturbed(page.corners, 5.0f, seed);
+        ASSERT_GT(cornerError(quad, page.corners), 1.0f);
+
+        EXPECT_EQ(refineQuad(frame.view(), quad), 4);
+        EXPECT_LT(cornerError(quad, page.corners), 0.35f) << "seed " << seed;
+    }
+}
+
+TEST(CornerRefiner, GrayAndBGRAAgree) {
+    SyntheticPage page;
+    page.width   = 1440;
+    page.height  = 1080;
+    page.corners = pageCorners(page.width, page.height, 0.15f, 40.0f);
+    Frame bgra   = renderPage(page, PixelFormat::BGRA8);
+    Frame gray   = renderPage(page, PixelFormat::Gray8);
+
+    Quad a = perturbed(page.corners, 3.0f, 9), b = a;
+    refineQuad(bgra.view(), a);
+    refineQuad(gray.view(), b);
+    EXPECT_LT(cornerError(a, b), 0.25f);
+    EXPECT_LT(cornerError(a, page.corners), 0.35f);
+}
+
+TEST(CornerRefiner, FitsStraightEdgeWithOutliers) {
+    // Vertical edge at x = 20.25, blurred like through a lens, with a dark blob sitting on it
+    const int width = 48, height = 96;
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const float step = 1.0f / (1.0f + std::exp(-(x + 0.5f - 20.25f) / 0.8f));
+            int value = static_cast<int>(60.0f + 140.0f * step + 0.5f);
+            if (y >= 40 && y < 46 && x >= 23 && x < 27) value = 20;
+            pixels[static_cast<size_t>(y) * width + x] = static_cast<uint8_t>(value);
+        }
+    }
+    ImageView image(pixels.data(), width, height, width, PixelFormat::Gray8);
+
+    EdgeLine line;
+    ASSERT_TRUE(fitEdgeLine(image, Point(22.0f, 2.0f), Point(22.0f, 94.0f), CornerRefinerOptions(), line));
+    EXPECT_NEAR(line.point.x, 20.25f, 0.05f);
+    EXPECT_NEAR(std::fabs(line.direction.y), 1.0f, 1e-4f);
+    EXPECT_LT(line.residual, 0.05f);
+}
+
+TEST(CornerRefiner, KeepsCornersWithoutEdges) {
+    std::vector<uint8_t> pixels(64 * 64, 128);
+    ImageView flat(pixels.data(), 64, 64, 64, PixelFormat::Gray8);
+
+    Quad quad;
+    quad.topLeft     = Point(10, 10);
+    quad.topRight    = Point(50, 10);
+    quad.bottomRight = Point(50, 50);
+    quad.bottomLeft  = Point(10, 50);
+    const Quad original = quad;
+
+    EXPECT_EQ(refineQuad(flat, quad), 0);
+    EXPECT_EQ(cornerError(quad, original), 0.0f);
+}
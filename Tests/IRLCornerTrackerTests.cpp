@@ -0,0 +1,115 @@
+//
+//  IRLCornerTrackerTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLCornerTracker.hpp"
+#include "IRLFrameSequence.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+using namespace irl;
+using namespace irl::test;
+
+static float meanCornerError(const Quad& a, const Quad& b) {
+    float sum = 0.0f;
+    for (int k = 0; k < 4; k++) sum += distance(a[k], b[k]);
+    return 0.25f * sum;
+}
+
+TEST(CornerTracker, FollowsHandHeldSequence) {
+    const FrameSequence sequence;
+    const int count = 60;
+
+    // Detection is simulated by the true corners, off by up to a pixel like a refined detection
+    CornerTracker tracker;
+    Quad detected = sequence.corners(0);
+    detected.topLeft = detected.topLeft + Point(0.6f, -0.4f);
+    detected.bottomRight = detected.bottomRight + Point(-0.3f, 0.7f);
+    tracker.start(sequence.frame(0).view(), detected);
+
+    float  sum = 0.0f, worst = 0.0f;
+    int    detections = 1;
+    double milliseconds = 0.0;
+    for (int i = 1; i < count; i++) {
+        Frame frame = sequence.frame(i);
+        const Quad truth = sequence.corners(i);
+
+        auto start = std::chrono::steady_clock::now();
+        ASSERT_TRUE(tracker.track(frame.view())) << "lost at frame " << i << ", error " << tracker.lastError();
+        milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        const float error = meanCornerError(tracker.quad(), truth);
+        sum  += error;
+        worst = std::max(worst, cornerError(tracker.quad(), truth));
+
+        if (tracker.needsDetection()) {
+            tracker.start(frame.view(), truth, true);
+            detections++;
+        }
+    }
+
+    std::printf("  %d frames, %d detections, mean corner error %.2f px, worst %.2f px, %.3f ms per frame\n",
+                count, detections, sum / (count - 1), worst, milliseconds / (count - 1));
+    EXPECT_LT(sum / (count - 1), 0.9f);
+    EXPECT_LT(worst, 2.5f);
+    EXPECT_EQ(detections, 1 + (count - 1) / tracker.options().redetectInterval);
+}
+
+TEST(CornerTracker, DriftStaysSmallWithoutDetection) {
+    const FrameSequence sequence;
+    CornerTrackerOptions options;
+    options.redetectInterval = 1000;
+    CornerTracker tracker(options);
+    tracker.start(sequence.frame(0).view(), sequence.corners(0));
+
+    for (int i = 1; i <= 30; i++) {
+        const Quad before = tracker.quad();
+        ASSERT_TRUE(tracker.track(sequence.frame(i).view())) << "lost at frame " << i;
+        EXPECT_FALSE(tracker.needsDetection());
+
+        float moved = 0.0f;
+        for (int k = 0; k < 4; k++) moved += distance(before[k], tracker.quad()[k]);
+        EXPECT_NEAR(tracker.motion(), 0.25f * moved, 1e-3f);
+    }
+    EXPECT_EQ(tracker.framesSinceStart(), 30);
+    EXPECT_LT(cornerError(tracker.quad(), sequence.corners(30)), 4.0f);
+}
+
+TEST(CornerTracker, LosesQuadOnSceneCut) {
+    const FrameSequence sequence;
+    CornerTracker tracker;
+    tracker.start(sequence.frame(0).view(), sequence.corners(0));
+    ASSERT_TRUE(tracker.track(sequence.frame(1).view()));
+
+    // The page leaves the frame: only desk is left around the corners
+    SyntheticPage empty;
+    empty.width   = sequence.width;
+    empty.height  = sequence.height;
+    empty.corners = pageCorners(sequence.width, sequence.height, 0.45f, 0.0f);
+    empty.text    = false;
+    Frame cut = renderPage(empty);
+
+    const Quad last = tracker.quad();
+    EXPECT_FALSE(tracker.track(cut.view()));
+    EXPECT_FALSE(tracker.isTracking());
+    EXPECT_TRUE(tracker.needsDetection());
+    EXPECT_GT(tracker.lastError(), tracker.options().maximumError);
+    EXPECT_EQ(cornerError(tracker.quad(), last), 0.0f);
+}
+
+TEST(CornerTracker, TracksGrayFramesLikeBGRA) {
+    const FrameSequence sequence;
+    CornerTracker bgra, gray;
+    bgra.start(sequence.frame(0).view(), sequence.corners(0));
+    gray.start(sequence.frame(0, PixelFormat::Gray8).view(), sequence.corners(0));
+    for (int i = 1; i <= 5; i++) {
+        ASSERT_TRUE(bgra.track(sequence.frame(i).view()));
+        ASSERT_TRUE(gray.track(sequence.frame(i, PixelFormat::Gray8).view()));
+    }
+    EXPECT_LT(cornerError(bgra.quad(), gray.quad()), 0.5f);
+}
@@ -0,0 +1,110 @@
+//
+//  IRLDetectionSchedulerTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLDetectionScheduler.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace irl;
+
+/** Frames between the first two detections, running `frames` tracked frames */
+static int detectionInterval(DetectionScheduler& scheduler, float motion, bool confident, int frames = 400) {
+    int first = -1;
+    for (int i = 0; i < frames; i++) {
+        if (!scheduler.next(true, motion, confident).detect) continue;
+        if (first >= 0) return i - first;
+        first = i;
+    }
+    return 0;
+}
+
+TEST(DetectionScheduler, DetectsFirstFrameThenEveryBaseInterval) {
+    DetectionScheduler scheduler;
+    EXPECT_TRUE(scheduler.next(false, 0.0f, false).detect);
+    scheduler.recordDetection(2.0f);
+    scheduler.recordTracking(0.2f);
+
+    ScheduleDecision decision = scheduler.next(true, 0.003f, false);
+    EXPECT_FALSE(decision.detect);
+    EXPECT_EQ(decision.reason, ScheduleReason::Steady);
+    EXPECT_EQ(decision.interval, scheduler.options().baseInterval);
+    EXPECT_EQ(detectionInterval(scheduler, 0.003f, false), scheduler.options().baseInterval);
+}
+
+TEST(DetectionScheduler, SlowDetectorIsStretchedToTheBudget) {
+    DetectionSchedulerOptions options;
+    options.frameBudget  = 8.0f;
+    options.baseInterval = 2;
+    DetectionScheduler scheduler(options);
+    scheduler.recordDetection(40.0f);
+    scheduler.recordTracking(0.5f);
+
+    // 40 ms every 6 frames is 6.7 ms per frame, plus 0.5 ms of tracking
+    ScheduleDecision decision = scheduler.next(true, 0.02f, false);
+    EXPECT_EQ(decision.reason, ScheduleReason::Budget);
+    EXPECT_EQ(decision.interval, 6);
+    EXPECT_LE(scheduler.detectionLatency() / decision.interval + 0.5f, options.frameBudget);
+
+    // Even when nothing is tracked
+    scheduler.next(false, 0.0f, false);
+    decision = scheduler.next(false, 0.0f, false);
+    EXPECT_EQ(decision.interval, 6);
+    EXPECT_FALSE(decision.detect);
+}
+
+TEST(DetectionScheduler, FastMotionDetectsEveryFrameTheBudgetAllows) {
+    DetectionScheduler scheduler;
+    scheduler.recordDetection(2.0f);
+    scheduler.recordTracking(0.2f);
+    for (int i = 0; i < 20; i++) scheduler.next(true, 0.02f, true);
+
+    ScheduleDecision decision = scheduler.next(true, 0.02f, true);
+    EXPECT_EQ(decision.reason, ScheduleReason::Motion);
+    EXPECT_EQ(decision.interval, 1);
+    EXPECT_TRUE(decision.detect);
+}
+
+TEST(DetectionScheduler, StaticConfidentSceneBacksOff) {
+    DetectionSchedulerOptions options;
+    options.baseInterval    = 10;
+    options.maximumInterval = 80;
+    DetectionScheduler scheduler(options);
+    scheduler.recordDetection(2.0f);
+    scheduler.setLogging(true);
+
+    // Intervals double after each detection: 10, 20, 40, 80, 80
+    std::vector<int> gaps;
+    int last = -1;
+    for (int i = 0; i < 260; i++) {
+        if (!scheduler.next(true, 0.0f, true).detect) continue;
+        if (last >= 0) gaps.push_back(i - last);
+        last = i;
+    }
+    ASSERT_GE(gaps.size(), 4u);
+    EXPECT_EQ(gaps[0], 20);
+    EXPECT_EQ(gaps[1], 40);
+    EXPECT_EQ(gaps[2], 80);
+    EXPECT_EQ(gaps[3], 80);
+    EXPECT_EQ(scheduler.log().size(), 260u);
+    EXPECT_EQ(scheduler.log().back().reason, ScheduleReason::Static);
+
+    // Not confident anymore: back to the base interval at once
+    ScheduleDecision decision = scheduler.next(true, 0.0f, false);
+    EXPECT_EQ(decision.reason, ScheduleReason::Steady);
+    EXPECT_EQ(decision.interval, 10);
+    EXPECT_STREQ(scheduleReasonName(decision.reason), "steady");
+}
+
+TEST(DetectionScheduler, ResetDetectsOnNextFrame) {
+    DetectionScheduler scheduler;
+    scheduler.recordDetection(2.0f);
+    EXPECT_TRUE(scheduler.next(true, 0.0f, false).detect);
+    EXPECT_FALSE(scheduler.next(true, 0.0f, false).detect);
+    scheduler.reset();
+    EXPECT_EQ(scheduler.detectionLatency(), 0.0f);
+    EXPECT_TRUE(scheduler.next(true, 0.0f, false).detect);
+}
@@ -0,0 +1,185 @@
+//
+//  IRLEdgeMapTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Every vector variant must give the same bits as the scalar reference.
+//
+
+#include "IRLEdgeKernels.hpp"
+#include "IRLEdgeMap.hpp"
+#include "IRLSyntheticPage.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+using namespace irl;
+using namespace irl::test;
+
+static std::vector<SimdLevel> supportedVectorLevels() {
+    std::vector<SimdLevel> levels;
+    for (SimdLevel level : { SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::NEON }) {
+        if (detail::edgeKernels(level)) levels.push_back(level);
+    }
+    return levels;
+}
+
+static Plane8 pageLuma(int width, int height, uint32_t seed) {
+    SyntheticPage page;
+    page.width   = width;
+    page.height  = height;
+    page.seed    = seed;
+    page.corners = pageCorners(width, height, 0.15f, width * 0.04f);
+    Frame frame  = renderPage(page, PixelFormat::Gray8);
+
+    Plane8 luma, smoothed;
+    convertToLuma(frame.view(), luma);
+    smoothBinomial3(luma, smoothed);
+    return smoothed;
+}
+
+static Plane8 noiseLuma(int width, int height, uint32_t seed) {
+    XorShift random(seed);
+    Plane8 plane(width, height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) plane.row(y)[x] = static_cast<uint8_t>(random.next() >> 24);
+    }
+    return plane;
+}
+
+static void expectSameEdges(const Plane8& expected, const Plane8& actual, SimdLevel level) {
+    ASSERT_EQ(expected.width(), actual.width());
+    ASSERT_EQ(expected.height(), actual.height());
+    for (int y = 0; y < expected.height(); y++) {
+        ASSERT_EQ(0, std::memcmp(expected.row(y), actual.row(y), static_cast<size_t>(expected.width())))
+            << simdLevelName(level) << " row " << y << " of " << expected.width() << "x" << expected.height();
+    }
+}
+
+TEST(EdgeMap, RowKernelsMatchScalarReference) {
+    const detail::EdgeKernels* scalar = detail::edgeKernelsScalar();
+    XorShift random(7);
+
+    // Every width up to a few vector lengths, so each variant runs its head, body and tail paths
+    for (int width = 1; width <= 80; width++) {
+        std::vector<uint8_t> rows(3 * static_cast<size_t>(width));
+        for (uint8_t& value : rows) value = static_cast<uint8_t>((random.next() >> 24) & (width % 2 ? 0xFF : 0xF0));
+        const uint8_t* above  = rows.data();
+        const uint8_t* center = above + width;
+        const uint8_t* below  = center + width;
+
+        std::vector<int16_t> expected(3 * static_cast<size_t>(width));
+        scalar->sobelRow(above, center, below, width, &expected[0], &expected[width], &expected[2 * width]);
+
+        // Magnitude rows with plateaus and exact threshold hits for the suppression
+        std::vector<int16_t> magnitude(3 * static_cast<size_t>(width));
+        for (int16_t& value : magnitude) value = static_cast<int16_t>((random.next() >> 24) % 9 * 20);
+        std::vector<uint8_t> expectedClasses(static_cast<size_t>(width));
+        if (width >= 3) {
+            scalar->suppressRow(&magnitude[0], &magnitude[width], &magnitude[2 * width], &expected[0], &expected[width],
+                                width, 60, 120, expectedClasses.data());
+        }
+
+        for (SimdLevel level : supportedVectorLevels()) {
+            const detail::EdgeKernels* kernels = detail::edgeKernels(level);
+
+            std::vector<int16_t> actual(3 * static_cast<size_t>(width));
+            kernels->sobelRow(above, center, below, width, &actual[0], &actual[width], &actual[2 * width]);
+            EXPECT_EQ(expected, actual) << simdLevelName(level) << " sobel, width " << width;
+
+            if (width >= 3) {
+                std::vector<uint8_t> classes(static_cast<size_t>(width));
+                kernels->suppressRow(&magnitude[0], &magnitude[width], &magnitude[2 * width], &expected[0], &expected[width],
+                                     width, 60, 120, classes.data());
+                EXPECT_EQ(expectedClasses, classes) << simdLevelName(level) << " suppression, width " << width;
+
+                std::vector<int32_t> expectedPositions(static_cast<size_t>(width)), positions(static_cast<size_t>(width));
+                const int expectedCount = scalar->collectStrong(expectedClasses.data(), width, expectedPositions.data());
+                ASSERT_EQ(expectedCount, kernels->collectStrong(expectedClasses.data(), width, positions.data()));
+                for (int i = 0; i < expectedCount; i++) EXPECT_EQ(expectedPositions[i], positions[i]);
+            }
+        }
+    }
+}
+
+TEST(EdgeMap, VariantsMatchScalarOnFrames) {
+    const Plane8 frames[] = { pageLuma(1440, 1080, 1), pageLuma(333, 251, 2), noiseLuma(97, 61, 3), noiseLuma(3, 3, 4) };
+
+    for (const Plane8& luma : frames) {
+        Plane8 expected;
+        EdgeDetector reference(SimdLevel::Scalar);
+        reference.detect(luma.view(), EdgeMapOptions(), expected);
+
+        for (SimdLevel level : supportedVectorLevels()) {
+            EdgeDetector detector(level);
+            ASSERT_EQ(detector.simdLevel(), level);
+            Plane8 edges;
+            detector.detect(luma.view(), EdgeMapOptions(), edges);
+            expectSameEdges(expected, edges, level);
+        }
+    }
+}
+
+TEST(EdgeMap, FindsPageOutline) {
+    const int width = 640, height = 480;
+    Plane8 luma = pageLuma(width, height, 5);
+
+    EdgeDetector detector;
+    Plane8 edges;
+    detector.detect(luma.view(), EdgeMapOptions(), edges);
+
+    // The top side of the page runs from (96 + 25.6, 72) to (544, 72 + 25.6): one thin line crosses every column
+    const Quad corners = pageCorners(width, height, 0.15f, width * 0.04f);
+    for (int x = 160; x < 500; x += 20) {
+        const float t = (x - corners.topLeft.x) / (corners.topRight.x - corners.topLeft.x);
+        const int   y = static_cast<int>(corners.topLeft.y + t * (corners.topRight.y - corners.topLeft.y));
+        int hits = 0;
+        for (int j = y - 4; j <= y + 4; j++) hits += edges.row(j)[x] == 255;
+        EXPECT_GE(hits, 1) << "column " << x;
+        EXPECT_LE(hits, 2) << "column " << x;
+    }
+
+    // Flat desk area far from the page: no edges
+    for (int y = 5; y < 40; y++) {
+        for (int x = 5; x < 60; x++) EXPECT_EQ(edges.row(y)[x], 0);
+    }
+}
+
+TEST(EdgeMap, HysteresisFollowsWeakEdgesFromStrongOnes) {
+    // A vertical step whose contrast fades from strong to weak, next to an isolated weak step
+    const int width = 40, height = 30;
+    Plane8 luma(width, height);
+    for (int y = 0; y < height; y++) {
+        const int contrast = y < 5 ? 80 : 20;
+        for (int x = 0; x < width; x++) {
+            uint8_t value = 100;
+            if (x >= 10 && x < 25) value = static_cast<uint8_t>(100 + contrast);
+            if (x >= 30 && y > 15) value = 120;
+            luma.row(y)[x] = value;
+        }
+    }
+
+    EdgeMapOptions options;
+    options.lowThreshold  = 60;
+    options.highThreshold = 200;
+    Plane8 edges;
+    EdgeDetector(SimdLevel::Scalar).detect(luma.view(), options, edges);
+
+    int connected = 0, isolated = 0;
+    for (int y = 1; y < height - 1; y++) {
+        connected += edges.row(y)[9] == 255 || edges.row(y)[10] == 255;
+        isolated  += edges.row(y)[29] == 255 || edges.row(y)[30] == 255;
+    }
+    EXPECT_EQ(connected, height - 2);
+    EXPECT_EQ(isolated, 0);
+}
+
+TEST(EdgeMap, TinyFramesHaveNoEdges) {
+    Plane8 luma = noiseLuma(2, 5, 9), edges;
+    EdgeDetector().detect(luma.view(), EdgeMapOptions(), edges);
+    ASSERT_EQ(edges.width(), 2);
+    ASSERT_EQ(edges.height(), 5);
+    for (int y = 0; y < 5; y++) EXPECT_EQ(edges.row(y)[0] | edges.row(y)[1], 0);
+}
@@ -0,0 +1,72 @@
+//
+//  IRLFrameSequence.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Replayable hand-held video of a page: the page drifts, rotates and zooms slightly from
+//  frame to frame, like a phone held over a desk. Every frame is a pure function of its index.
+//
+
+#ifndef IRL_FRAME_SEQUENCE_HPP
+#define IRL_FRAME_SEQUENCE_HPP
+
+#include "IRLSyntheticPage.hpp"
+
+namespace irl {
+namespace test {
+
+/** @brief Description of a synthetic video */
+struct FrameSequence {
+    int     width       = 960;
+    int     height      = 720;
+    float   inset       = 0.18f;
+
+    /** Peak translation of the page, in pixels. The peak speed is about 2 * pi * amplitude / period. */
+    float   amplitudeX  = 40.0f;
+    float   amplitudeY  = 25.0f;
+
+    /** Peak rotation in degrees and peak relative zoom */
+    float   rotation    = 3.0f;
+    float   zoom        = 0.05f;
+
+    /** Peak independent motion of each corner, in pixels */
+    float   wobble      = 1.5f;
+
+    /** @return Page corners of frame `index` */
+    Quad corners(int index) const {
+        const float pi  = 3.14159265f;
+        const float t   = static_cast<float>(index);
+        const Point center(width * 0.5f + amplitudeX * std::sin(2.0f * pi * t / 40.0f),
+                           height * 0.5f + amplitudeY * std::sin(2.0f * pi * t / 29.0f + 1.0f));
+        const float angle = rotation * pi / 180.0f * std::sin(2.0f * pi * t / 53.0f);
+        const float scale = 1.0f + zoom * std::sin(2.0f * pi * t / 47.0f + 2.0f);
+        const float c = std::cos(angle) * scale, s = std::sin(angle) * scale;
+
+        const Quad base = pageCorners(width, height, inset, width * 0.02f);
+        const Point middle(width * 0.5f, height * 0.5f);
+        Quad q;
+        for (int k = 0; k < 4; k++) {
+            // Small independent wobble per corner stands for the perspective changes of a moving camera
+            const Point d = base[k] - middle;
+            const Point jitter(wobble * std::sin(0.37f * t + k), wobble * std::cos(0.29f * t + 2 * k));
+            q[k] = center + Point(c * d.x - s * d.y, s * d.x + c * d.y) + jitter;
+        }
+        return q;
+    }
+
+    /** @return Frame `index`, with its own sensor noise */
+    Frame frame(int index, PixelFormat format = PixelFormat::BGRA8) const {
+        SyntheticPage page;
+        page.width   = width;
+        page.height  = height;
+        page.corners = corners(index);
+        page.seed    = static_cast<uint32_t>(index + 1);
+        return renderPage(page, format);
+    }
+};
+
+} // namespace test
+} // namespace irl
+
+#endif /* IRL_FRAME_SEQUENCE_HPP */
@@ -0,0 +1,139 @@
+//
+//  IRLGuidedFilterTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLGuidedFilter.hpp"
+#include "IRLSyntheticPage.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+using namespace irl;
+using namespace irl::test;
+
+/** The guided filter written from the paper: every window summed directly, in double precision */
+static std::vector<uint8_t> referenceFilter(const Frame& gray, int radius, double epsilon) {
+    const int width = gray.width, height = gray.height;
+    auto at = [&](int x, int y) { return static_cast<double>(gray.pixels[static_cast<size_t>(y) * gray.stride + x]); };
+    auto window = [&](int x, int y, const std::function<double(int, int)>& value) {
+        double sum = 0.0, count = 0.0;
+        for (int j = std::max(y - radius, 0); j <= std::min(y + radius, height - 1); j++) {
+            for (int i = std::max(x - radius, 0); i <= std::min(x + radius, width - 1); i++, count++) sum += value(i, j);
+        }
+        return sum / count;
+    };
+
+    std::vector<double> a(static_cast<size_t>(width) * height), b(a.size());
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const double mean     = window(x, y, at);
+            const double variance = window(x, y, [&](int i, int j) { return at(i, j) * at(i, j); }) - mean * mean;
+            const double slope    = variance / (variance + epsilon * 255.0 * 255.0);
+            a[static_cast<size_t>(y) * width + x] = slope;
+            b[static_cast<size_t>(y) * width + x] = mean - slope * mean;
+        }
+    }
+
+    std::vector<uint8_t> filtered(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const double meanA = window(x, y, [&](int i, int j) { return a[static_cast<size_t>(j) * width + i]; });
+            const double meanB = window(x, y, [&](int i, int j) { return b[static_cast<size_t>(j) * width + i]; });
+            filtered[static_cast<size_t>(y) * width + x] = static_cast<uint8_t>(std::min(std::max(std::lround(meanA * at(x, y) + meanB), 0L), 255L));
+        }
+    }
+    return filtered;
+}
+
+static Frame noisyPage(int width, int height, int noise, PixelFormat format = PixelFormat::Gray8, bool text = true) {
+    SyntheticPage page;
+    page.text    = text;
+    page.width   = width;
+    page.height  = height;
+    page.noise   = noise;
+    page.corners = pageCorners(width, height, 0.08f, 6.0f);
+    return renderPage(page, format);
+}
+
+TEST(GuidedFilter, MatchesTheDirectSums) {
+    // Taller than a band, so the band starts are covered too
+    const Frame gray = noisyPage(83, 300, 10);
+    for (int radius : { 1, 3, 8 }) {
+        GuidedFilterOptions options;
+        options.radius = radius;
+        GuidedFilter filter(options);
+        std::vector<uint8_t> filtered(gray.pixels.size());
+        filter.apply(gray.view(), filtered.data(), gray.stride);
+
+        const std::vector<uint8_t> expected = referenceFilter(gray, radius, options.epsilon);
+        int worst = 0;
+        for (size_t i = 0; i < expected.size(); i++) worst = std::max(worst, std::abs(expected[i] - filtered[i]));
+        EXPECT_LE(worst, 1) << "radius " << radius;
+    }
+}
+
+TEST(GuidedFilter, RemovesNoiseAndKeepsText) {
+    auto filtered = [](const Frame& frame) {
+        std::vector<uint8_t> pixels(frame.pixels.size());
+        GuidedFilter().apply(frame.view(), pixels.data(), frame.stride);
+        return pixels;
+    };
+    auto error = [](const std::vector<uint8_t>& pixels, const Frame& clean) {
+        double sum = 0.0;
+        for (size_t i = 0; i < pixels.size(); i++) sum += std::abs(pixels[i] - clean.pixels[i]);
+        return sum / pixels.size();
+    };
+
+    // Blank paper: windows touching a stroke keep their noise, so the gain is measured without text
+    const Frame blank = noisyPage(480, 360, 0, PixelFormat::Gray8, false);
+    const Frame grain = noisyPage(480, 360, 14, PixelFormat::Gray8, false);
+    EXPECT_LT(error(filtered(grain), blank), 0.3 * error(grain.pixels, blank));
+
+    // Strokes keep their darkness: the darkest twentieth of the page barely moves
+    const Frame clean = noisyPage(480, 360, 0);
+    const Frame noisy = noisyPage(480, 360, 14);
+    auto darkest = [](std::vector<uint8_t> pixels) {
+        std::nth_element(pixels.begin(), pixels.begin() + pixels.size() / 20, pixels.end());
+        return static_cast<int>(pixels[pixels.size() / 20]);
+    };
+    EXPECT_LT(error(filtered(noisy), clean), error(noisy.pixels, clean));
+    EXPECT_NEAR(darkest(filtered(noisy)), darkest(clean.pixels), 12);
+}
+
+TEST(GuidedFilter, ColorsInPlaceAndOnAnyThreadCount) {
+    const Frame bgra = noisyPage(257, 301, 10, PixelFormat::BGRA8);
+
+    std::vector<uint8_t> reference(bgra.pixels.size());
+    GuidedFilterOptions options;
+    options.threads = 1;
+    GuidedFilter(options).apply(bgra.view(), reference.data(), bgra.stride);
+    for (size_t i = 3; i < reference.size(); i += 4) ASSERT_EQ(bgra.pixels[i], reference[i]);
+
+    for (int threads : { 2, 3 }) {
+        std::vector<uint8_t> pixels = bgra.pixels;
+        options.threads = threads;
+        GuidedFilter(options).apply(ImageView(pixels.data(), bgra.width, bgra.height, bgra.stride, PixelFormat::BGRA8), pixels.data(), bgra.stride);
+        EXPECT_EQ(reference, pixels) << threads << " threads";
+    }
+}
+
+TEST(GuidedFilter, FiltersInPlaceWithTheWidestWindow) {
+    // The rows around the band edges reach a whole band away
+    const Frame bgra = noisyPage(131, 300, 10, PixelFormat::BGRA8);
+    GuidedFilterOptions options;
+    options.radius  = 64;
+    options.threads = 1;
+    std::vector<uint8_t> reference(bgra.pixels.size());
+    GuidedFilter(options).apply(bgra.view(), reference.data(), bgra.stride);
+
+    std::vector<uint8_t> pixels = bgra.pixels;
+    options.threads = 3;
+    GuidedFilter(options).apply(ImageView(pixels.data(), bgra.width, bgra.height, bgra.stride, PixelFormat::BGRA8), pixels.data(), bgra.stride);
+    EXPECT_EQ(reference, pixels);
+}
@@ -0,0 +1,104 @@
+//
+//  IRLIlluminationFlattenerTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLIlluminationFlattener.hpp"
+#include "IRLSyntheticPage.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace irl;
+using namespace irl::test;
+
+/** A full frame page under a desk lamp: full light in the top right corner, a third of it in the bottom left one */
+static Frame litPage(int width, int height, PixelFormat format) {
+    SyntheticPage page;
+    page.width   = width;
+    page.height  = height;
+    page.paper   = 230;
+    page.noise   = 2;
+    page.corners = pageCorners(width, height, -0.1f, 0.0f);
+    Frame frame  = renderPage(page, format);
+
+    const int channels = static_cast<int>(bytesPerPixel(format));
+    for (int y = 0; y < height; y++) {
+        uint8_t* row = frame.pixels.data() + frame.stride * y;
+        for (int x = 0; x < width; x++) {
+            const float light = 1.0f - 0.67f * (0.5f * (width - x) / width + 0.5f * static_cast<float>(y) / height);
+            for (int c = 0; c < std::min(channels, 3); c++) row[channels * x + c] = static_cast<uint8_t>(row[channels * x + c] * light + 0.5f);
+        }
+    }
+    return frame;
+}
+
+/** @return The lowest and the highest value of the paper pixels (above `threshold`) of the luma, over 32x32 cells */
+static void paperRange(const ImageView& view, int threshold, int& low, int& high) {
+    Plane8 luma;
+    convertToLuma(view, luma);
+    low = 255; high = 0;
+    for (int cy = 0; cy + 32 <= luma.height(); cy += 32) {
+        for (int cx = 0; cx + 32 <= luma.width(); cx += 32) {
+            int brightest = 0;
+            for (int y = cy; y < cy + 32; y++) {
+                for (int x = cx; x < cx + 32; x++) brightest = std::max<int>(brightest, luma.row(y)[x]);
+            }
+            if (brightest < threshold) continue;
+            low  = std::min(low, brightest);
+            high = std::max(high, brightest);
+        }
+    }
+}
+
+TEST(IlluminationFlattener, EvensOutTheLampGradient) {
+    for (PixelFormat format : { PixelFormat::Gray8, PixelFormat::BGRA8 }) {
+        Frame frame = litPage(960, 720, format);
+
+        int low, high;
+        paperRange(frame.view(), 0, low, high);
+        EXPECT_GT(high - low, 100);
+
+        IlluminationFlattener flattener;
+        std::vector<uint8_t> output(frame.pixels.size());
+        flattener.apply(frame.view(), output.data(), frame.stride);
+        EXPECT_EQ(flattener.level(), 4);
+        EXPECT_EQ(flattener.background().width(), 960 >> 4);
+
+        ImageView flat(output.data(), frame.width, frame.height, frame.stride, format);
+        paperRange(flat, 0, low, high);
+        EXPECT_GE(low, 225);
+        EXPECT_LE(high - low, 20);
+
+        // Strokes stay dark
+        Plane8 luma;
+        convertToLuma(flat, luma);
+        int dark = 0;
+        for (int y = 0; y < luma.height(); y++) {
+            for (int x = 0; x < luma.width(); x++) dark += luma.row(y)[x] < 128;
+        }
+        EXPECT_GT(dark, luma.width() * luma.height() / 10);
+    }
+}
+
+TEST(IlluminationFlattener, WorksInPlaceAndKeepsAlpha) {
+    Frame frame = litPage(320, 240, PixelFormat::BGRA8);
+    Frame copy  = frame;
+
+    IlluminationFlattener flattener;
+    std::vector<uint8_t> output(frame.pixels.size());
+    flattener.apply(copy.view(), output.data(), copy.stride);
+    flattener.apply(frame.view(), frame.pixels.data(), frame.stride);
+    EXPECT_EQ(frame.pixels, output);
+    for (size_t i = 3; i < output.size(); i += 4) ASSERT_EQ(output[i], 255);
+}
+
+TEST(IlluminationFlattener, LowersTheLevelOnSmallSources) {
+    Frame frame = litPage(40, 24, PixelFormat::Gray8);
+
+    IlluminationFlattener flattener;
+    flattener.apply(frame.view(), frame.pixels.data(), frame.stride);
+    EXPECT_EQ(flattener.level(), 1);
+    EXPECT_EQ(flattener.background().height(), 12);
+}
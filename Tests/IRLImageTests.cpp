@@ -0,0 +1,73 @@
+//
+//  IRLImageTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLImage.hpp"
+#include "IRLQuadDetector.hpp"
+#include "IRLSyntheticPage.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+
+using namespace irl;
+using namespace irl::test;
+
+TEST(Image, BiPlanarRoundTripsThroughBGRA) {
+    // Saturated patches on every 8x8 block, so chroma subsampling does not blur them
+    Frame frame;
+    frame.width  = 67;
+    frame.height = 33;
+    frame.stride = static_cast<size_t>(frame.width) * 4;
+    frame.pixels.resize(frame.stride * frame.height);
+    const uint8_t colors[][3] = { {255, 255, 255}, {0, 0, 0}, {40, 40, 220}, {30, 200, 40}, {210, 60, 20}, {128, 128, 128}, {90, 180, 240} };
+    for (int y = 0; y < frame.height; y++) {
+        for (int x = 0; x < frame.width; x++) {
+            const uint8_t* c = colors[(x / 8 + 3 * (y / 8)) % 7];
+            uint8_t* p = frame.pixels.data() + frame.stride * y + 4 * x;
+            p[0] = c[0]; p[1] = c[1]; p[2] = c[2]; p[3] = 255;
+        }
+    }
+
+    BiPlanarFrame nv12 = encodeBiPlanar(frame);
+    std::vector<uint8_t> bgra(frame.stride * frame.height, 0);
+    convertToBGRA(nv12.view(), bgra.data(), frame.stride);
+
+    for (size_t i = 0; i < bgra.size(); i++) {
+        const int tolerance = (i & 3) == 3 ? 0 : 3;
+        ASSERT_LE(std::abs(bgra[i] - frame.pixels[i]), tolerance) << "byte " << i;
+    }
+}
+
+TEST(Image, GrayChromaKeepsLuma) {
+    std::vector<uint8_t> luma = { 0, 16, 128, 235, 255, 77 };
+    std::vector<uint8_t> chroma(6, 128);
+    BiPlanarView view(luma.data(), 3, 2, 3, chroma.data(), 4);
+
+    uint8_t bgra[2 * 12];
+    convertToBGRA(view, bgra, 12);
+    for (int i = 0; i < 6; i++) {
+        EXPECT_EQ(bgra[4 * i + 0], luma[i]);
+        EXPECT_EQ(bgra[4 * i + 1], luma[i]);
+        EXPECT_EQ(bgra[4 * i + 2], luma[i]);
+        EXPECT_EQ(bgra[4 * i + 3], 255);
+    }
+}
+
+TEST(Image, LumaPlaneDetectsLikeBGRA) {
+    SyntheticPage page;
+    page.corners = pageCorners(page.width, page.height, 0.14f, 30.0f);
+    Frame bgra = renderPage(page);
+    BiPlanarFrame nv12 = encodeBiPlanar(bgra);
+
+    QuadDetector detector;
+    std::vector<DetectedQuad> fromBGRA = detector.detect(bgra.view());
+    std::vector<DetectedQuad> fromLuma = detector.detect(nv12.view().luma);
+    ASSERT_FALSE(fromBGRA.empty());
+    ASSERT_FALSE(fromLuma.empty());
+    EXPECT_EQ(cornerError(fromBGRA[0].quad, fromLuma[0].quad), 0.0f);
+    EXPECT_LT(cornerError(fromLuma[0].quad, page.corners), 2.0f);
+}
@@ -0,0 +1,112 @@
+//
+//  IRLLineQuadFinderTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLAllocationCounter.hpp"
+#include "IRLLineQuadFinder.hpp"
+#include "IRLSyntheticPage.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace irl;
+using namespace irl::test;
+
+static SyntheticPage tiltedPage(int width, int height, uint32_t seed = 1) {
+    SyntheticPage page;
+    page.width   = width;
+    page.height  = height;
+    page.seed    = seed;
+    page.corners = pageCorners(width, height, 0.14f, width * 0.05f);
+    return page;
+}
+
+TEST(LineQuadFinder, FindsTiltedPageInPreviewFrame) {
+    SyntheticPage page = tiltedPage(1440, 1080);
+    Frame frame = renderPage(page);
+
+    LineQuadFinder finder;
+    Span<const QuadCandidate> candidates = finder.find(frame.view());
+    ASSERT_FALSE(candidates.isEmpty());
+    EXPECT_EQ(finder.searchedLevel(), 2);
+
+    // Corners come from 2 px (full resolution) accumulator cells, before any refinement
+    const QuadCandidate& best = candidates[0];
+    EXPECT_LT(cornerError(best.quad, page.corners), 6.0f);
+    EXPECT_GT(best.coverage, 0.9f);
+    EXPECT_NEAR(best.area, page.corners.signedArea(), 0.02f * page.corners.signedArea());
+
+    // Sides are top, right, bottom, left
+    const Point up(0.0f, -1.0f);
+    const HoughLine& top = finder.lines()[best.lines[0]];
+    EXPECT_GT(std::fabs(dot(top.normal, up)), 0.9f);
+    const HoughLine& left = finder.lines()[best.lines[3]];
+    EXPECT_LT(std::fabs(dot(left.normal, up)), 0.2f);
+}
+
+TEST(LineQuadFinder, CandidatesAreSortedAndBounded) {
+    Frame frame = renderPage(tiltedPage(1440, 1080, 3));
+
+    LineQuadFinderOptions options;
+    options.maximumCandidates = 3;
+    LineQuadFinder finder(options);
+    Span<const QuadCandidate> candidates = finder.find(frame.view());
+    ASSERT_GE(candidates.count, 1);
+    EXPECT_LE(candidates.count, 3);
+    EXPECT_LE(finder.lines().count, options.maximumLines);
+    for (int i = 1; i < candidates.count; i++) EXPECT_GE(candidates[i - 1].score, candidates[i].score);
+    for (const QuadCandidate& candidate : candidates) {
+        EXPECT_GT(candidate.area, 0.0f);
+        EXPECT_GE(candidate.coverage, options.minimumCoverage);
+    }
+}
+
+TEST(LineQuadFinder, IsDeterministic) {
+    Frame frame = renderPage(tiltedPage(960, 720, 5));
+
+    LineQuadFinder a, b;
+    Span<const QuadCandidate> first = a.find(frame.view());
+    b.find(renderPage(tiltedPage(960, 720, 6)).view());
+    Span<const QuadCandidate> second = b.find(frame.view());
+
+    ASSERT_EQ(first.count, second.count);
+    for (int i = 0; i < first.count; i++) {
+        for (int k = 0; k < 4; k++) {
+            EXPECT_EQ(first[i].quad[k].x, second[i].quad[k].x);
+            EXPECT_EQ(first[i].quad[k].y, second[i].quad[k].y);
+        }
+        EXPECT_EQ(first[i].score, second[i].score);
+    }
+}
+
+TEST(LineQuadFinder, DoesNotAllocateInSteadyState) {
+    Frame frames[] = { renderPage(tiltedPage(1440, 1080, 1)), renderPage(tiltedPage(1440, 1080, 2)) };
+
+    LineQuadFinder finder;
+    for (int i = 0; i < 3; i++) finder.find(frames[i % 2].view());
+
+    const long before = allocationCount();
+    const int  arenaAllocations = finder.arena().heapAllocations();
+    int found = 0;
+    for (int i = 0; i < 6; i++) found += finder.find(frames[i % 2].view()).count;
+    EXPECT_EQ(allocationCount() - before, 0);
+    EXPECT_EQ(finder.arena().heapAllocations(), arenaAllocations);
+    EXPECT_GT(found, 0);
+}
+
+TEST(LineQuadFinder, RejectsSmallFeatures) {
+    SyntheticPage page = tiltedPage(640, 480);
+    page.corners = pageCorners(640, 480, 0.38f, 4.0f);
+    Frame frame = renderPage(page);
+
+    LineQuadFinder finder;
+    EXPECT_TRUE(finder.find(frame.view()).isEmpty());
+}
+
+TEST(LineQuadFinder, EmptyFrame) {
+    LineQuadFinder finder;
+    EXPECT_TRUE(finder.find(ImageView()).isEmpty());
+    EXPECT_TRUE(finder.lines().isEmpty());
+}
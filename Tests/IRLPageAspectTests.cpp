@@ -0,0 +1,163 @@
+//
+//  IRLPageAspectTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLHomography.hpp"
+#include "IRLPageAspect.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+using namespace irl;
+
+static const int    kPhotoWidth  = 4032;
+static const int    kPhotoHeight = 3024;
+static const double kFocalLength = 3300.0;     // about the 63 degrees of a phone camera across 4032 pixels
+static const double kRadiansPerDegree = 3.14159265358979323846 / 180.0;
+
+/**
+ Corners of a `width` x `height` page (mm) photographed from `distance` mm, turned by `yaw` and `pitch` degrees and
+ moved by (`shiftX`, `shiftY`) mm on the side, through a pinhole at the center of the photo.
+ */
+static Quad photographedPage(double width, double height, double yaw, double pitch, double distance,
+                             double shiftX = 0.0, double shiftY = 0.0) {
+    const double a = yaw * kRadiansPerDegree, b = pitch * kRadiansPerDegree;
+    auto project = [&](double x, double y) {
+        // Yaw around the vertical axis, then pitch around the horizontal one, page centered on the axis before the shift
+        x -= 0.5 * width;
+        y -= 0.5 * height;
+        const double x1 = x * std::cos(a), z1 = x * std::sin(a);
+        const double y2 = y * std::cos(b) - z1 * std::sin(b), z2 = y * std::sin(b) + z1 * std::cos(b);
+        const double X = x1 + shiftX, Y = y2 + shiftY, Z = z2 + distance;
+        return Point(static_cast<float>(0.5 * kPhotoWidth + kFocalLength * X / Z), static_cast<float>(0.5 * kPhotoHeight + kFocalLength * Y / Z));
+    };
+    Quad quad;
+    quad.topLeft     = project(0.0, 0.0);
+    quad.topRight    = project(width, 0.0);
+    quad.bottomRight = project(width, height);
+    quad.bottomLeft  = project(0.0, height);
+    return quad;
+}
+
+static CameraIntrinsics camera(double focalLength) {
+    CameraIntrinsics intrinsics;
+    intrinsics.focalLength    = focalLength;
+    intrinsics.principalPoint = Point(0.5f * kPhotoWidth, 0.5f * kPhotoHeight);
+    return intrinsics;
+}
+
+TEST(PageAspect, RecoversTheAspectOfATiltedPage) {
+    // A4 and a square card, tilted both ways, off center
+    const double sizes[][2] = { { 210.0, 297.0 }, { 120.0, 120.0 } };
+    const double tilts[][2] = { { 25.0, 0.0 }, { 0.0, -30.0 }, { 20.0, 35.0 }, { -35.0, 15.0 } };
+    for (const auto& size : sizes) {
+        for (const auto& tilt : tilts) {
+            const Quad quad = photographedPage(size[0], size[1], tilt[0], tilt[1], 450.0, 30.0, -20.0);
+            const double expected = size[0] / size[1];
+
+            double known = 0.0, estimated = 0.0;
+            ASSERT_TRUE(estimatePageAspect(quad, camera(kFocalLength), known));
+            EXPECT_NEAR(expected, known, 1e-3 * expected) << tilt[0] << " " << tilt[1];
+            // Tilted both ways, both pairs of sides converge and the quad tells the focal length
+            if (tilt[0] != 0.0 && tilt[1] != 0.0) {
+                ASSERT_TRUE(estimatePageAspect(quad, camera(0.0), estimated)) << tilt[0] << " " << tilt[1];
+                EXPECT_NEAR(expected, estimated, 1e-2 * expected) << tilt[0] << " " << tilt[1];
+            }
+
+            // What CIPerspectiveCorrection keeps is off by far more
+            int width, height;
+            rectifiedSize(quad, width, height);
+            EXPECT_GT(std::fabs(static_cast<double>(width) / height / expected - 1.0), 0.03) << tilt[0] << " " << tilt[1];
+        }
+    }
+}
+
+TEST(PageAspect, NeedsTheFocalLengthWhenOnePairOfSidesIsParallel) {
+    // Only turned around the vertical axis: the top and bottom sides converge, the left and right ones stay parallel
+    const Quad quad = photographedPage(210.0, 297.0, 30.0, 0.0, 450.0);
+    double aspect = 0.0;
+    EXPECT_FALSE(estimatePageAspect(quad, camera(0.0), aspect));
+    ASSERT_TRUE(estimatePageAspect(quad, camera(kFocalLength), aspect));
+    EXPECT_NEAR(210.0 / 297.0, aspect, 1e-3);
+
+    // Face on, the focal length does not matter
+    ASSERT_TRUE(estimatePageAspect(photographedPage(210.0, 297.0, 0.0, 0.0, 450.0), camera(0.0), aspect));
+    EXPECT_NEAR(210.0 / 297.0, aspect, 1e-3);
+}
+
+TEST(PageAspect, SizesThePageOnceForThePaper) {
+    const Quad quad = photographedPage(215.9, 279.4, -20.0, 30.0, 500.0, -25.0, 10.0);
+    int rectifiedWidth, rectifiedHeight, width, height;
+    rectifiedSize(quad, rectifiedWidth, rectifiedHeight);
+    pageSize(quad, camera(kFocalLength), width, height);
+
+    // US Letter exactly, and no side sampled more sparsely than the rectified size
+    EXPECT_NEAR(8.5 / 11.0, static_cast<double>(width) / height, 1.0 / height);
+    EXPECT_GE(width, rectifiedWidth);
+    EXPECT_GE(height, rectifiedHeight);
+    EXPECT_TRUE(width == rectifiedWidth || height == rectifiedHeight);
+
+    // Without the snapping the estimate is kept as is, a square is no paper size
+    PageAspectOptions options;
+    options.paperTolerance = 0.0;
+    pageSize(photographedPage(150.0, 150.0, 25.0, 25.0, 450.0), camera(kFocalLength), width, height, options);
+    EXPECT_NEAR(1.0, static_cast<double>(width) / height, 2.0 / height);
+
+    // A quad no camera can see keeps the rectified size
+    Quad twisted = quad;
+    std::swap(twisted.topRight, twisted.bottomRight);
+    rectifiedSize(twisted, rectifiedWidth, rectifiedHeight);
+    pageSize(twisted, camera(0.0), width, height);
+    EXPECT_EQ(rectifiedWidth, width);
+    EXPECT_EQ(rectifiedHeight, height);
+}
+
+TEST(PageAspect, ShrinksThePageToTheResolution) {
+    // A Letter sheet filling most of a 12 megapixel photo
+    const Quad quad = photographedPage(215.9, 279.4, 15.0, -20.0, 330.0);
+    int fullWidth, fullHeight;
+    pageSize(quad, camera(kFocalLength), fullWidth, fullHeight);
+    ASSERT_GT(fullHeight, 2200);
+
+    // 200 dpi on the paper itself: 11 inches high
+    PageAspectOptions options;
+    options.dpi = 200.0;
+    int width, height;
+    pageSize(quad, camera(kFocalLength), width, height, options);
+    EXPECT_NEAR(2200, height, 1);
+    EXPECT_NEAR(1700, width, 2);
+
+    // The pixel budget holds when it is the tighter one
+    options.maxPixels = 1000000;
+    pageSize(quad, camera(kFocalLength), width, height, options);
+    EXPECT_LE(width * height, 1000000);
+    EXPECT_GT(width * height, 990000);
+    EXPECT_NEAR(8.5 / 11.0, static_cast<double>(width) / height, 2.0 / height);
+
+    // Never enlarged
+    options.dpi       = 1200.0;
+    options.maxPixels = 0;
+    pageSize(quad, camera(kFocalLength), width, height, options);
+    EXPECT_EQ(fullWidth, width);
+    EXPECT_EQ(fullHeight, height);
+
+    // Paper unknown: the long side of an A4 sheet, 11.7 inches
+    width  = 3000;
+    height = 2000;
+    options.dpi = 100.0;
+    limitPageResolution(width, height, options);
+    EXPECT_EQ(1169, width);
+    EXPECT_EQ(779, height);
+}
+
+TEST(PageAspect, CentersTheIntrinsicsOnThePhoto) {
+    const CameraIntrinsics intrinsics = CameraIntrinsics::centered(kPhotoHeight, kPhotoWidth, 90.0);
+    EXPECT_FLOAT_EQ(0.5f * kPhotoHeight, intrinsics.principalPoint.x);
+    EXPECT_FLOAT_EQ(0.5f * kPhotoWidth, intrinsics.principalPoint.y);
+    EXPECT_NEAR(0.5 * kPhotoWidth, intrinsics.focalLength, 1e-6);
+    EXPECT_EQ(0.0, CameraIntrinsics::centered(kPhotoWidth, kPhotoHeight).focalLength);
+}
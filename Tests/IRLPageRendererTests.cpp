@@ -0,0 +1,418 @@
+//
+//  IRLPageRendererTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLPageRenderer.hpp"
+#include "IRLPeakMemory.hpp"
+#include "IRLPerspectiveWarp.hpp"
+#include "IRLSyntheticPage.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+using namespace irl;
+using namespace irl::test;
+
+static Frame tiltedPage(Quad& corners) {
+    SyntheticPage page;
+    page.width   = 800;
+    page.height  = 600;
+    page.text    = false;
+    page.noise   = 0;
+    page.corners = pageCorners(page.width, page.height, 0.12f, 30.0f);
+    corners      = page.corners;
+    return renderPage(page);
+}
+
+TEST(Homography, MapsTheRectangleCornersOnTheQuad) {
+    Quad quad = pageCorners(800, 600, 0.1f, 40.0f);
+    Homography H = Homography::rectangleToQuad(500.0, 700.0, quad);
+
+    EXPECT_LT(distance(H.map(Point(0.0f,   0.0f)),   quad.topLeft),     1e-3f);
+    EXPECT_LT(distance(H.map(Point(500.0f, 0.0f)),   quad.topRight),    1e-3f);
+    EXPECT_LT(distance(H.map(Point(500.0f, 700.0f)), quad.bottomRight), 1e-3f);
+    EXPECT_LT(distance(H.map(Point(0.0f,   700.0f)), quad.bottomLeft),  1e-3f);
+}
+
+TEST(PageRenderer, RectifiesThePage) {
+    Quad corners;
+    Frame frame = tiltedPage(corners);
+
+    PageRenderOptions options;
+    options.filter = PageFilter::None;
+    options.margin = 0;
+    PageRenderer renderer(options);
+
+    int width, height, rectifiedWidth, rectifiedHeight;
+    renderer.outputSize(corners, width, height);
+    rectifiedSize(corners, rectifiedWidth, rectifiedHeight);
+    EXPECT_EQ(width, rectifiedWidth);
+    EXPECT_EQ(height, rectifiedHeight);
+
+    Frame page;
+    page.width = width; page.height = height; page.stride = 4 * static_cast<size_t>(width);
+    page.pixels.resize(page.stride * height);
+    renderer.render(frame.view(), corners, page.pixels.data(), page.stride);
+
+    // Paper everywhere but the anti-aliased outline
+    for (int y = 2; y < height - 2; y++) {
+        for (int x = 2; x < width - 2; x++) ASSERT_NEAR(page.pixels[page.stride * y + 4 * x + 1], 205, 1) << x << "," << y;
+    }
+
+    options.margin = 40;
+    renderer.setOptions(options);
+    renderer.outputSize(corners, width, height);
+    EXPECT_EQ(width, rectifiedWidth - 80);
+    EXPECT_EQ(height, rectifiedHeight - 80);
+}
+
+TEST(PageRenderer, SamplesLikeThePerspectiveWarp) {
+    SyntheticPage source;
+    source.width   = 640;
+    source.height  = 480;
+    source.corners = pageCorners(source.width, source.height, 0.1f, 35.0f);
+    Frame frame    = renderPage(source);
+
+    // The page of `IRLNativePageRenderer` and the one of `IRLNativeWarper` are the same pixels, margins cropped
+    int fullWidth, fullHeight;
+    rectifiedSize(source.corners, fullWidth, fullHeight);
+    const size_t fullStride = 4 * static_cast<size_t>(fullWidth);
+    for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::NEON }) {
+        if (!isSimdLevelSupported(level)) continue;
+        std::vector<uint8_t> warped(fullStride * fullHeight);
+        PerspectiveWarp(WarpOptions(), level).rectify(frame.view(), source.corners, warped.data(), fullStride);
+
+        for (int margin : { 0, 40 }) {
+            PageRenderOptions options;
+            options.filter = PageFilter::None;
+            options.margin = margin;
+            PageRenderer renderer(options, level);
+            int width, height;
+            renderer.outputSize(source.corners, width, height);
+            const size_t stride = 4 * static_cast<size_t>(width);
+            std::vector<uint8_t> page(stride * height);
+            renderer.render(frame.view(), source.corners, page.data(), stride);
+            for (int y = 0; y < height; y++) {
+                ASSERT_EQ(0, std::memcmp(warped.data() + fullStride * (y + margin) + 4 * margin, page.data() + stride * y, stride))
+                    << simdLevelName(level) << " margin " << margin << " row " << y;
+            }
+        }
+    }
+}
+
+TEST(PageRenderer, SizesThePageForThePaperWithTrueAspect) {
+    Quad corners;
+    Frame frame = tiltedPage(corners);
+
+    PageRenderOptions options;
+    options.filter     = PageFilter::None;
+    options.trueAspect = true;
+    options.camera     = CameraIntrinsics::centered(frame.width, frame.height, 60.0);
+    PageRenderer renderer(options);
+
+    int width, height, paperWidth, paperHeight;
+    renderer.outputSize(corners, width, height);
+    pageSize(corners, options.camera, paperWidth, paperHeight);
+    EXPECT_EQ(width, paperWidth - 80);
+    EXPECT_EQ(height, paperHeight - 80);
+
+    // The page fills the whole output, like with the rectified size
+    Frame page;
+    page.width = width; page.height = height; page.stride = 4 * static_cast<size_t>(width);
+    page.pixels.resize(page.stride * height);
+    renderer.render(frame.view(), corners, page.pixels.data(), page.stride);
+    for (int y = 0; y < height; y += 7) {
+        for (int x = 0; x < width; x += 7) ASSERT_NEAR(page.pixels[page.stride * y + 4 * x + 1], 205, 1) << x << "," << y;
+    }
+}
+
+TEST(PageRenderer, RendersStraightToTheTargetResolution) {
+    SyntheticPage source;
+    source.width   = 800;
+    source.height  = 600;
+    source.corners = pageCorners(source.width, source.height, 0.08f, 25.0f);
+    Frame frame    = renderPage(source);
+
+    int fullWidth, fullHeight;
+    rectifiedSize(source.corners, fullWidth, fullHeight);
+    PageRenderOptions options;
+    options.filter    = PageFilter::None;
+    options.margin    = 0;
+    options.maxPixels = fullWidth * fullHeight / 6;
+    PageRenderer renderer(options);
+
+    // Shrunk to the budget at the aspect of the page, then sampled like the area filter of the warp
+    int width, height;
+    renderer.outputSize(source.corners, width, height);
+    EXPECT_LE(width * height, options.maxPixels);
+    EXPECT_GT(width * height, options.maxPixels * 9 / 10);
+    EXPECT_NEAR(static_cast<double>(fullWidth) / fullHeight, static_cast<double>(width) / height, 0.01);
+
+    const size_t stride = 4 * static_cast<size_t>(width);
+    std::vector<uint8_t> page(stride * height), warped(page.size());
+    renderer.render(frame.view(), source.corners, page.data(), stride);
+    WarpOptions area;
+    area.interpolation = Interpolation::Area;
+    PerspectiveWarp(area).rectify(frame.view(), source.corners, width, height, warped.data(), stride);
+    EXPECT_EQ(warped, page);
+
+    // The margins shrink with the page
+    options.margin = 40;
+    renderer.setOptions(options);
+    int croppedWidth, croppedHeight;
+    renderer.outputSize(source.corners, croppedWidth, croppedHeight);
+    const int margin = static_cast<int>(std::lround(40.0 * width / fullWidth));
+    EXPECT_EQ(width - 2 * margin, croppedWidth);
+    EXPECT_EQ(height - 2 * margin, croppedHeight);
+
+    // Never enlarged
+    options.maxPixels = 4 * fullWidth * fullHeight;
+    renderer.setOptions(options);
+    renderer.outputSize(source.corners, croppedWidth, croppedHeight);
+    EXPECT_EQ(fullWidth - 80, croppedWidth);
+    EXPECT_EQ(fullHeight - 80, croppedHeight);
+}
+
+TEST(PageRenderer, MatchesTheFilterThenCropChain) {
+    SyntheticPage page;
+    page.width   = 640;
+    page.height  = 480;
+    page.corners = pageCorners(page.width, page.height, 0.08f, 20.0f);
+    Frame frame  = renderPage(page);
+
+    for (PageFilter filter : { PageFilter::Contrast, PageFilter::Enhance, PageFilter::UltraContrast, PageFilter::Luma }) {
+        // Chain of full size steps: rectify, filter, crop
+        PageRenderOptions plain;
+        plain.filter = PageFilter::None;
+        plain.margin = 0;
+        PageRenderer rectifier(plain);
+        int rectifiedWidth, rectifiedHeight;
+        rectifier.outputSize(page.corners, rectifiedWidth, rectifiedHeight);
+        std::vector<uint8_t> rectified(4 * static_cast<size_t>(rectifiedWidth) * rectifiedHeight);
+        rectifier.render(frame.view(), page.corners, rectified.data(), 4 * static_cast<size_t>(rectifiedWidth));
+        ImageView rectifiedView(rectified.data(), rectifiedWidth, rectifiedHeight, 4 * static_cast<size_t>(rectifiedWidth), PixelFormat::BGRA8);
+
+        std::vector<uint8_t> filtered;
+        size_t filteredStride;
+        if (filter == PageFilter::UltraContrast || filter == PageFilter::Luma) {
+            PointFilterOptions gray;
+            if (filter == PageFilter::UltraContrast) gray.curve = &kUltraContrastCurve;
+            filteredStride = static_cast<size_t>(rectifiedWidth);
+            filtered.resize(filteredStride * rectifiedHeight);
+            PointFilter(gray).applyLuma(rectifiedView, filtered.data(), filteredStride);
+        } else {
+            filteredStride = rectifiedView.stride;
+            filtered.resize(rectified.size());
+            ColorControls(filter == PageFilter::Enhance ? enhanceColorControls() : contrastColorControls())
+                .apply(rectifiedView, filtered.data(), filteredStride);
+        }
+
+        // Fused
+        PageRenderOptions options;
+        options.filter = filter;
+        PageRenderer renderer(options);
+        int width, height;
+        renderer.outputSize(page.corners, width, height);
+        const size_t channels = bytesPerPixel(renderer.outputFormat());
+        std::vector<uint8_t> fused(channels * width * height);
+        renderer.render(frame.view(), page.corners, fused.data(), channels * width);
+
+        for (int y = 0; y < height; y++) {
+            const uint8_t* expected = filtered.data() + filteredStride * (y + 40) + channels * 40;
+            ASSERT_EQ(0, std::memcmp(expected, fused.data() + channels * width * y, channels * width)) << "row " << y;
+        }
+    }
+}
+
+TEST(PageRenderer, DenoisesTheWarpedRowsBeforeSharpening) {
+    SyntheticPage page;
+    page.width   = 640;
+    page.height  = 480;
+    page.noise   = 12;
+    page.corners = pageCorners(page.width, page.height, 0.08f, 20.0f);
+    Frame frame  = renderPage(page);
+
+    // Chain of full size steps: rectify, denoise, sharpen, filter
+    PageRenderOptions plain;
+    plain.filter = PageFilter::None;
+    PageRenderer rectifier(plain);
+    int width, height;
+    rectifier.outputSize(page.corners, width, height);
+    const size_t stride = 4 * static_cast<size_t>(width);
+    std::vector<uint8_t> rectified(stride * height), denoised(rectified.size()), sharpened(rectified.size());
+    rectifier.render(frame.view(), page.corners, rectified.data(), stride);
+    GuidedFilter().apply(ImageView(rectified.data(), width, height, stride, PixelFormat::BGRA8), denoised.data(), stride);
+    UnsharpMask().apply(ImageView(denoised.data(), width, height, stride, PixelFormat::BGRA8), sharpened.data(), stride);
+
+    for (int sharpen = 0; sharpen < 2; sharpen++) {
+        std::vector<uint8_t> expected = sharpen ? sharpened : denoised;
+        ColorControls(contrastColorControls()).apply(ImageView(expected.data(), width, height, stride, PixelFormat::BGRA8), expected.data(), stride);
+
+        // Fused, in bands that start off the rows of both windows
+        PageRenderOptions options;
+        options.threads   = 3;
+        options.denoise   = true;
+        options.sharpen   = sharpen == 1;
+        options.bandBytes = 13 * stride;
+        PageRenderer renderer(options);
+        std::vector<uint8_t> fused(stride * height);
+        renderer.render(frame.view(), page.corners, fused.data(), stride);
+        EXPECT_TRUE(fused == expected) << "sharpen " << sharpen;
+
+        std::vector<uint8_t> banded(stride * height);
+        renderer.renderBands(frame.view(), page.corners, [&](const ImageView& band, int top) {
+            for (int y = 0; y < band.height; y++) std::copy(band.row(y), band.row(y) + stride, banded.begin() + stride * (top + y));
+            return true;
+        });
+        EXPECT_TRUE(banded == expected) << "sharpen " << sharpen;
+    }
+}
+
+TEST(PageRenderer, DenoisesA48MegapixelPhotoInBoundedMemory) {
+    // 8000 x 6000 BGRA, 183 MB, the page filling most of it
+    const int width = 8000, height = 6000;
+    const size_t stride = 4 * static_cast<size_t>(width);
+    std::vector<uint8_t> pixels(stride * height);
+    for (size_t i = 0; i < pixels.size(); i++) pixels[i] = static_cast<uint8_t>(i * 2654435761u >> 24);
+    const ImageView source(pixels.data(), width, height, stride, PixelFormat::BGRA8);
+    Quad quad;
+    quad.topLeft     = Point(310.0f, 240.0f);
+    quad.topRight    = Point(7650.0f, 420.0f);
+    quad.bottomRight = Point(7890.0f, 5830.0f);
+    quad.bottomLeft  = Point(120.0f, 5610.0f);
+
+    // The page and a plane of its luma would be 200 MB: the band buffer and the rows of the windows stay under the cap
+    const long cap = 12 << 20;
+    uint64_t checksum = 0;
+    const long peak = peakWorkingBytes([&] {
+        PageRenderOptions options;
+        options.threads   = 3;
+        options.denoise   = true;
+        options.sharpen   = true;
+        options.bandBytes = 4 << 20;
+        PageRenderer renderer(options);
+        renderer.renderBands(source, quad, [&](const ImageView& band, int) {
+            for (int y = 0; y < band.height; y++) {
+                for (int x = 0; x < 4 * band.width; x += 64) checksum += band.data[band.stride * y + x];
+            }
+            return true;
+        });
+        if (checksum == 0) std::abort();
+    });
+    if (peak < 0) GTEST_SKIP() << "no resident memory counters";
+    EXPECT_LT(peak, cap) << peak / (1 << 20) << " MB";
+}
+
+TEST(PageRenderer, GivesTheSameBytesOnAnyThreadCount) {
+    SyntheticPage page;
+    page.width   = 640;
+    page.height  = 480;
+    page.corners = pageCorners(page.width, page.height, 0.05f, 25.0f);
+    Frame frame  = renderPage(page);
+
+    std::vector<uint8_t> reference;
+    for (int threads : { 1, 3, 4 }) {
+        PageRenderOptions options;
+        options.filter  = PageFilter::UltraContrast;
+        options.threads = threads;
+        PageRenderer renderer(options);
+        int width, height;
+        renderer.outputSize(page.corners, width, height);
+        std::vector<uint8_t> output(static_cast<size_t>(width) * height);
+        renderer.render(frame.view(), page.corners, output.data(), width);
+
+        if (reference.empty()) reference = output;
+        EXPECT_EQ(output, reference) << threads << " threads";
+    }
+}
+
+TEST(PageRenderer, StreamsTheSameBytesInBands) {
+    SyntheticPage page;
+    page.width   = 640;
+    page.height  = 480;
+    page.corners = pageCorners(page.width, page.height, 0.07f, 15.0f);
+    Frame frame  = renderPage(page);
+
+    for (int variant = 0; variant < 3; variant++) {
+        PageRenderOptions options;
+        options.threads      = 3;
+        options.filter       = variant == 2 ? PageFilter::UltraContrast : PageFilter::Contrast;
+        options.whiteBalance = variant == 0;
+        options.sharpen      = variant == 1;
+        PageRenderer renderer(options);
+        int width, height;
+        renderer.outputSize(page.corners, width, height);
+        const size_t stride = bytesPerPixel(renderer.outputFormat()) * static_cast<size_t>(width);
+        std::vector<uint8_t> whole(stride * height);
+        renderer.render(frame.view(), page.corners, whole.data(), stride);
+
+        // 13 rows per band, the last one shorter, and the bands start off the rows of the sharpener
+        options.bandBytes = 13 * stride + 7;
+        renderer.setOptions(options);
+        ASSERT_EQ(13, renderer.bandRows(width));
+        std::vector<uint8_t> banded(stride * height);
+        int next = 0;
+        renderer.renderBands(frame.view(), page.corners, [&](const ImageView& band, int top) {
+            EXPECT_EQ(next, top);
+            EXPECT_EQ(std::min(13, height - top), band.height);
+            for (int y = 0; y < band.height; y++) {
+                std::copy(band.data + band.stride * y, band.data + band.stride * y + stride, banded.begin() + stride * (top + y));
+            }
+            next = top + band.height;
+            return true;
+        });
+        EXPECT_EQ(height, next);
+        EXPECT_TRUE(whole == banded) << "variant " << variant;
+    }
+}
+
+TEST(PageRenderer, EstimatesThePaperWhiteOncePerPage) {
+    SyntheticPage page;
+    page.width   = 640;
+    page.height  = 480;
+    page.corners = pageCorners(page.width, page.height, 0.06f, 10.0f);
+    Frame frame  = renderPage(page);
+    // Under a warm light
+    for (size_t p = 0; p < frame.pixels.size(); p += 4) frame.pixels[p] = static_cast<uint8_t>(frame.pixels[p] * 3 / 4);
+
+    PageRenderOptions options;
+    options.threads      = 2;
+    options.whiteBalance = true;
+    std::vector<std::vector<uint8_t>> pages;
+    for (size_t bandRows : { 7, 64 }) {
+        PageRenderer renderer(options);
+        int width, height;
+        renderer.outputSize(page.corners, width, height);
+        const size_t stride = 4 * static_cast<size_t>(width);
+        PageRenderOptions banded = options;
+        banded.bandBytes = bandRows * stride;
+        renderer.setOptions(banded);
+
+        std::vector<uint8_t> output(stride * height);
+        renderer.renderBands(frame.view(), page.corners, [&](const ImageView& band, int top) {
+            for (int y = 0; y < band.height; y++) std::copy(band.row(y), band.row(y) + stride, output.begin() + stride * (top + y));
+            return true;
+        });
+        pages.push_back(output);
+    }
+    EXPECT_TRUE(pages[0] == pages[1]);
+
+    // Rows keep the paper white of `prepare`, even from a photo under another light
+    PageRenderer renderer(options);
+    int width, height;
+    renderer.outputSize(page.corners, width, height);
+    const size_t stride = 4 * static_cast<size_t>(width);
+    renderer.prepare(frame.view(), page.corners);
+    const PaperWhite white = renderer.paperWhite();
+    Frame neutral = renderPage(page);
+    std::vector<uint8_t> rows(stride * 16);
+    renderer.renderRows(neutral.view(), page.corners, 100, 16, rows.data(), stride);
+    EXPECT_TRUE(std::equal(white.gains, white.gains + 3, renderer.paperWhite().gains));
+    EXPECT_GT(white.gains[0], 1.1f);
+}
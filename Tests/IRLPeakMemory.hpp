@@ -0,0 +1,97 @@
+//
+//  IRLPeakMemory.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Peak resident memory of a piece of work, for the Linux tests and benchmarks. The work runs
+//  in a forked child: free heap pages are handed back to the kernel and the high water mark is
+//  reset first, so neither the history of the test process nor memory it already holds hides
+//  what the work needs.
+//
+
+#ifndef IRL_PEAK_MEMORY_HPP
+#define IRL_PEAK_MEMORY_HPP
+
+#if defined(__linux__)
+#include <malloc.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <cstdio>
+#include <cstring>
+
+namespace irl {
+namespace test {
+
+#if defined(__linux__)
+
+/** @return The `VmRSS` or `VmHWM` line of /proc/self/status, in bytes */
+inline long residentBytes(const char* field) {
+    FILE* file = std::fopen("/proc/self/status", "r");
+    if (!file) return -1;
+    char line[256];
+    long kilobytes = -1;
+    const size_t length = std::strlen(field);
+    while (std::fgets(line, sizeof(line), file)) {
+        if (std::strncmp(line, field, length) == 0 && line[length] == ':') {
+            std::sscanf(line + length + 1, "%ld", &kilobytes);
+            break;
+        }
+    }
+    std::fclose(file);
+    return kilobytes < 0 ? -1 : kilobytes * 1024;
+}
+
+/**
+ @return Growth of the resident memory of the process while `body` runs, at its peak, in bytes. -1 when it can not be measured.
+ @discussion Buffers the parent already holds are shared with the child and count only once written to (copy on write).
+ */
+template <typename Body>
+long peakWorkingBytes(Body&& body) {
+    int channel[2];
+    if (pipe(channel) != 0) return -1;
+
+    const pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) {
+        close(channel[0]);
+        malloc_trim(0);
+
+        // Writing 5 to clear_refs resets VmHWM to the current VmRSS
+        long growth = -1;
+        if (FILE* refs = std::fopen("/proc/self/clear_refs", "w")) {
+            const bool reset = std::fputs("5", refs) >= 0;
+            std::fclose(refs);
+            const long start = residentBytes("VmRSS");
+            body();
+            const long peak = residentBytes("VmHWM");
+            if (reset && start >= 0 && peak >= 0) growth = peak - start;
+        }
+        const ssize_t written = write(channel[1], &growth, sizeof(growth));
+        _exit(written == sizeof(growth) ? 0 : 1);
+    }
+
+    close(channel[1]);
+    long growth = -1;
+    if (read(channel[0], &growth, sizeof(growth)) != sizeof(growth)) growth = -1;
+    close(channel[0]);
+
+    int status = 0;
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) return -1;
+    return growth;
+}
+
+#else
+
+template <typename Body>
+long peakWorkingBytes(Body&&) { return -1; }
+
+#endif
+
+} // namespace test
+} // namespace irl
+
+#endif /* IRL_PEAK_MEMORY_HPP */
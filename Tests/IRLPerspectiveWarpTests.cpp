@@ -0,0 +1,474 @@
+//
+//  IRLPerspectiveWarpTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLPeakMemory.hpp"
+#include "IRLPerspectiveWarp.hpp"
+#include "IRLSyntheticPage.hpp"
+#include "IRLWarpKernels.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+using namespace irl;
+using namespace irl::test;
+
+static const SimdLevel kLevels[] = { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::NEON };
+
+/** A page photographed from the side: strong perspective, every side a different length */
+static Quad slantedQuad() {
+    Quad quad;
+    quad.topLeft     = Point(112.3f, 61.8f);
+    quad.topRight    = Point(538.9f, 95.2f);
+    quad.bottomRight = Point(601.4f, 447.6f);
+    quad.bottomLeft  = Point(41.7f, 402.5f);
+    return quad;
+}
+
+static Frame photo() {
+    SyntheticPage page;
+    page.width   = 640;
+    page.height  = 480;
+    page.corners = slantedQuad();
+    return renderPage(page);
+}
+
+static uint64_t fingerprint(const std::vector<uint8_t>& bytes) {
+    uint64_t hash = 14695981039346656037ull;
+    for (uint8_t byte : bytes) hash = (hash ^ byte) * 1099511628211ull;
+    return hash;
+}
+
+// MARK: - Homography
+
+TEST(Homography, SolvesFourCorrespondences) {
+    const Quad quad = slantedQuad();
+    const Point corners[4] = { Point(0.0f, 0.0f), Point(400.0f, 0.0f), Point(400.0f, 300.0f), Point(0.0f, 300.0f) };
+    const Point targets[4] = { quad[0], quad[1], quad[2], quad[3] };
+
+    Homography H;
+    ASSERT_TRUE(Homography::solve(corners, targets, H));
+    const Homography closed = Homography::rectangleToQuad(400.0, 300.0, quad);
+    for (int i = 0; i < 9; i++) EXPECT_NEAR(closed.m[i], H.m[i], 1e-9 * std::max(1.0, std::fabs(closed.m[i]))) << i;
+
+    for (int i = 0; i < 4; i++) {
+        EXPECT_NEAR(targets[i].x, H.map(corners[i]).x, 1e-3f);
+        EXPECT_NEAR(targets[i].y, H.map(corners[i]).y, 1e-3f);
+    }
+
+    const Homography identity = H.inverse() * H;
+    const Point inside(217.0f, 143.0f);
+    EXPECT_NEAR(inside.x, identity.map(inside).x, 1e-3f);
+    EXPECT_NEAR(inside.y, identity.map(inside).y, 1e-3f);
+    EXPECT_NEAR(corners[2].x, H.inverse().map(targets[2]).x, 1e-3f);
+}
+
+TEST(Homography, RefusesCollinearPoints) {
+    const Point line[4]    = { Point(0.0f, 0.0f), Point(50.0f, 50.0f), Point(100.0f, 100.0f), Point(0.0f, 100.0f) };
+    const Point square[4]  = { Point(0.0f, 0.0f), Point(100.0f, 0.0f), Point(100.0f, 100.0f), Point(0.0f, 100.0f) };
+    Homography H;
+    EXPECT_FALSE(Homography::solve(line, square, H));
+    EXPECT_FALSE(Homography::solve(square, line, H));
+}
+
+// MARK: - Coordinates
+
+TEST(PerspectiveWarp, StepsCloseToTheExactProjection) {
+    const Quad quad = slantedQuad();
+    int width, height;
+    rectifiedSize(quad, width, height);
+    const Homography H = Homography::rectangleToQuad(width, height, quad);
+
+    std::vector<int32_t> xs(static_cast<size_t>(width)), ys(xs.size());
+    double worst = 0.0;
+    for (int y = 0; y < height; y += 7) {
+        PerspectiveWarp::coordinatesRow(H, y, width, 640, 480, Interpolation::Bicubic, xs.data(), ys.data());
+        for (int x = 0; x < width; x++) {
+            const Point exact = H.map(Point(x + 0.5f, y + 0.5f));
+            worst = std::max(worst, std::fabs(xs[x] / 65536.0 - (exact.x - 0.5)));
+            worst = std::max(worst, std::fabs(ys[x] / 65536.0 - (exact.y - 0.5)));
+        }
+    }
+    EXPECT_LT(worst, 1e-3);
+}
+
+// MARK: - Samplers
+
+TEST(PerspectiveWarp, IdentityCopiesTheSource) {
+    const Frame frame = photo();
+    for (Interpolation interpolation : { Interpolation::Bilinear, Interpolation::Bicubic, Interpolation::Area }) {
+        WarpOptions options;
+        options.interpolation = interpolation;
+        std::vector<uint8_t> copy(frame.pixels.size());
+        PerspectiveWarp(options).warp(frame.view(), Homography(), copy.data(), frame.stride, frame.width, frame.height);
+        EXPECT_EQ(frame.pixels, copy) << static_cast<int>(interpolation);
+    }
+}
+
+/** The samplers of the paper, in double precision, at the exact projection of every pixel */
+static std::vector<uint8_t> referenceWarp(const Frame& frame, const Homography& H, int width, int height, Interpolation interpolation) {
+    auto at = [&](int x, int y, int c) {
+        x = std::min(std::max(x, 0), frame.width - 1);
+        y = std::min(std::max(y, 0), frame.height - 1);
+        return static_cast<double>(frame.pixels[static_cast<size_t>(y) * frame.stride + 4 * x + c]);
+    };
+    auto cubic = [](double t, double* w) {
+        const double t2 = t * t, t3 = t2 * t;
+        w[0] = 0.5 * (-t3 + 2.0 * t2 - t);
+        w[1] = 0.5 * (3.0 * t3 - 5.0 * t2 + 2.0);
+        w[2] = 0.5 * (-3.0 * t3 + 4.0 * t2 + t);
+        w[3] = 0.5 * (t3 - t2);
+    };
+
+    std::vector<uint8_t> output(4 * static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const Point p = H.map(Point(x + 0.5f, y + 0.5f));
+            const double sx = std::min(std::max(p.x - 0.5, 0.0), frame.width - 1.0);
+            const double sy = std::min(std::max(p.y - 0.5, 0.0), frame.height - 1.0);
+            const int    x0 = static_cast<int>(sx), y0 = static_cast<int>(sy);
+            const double fx = sx - x0, fy = sy - y0;
+            for (int c = 0; c < 4; c++) {
+                double value = 0.0;
+                if (interpolation == Interpolation::Bilinear) {
+                    value = (at(x0, y0, c) * (1 - fx) + at(x0 + 1, y0, c) * fx) * (1 - fy) + (at(x0, y0 + 1, c) * (1 - fx) + at(x0 + 1, y0 + 1, c) * fx) * fy;
+                } else {
+                    double wx[4], wy[4];
+                    cubic(fx, wx);
+                    cubic(fy, wy);
+                    for (int j = 0; j < 4; j++) for (int i = 0; i < 4; i++) value += wx[i] * wy[j] * at(x0 - 1 + i, y0 - 1 + j, c);
+                }
+                output[(static_cast<size_t>(y) * width + x) * 4 + c] = static_cast<uint8_t>(std::min(std::max(std::lround(value), 0L), 255L));
+            }
+        }
+    }
+    return output;
+}
+
+TEST(PerspectiveWarp, MatchesTheExactSamplers) {
+    const Frame frame = photo();
+    const Quad  quad  = slantedQuad();
+    int width, height;
+    rectifiedSize(quad, width, height);
+    const Homography H = Homography::rectangleToQuad(width, height, quad);
+
+    for (Interpolation interpolation : { Interpolation::Bilinear, Interpolation::Bicubic }) {
+        WarpOptions options;
+        options.interpolation = interpolation;
+        std::vector<uint8_t> warped(4 * static_cast<size_t>(width) * height);
+        PerspectiveWarp(options).rectify(frame.view(), quad, warped.data(), 4 * static_cast<size_t>(width));
+
+        const std::vector<uint8_t> expected = referenceWarp(frame, H, width, height, interpolation);
+        int worst = 0;
+        double total = 0.0;
+        for (size_t i = 0; i < expected.size(); i++) {
+            const int error = std::abs(expected[i] - warped[i]);
+            worst  = std::max(worst, error);
+            total += error;
+        }
+        // Weights are quantized (Q8 bilinear, rounded after each pass, 256 phases bicubic): a level or two off
+        // on steep edges, a fraction of a level on average
+        EXPECT_LE(worst, 2) << static_cast<int>(interpolation);
+        EXPECT_LT(total / expected.size(), 0.2) << static_cast<int>(interpolation);
+    }
+}
+
+TEST(PerspectiveWarp, GoldenOutputsOnEveryLevelAndThreadCount) {
+    const Frame frame = photo();
+    const Quad  quad  = slantedQuad();
+    int width, height;
+    rectifiedSize(quad, width, height);
+
+    // Fingerprints of the scalar reference. A change of the samplers or of the stepping must update them knowingly.
+    const uint64_t golden[2] = { 9003763443919613350ull, 18233392953112717758ull };
+    for (Interpolation interpolation : { Interpolation::Bilinear, Interpolation::Bicubic }) {
+        for (SimdLevel level : kLevels) {
+            if (!detail::warpKernels(level)) continue;
+            for (int threads : { 1, 3 }) {
+                WarpOptions options;
+                options.interpolation = interpolation;
+                options.threads       = threads;
+                std::vector<uint8_t> warped(4 * static_cast<size_t>(width) * height);
+                PerspectiveWarp(options, level).rectify(frame.view(), quad, warped.data(), 4 * static_cast<size_t>(width));
+                EXPECT_EQ(golden[static_cast<int>(interpolation)], fingerprint(warped))
+                    << simdLevelName(level) << " " << threads << " threads, interpolation " << static_cast<int>(interpolation);
+            }
+        }
+    }
+}
+
+TEST(PerspectiveWarp, ReplicatesTheBordersOfTinySources) {
+    // One pixel wide and one row high sources must not read past them
+    const uint8_t pixel[4] = { 10, 20, 30, 255 };
+    for (Interpolation interpolation : { Interpolation::Bilinear, Interpolation::Bicubic, Interpolation::Area }) {
+        WarpOptions options;
+        options.interpolation = interpolation;
+        Homography zoom;
+        zoom.m[0] = 0.1;
+        zoom.m[4] = 0.1;
+        std::vector<uint8_t> output(4 * 13 * 5);
+        PerspectiveWarp(options).warp(ImageView(pixel, 1, 1, 4, PixelFormat::BGRA8), zoom, output.data(), 4 * 13, 13, 5);
+        for (size_t i = 0; i < output.size(); i++) ASSERT_EQ(pixel[i % 4], output[i]) << i;
+    }
+}
+
+// MARK: - Area filter
+
+/** The page of `slantedQuad` shrunk 2.5 times, like a photo rectified straight to 200 dpi */
+static void shrunkSize(int& width, int& height) {
+    rectifiedSize(slantedQuad(), width, height);
+    width  = width  * 2 / 5;
+    height = height * 2 / 5;
+}
+
+TEST(PerspectiveWarp, MeasuresTheFootprintOfEachPixel) {
+    const int width = 100;
+    std::vector<int32_t> fxs(width), fys(width);
+    auto expectFootprint = [&](const Homography& H, double x, double y) {
+        PerspectiveWarp::footprintRow(H, 7, width, fxs.data(), fys.data());
+        for (int i = 0; i < width; i++) {
+            EXPECT_NEAR(x, fxs[static_cast<size_t>(i)] / 65536.0, 1e-3) << i;
+            EXPECT_NEAR(y, fys[static_cast<size_t>(i)] / 65536.0, 1e-3) << i;
+        }
+    };
+
+    // Shrunk 3 times across and twice down, then turned a quarter: the axes swap
+    Homography shrink;
+    shrink.m[0] = 3.0;
+    shrink.m[4] = 2.0;
+    expectFootprint(shrink, 3.0, 2.0);
+    Homography turn;
+    turn.m[0] = 0.0; turn.m[1] = 2.5;
+    turn.m[3] = 2.5; turn.m[4] = 0.0;
+    expectFootprint(turn, 2.5, 2.5);
+
+    // Magnified: never less than a pixel. Shrunk 100 times: never more than the taps
+    Homography zoom;
+    zoom.m[0] = zoom.m[4] = 0.25;
+    expectFootprint(zoom, 1.0, 1.0);
+    zoom.m[0] = zoom.m[4] = 100.0;
+    expectFootprint(zoom, detail::kAreaTaps - 1, detail::kAreaTaps - 1);
+
+    // In perspective, the derivatives of the exact projection
+    int shrunkWidth, shrunkHeight;
+    shrunkSize(shrunkWidth, shrunkHeight);
+    const Homography H = Homography::rectangleToQuad(shrunkWidth, shrunkHeight, slantedQuad());
+    std::vector<int32_t> xs(static_cast<size_t>(shrunkWidth)), ys(xs.size());
+    fxs.resize(xs.size());
+    fys.resize(xs.size());
+    for (int y : { 0, shrunkHeight / 2, shrunkHeight - 1 }) {
+        PerspectiveWarp::footprintRow(H, y, shrunkWidth, fxs.data(), fys.data());
+        for (int x = 0; x < shrunkWidth; x++) {
+            // Central differences, in double: `map` rounds to float
+            const double h = 1e-4, cx = x + 0.5, cy = y + 0.5;
+            auto map = [&](double u, double v, int axis) {
+                const double* m = H.m;
+                return (m[3 * axis] * u + m[3 * axis + 1] * v + m[3 * axis + 2]) / (m[6] * u + m[7] * v + m[8]);
+            };
+            auto size = [&](int axis) {
+                const double du = (map(cx + h, cy, axis) - map(cx - h, cy, axis)) / (2.0 * h);
+                const double dv = (map(cx, cy + h, axis) - map(cx, cy - h, axis)) / (2.0 * h);
+                return std::max(std::hypot(du, dv), 1.0);
+            };
+            const double sizeX = size(0), sizeY = size(1);
+            EXPECT_NEAR(sizeX, fxs[static_cast<size_t>(x)] / 65536.0, 0.01 * sizeX) << x << " " << y;
+            EXPECT_NEAR(sizeY, fys[static_cast<size_t>(x)] / 65536.0, 0.01 * sizeY) << x << " " << y;
+        }
+    }
+}
+
+TEST(PerspectiveWarp, AreaMatchesTheExactBoxFilter) {
+    const Frame frame = photo();
+    int width, height;
+    shrunkSize(width, height);
+    const Homography H = Homography::rectangleToQuad(width, height, slantedQuad());
+
+    WarpOptions options;
+    options.interpolation = Interpolation::Area;
+    std::vector<uint8_t> warped(4 * static_cast<size_t>(width) * height);
+    PerspectiveWarp(options).rectify(frame.view(), slantedQuad(), width, height, warped.data(), 4 * static_cast<size_t>(width));
+
+    // The average of the source under the box of each pixel, in double precision, with the footprint of the exact projection
+    int worst = 0;
+    double total = 0.0;
+    std::vector<int32_t> fxs(static_cast<size_t>(width)), fys(fxs.size());
+    for (int y = 0; y < height; y++) {
+        PerspectiveWarp::footprintRow(H, y, width, fxs.data(), fys.data());
+        for (int x = 0; x < width; x++) {
+            const Point  p  = H.map(Point(x + 0.5f, y + 0.5f));
+            const double fx = fxs[static_cast<size_t>(x)] / 65536.0, fy = fys[static_cast<size_t>(x)] / 65536.0;
+            const double left = std::max(p.x - 0.5 * fx, 0.0), right  = std::min(p.x + 0.5 * fx, static_cast<double>(frame.width));
+            const double top  = std::max(p.y - 0.5 * fy, 0.0), bottom = std::min(p.y + 0.5 * fy, static_cast<double>(frame.height));
+            double sums[4] = { 0.0, 0.0, 0.0, 0.0 }, area = 0.0;
+            for (int j = static_cast<int>(top); j < bottom; j++) {
+                const double coverY = std::min(bottom, j + 1.0) - std::max(top, static_cast<double>(j));
+                for (int i = static_cast<int>(left); i < right; i++) {
+                    const double cover = coverY * (std::min(right, i + 1.0) - std::max(left, static_cast<double>(i)));
+                    for (int c = 0; c < 4; c++) sums[c] += cover * frame.pixels[static_cast<size_t>(j) * frame.stride + 4 * static_cast<size_t>(i) + static_cast<size_t>(c)];
+                    area += cover;
+                }
+            }
+            for (int c = 0; c < 4; c++) {
+                const int error = std::abs(static_cast<int>(std::lround(sums[c] / area)) - warped[(static_cast<size_t>(y) * width + x) * 4 + static_cast<size_t>(c)]);
+                worst  = std::max(worst, error);
+                total += error;
+            }
+        }
+    }
+    // Q12 weights rounded per pass, coordinates stepped along the rows: a level off at most
+    EXPECT_LE(worst, 2);
+    EXPECT_LT(total / warped.size(), 0.2);
+}
+
+TEST(PerspectiveWarp, AreaDoesNotAliasFinePrint) {
+    // A one pixel checkerboard, the finest print there is, shrunk about 2.7 times in perspective
+    Frame frame;
+    frame.width  = 600;
+    frame.height = 450;
+    frame.stride = 4 * static_cast<size_t>(frame.width);
+    frame.pixels.resize(frame.stride * static_cast<size_t>(frame.height));
+    for (int y = 0; y < frame.height; y++) {
+        for (int x = 0; x < frame.width; x++) {
+            uint8_t* pixel = &frame.pixels[static_cast<size_t>(y) * frame.stride + 4 * static_cast<size_t>(x)];
+            std::fill(pixel, pixel + 3, static_cast<uint8_t>((x + y) % 2 ? 255 : 0));
+            pixel[3] = 255;
+        }
+    }
+    Quad quad;
+    quad.topLeft     = Point(20.0f, 12.0f);
+    quad.topRight    = Point(585.0f, 30.0f);
+    quad.bottomRight = Point(570.0f, 440.0f);
+    quad.bottomLeft  = Point(35.0f, 425.0f);
+    const int width = 210, height = 155;
+
+    auto deviation = [&](Interpolation interpolation, double& mean) {
+        WarpOptions options;
+        options.interpolation = interpolation;
+        std::vector<uint8_t> warped(4 * static_cast<size_t>(width) * height);
+        PerspectiveWarp(options).rectify(frame.view(), quad, width, height, warped.data(), 4 * static_cast<size_t>(width));
+        double sum = 0.0, squares = 0.0;
+        for (size_t i = 0; i < warped.size(); i += 4) {
+            sum     += warped[i];
+            squares += static_cast<double>(warped[i]) * warped[i];
+        }
+        const double count = warped.size() / 4.0;
+        mean = sum / count;
+        return std::sqrt(squares / count - mean * mean);
+    };
+
+    // Bilinear picks black or white squares at random, the area filter sees the gray they average to
+    double bilinearMean, areaMean;
+    const double bilinear = deviation(Interpolation::Bilinear, bilinearMean);
+    const double area     = deviation(Interpolation::Area, areaMean);
+    EXPECT_GT(bilinear, 30.0);
+    EXPECT_LT(area, 8.0);
+    EXPECT_NEAR(127.5, areaMean, 2.0);
+}
+
+TEST(PerspectiveWarp, AreaGoldenOutputsOnEveryLevelAndThreadCount) {
+    const Frame frame = photo();
+    int width, height;
+    shrunkSize(width, height);
+
+    // Fingerprint of the scalar reference. A change of the filter or of the stepping must update it knowingly.
+    const uint64_t golden = 6395952904984023394ull;
+    for (SimdLevel level : kLevels) {
+        if (!detail::warpKernels(level)) continue;
+        for (int threads : { 1, 3 }) {
+            WarpOptions options;
+            options.interpolation = Interpolation::Area;
+            options.threads       = threads;
+            std::vector<uint8_t> warped(4 * static_cast<size_t>(width) * height);
+            PerspectiveWarp(options, level).rectify(frame.view(), slantedQuad(), width, height, warped.data(), 4 * static_cast<size_t>(width));
+            EXPECT_EQ(golden, fingerprint(warped)) << simdLevelName(level) << " " << threads << " threads";
+        }
+    }
+}
+
+// MARK: - Bands
+
+TEST(PerspectiveWarp, BandsMatchTheWholeWarp) {
+    const Frame frame = photo();
+    int width, height;
+    rectifiedSize(slantedQuad(), width, height);
+    const size_t stride = 4 * static_cast<size_t>(width);
+
+    for (Interpolation interpolation : { Interpolation::Bilinear, Interpolation::Bicubic, Interpolation::Area }) {
+        WarpOptions options;
+        options.interpolation = interpolation;
+        options.threads       = 3;
+        PerspectiveWarp warp(options);
+        std::vector<uint8_t> whole(stride * height);
+        warp.rectify(frame.view(), slantedQuad(), width, height, whole.data(), stride);
+
+        // 7 rows and a bit per band, the last one shorter
+        options.bandBytes = 7 * stride + 100;
+        warp.setOptions(options);
+        ASSERT_EQ(7, warp.bandRows(width));
+        std::vector<uint8_t> banded(stride * height);
+        int next = 0;
+        warp.rectifyBands(frame.view(), slantedQuad(), width, height, [&](const ImageView& band, int top) {
+            EXPECT_EQ(next, top);
+            EXPECT_EQ(width, band.width);
+            EXPECT_EQ(std::min(7, height - top), band.height);
+            for (int y = 0; y < band.height; y++) {
+                std::copy(band.data + band.stride * y, band.data + band.stride * y + stride, banded.begin() + stride * (top + y));
+            }
+            next = top + band.height;
+            return true;
+        });
+        EXPECT_EQ(height, next);
+        EXPECT_TRUE(whole == banded) << static_cast<int>(interpolation);
+    }
+
+    // The consumer stops the warp, and a row too wide for the buffer still makes a band
+    WarpOptions options;
+    options.bandBytes = 16;
+    PerspectiveWarp warp(options);
+    EXPECT_EQ(1, warp.bandRows(width));
+    int bands = 0;
+    warp.rectifyBands(frame.view(), slantedQuad(), width, height, [&](const ImageView&, int) { return ++bands < 3; });
+    EXPECT_EQ(3, bands);
+}
+
+TEST(PerspectiveWarp, StreamsA48MegapixelPhotoInBoundedMemory) {
+    // 8000 x 6000 BGRA, 183 MB, the page filling most of it
+    const int width = 8000, height = 6000;
+    const size_t stride = 4 * static_cast<size_t>(width);
+    std::vector<uint8_t> pixels(stride * height);
+    for (size_t i = 0; i < pixels.size(); i++) pixels[i] = static_cast<uint8_t>(i * 2654435761u >> 24);
+    const ImageView source(pixels.data(), width, height, stride, PixelFormat::BGRA8);
+    Quad quad;
+    quad.topLeft     = Point(310.0f, 240.0f);
+    quad.topRight    = Point(7650.0f, 420.0f);
+    quad.bottomRight = Point(7890.0f, 5830.0f);
+    quad.bottomLeft  = Point(120.0f, 5610.0f);
+    int pageWidth, pageHeight;
+    rectifiedSize(quad, pageWidth, pageHeight);
+    ASSERT_GT(static_cast<long>(pageWidth) * pageHeight, 40000000L);
+
+    // The page itself would be 160 MB: the bands, the rows of coordinates and the threads stay under the cap
+    const long cap = 8 << 20;
+    uint64_t checksum = 0;
+    const long peak = peakWorkingBytes([&] {
+        WarpOptions options;
+        options.threads   = 3;
+        options.bandBytes = 4 << 20;
+        PerspectiveWarp warp(options);
+        warp.rectifyBands(source, quad, pageWidth, pageHeight, [&](const ImageView& band, int) {
+            for (int y = 0; y < band.height; y++) {
+                for (int x = 0; x < 4 * band.width; x += 64) checksum += band.data[band.stride * y + x];
+            }
+            return true;
+        });
+        if (checksum == 0) std::abort();
+    });
+    if (peak < 0) GTEST_SKIP() << "no resident memory counters";
+    EXPECT_LT(peak, cap) << peak / (1 << 20) << " MB";
+}
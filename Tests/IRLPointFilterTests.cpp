@@ -0,0 +1,197 @@
+//
+//  IRLPointFilterTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  The fixed point chain must stay within 1 of the formula evaluated in double precision, and
+//  every vector variant must give the same bits as the scalar reference. Past a curve, the
+//  value must be the one of an entry within 1 of the formula.
+//
+
+#include "IRLPointFilter.hpp"
+#include "IRLPointFilterKernels.hpp"
+#include "IRLSyntheticPage.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+
+using namespace irl;
+using namespace irl::test;
+
+static std::vector<uint8_t> randomPixels(int count, uint32_t seed) {
+    XorShift random(seed);
+    std::vector<uint8_t> pixels(static_cast<size_t>(count) * 4);
+    for (uint8_t& value : pixels) value = static_cast<uint8_t>(random.next() >> 24);
+    return pixels;
+}
+
+/** The chain before rounding and threshold, in bytes */
+static double referenceChannel(const uint8_t* pixel, int channel, const PointFilterOptions& options) {
+    const double luma  = 0.0721 * pixel[0] + 0.7154 * pixel[1] + 0.2125 * pixel[2];
+    const double mixed = luma + options.saturation * (pixel[channel] - luma);
+    const double value = ((mixed / 255.0 + options.brightness - 0.5) * options.contrast + 0.5) * 255.0;
+    return std::min(std::max(value, 0.0), 255.0);
+}
+
+static std::vector<PointFilterOptions> presets() {
+    std::vector<PointFilterOptions> options(5);
+    options[0].saturation = 0.0f;   options[0].contrast = 1.14f;
+    options[1].contrast   = 1.1f;
+    options[2].saturation = 0.35f;  options[2].brightness = 0.04f;  options[2].contrast = 0.8f;
+    options[3].saturation = 0.6f;   options[3].brightness = -0.2f;  options[3].contrast = 3.5f;
+    options[4].brightness = 0.3f;   options[4].contrast   = 0.25f;
+    return options;
+}
+
+TEST(PointFilter, MatchesTheFormula) {
+    std::vector<uint8_t> pixels = randomPixels(4096, 3);
+    for (int v = 0; v < 256; v++) std::memset(&pixels[4 * v], v, 4);
+    const ImageView view(pixels.data(), 4096, 1, pixels.size(), PixelFormat::BGRA8);
+
+    for (const PointFilterOptions& options : presets()) {
+        std::vector<uint8_t> fixed(pixels.size()), floating(pixels.size());
+        PointFilter(options, SimdLevel::Scalar).apply(view, fixed.data(), fixed.size());
+        detail::pointFilterRowFloat(pixels.data(), floating.data(), view.width, 4, options);
+
+        int worstFixed = 0, worstFloat = 0;
+        for (size_t p = 0; p < pixels.size(); p += 4) {
+            for (int i = 0; i < 3; i++) {
+                const long expected = std::lround(referenceChannel(&pixels[p], i, options));
+                worstFixed = std::max<int>(worstFixed, static_cast<int>(std::labs(expected - fixed[p + i])));
+                worstFloat = std::max<int>(worstFloat, static_cast<int>(std::labs(expected - floating[p + i])));
+            }
+            EXPECT_EQ(pixels[p + 3], fixed[p + 3]);
+        }
+        EXPECT_LE(worstFixed, 1) << "saturation " << options.saturation << " contrast " << options.contrast;
+        EXPECT_LE(worstFloat, 1) << "saturation " << options.saturation << " contrast " << options.contrast;
+    }
+}
+
+TEST(PointFilter, GrayMatchesTheFormula) {
+    std::vector<uint8_t> ramp(256);
+    for (int v = 0; v < 256; v++) ramp[v] = static_cast<uint8_t>(v);
+
+    for (const PointFilterOptions& options : presets()) {
+        std::vector<uint8_t> fixed(ramp.size());
+        PointFilter(options, SimdLevel::Scalar).apply(ImageView(ramp.data(), 256, 1, 256, PixelFormat::Gray8), fixed.data(), 256);
+        for (int v = 0; v < 256; v++) {
+            const uint8_t pixel[4] = { ramp[v], ramp[v], ramp[v], 255 };
+            EXPECT_NEAR(referenceChannel(pixel, 0, options), fixed[v], 1.0) << "value " << v << " contrast " << options.contrast;
+        }
+    }
+}
+
+TEST(PointFilter, ThresholdsTheFilteredValues) {
+    PointFilterOptions options;
+    options.saturation = 0.0f;
+    options.contrast   = 1.14f;
+    options.threshold  = 140;
+
+    std::vector<uint8_t> pixels = randomPixels(2048, 9);
+    std::vector<uint8_t> output(pixels.size());
+    PointFilter(options).apply(ImageView(pixels.data(), 2048, 1, pixels.size(), PixelFormat::BGRA8), output.data(), output.size());
+
+    for (size_t p = 0; p < pixels.size(); p += 4) {
+        const double value = referenceChannel(&pixels[p], 1, options);
+        ASSERT_TRUE(output[p + 1] == 0 || output[p + 1] == 255);
+        // Values within rounding distance of the threshold may land on either side
+        if (std::fabs(value - options.threshold) > 1.0) {
+            EXPECT_EQ(value > options.threshold ? 255 : 0, output[p + 1]) << value;
+        }
+        EXPECT_EQ(output[p], output[p + 1]);
+        EXPECT_EQ(pixels[p + 3], output[p + 3]);
+    }
+}
+
+TEST(PointFilter, LooksTheCurveUpAfterTheContrast) {
+    // A curve lands a value 1 off on any entry next to it: compare with the entries around the exact value
+    std::vector<uint8_t> pixels = randomPixels(4096, 17);
+    const ImageView view(pixels.data(), 4096, 1, pixels.size(), PixelFormat::BGRA8);
+
+    for (PointFilterOptions options : presets()) {
+        options.curve = &kUltraContrastCurve;
+        std::vector<uint8_t> color(pixels.size()), luma(4096), floating(4096);
+        PointFilter filter(options, SimdLevel::Scalar);
+        filter.apply(view, color.data(), color.size());
+        filter.applyLuma(view, luma.data(), luma.size());
+        detail::pointFilterLumaRowFloat(pixels.data(), floating.data(), view.width, options);
+
+        PointFilterOptions gray = options;
+        gray.saturation = 0.0f;
+        for (size_t p = 0; p < pixels.size(); p += 4) {
+            auto near = [&](double value, uint8_t actual) {
+                const int low  = std::max(static_cast<int>(std::floor(value)) - 1, 0);
+                const int high = std::min(static_cast<int>(std::ceil(value)) + 1, 255);
+                for (int v = low; v <= high; v++) {
+                    if (kUltraContrastCurve[v] == actual) return true;
+                }
+                return false;
+            };
+            for (int i = 0; i < 3; i++) EXPECT_TRUE(near(referenceChannel(&pixels[p], i, options), color[p + i])) << "contrast " << options.contrast;
+            EXPECT_TRUE(near(referenceChannel(&pixels[p], 0, gray), luma[p / 4])) << "contrast " << options.contrast;
+            EXPECT_TRUE(near(referenceChannel(&pixels[p], 0, gray), floating[p / 4])) << "contrast " << options.contrast;
+        }
+    }
+}
+
+TEST(PointFilter, LumaMatchesTheFormula) {
+    std::vector<uint8_t> pixels = randomPixels(4096, 23);
+    const ImageView view(pixels.data(), 4096, 1, pixels.size(), PixelFormat::BGRA8);
+
+    for (PointFilterOptions options : presets()) {
+        std::vector<uint8_t> luma(4096);
+        PointFilter(options, SimdLevel::Scalar).applyLuma(view, luma.data(), luma.size());
+        options.saturation = 0.0f;
+        for (int x = 0; x < 4096; x++) {
+            EXPECT_NEAR(referenceChannel(&pixels[4 * static_cast<size_t>(x)], 0, options), luma[x], 1.0) << "contrast " << options.contrast;
+        }
+    }
+}
+
+TEST(PointFilter, VectorVariantsAreBitExact) {
+    std::vector<PointFilterOptions> options = presets();
+    options[0].threshold = 128;
+    options[1].curve     = &kUltraContrastCurve;
+    options[3].curve     = &kUltraContrastCurve;
+    options[3].threshold = 100;
+
+    for (SimdLevel level : { SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::NEON }) {
+        if (!detail::pointFilterKernels(level)) continue;
+        for (const PointFilterOptions& preset : options) {
+            // Odd width so the row ends go through the scalar tail
+            const int width = 333, height = 7;
+            std::vector<uint8_t> pixels = randomPixels(width * height, 11);
+            for (PixelFormat format : { PixelFormat::BGRA8, PixelFormat::Gray8 }) {
+                const size_t stride = static_cast<size_t>(width) * bytesPerPixel(format);
+                ImageView view(pixels.data(), width, height, stride, format);
+
+                std::vector<uint8_t> expected(stride * height), actual(stride * height);
+                PointFilter(preset, SimdLevel::Scalar).apply(view, expected.data(), stride);
+                PointFilter vector(preset, level);
+                ASSERT_EQ(vector.simdLevel(), level);
+                vector.apply(view, actual.data(), stride);
+                EXPECT_EQ(expected, actual) << simdLevelName(level) << " contrast " << preset.contrast << " channels " << bytesPerPixel(format);
+            }
+
+            const ImageView view(pixels.data(), width, height, 4 * static_cast<size_t>(width), PixelFormat::BGRA8);
+            std::vector<uint8_t> expected(static_cast<size_t>(width) * height), actual(expected.size());
+            PointFilter(preset, SimdLevel::Scalar).applyLuma(view, expected.data(), static_cast<size_t>(width));
+            PointFilter(preset, level).applyLuma(view, actual.data(), static_cast<size_t>(width));
+            EXPECT_EQ(expected, actual) << simdLevelName(level) << " contrast " << preset.contrast << " luma";
+        }
+    }
+}
+
+TEST(PointFilter, FiltersInPlace) {
+    std::vector<uint8_t> pixels = randomPixels(97 * 5, 5);
+    ImageView view(pixels.data(), 97, 5, 97 * 4, PixelFormat::BGRA8);
+
+    PointFilter filter(presets()[2]);
+    std::vector<uint8_t> expected(pixels.size());
+    filter.apply(view, expected.data(), view.stride);
+    filter.apply(view, pixels.data(), view.stride);
+    EXPECT_EQ(expected, pixels);
+}
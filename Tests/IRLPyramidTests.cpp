@@ -0,0 +1,80 @@
+//
+//  IRLPyramidTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLPyramid.hpp"
+#include "IRLSyntheticPage.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace irl;
+using namespace irl::test;
+
+TEST(LumaPyramid, BGRADownsampleMatchesLumaThenBox) {
+    SyntheticPage page;
+    page.width   = 321;
+    page.height  = 243;
+    page.corners = pageCorners(page.width, page.height, 0.2f, 10.0f);
+    Frame frame  = renderPage(page);
+
+    Plane8 fused;
+    downsampleLuma2x(frame.view(), fused);
+    ASSERT_EQ(fused.width(), 160);
+    ASSERT_EQ(fused.height(), 121);
+
+    Plane8 luma, boxed;
+    convertToLuma(frame.view(), luma);
+    downsampleLuma2x(luma.view(), boxed);
+
+    // Fusing skips one rounding step, results may differ by one
+    for (int y = 0; y < fused.height(); y++) {
+        for (int x = 0; x < fused.width(); x++) {
+            EXPECT_NEAR(fused.row(y)[x], boxed.row(y)[x], 1) << x << "," << y;
+        }
+    }
+}
+
+TEST(LumaPyramid, LevelsHalveTheSize) {
+    SyntheticPage page;
+    page.corners = pageCorners(page.width, page.height, 0.2f, 0.0f);
+    Frame frame  = renderPage(page);
+
+    LumaPyramid pyramid;
+    pyramid.build(frame.view(), 3);
+    ASSERT_EQ(pyramid.levels(), 3);
+    EXPECT_EQ(pyramid.level(0).format, PixelFormat::BGRA8);
+    EXPECT_EQ(pyramid.level(3).format, PixelFormat::Gray8);
+    EXPECT_EQ(pyramid.level(3).width, 180);
+    EXPECT_EQ(pyramid.level(3).height, 135);
+}
+
+TEST(LumaPyramid, ExtractReplicatesBorders) {
+    const uint8_t pixels[] = { 10, 20,
+                               30, 40 };
+    ImageView view(pixels, 2, 2, 2, PixelFormat::Gray8);
+    Plane8 window;
+    extractLuma(view, -1, -1, 4, 4, window);
+    EXPECT_EQ(window.row(0)[0], 10);
+    EXPECT_EQ(window.row(0)[3], 20);
+    EXPECT_EQ(window.row(3)[0], 30);
+    EXPECT_EQ(window.row(2)[2], 40);
+}
+
+TEST(LumaPyramid, ExtractDownsampledAveragesBlocks) {
+    const uint8_t pixels[] = {  0,  4, 10, 10,
+                                8, 12, 10, 10,
+                               40, 40, 90, 91,
+                               40, 40, 92, 93 };
+    ImageView view(pixels, 4, 4, 4, PixelFormat::Gray8);
+    Plane8 window;
+    extractLumaDownsampled(view, 1, 0, 0, 3, 2, window);
+    ASSERT_EQ(window.width(), 3);
+    EXPECT_EQ(window.row(0)[0], 6);
+    EXPECT_EQ(window.row(0)[1], 10);
+    EXPECT_EQ(window.row(1)[0], 40);
+    EXPECT_EQ(window.row(1)[1], 92);
+    EXPECT_EQ(window.row(0)[2], 10);    // past the right border, replicated
+}
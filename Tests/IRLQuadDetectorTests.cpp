@@ -0,0 +1,132 @@
+//
+//  IRLQuadDetectorTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLQuadDetector.hpp"
+#include "IRLSyntheticPage.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace irl;
+using namespace irl::test;
+
+TEST(QuadDetector, FindsTiltedPageInPreviewFrame) {
+    SyntheticPage page;
+    page.corners = pageCorners(page.width, page.height, 0.15f, 40.0f);
+    Frame frame = renderPage(page);
+
+    QuadDetector detector;
+    std::vector<DetectedQuad> quads = detector.detect(frame.view());
+
+    ASSERT_EQ(quads.size(), 1u);
+    EXPECT_LT(cornerError(quads[0].quad, page.corners), 3.0f);
+    EXPECT_GT(quads[0].fillRatio, 0.95f);
+}
+
+TEST(QuadDetector, GrayAndBGRAGiveTheSameCorners) {
+    SyntheticPage page;
+    page.corners = pageCorners(page.width, page.height, 0.2f, -25.0f);
+    Frame bgra = renderPage(page, PixelFormat::BGRA8);
+    Frame gray = renderPage(page, PixelFormat::Gray8);
+
+    QuadDetector detector;
+    std::vector<DetectedQuad> fromBGRA = detector.detect(bgra.view());
+    std::vector<DetectedQuad> fromGray = detector.detect(gray.view());
+
+    ASSERT_EQ(fromBGRA.size(), 1u);
+    ASSERT_EQ(fromGray.size(), 1u);
+    EXPECT_LT(cornerError(fromBGRA[0].quad, fromGray[0].quad), 1.5f);
+}
+
+TEST(QuadDetector, IsDeterministic) {
+    SyntheticPage page;
+    page.corners = pageCorners(page.width, page.height, 0.1f, 60.0f);
+    Frame frame = renderPage(page);
+
+    QuadDetector first, second;
+    std::vector<DetectedQuad> a = first.detect(frame.view());
+    std::vector<DetectedQuad> b = second.detect(frame.view());
+    a = first.detect(frame.view());    // reused buffers must not change anything
+
+    ASSERT_EQ(a.size(), b.size());
+    for (size_t i = 0; i < a.size(); i++) {
+        for (int k = 0; k < 4; k++) {
+            EXPECT_EQ(a[i].quad[k].x, b[i].quad[k].x);
+            EXPECT_EQ(a[i].quad[k].y, b[i].quad[k].y);
+        }
+    }
+}
+
+TEST(QuadDetector, RejectsSmallFeatures) {
+    SyntheticPage page;
+    page.corners = pageCorners(page.width, page.height, 0.38f, 0.0f);
+    Frame frame = renderPage(page);
+
+    QuadDetector detector;
+    EXPECT_TRUE(detector.detect(frame.view()).empty());
+
+    QuadDetectorOptions options;
+    options.minimumFeatureSize = 0.1f;
+    detector.setOptions(options);
+    EXPECT_EQ(detector.detect(frame.view()).size(), 1u);
+}
+
+TEST(QuadDetector, EmptyFrame) {
+    SyntheticPage page;
+    page.width  = 320;
+    page.height = 240;
+    page.paper  = page.background;
+    page.noise  = 0;
+    page.text   = false;
+    page.corners = pageCorners(page.width, page.height, 0.2f, 0.0f);
+    Frame frame = renderPage(page);
+
+    QuadDetector detector;
+    EXPECT_TRUE(detector.detect(frame.view()).empty());
+    EXPECT_TRUE(detector.detect(ImageView()).empty());
+}
+
+TEST(QuadDetector, PyramidKeepsFullResolutionPrecision) {
+    SyntheticPage page;
+    page.width   = 4032;
+    page.height  = 3024;
+    page.corners = pageCorners(page.width, page.height, 0.12f, 120.0f);
+    Frame frame  = renderPage(page);
+
+    for (int levels = 2; levels <= 3; levels++) {
+        QuadDetectorOptions options;
+        options.pyramidLevels = levels;
+        QuadDetector detector(options);
+        std::vector<DetectedQuad> quads = detector.detect(frame.view());
+
+        ASSERT_EQ(quads.size(), 1u) << levels;
+        EXPECT_LT(cornerError(quads[0].quad, page.corners), 3.0f) << levels;
+    }
+}
+
+TEST(QuadDetector, PyramidClampsLevelsOnSmallFrames) {
+    SyntheticPage page;
+    page.width   = 320;
+    page.height  = 240;
+    page.corners = pageCorners(page.width, page.height, 0.15f, 8.0f);
+    Frame frame  = renderPage(page);
+
+    QuadDetectorOptions options;
+    options.pyramidLevels = 5;
+    QuadDetector detector(options);
+    std::vector<DetectedQuad> quads = detector.detect(frame.view());
+
+    ASSERT_EQ(quads.size(), 1u);
+    EXPECT_LT(cornerError(quads[0].quad, page.corners), 3.0f);
+}
+
+TEST(QuadDetector, LargestInscribedQuadOfRotatedSquare) {
+    // A diamond makes every diagonal extreme ambiguous
+    std::vector<Point> hull = { Point(50, 0), Point(100, 50), Point(50, 100), Point(0, 50) };
+    Quad quad;
+    ASSERT_TRUE(largestInscribedQuad(hull, quad));
+    EXPECT_FLOAT_EQ(quad.signedArea(), 5000.0f);
+}
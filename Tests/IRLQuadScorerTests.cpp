@@ -0,0 +1,128 @@
+//
+//  IRLQuadScorerTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLQuadScorer.hpp"
+#include "IRLSyntheticPage.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace irl;
+using namespace irl::test;
+
+/** Top plus left side, what `+biggestRectangleInRectangles:` maximizes */
+static float halfPerimeter(const Quad& quad) {
+    return distance(quad.topLeft, quad.topRight) + distance(quad.topLeft, quad.bottomLeft);
+}
+
+static Quad offset(const Quad& quad, float dx, float dy) {
+    Quad result = quad;
+    for (int k = 0; k < 4; k++) result[k] = result[k] + Point(dx, dy);
+    return result;
+}
+
+TEST(QuadScorer, PrefersThePageOverSkewedOversizedCandidates) {
+    SyntheticPage page;
+    page.width   = 960;
+    page.height  = 720;
+    page.corners = pageCorners(page.width, page.height, 0.2f, 12.0f);
+    Frame frame  = renderPage(page);
+
+    // A false positive spanning the page and the desk, with a longer top and left side
+    Quad skewed;
+    skewed.topLeft      = Point(40.0f, 30.0f);
+    skewed.topRight     = Point(930.0f, 160.0f);
+    skewed.bottomRight  = Point(700.0f, 560.0f);
+    skewed.bottomLeft   = Point(90.0f, 690.0f);
+    ASSERT_GT(halfPerimeter(skewed), halfPerimeter(page.corners));
+
+    QuadScorer scorer;
+    scorer.add(skewed);
+    scorer.add(page.corners);
+    EXPECT_EQ(scorer.score(frame.view(), 0, 0, nullptr), 1);
+    EXPECT_GT(scorer.scoreOf(1).edgeSupport, 0.9f);
+    EXPECT_LT(scorer.scoreOf(0).edgeSupport, 0.2f);
+    EXPECT_GT(scorer.scoreOf(0).area, scorer.scoreOf(1).area);
+}
+
+TEST(QuadScorer, ConvexityAndAngles) {
+    Quad square;
+    square.topLeft      = Point(100.0f, 100.0f);
+    square.topRight     = Point(300.0f, 100.0f);
+    square.bottomRight  = Point(300.0f, 300.0f);
+    square.bottomLeft   = Point(100.0f, 300.0f);
+
+    Quad dart = square;                         // reflex corner
+    dart.bottomRight = Point(150.0f, 150.0f);
+
+    Quad bowtie = square;                       // self intersecting
+    std::swap(bowtie.bottomRight, bowtie.bottomLeft);
+
+    Quad counterClockwise = square;
+    std::swap(counterClockwise.topRight, counterClockwise.bottomLeft);
+
+    QuadScorer scorer;
+    for (const Quad& quad : { square, dart, bowtie, counterClockwise }) scorer.add(quad);
+    EXPECT_EQ(scorer.score(ImageView(), 400, 400, nullptr), 0);
+
+    EXPECT_FLOAT_EQ(scorer.scoreOf(0).convexity, 1.0f);
+    EXPECT_FLOAT_EQ(scorer.scoreOf(0).angles, 1.0f);
+    EXPECT_FLOAT_EQ(scorer.scoreOf(0).area, 0.25f);
+    EXPECT_LT(scorer.scoreOf(1).convexity, 0.6f);
+    EXPECT_FLOAT_EQ(scorer.scoreOf(2).convexity, 0.0f);
+    EXPECT_FLOAT_EQ(scorer.scoreOf(3).convexity, 0.0f);
+    EXPECT_FLOAT_EQ(scorer.scoreOf(3).area, 0.0f);
+}
+
+TEST(QuadScorer, TemporalConsistencyBreaksTies) {
+    const Quad a = pageCorners(960, 720, 0.2f, 0.0f);
+    const Quad b = offset(a, 60.0f, 0.0f);
+
+    QuadScorer scorer;
+    scorer.add(a);
+    scorer.add(b);
+    EXPECT_EQ(scorer.score(ImageView(), 960, 720, nullptr), 0);     // equal scores, first wins
+
+    const Quad previous = offset(b, 3.0f, -2.0f);
+    EXPECT_EQ(scorer.score(ImageView(), 960, 720, &previous), 1);
+    EXPECT_GT(scorer.scoreOf(1).temporal, 0.95f);
+
+    QuadScorerOptions options;
+    options.weights.temporal = 0.0f;
+    scorer.setOptions(options);
+    EXPECT_EQ(scorer.score(ImageView(), 960, 720, &previous), 0);
+}
+
+TEST(QuadScorer, HundredsOfCandidatesAreDeterministic) {
+    SyntheticPage page;
+    page.width   = 960;
+    page.height  = 720;
+    page.corners = pageCorners(page.width, page.height, 0.18f, 20.0f);
+    Frame frame  = renderPage(page);
+
+    // Jittered copies of the page, a few of them exact, and random quads
+    XorShift random(7);
+    QuadScorer scorer;
+    for (int i = 0; i < 400; i++) {
+        Quad quad = page.corners;
+        const float amplitude = (i % 50 == 17) ? 0.0f : (i % 2 ? 40.0f : 300.0f);
+        for (int k = 0; k < 4; k++) {
+            quad[k].x += amplitude * (static_cast<float>(random.next() % 2001) / 1000.0f - 1.0f);
+            quad[k].y += amplitude * (static_cast<float>(random.next() % 2001) / 1000.0f - 1.0f);
+        }
+        scorer.add(quad);
+    }
+    ASSERT_EQ(scorer.count(), 400);
+
+    const int best = scorer.score(frame.view(), 0, 0, nullptr);
+    EXPECT_EQ(best, 17);
+    EXPECT_EQ(scorer.score(frame.view(), 0, 0, nullptr), best);
+    EXPECT_EQ(cornerError(scorer.candidate(best), page.corners), 0.0f);
+
+    scorer.clear();
+    EXPECT_EQ(scorer.count(), 0);
+    EXPECT_EQ(scorer.score(frame.view(), 0, 0, nullptr), -1);
+}
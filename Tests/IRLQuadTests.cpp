@@ -0,0 +1,61 @@
+//
+//  IRLQuadTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLAllocationCounter.hpp"
+#include "IRLQuad.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace irl;
+using namespace irl::test;
+
+static void expectSameQuad(const Quad& expected, const Quad& actual) {
+    for (int k = 0; k < 4; k++) {
+        EXPECT_FLOAT_EQ(expected[k].x, actual[k].x) << k;
+        EXPECT_FLOAT_EQ(expected[k].y, actual[k].y) << k;
+    }
+}
+
+TEST(Quad, PseudoAngleFollowsAtan2) {
+    float previous = -3.0f;
+    for (int i = -179; i <= 180; i++) {
+        const double radians = i * 3.14159265358979323846 / 180.0;
+        const float  angle   = pseudoAngle(Point(static_cast<float>(std::cos(radians)), static_cast<float>(std::sin(radians))));
+        EXPECT_GT(angle, previous) << i;
+        previous = angle;
+    }
+    EXPECT_EQ(0.0f, pseudoAngle(Point()));
+}
+
+TEST(Quad, NamesCornersGivenInAnyOrder) {
+    // A page turned by 20 degrees, then one seen in strong perspective
+    const Point turned[4]  = { Point(140.0f, 52.0f), Point(520.0f, 190.0f), Point(430.0f, 440.0f), Point(50.0f, 300.0f) };
+    const Point slanted[4] = { Point(112.3f, 61.8f), Point(538.9f, 95.2f), Point(601.4f, 447.6f), Point(41.7f, 402.5f) };
+    for (const Point* corners : { turned, slanted }) {
+        Quad expected;
+        for (int k = 0; k < 4; k++) expected[k] = corners[k];
+
+        int permutation[4] = { 0, 1, 2, 3 };
+        do {
+            const Point shuffled[4] = { corners[permutation[0]], corners[permutation[1]], corners[permutation[2]], corners[permutation[3]] };
+            expectSameQuad(expected, canonicalQuad(shuffled));
+        } while (std::next_permutation(permutation, permutation + 4));
+        EXPECT_GT(canonicalQuad(corners).signedArea(), 0.0f);
+    }
+}
+
+TEST(Quad, CanonicalizesWithoutAllocating) {
+    const Point corners[4] = { Point(430.0f, 440.0f), Point(140.0f, 52.0f), Point(50.0f, 300.0f), Point(520.0f, 190.0f) };
+    float sum = 0.0f;
+    const long before = allocationCount();
+    for (int i = 0; i < 1000; i++) sum += canonicalQuad(corners).topLeft.x;
+    EXPECT_EQ(0, allocationCount() - before);
+    EXPECT_FLOAT_EQ(140000.0f, sum);
+}
@@ -0,0 +1,198 @@
+//
+//  IRLSyntheticPage.hpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+//  Deterministic camera-like frames (a bright page with text lines on a darker, noisy desk)
+//  shared by the core tests and benchmarks.
+//
+
+#ifndef IRL_SYNTHETIC_PAGE_HPP
+#define IRL_SYNTHETIC_PAGE_HPP
+
+#include "IRLImage.hpp"
+#include "IRLQuad.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace irl {
+namespace test {
+
+/** @brief Description of a synthetic frame */
+struct SyntheticPage {
+    int         width       = 1440;
+    int         height      = 1080;
+    Quad        corners;
+    int         paper       = 205;
+    int         background  = 70;
+    int         noise       = 6;
+    bool        text        = true;
+    uint32_t    seed        = 1;
+};
+
+/** @return A page covering `inset` of the frame on every side, slightly tilted by `skew` pixels */
+inline Quad pageCorners(int width, int height, float inset, float skew) {
+    Quad q;
+    q.topLeft       = Point(width * inset + skew,           height * inset);
+    q.topRight      = Point(width * (1.0f - inset),         height * inset + skew);
+    q.bottomRight   = Point(width * (1.0f - inset) - skew,  height * (1.0f - inset));
+    q.bottomLeft    = Point(width * inset,                  height * (1.0f - inset) - skew);
+    return q;
+}
+
+/** @brief A BGRA or Gray8 frame owning its pixels */
+struct Frame {
+    std::vector<uint8_t>    pixels;
+    int                     width   = 0;
+    int                     height  = 0;
+    size_t                  stride  = 0;
+    PixelFormat             format  = PixelFormat::BGRA8;
+
+    ImageView view() const { return ImageView(pixels.data(), width, height, stride, format); }
+};
+
+/** @brief Small deterministic generator so frames are identical on every platform */
+struct XorShift {
+    uint32_t state;
+    explicit XorShift(uint32_t seed) : state(seed ? seed : 0x9E3779B9u) {}
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    int noise(int amplitude) {
+        return amplitude == 0 ? 0 : static_cast<int>(next() % static_cast<uint32_t>(2 * amplitude + 1)) - amplitude;
+    }
+};
+
+/**
+ @brief Render `page`.
+ @discussion Page edges are anti-aliased with the signed distance to the quad sides. Text lines are drawn
+ in page space so they follow the perspective.
+ */
+inline Frame renderPage(const SyntheticPage& page, PixelFormat format = PixelFormat::BGRA8) {
+    Frame frame;
+    frame.width  = page.width;
+    frame.height = page.height;
+    frame.format = format;
+    frame.stride = static_cast<size_t>(page.width) * bytesPerPixel(format);
+    frame.pixels.resize(frame.stride * page.height);
+
+    const Quad& q = page.corners;
+    Point normals[4];
+    float offsets[4];
+    for (int i = 0; i < 4; i++) {
+        Point a = q[i], b = q[(i + 1) & 3];
+        Point d = b - a;
+        float length = std::max(distance(a, b), 1e-3f);
+        normals[i] = Point(-d.y / length, d.x / length);    // points inside for a clockwise quad
+        offsets[i] = dot(normals[i], a);
+    }
+
+    XorShift random(page.seed);
+    const float heightOfPage = 0.5f * (distance(q.topLeft, q.bottomLeft) + distance(q.topRight, q.bottomRight));
+
+    for (int y = 0; y < page.height; y++) {
+        uint8_t* row = frame.pixels.data() + frame.stride * y;
+        for (int x = 0; x < page.width; x++) {
+            Point p(x + 0.5f, y + 0.5f);
+            float inside = 1e9f;
+            for (int i = 0; i < 4; i++) inside = std::min(inside, dot(normals[i], p) - offsets[i]);
+            float coverage = std::min(std::max(inside + 0.5f, 0.0f), 1.0f);
+
+            // Desk has a soft horizontal gradient
+            float desk  = page.background + 20.0f * x / page.width;
+            float paper = static_cast<float>(page.paper);
+
+            if (page.text && inside > 0.08f * heightOfPage) {
+                // Distance to the top side gives the line position, distance to the left side the column
+                float v = dot(normals[0], p) - offsets[0];
+                float u = dot(normals[3], p) - offsets[3];
+                int   line = static_cast<int>(v / 18.0f);
+                bool  stroke = std::fmod(v, 18.0f) < 7.0f && std::fmod(u + line * 37.0f, 53.0f) < 41.0f;
+                if (stroke && u > 0.06f * heightOfPage && inside > 0.1f * heightOfPage) paper = 60.0f;
+            }
+
+            int value = static_cast<int>(desk + (paper - desk) * coverage + 0.5f) + random.noise(page.noise);
+            uint8_t v8 = static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+
+            if (format == PixelFormat::Gray8) {
+                row[x] = v8;
+            } else {
+                // Slight warm cast, like an indoor shot
+                row[4 * x + 0] = static_cast<uint8_t>(std::max(0, v8 - 6));
+                row[4 * x + 1] = v8;
+                row[4 * x + 2] = static_cast<uint8_t>(std::min(255, v8 + 4));
+                row[4 * x + 3] = 255;
+            }
+        }
+    }
+    return frame;
+}
+
+/** @brief A 4:2:0 bi-planar frame owning its planes, as delivered by the camera in `420YpCbCr8BiPlanarFullRange` */
+struct BiPlanarFrame {
+    std::vector<uint8_t>    luma;
+    std::vector<uint8_t>    chroma;
+    int                     width   = 0;
+    int                     height  = 0;
+
+    size_t chromaStride() const { return 2 * static_cast<size_t>((width + 1) / 2); }
+    BiPlanarView view() const { return BiPlanarView(luma.data(), width, height, width, chroma.data(), chromaStride()); }
+};
+
+/**
+ @return `frame` (BGRA8) encoded as full range BT.601 NV12, the camera side of `convertToBGRA`.
+ @discussion Luma uses the same Q8 weights as `convertToLuma`, chroma is the average of each 2x2 block.
+ */
+inline BiPlanarFrame encodeBiPlanar(const Frame& frame) {
+    BiPlanarFrame nv12;
+    nv12.width  = frame.width;
+    nv12.height = frame.height;
+    nv12.luma.resize(static_cast<size_t>(frame.width) * frame.height);
+    nv12.chroma.resize(nv12.chromaStride() * ((frame.height + 1) / 2));
+
+    for (int y = 0; y < frame.height; y++) {
+        const uint8_t* src = frame.pixels.data() + frame.stride * y;
+        for (int x = 0; x < frame.width; x++, src += 4) {
+            nv12.luma[static_cast<size_t>(y) * frame.width + x] = static_cast<uint8_t>((29 * src[0] + 150 * src[1] + 77 * src[2] + 128) >> 8);
+        }
+    }
+
+    for (int y = 0; y < frame.height; y += 2) {
+        uint8_t* dst = nv12.chroma.data() + nv12.chromaStride() * (y / 2);
+        for (int x = 0; x < frame.width; x += 2, dst += 2) {
+            float b = 0.0f, g = 0.0f, r = 0.0f;
+            int   count = 0;
+            for (int dy = 0; dy < 2 && y + dy < frame.height; dy++) {
+                for (int dx = 0; dx < 2 && x + dx < frame.width; dx++, count++) {
+                    const uint8_t* p = frame.pixels.data() + frame.stride * (y + dy) + 4 * (x + dx);
+                    b += p[0]; g += p[1]; r += p[2];
+                }
+            }
+            b /= count; g /= count; r /= count;
+            const float cb = 128.0f - 0.168736f * r - 0.331264f * g + 0.5f * b;
+            const float cr = 128.0f + 0.5f * r - 0.418688f * g - 0.081312f * b;
+            dst[0] = static_cast<uint8_t>(std::min(std::max(cb + 0.5f, 0.0f), 255.0f));
+            dst[1] = static_cast<uint8_t>(std::min(std::max(cr + 0.5f, 0.0f), 255.0f));
+        }
+    }
+    return nv12;
+}
+
+/** @return Largest distance between matching corners of `a` and `b` */
+inline float cornerError(const Quad& a, const Quad& b) {
+    float error = 0.0f;
+    for (int i = 0; i < 4; i++) error = std::max(error, distance(a[i], b[i]));
+    return error;
+}
+
+} // namespace test
+} // namespace irl
+
+#endif /* IRL_SYNTHETIC_PAGE_HPP */
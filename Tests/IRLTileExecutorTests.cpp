@@ -0,0 +1,76 @@
+//
+//  IRLTileExecutorTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLTileExecutor.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+using namespace irl;
+
+TEST(TileExecutor, RunsEveryTileOnce) {
+    for (int threads : { 1, 2, 3, 8 }) {
+        TileExecutor executor(threads);
+        EXPECT_EQ(executor.threadCount(), threads);
+
+        // 1000 x 700 in 64 x 48 tiles: 16 x 15 tiles, cut on the right and at the bottom
+        std::vector<std::atomic<int>> visits(16 * 15);
+        for (std::atomic<int>& count : visits) count = 0;
+        std::atomic<long> pixels(0);
+        std::atomic<int>  badWorker(0);
+
+        executor.run(1000, 700, 64, 48, [&](const Tile& tile, int worker) {
+            visits[static_cast<size_t>(tile.index)]++;
+            pixels += static_cast<long>(tile.width) * tile.height;
+            if (worker < 0 || worker >= threads) badWorker++;
+            EXPECT_EQ(tile.index, (tile.y / 48) * 16 + tile.x / 64);
+            EXPECT_LE(tile.x + tile.width, 1000);
+            EXPECT_LE(tile.y + tile.height, 700);
+        });
+
+        for (const std::atomic<int>& count : visits) ASSERT_EQ(count.load(), 1);
+        EXPECT_EQ(pixels.load(), 1000L * 700L);
+        EXPECT_EQ(badWorker.load(), 0);
+    }
+}
+
+TEST(TileExecutor, StealsFromSlowWorkers) {
+    TileExecutor executor(4);
+
+    // The first run of tiles is slow: the other workers must take some of it
+    std::vector<int> ranBy(64, -1);
+    executor.runBands(1, 64, 1, [&](const Tile& tile, int worker) {
+        if (tile.index < 16) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        ranBy[static_cast<size_t>(tile.index)] = worker;
+    });
+
+    int stolen = 0;
+    for (int i = 0; i < 16; i++) {
+        ASSERT_GE(ranBy[static_cast<size_t>(i)], 0);
+        stolen += ranBy[static_cast<size_t>(i)] != ranBy[0];
+    }
+    EXPECT_GT(stolen, 0);
+}
+
+TEST(TileExecutor, RunsBackToBackAndFromSeveralThreads) {
+    TileExecutor executor(3);
+    std::atomic<long> total(0);
+
+    auto submit = [&] {
+        for (int i = 0; i < 50; i++) {
+            executor.runBands(10, 100, 7, [&](const Tile& tile, int) { total += tile.height; });
+        }
+    };
+    std::thread other(submit);
+    submit();
+    other.join();
+
+    EXPECT_EQ(total.load(), 2L * 50L * 100L);
+}
@@ -0,0 +1,79 @@
+//
+//  IRLToneCurveTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLToneCurve.hpp"
+#include "IRLToneCurveKernels.hpp"
+#include "IRLSyntheticPage.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+using namespace irl;
+using namespace irl::test;
+
+static_assert(kUltraContrastCurve[0] == 0 && kUltraContrastCurve[255] == 255, "Ultra Contrast curve is built at compile time");
+
+/** Replays the drawing of the former `+[CIImage imageGradientImage:]`, one pixel per byte */
+static ToneCurve drawnGradient(double threshold) {
+    double pixels[256];
+    for (double& pixel : pixels) pixel = 1.0;
+    for (int i = 0; i < 200; i++) {
+        const double gray  = 1.0 / (1.0 + std::exp(-(10.0 * (100 - i) / 200.0)));
+        const double width = 256.0 * threshold * threshold + 200 - i;
+        for (int x = 0; x < 256; x++) if (x + 0.5 < width) pixels[x] = gray;
+    }
+    for (int x = 0; x < 256; x++) if (x + 0.5 < 256.0 * threshold) pixels[x] = 0.0;
+
+    ToneCurve curve;
+    for (int x = 0; x < 256; x++) curve.values[x] = static_cast<uint8_t>(std::lround(pixels[x] * 255.0));
+    return curve;
+}
+
+TEST(ToneCurve, UltraContrastMatchesTheDrawnGradient) {
+    for (double threshold : { 0.3, 0.1, 0.5, 0.75 }) {
+        const ToneCurve expected = drawnGradient(threshold);
+        const ToneCurve actual   = ultraContrastCurve(threshold);
+        for (int x = 0; x < 256; x++) EXPECT_EQ(expected[x], actual[x]) << "threshold " << threshold << " byte " << x;
+    }
+
+    const ToneCurve expected = drawnGradient(0.3);
+    for (int x = 0; x < 256; x++) EXPECT_EQ(expected[x], kUltraContrastCurve[x]);
+}
+
+TEST(ToneCurve, VectorVariantsAreBitExact) {
+    // Random curve so a wrong sub table shows, odd width for the row ends
+    XorShift random(7);
+    ToneCurve curve;
+    for (uint8_t& value : curve.values) value = static_cast<uint8_t>(random.next() >> 24);
+
+    const int width = 301, height = 9;
+    Plane8 source(width, height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) source.row(y)[x] = static_cast<uint8_t>(x + 37 * y);
+    }
+
+    for (SimdLevel level : { SimdLevel::Scalar, SimdLevel::SSE41, SimdLevel::AVX2, SimdLevel::NEON }) {
+        if (!detail::toneCurveKernels(level)) continue;
+        Plane8 mapped;
+        ToneMapper(level).apply(source.view(), curve, mapped);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                ASSERT_EQ(mapped.row(y)[x], curve[source.row(y)[x]]) << simdLevelName(level) << " " << x << "," << y;
+            }
+        }
+    }
+}
+
+TEST(ToneCurve, MapsInPlace) {
+    Plane8 plane(70, 3);
+    for (int y = 0; y < 3; y++) for (int x = 0; x < 70; x++) plane.row(y)[x] = static_cast<uint8_t>(3 * x + y);
+
+    ToneMapper().apply(plane.view(), kUltraContrastCurve, plane);
+    ASSERT_EQ(plane.width(), 70);
+    for (int y = 0; y < 3; y++) for (int x = 0; x < 70; x++) EXPECT_EQ(plane.row(y)[x], kUltraContrastCurve[3 * x + y]);
+}
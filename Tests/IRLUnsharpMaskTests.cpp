@@ -0,0 +1,109 @@
+//
+//  IRLUnsharpMaskTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLPageRenderer.hpp"
+#include "IRLSyntheticPage.hpp"
+#include "IRLUnsharpMask.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace irl;
+using namespace irl::test;
+
+static Frame noisyPage(int width, int height, PixelFormat format) {
+    SyntheticPage page;
+    page.width   = width;
+    page.height  = height;
+    page.noise   = 8;
+    page.corners = pageCorners(width, height, 0.08f, 6.0f);
+    return renderPage(page, format);
+}
+
+TEST(UnsharpMask, MatchesTheDirectBlur) {
+    // Taller than a band, so the band starts are covered too
+    const Frame gray = noisyPage(97, 203, PixelFormat::Gray8);
+    for (int radius : { 1, 2, 5 }) {
+        UnsharpMaskOptions options;
+        options.radius    = radius;
+        options.amount    = 1.5f;
+        options.threshold = 4;
+        std::vector<uint8_t> sharpened(gray.pixels.size());
+        UnsharpMask(options).apply(gray.view(), sharpened.data(), gray.stride);
+
+        int worst = 0;
+        for (int y = 0; y < gray.height; y++) {
+            for (int x = 0; x < gray.width; x++) {
+                double sum = 0.0, count = 0.0;
+                for (int j = std::max(y - radius, 0); j <= std::min(y + radius, gray.height - 1); j++) {
+                    for (int i = std::max(x - radius, 0); i <= std::min(x + radius, gray.width - 1); i++, count++) sum += gray.pixels[j * gray.stride + i];
+                }
+                const int    value      = gray.pixels[y * gray.stride + x];
+                const double difference = value - sum / count;
+                const double excess     = std::max(std::fabs(difference) - options.threshold, 0.0) * (difference < 0 ? -1 : 1);
+                const int    expected   = static_cast<int>(std::min(std::max(std::lround(value + options.amount * excess), 0L), 255L));
+                worst = std::max(worst, std::abs(expected - sharpened[y * gray.stride + x]));
+            }
+        }
+        // The blur is rounded to a level before the difference, so the amount can turn half a level into one
+        EXPECT_LE(worst, 1) << "radius " << radius;
+    }
+}
+
+TEST(UnsharpMask, SteepensEdgesAndLeavesTheGrain) {
+    // A soft vertical edge from 60 to 200 over 4 pixels, with a faint ripple on both sides
+    const int width = 64, height = 16;
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const int level = x < 30 ? 60 : x >= 34 ? 200 : 60 + 35 * (x - 30 + 1) - 17;
+            pixels[y * width + x] = static_cast<uint8_t>(level + ((x + y) % 2 ? 1 : -1));
+        }
+    }
+    std::vector<uint8_t> sharpened(pixels.size());
+    UnsharpMask().apply(ImageView(pixels.data(), width, height, width, PixelFormat::Gray8), sharpened.data(), width);
+
+    const uint8_t* row = sharpened.data() + 8 * width;
+    EXPECT_LT(row[30], pixels[8 * width + 30]);
+    EXPECT_GT(row[33], pixels[8 * width + 33]);
+    EXPECT_GT(row[33] - row[30], pixels[8 * width + 33] - pixels[8 * width + 30]);
+    for (int x : { 5, 15, 50, 60 }) EXPECT_EQ(pixels[8 * width + x], row[x]) << x;
+}
+
+TEST(UnsharpMask, PageRendererSharpensInTheSamePass) {
+    SyntheticPage page;
+    page.width   = 640;
+    page.height  = 480;
+    page.corners = pageCorners(page.width, page.height, 0.1f, 15.0f);
+    const Frame frame = renderPage(page);
+
+    PageRenderOptions options;
+    options.filter  = PageFilter::None;
+    options.margin  = 10;
+    options.threads = 1;
+    PageRenderer renderer(options);
+    int width, height;
+    renderer.outputSize(page.corners, width, height);
+    const size_t rowBytes = 4 * static_cast<size_t>(width);
+
+    // The page rendered, then sharpened in a second pass
+    std::vector<uint8_t> rendered(rowBytes * height), expected(rendered.size());
+    renderer.render(frame.view(), page.corners, rendered.data(), rowBytes);
+    UnsharpMask().apply(ImageView(rendered.data(), width, height, rowBytes, PixelFormat::BGRA8), expected.data(), rowBytes);
+    EXPECT_NE(rendered, expected);
+
+    options.sharpen = true;
+    for (int threads : { 1, 3 }) {
+        options.threads = threads;
+        renderer.setOptions(options);
+        std::vector<uint8_t> fused(rendered.size());
+        renderer.render(frame.view(), page.corners, fused.data(), rowBytes);
+        EXPECT_EQ(expected, fused) << threads << " threads";
+    }
+}
@@ -0,0 +1,91 @@
+//
+//  IRLWhiteBalanceTests.cpp
+//  IRLDocumentScanner
+//
+//  Copyright (c) 2018 iRLMobile. All rights reserved.
+//
+
+#include "IRLPageRenderer.hpp"
+#include "IRLSyntheticPage.hpp"
+#include "IRLWhiteBalance.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+using namespace irl;
+using namespace irl::test;
+
+/** A gray page under a warm light: blue and green scaled down, like tungsten */
+static Frame tintedPage(SyntheticPage& page) {
+    page.width   = 800;
+    page.height  = 600;
+    page.paper   = 230;
+    page.corners = pageCorners(page.width, page.height, 0.1f, 20.0f);
+    Frame frame  = renderPage(page);
+    for (size_t i = 0; i < frame.pixels.size(); i += 4) {
+        frame.pixels[i + 0] = static_cast<uint8_t>(frame.pixels[i + 0] * 0.7f);
+        frame.pixels[i + 1] = static_cast<uint8_t>(frame.pixels[i + 1] * 0.88f);
+    }
+    return frame;
+}
+
+TEST(WhiteBalance, FindsThePaperColor) {
+    SyntheticPage page;
+    Frame frame = tintedPage(page);
+
+    const PaperWhite white = estimatePaperWhite(frame.view(), page.corners);
+    ASSERT_TRUE(white.valid);
+    // The brightest samples of the paper, a little above its mean level with the noise. The synthetic page
+    // already is slightly warm: blue 6 below the gray level, red 4 above.
+    EXPECT_NEAR(white.color[2], page.paper + 4, 12.0f);
+    EXPECT_NEAR(white.color[0] / white.color[2], 0.7f * (page.paper - 6) / (page.paper + 4), 0.02f);
+    EXPECT_NEAR(white.color[1] / white.color[2], 0.88f * page.paper / (page.paper + 4), 0.02f);
+
+    // Red is the brightest channel and keeps its level
+    EXPECT_FLOAT_EQ(white.gains[2], 1.0f);
+    EXPECT_GT(white.gains[0], white.gains[1]);
+    EXPECT_GT(white.gains[1], 1.0f);
+}
+
+TEST(WhiteBalance, LeavesDarkPagesAlone) {
+    SyntheticPage page;
+    page.width   = 320;
+    page.height  = 240;
+    page.paper   = 30;
+    page.text    = false;
+    page.corners = pageCorners(page.width, page.height, 0.1f, 5.0f);
+    Frame frame  = renderPage(page);
+
+    const PaperWhite white = estimatePaperWhite(frame.view(), page.corners);
+    EXPECT_FALSE(white.valid);
+    for (float gain : white.gains) EXPECT_EQ(1.0f, gain);
+}
+
+TEST(WhiteBalance, PageRendererNeutralizesThePaper) {
+    SyntheticPage page;
+    Frame frame = tintedPage(page);
+
+    PageRenderOptions options;
+    options.margin = 20;
+    auto paperCast = [&](bool balance) {
+        options.whiteBalance = balance;
+        PageRenderer renderer(options);
+        int width, height;
+        renderer.outputSize(page.corners, width, height);
+        std::vector<uint8_t> output(4 * static_cast<size_t>(width) * height);
+        renderer.render(frame.view(), page.corners, output.data(), 4 * static_cast<size_t>(width));
+
+        // Red minus blue over the paper pixels, those clipped by the contrast left out
+        double cast = 0.0, count = 0.0;
+        for (size_t i = 0; i < output.size(); i += 4) {
+            if (output[i + 2] < 200 || output[i + 2] == 255) continue;
+            cast  += output[i + 2] - output[i + 0];
+            count += 1.0;
+        }
+        return cast / std::max(count, 1.0);
+    };
+
+    EXPECT_GT(paperCast(false), 40.0);
+    EXPECT_LT(std::fabs(paperCast(true)), 3.0);
+}